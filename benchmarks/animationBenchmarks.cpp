@@ -0,0 +1,182 @@
+#include "benchmark.h"
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Geometry/sphereSet.h"
+#include "Math/interval.h"
+#include "Math/random.h"
+#include "Math/ray.h"
+#include "Math/utilities.h"
+#include "Math/vector3.h"
+
+namespace
+{
+    const uint64_t ANIMATION_SEED = 23;
+
+    // Rays per hit benchmark iteration batch.
+    const int ANIMATION_RAY_COUNT = 4096;
+
+    // Distance over which the direction of motion changes.
+    const float ANIMATION_FLOW_SCALE = 40.0f;
+
+    // Frames the spheres drift for before the hierarchies are compared.
+    const int ANIMATION_DRIFT_FRAMES = 30;
+
+    // Spheres of an animated crowd: where they start and how far they move
+    // per frame.
+    struct Crowd
+    {
+        std::vector<Point3> centers;
+        std::vector<Vector3> velocities;
+    };
+
+    // Places count spheres (radii 0.5 to 2) in a cube of the given half
+    // extent, each drifting by about one radius per frame along a smooth
+    // flow, and adds them to set.
+    Crowd addCrowd(SphereSet& set, uint32_t count, float extent)
+    {
+        RandomStream rng(ANIMATION_SEED);
+        Crowd crowd;
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            Point3 center(extent * (2.0f * rng.nextFloat() - 1.0f),
+                          extent * (2.0f * rng.nextFloat() - 1.0f),
+                          extent * (2.0f * rng.nextFloat() - 1.0f));
+            Vector3 flow(std::sin(center.y() / ANIMATION_FLOW_SCALE),
+                         std::cos(center.z() / ANIMATION_FLOW_SCALE),
+                         std::sin(center.x() / ANIMATION_FLOW_SCALE));
+
+            set.add(center, Vector3(), 0.5f + 1.5f * rng.nextFloat(), 0);
+            crowd.centers.push_back(center);
+            crowd.velocities.push_back(flow);
+        }
+
+        return crowd;
+    }
+
+    // Moves every sphere of the crowd to where it is at frame.
+    void poseCrowd(SphereSet& set, const Crowd& crowd, int frame)
+    {
+        for (uint32_t i = 0; i < crowd.centers.size(); ++i)
+        {
+            set.setCenter(i, crowd.centers[i] +
+                             static_cast<float>(frame) *
+                             crowd.velocities[i]);
+        }
+    }
+
+    // Random rays through the cube.
+    std::vector<Ray> makeAnimationRays(float extent)
+    {
+        RandomStream rng(ANIMATION_SEED + 1);
+        std::vector<Ray> rays;
+
+        for (int i = 0; i < ANIMATION_RAY_COUNT; ++i)
+        {
+            Point3 origin(extent * (2.0f * rng.nextFloat() - 1.0f),
+                          extent * (2.0f * rng.nextFloat() - 1.0f),
+                          extent * (2.0f * rng.nextFloat() - 1.0f));
+            Vector3 direction(2.0f * rng.nextFloat() - 1.0f,
+                              2.0f * rng.nextFloat() - 1.0f,
+                              2.0f * rng.nextFloat() - 1.0f);
+
+            rays.push_back(Ray(origin, direction));
+        }
+
+        return rays;
+    }
+}
+
+void runAnimationBenchmarks(BenchmarkRunner& runner)
+{
+    uint32_t count = runner.quick() ? 20000 : 200000;
+    float extent = 10.0f * std::cbrt(static_cast<float>(count));
+    std::string prefix = std::to_string(count);
+
+    // Cost of updating the hierarchy for a new frame.
+    for (bool refit : {false, true})
+    {
+        std::string name = "animation_update/" + prefix +
+                           (refit ? "/refit" : "/rebuild");
+
+        if (!runner.enabled(name))
+        {
+            continue;
+        }
+
+        SphereSet set;
+        Crowd crowd = addCrowd(set, count, extent);
+        set.build();
+        int frame = 0;
+
+        runner.run(name, [&](uint64_t iterations)
+                   {
+                       for (uint64_t i = 0; i < iterations; ++i)
+                       {
+                           poseCrowd(set, crowd,
+                                     ++frame % ANIMATION_DRIFT_FRAMES);
+
+                           if (refit)
+                           {
+                               set.refit();
+                           }
+                           else
+                           {
+                               set.build();
+                           }
+                       }
+                   });
+    }
+
+    // Ray queries after the crowd drifted, through a hierarchy refitted
+    // every frame since the first against one rebuilt for the last frame.
+    std::vector<Ray> rays = makeAnimationRays(extent);
+
+    for (bool refit : {false, true})
+    {
+        std::string name = "animation_hit/" + prefix + "/" +
+                           std::to_string(ANIMATION_DRIFT_FRAMES) +
+                           (refit ? "/refitted" : "/rebuilt");
+
+        if (!runner.enabled(name))
+        {
+            continue;
+        }
+
+        SphereSet set;
+        Crowd crowd = addCrowd(set, count, extent);
+        set.build();
+
+        for (int frame = 1; frame <= ANIMATION_DRIFT_FRAMES; ++frame)
+        {
+            poseCrowd(set, crowd, frame);
+
+            if (refit)
+            {
+                set.refit();
+            }
+        }
+
+        if (!refit)
+        {
+            set.build();
+        }
+
+        runner.run(name, [&](uint64_t iterations)
+                   {
+                       for (uint64_t i = 0; i < iterations; ++i)
+                       {
+                           uint32_t sphere;
+                           float t;
+                           bool hit = set.intersect(
+                                          rays[i % ANIMATION_RAY_COUNT],
+                                          Interval(0.001f, INF), sphere, t);
+                           doNotOptimize(hit);
+                       }
+                   });
+    }
+}
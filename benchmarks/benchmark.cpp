@@ -0,0 +1,165 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include "Camera/camera.h"
+#include "Math/vector3.h"
+#include "Render/framebuffer.h"
+
+#ifndef RAYTRACER_VERSION
+#define RAYTRACER_VERSION "unknown"
+#endif
+
+#ifndef RAYTRACER_REVISION
+#define RAYTRACER_REVISION "unknown"
+#endif
+
+#ifndef RAYTRACER_BUILD_TYPE
+#define RAYTRACER_BUILD_TYPE "unknown"
+#endif
+
+namespace
+{
+    // Writes a JSON string literal (names never need more than quotes and
+    // backslashes escaped).
+    void writeString(std::ostream& out, const std::string& value)
+    {
+        out << '"';
+
+        for (char c : value)
+        {
+            if (c == '"' || c == '\\')
+            {
+                out << '\\';
+            }
+
+            out << c;
+        }
+
+        out << '"';
+    }
+
+    const char* compilerName()
+    {
+#if defined(__clang__)
+        return "clang " __clang_version__;
+#elif defined(__GNUC__)
+        return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+        return "msvc";
+#else
+        return "unknown";
+#endif
+    }
+}
+
+Camera makeDemoCamera(int width, int height, int samplesPerPixel)
+{
+    return Camera(width, height, samplesPerPixel, DEMO_MAX_DEPTH,
+                  static_cast<float>(width) / height, 20.0f, 0.02f, 10.0f,
+                  Point3(13.0f, 2.0f, 3.0f), Point3(0.0f, 0.0f, 0.0f),
+                  Vector3(0.0f, 1.0f, 0.0f));
+}
+
+double rootMeanSquareError(const Framebuffer& a, const Framebuffer& b,
+                           bool clampToDisplay)
+{
+    double sum = 0.0;
+
+    for (int y = 0; y < a.height(); ++y)
+    {
+        for (int x = 0; x < a.width(); ++x)
+        {
+            Color pixelA = a.pixel(x, y);
+            Color pixelB = b.pixel(x, y);
+
+            for (int channel = 0; channel < 3; ++channel)
+            {
+                double difference = clampToDisplay ?
+                                    std::min(pixelA[channel], 1.0f) -
+                                    std::min(pixelB[channel], 1.0f) :
+                                    pixelA[channel] - pixelB[channel];
+                sum += difference * difference;
+            }
+        }
+    }
+
+    return std::sqrt(sum / (3.0 * a.pixelCount()));
+}
+
+BenchmarkRunner::BenchmarkRunner(const std::string& filter, bool quick) :
+                                 m_filter(filter), m_quick(quick),
+                                 m_minimumSeconds(quick ? 0.05 : 0.5) {}
+
+bool BenchmarkRunner::enabled(const std::string& name) const
+{
+    return m_filter.empty() || name.find(m_filter) != std::string::npos;
+}
+
+void BenchmarkRunner::record(const BenchmarkResult& result)
+{
+    m_results.push_back(result);
+
+    // Progress goes to the log so stdout only holds the report.
+    std::clog << std::left << std::setw(40) << result.name << ' '
+              << std::right << std::setw(14) << std::fixed
+              << std::setprecision(2) << result.nanosecondsPerOperation()
+              << " ns/op\n";
+}
+
+void BenchmarkRunner::writeJson(std::ostream& out) const
+{
+    out << std::setprecision(9) << std::defaultfloat;
+
+    out << "{\n";
+    out << "  \"version\": ";
+    writeString(out, RAYTRACER_VERSION);
+    out << ",\n  \"revision\": ";
+    writeString(out, RAYTRACER_REVISION);
+    out << ",\n  \"build_type\": ";
+    writeString(out, RAYTRACER_BUILD_TYPE);
+    out << ",\n  \"vector_backend\": ";
+    writeString(out, VECTOR3_BACKEND);
+    out << ",\n  \"compiler\": ";
+    writeString(out, compilerName());
+    out << ",\n  \"hardware_threads\": "
+        << std::thread::hardware_concurrency();
+    out << ",\n  \"quick\": " << (m_quick ? "true" : "false");
+    out << ",\n  \"benchmarks\": [";
+
+    for (size_t i = 0; i < m_results.size(); ++i)
+    {
+        const BenchmarkResult& result = m_results[i];
+
+        out << (i > 0 ? "," : "") << "\n    {\"name\": ";
+        writeString(out, result.name);
+        out << ", \"iterations\": " << result.iterations
+            << ", \"seconds\": " << result.seconds
+            << ", \"ns_per_op\": " << result.nanosecondsPerOperation();
+
+        for (const auto& metric : result.metrics)
+        {
+            out << ", ";
+            writeString(out, metric.first);
+            out << ": ";
+
+            // JSON has no representation of infinity or NaN.
+            if (std::isfinite(metric.second))
+            {
+                out << metric.second;
+            }
+            else
+            {
+                out << "null";
+            }
+        }
+
+        out << '}';
+    }
+
+    out << "\n  ]\n}\n";
+}
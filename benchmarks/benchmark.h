@@ -0,0 +1,178 @@
+/*
+ * This file provides a small benchmark harness. Micro benchmarks are timed
+ * by running an operation in batches that double in size until a batch
+ * takes long enough to measure, while longer benchmarks (e.g. full frames)
+ * time themselves and report their own metrics. All results are written as
+ * one JSON document so runs of different versions can be compared.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Keeps the compiler from optimizing away a value that is never used.
+template <typename T>
+inline void doNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+class Camera;
+class Framebuffer;
+
+// Bounces of the paths of the demo image.
+const int DEMO_MAX_DEPTH = 50;
+
+// Returns the camera of the renderer's demo image at the given resolution,
+// for the benchmarks that render the demo scene or variations of it.
+Camera makeDemoCamera(int width, int height, int samplesPerPixel);
+
+// Returns the root mean square difference of two images of the same size,
+// over all three channels. With clampToDisplay, values are clamped to the
+// displayed range first, so that a few pixels far brighter than the rest
+// (e.g. lights seen directly) cannot hide the noise of everything else.
+// Every benchmark reports the error of the same function, so their
+// numbers compare.
+double rootMeanSquareError(const Framebuffer& a, const Framebuffer& b,
+                           bool clampToDisplay);
+
+struct BenchmarkResult
+{
+    // Unique name of the benchmark, e.g. "sphere_hit/static".
+    std::string name;
+
+    // Number of operations timed.
+    uint64_t iterations = 0;
+
+    // Total wall time of the timed operations.
+    double seconds = 0.0;
+
+    // Additional named values (rays per second, path length, ...).
+    std::vector<std::pair<std::string, double>> metrics;
+
+    double nanosecondsPerOperation() const
+    {
+        return iterations > 0 ? 1e9 * seconds / iterations : 0.0;
+    }
+};
+
+class BenchmarkRunner
+{
+public:
+    // Benchmarks whose name does not contain filter are skipped. Quick runs
+    // shorten the timing and skip the largest problem sizes.
+    BenchmarkRunner(const std::string& filter, bool quick);
+
+    bool quick() const { return m_quick; }
+
+    // Returns whether the benchmark of the given name should run.
+    bool enabled(const std::string& name) const;
+
+    // Times operation(iterations), which must perform the operation that
+    // many times, and records the result.
+    template <typename Operation>
+    void run(const std::string& name, Operation&& operation);
+
+    // Records a result measured by the caller.
+    void record(const BenchmarkResult& result);
+
+    // Writes every result as JSON.
+    void writeJson(std::ostream& out) const;
+
+private:
+    std::string m_filter;
+    bool m_quick;
+
+    // Minimum duration of the timed batch of a micro benchmark.
+    double m_minimumSeconds;
+
+    std::vector<BenchmarkResult> m_results;
+};
+
+// Registers the benchmarks of the individual building blocks.
+void runMicroBenchmarks(BenchmarkRunner& runner);
+
+// Registers the whole-frame, path length and convergence benchmarks.
+void runFrameBenchmarks(BenchmarkRunner& runner);
+
+// Registers the benchmarks loading text scenes and scene caches.
+void runSceneFileBenchmarks(BenchmarkRunner& runner);
+
+// Registers the OBJ loading, mesh BVH build and triangle intersection
+// benchmarks.
+void runMeshBenchmarks(BenchmarkRunner& runner);
+
+// Registers the two-level instancing build and intersection benchmarks.
+void runInstanceBenchmarks(BenchmarkRunner& runner);
+
+// Registers the benchmarks of moving spheres with swept and interpolated
+// BVH bounds over increasing motion lengths.
+void runMotionBenchmarks(BenchmarkRunner& runner);
+
+// Registers the benchmarks comparing BVH refits with rebuilds for animated
+// spheres, in update time and in ray query time after the spheres drifted.
+void runAnimationBenchmarks(BenchmarkRunner& runner);
+
+// Registers the benchmarks timing the denoiser and comparing the error of
+// noisy and denoised images at several sample counts.
+void runDenoiseBenchmarks(BenchmarkRunner& runner);
+
+// Registers the benchmarks comparing the error of light sampling with
+// scattering alone on a scene lit by small lights, at equal samples and at
+// equal time.
+void runLightBenchmarks(BenchmarkRunner& runner);
+
+// Registers the benchmarks comparing the error of environment map
+// importance sampling with scattering alone on a scene lit by a sun.
+void runEnvironmentBenchmarks(BenchmarkRunner& runner);
+
+// Registers the benchmarks of the Vector3 operations and of a demo frame,
+// named after the vector backend the build uses.
+void runVectorBenchmarks(BenchmarkRunner& runner);
+
+template <typename Operation>
+void BenchmarkRunner::run(const std::string& name, Operation&& operation)
+{
+    if (!enabled(name))
+    {
+        return;
+    }
+
+    using Clock = std::chrono::steady_clock;
+
+    // Warm up caches and branch predictors.
+    operation(static_cast<uint64_t>(1));
+
+    uint64_t iterations = 1;
+
+    while (true)
+    {
+        Clock::time_point start = Clock::now();
+        operation(iterations);
+        double seconds = std::chrono::duration<double>(Clock::now() -
+                                                       start).count();
+
+        if (seconds >= m_minimumSeconds || iterations >= (1ull << 40))
+        {
+            BenchmarkResult result;
+            result.name = name;
+            result.iterations = iterations;
+            result.seconds = seconds;
+            record(result);
+
+            return;
+        }
+
+        iterations *= 2;
+    }
+}
@@ -0,0 +1,82 @@
+#include "benchmark.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "Camera/camera.h"
+#include "Math/random.h"
+#include "Render/denoiser.h"
+#include "Render/featureBuffer.h"
+#include "Render/framebuffer.h"
+#include "Render/threadPool.h"
+#include "Scene/randomScene.h"
+#include "Scene/scene.h"
+
+namespace
+{
+    // Size of the compared images.
+    const int DENOISE_WIDTH = 160;
+    const int DENOISE_HEIGHT = 90;
+
+    double secondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(
+               std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+void runDenoiseBenchmarks(BenchmarkRunner& runner)
+{
+    if (!runner.enabled("denoise/"))
+    {
+        return;
+    }
+
+    threadRandomStream() = RandomStream();
+    Scene scene(randomScene());
+    ThreadPool pool;
+
+    int referenceSamples = runner.quick() ? 256 : 1024;
+
+    Framebuffer reference(DENOISE_WIDTH, DENOISE_HEIGHT);
+    Camera referenceCamera = makeDemoCamera(DENOISE_WIDTH, DENOISE_HEIGHT,
+                                            referenceSamples);
+    referenceCamera.render(scene, reference);
+
+    for (int samplesPerPixel : {4, 8, 16, 32, 64})
+    {
+        Camera camera = makeDemoCamera(DENOISE_WIDTH, DENOISE_HEIGHT,
+                                       samplesPerPixel);
+        Framebuffer image(DENOISE_WIDTH, DENOISE_HEIGHT);
+        FeatureBuffer features;
+
+        camera.setThreadPool(&pool);
+        camera.setFeatureBuffer(&features);
+
+        auto start = std::chrono::steady_clock::now();
+        camera.render(scene, image);
+        double renderSeconds = secondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        Framebuffer denoised = denoise(image, features, DenoiseSettings(),
+                                       pool);
+        double denoiseSeconds = secondsSince(start);
+
+        BenchmarkResult result;
+        result.name = "denoise/" + std::to_string(samplesPerPixel);
+        result.iterations = 1;
+        result.seconds = denoiseSeconds;
+        result.metrics = {
+            {"samples_per_pixel", samplesPerPixel},
+            {"reference_samples_per_pixel", referenceSamples},
+            {"render_seconds", renderSeconds},
+            {"denoise_seconds", denoiseSeconds},
+            {"rmse", rootMeanSquareError(image, reference, false)},
+            {"denoised_rmse", rootMeanSquareError(denoised, reference,
+                                                  false)}
+        };
+
+        runner.record(result);
+    }
+}
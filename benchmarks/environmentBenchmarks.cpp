@@ -0,0 +1,158 @@
+#include "benchmark.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "Camera/camera.h"
+#include "Materials/materialData.h"
+#include "Render/framebuffer.h"
+#include "Render/threadPool.h"
+#include "Scene/environment.h"
+#include "Scene/scene.h"
+
+namespace
+{
+    // Size of the compared images.
+    const int ENVIRONMENT_WIDTH = 160;
+    const int ENVIRONMENT_HEIGHT = 90;
+
+    // Size of the environment map.
+    const int MAP_WIDTH = 512;
+    const int MAP_HEIGHT = 256;
+
+    // An outdoor environment: a blue sky over dark ground and a sun of
+    // 3x3 texels, 40 degrees above the horizon, that gives most of the
+    // light.
+    std::shared_ptr<const Environment> makeSunEnvironment()
+    {
+        Framebuffer image(MAP_WIDTH, MAP_HEIGHT);
+        int sunX = MAP_WIDTH * 3 / 8;
+        int sunY = MAP_HEIGHT * 5 / 18;
+
+        for (int y = 0; y < MAP_HEIGHT; ++y)
+        {
+            float height = 1.0f - 2.0f * (y + 0.5f) / MAP_HEIGHT;
+
+            for (int x = 0; x < MAP_WIDTH; ++x)
+            {
+                Color radiance = height > 0.0f ?
+                                 (1.0f - height) * Color(0.6f, 0.7f, 0.9f) +
+                                 height * Color(0.2f, 0.35f, 0.8f) :
+                                 Color(0.08f, 0.07f, 0.06f);
+
+                if (std::abs(x - sunX) <= 1 && std::abs(y - sunY) <= 1)
+                {
+                    radiance = Color(20000.0f, 18000.0f, 15000.0f);
+                }
+
+                image.addSamples(x, y, radiance, 1);
+            }
+        }
+
+        return std::make_shared<Environment>(image, 0.0f);
+    }
+
+    // The large spheres of the demo scene, all diffuse, in the sun.
+    Scene makeSunScene()
+    {
+        Scene scene;
+        scene.setEnvironment(makeSunEnvironment());
+
+        uint32_t ground = scene.addMaterial(
+                          MaterialData::diffuse(Color(0.5f, 0.5f, 0.5f)));
+        uint32_t gray = scene.addMaterial(
+                        MaterialData::diffuse(Color(0.7f, 0.7f, 0.7f)));
+        uint32_t brown = scene.addMaterial(
+                         MaterialData::diffuse(Color(0.4f, 0.2f, 0.1f)));
+        uint32_t blue = scene.addMaterial(
+                        MaterialData::diffuse(Color(0.1f, 0.2f, 0.5f)));
+
+        scene.addSphere(Point3(0.0f, -1000.0f, 0.0f), 1000.0f, ground);
+        scene.addSphere(Point3(0.0f, 1.0f, 0.0f), 1.0f, gray);
+        scene.addSphere(Point3(-4.0f, 1.0f, 0.0f), 1.0f, brown);
+        scene.addSphere(Point3(4.0f, 1.0f, 0.0f), 1.0f, blue);
+
+        scene.build();
+
+        return scene;
+    }
+
+    // Renders the scene through the camera of the demo image and returns
+    // the seconds taken.
+    double render(const Scene& scene, int samplesPerPixel, bool lightSampling,
+                  ThreadPool& pool, Framebuffer& image)
+    {
+        Camera camera = makeDemoCamera(ENVIRONMENT_WIDTH, ENVIRONMENT_HEIGHT,
+                                       samplesPerPixel);
+
+        camera.setLightSampling(lightSampling);
+        camera.setThreadPool(&pool);
+        image = Framebuffer(ENVIRONMENT_WIDTH, ENVIRONMENT_HEIGHT);
+
+        auto start = std::chrono::steady_clock::now();
+        camera.render(scene, image);
+
+        return std::chrono::duration<double>(
+               std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Records the error of image against the reference. The sun is out of
+    // view, so the linear values are compared.
+    void record(BenchmarkRunner& runner, const std::string& name,
+                int samplesPerPixel, int referenceSamples, double seconds,
+                const Framebuffer& image, const Framebuffer& reference)
+    {
+        double error = rootMeanSquareError(image, reference, false);
+
+        BenchmarkResult result;
+        result.name = name;
+        result.iterations = static_cast<uint64_t>(ENVIRONMENT_WIDTH) *
+                            ENVIRONMENT_HEIGHT * samplesPerPixel;
+        result.seconds = seconds;
+        result.metrics = {
+            {"samples_per_pixel", samplesPerPixel},
+            {"reference_samples_per_pixel", referenceSamples},
+            {"rmse", error},
+            // Inverse of the time needed to reach a given error.
+            {"efficiency", 1.0 / (error * error * seconds)}
+        };
+
+        runner.record(result);
+    }
+}
+
+void runEnvironmentBenchmarks(BenchmarkRunner& runner)
+{
+    if (!runner.enabled("environment/"))
+    {
+        return;
+    }
+
+    Scene scene = makeSunScene();
+    ThreadPool pool;
+
+    int referenceSamples = runner.quick() ? 256 : 2048;
+
+    Framebuffer reference;
+    render(scene, referenceSamples, true, pool, reference);
+
+    for (int samplesPerPixel : {4, 16, 64})
+    {
+        std::string prefix = "environment/" +
+                             std::to_string(samplesPerPixel);
+        Framebuffer image;
+
+        double seconds = render(scene, samplesPerPixel, true, pool, image);
+        record(runner, prefix + "/importance", samplesPerPixel,
+               referenceSamples, seconds, image, reference);
+
+        // Paths find the sun only when they scatter towards it.
+        double scatterSeconds = render(scene, samplesPerPixel, false, pool,
+                                       image);
+        record(runner, prefix + "/scatter_only", samplesPerPixel,
+               referenceSamples, scatterSeconds, image, reference);
+    }
+}
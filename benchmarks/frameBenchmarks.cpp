@@ -0,0 +1,171 @@
+#include "benchmark.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Camera/camera.h"
+#include "Math/color.h"
+#include "Math/random.h"
+#include "Render/framebuffer.h"
+#include "Render/wavefrontIntegrator.h"
+#include "Sampling/sampler.h"
+#include "Scene/randomScene.h"
+#include "Scene/scene.h"
+
+namespace
+{
+    struct FrameSettings
+    {
+        int width;
+        int height;
+        int samplesPerPixel;
+        IntegratorType integrator = IntegratorType::Path;
+        SamplerType sampler = SamplerType::Sobol;
+        int rouletteDepth = ROULETTE_MIN_DEPTH;
+    };
+
+    // The camera of the renderer's demo image with the given settings.
+    Camera makeCamera(const FrameSettings& settings)
+    {
+        Camera camera = makeDemoCamera(settings.width, settings.height,
+                                       settings.samplesPerPixel);
+
+        camera.setIntegrator(settings.integrator);
+        camera.setSampler(settings.sampler);
+        camera.setRouletteDepth(settings.rouletteDepth);
+
+        return camera;
+    }
+
+    // Renders one frame of the demo scene and records its throughput.
+    void runFrame(BenchmarkRunner& runner, const std::string& name,
+                  const Scene& scene, const FrameSettings& settings)
+    {
+        if (!runner.enabled(name))
+        {
+            return;
+        }
+
+        Camera camera = makeCamera(settings);
+        Framebuffer framebuffer(settings.width, settings.height);
+
+        auto start = std::chrono::steady_clock::now();
+        camera.render(scene, framebuffer);
+        double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start).count();
+
+        double samples = static_cast<double>(settings.width) *
+                         settings.height * settings.samplesPerPixel;
+        double rays = static_cast<double>(camera.raysTraced());
+
+        BenchmarkResult result;
+        result.name = name;
+        result.iterations = static_cast<uint64_t>(samples);
+        result.seconds = seconds;
+        result.metrics = {
+            {"width", settings.width},
+            {"height", settings.height},
+            {"samples_per_pixel", settings.samplesPerPixel},
+            {"rays", rays},
+            {"rays_per_second", rays / seconds},
+            {"samples_per_second", samples / seconds},
+            {"average_path_length", rays / samples}
+        };
+
+        runner.record(result);
+    }
+
+    // Error of every sampler against a high sample count reference, for
+    // equal-error comparisons between samplers.
+    void runConvergence(BenchmarkRunner& runner, const Scene& scene)
+    {
+        if (!runner.enabled("convergence/"))
+        {
+            return;
+        }
+
+        FrameSettings reference = {64, 36, runner.quick() ? 256 : 1024};
+        reference.sampler = SamplerType::Independent;
+
+        Framebuffer referenceImage(reference.width, reference.height);
+        makeCamera(reference).render(scene, referenceImage);
+
+        const std::pair<const char*, SamplerType> samplers[] = {
+            {"independent", SamplerType::Independent},
+            {"stratified", SamplerType::Stratified},
+            {"sobol", SamplerType::Sobol}
+        };
+
+        for (const auto& entry : samplers)
+        {
+            for (int samplesPerPixel : {4, 16, 64})
+            {
+                FrameSettings settings = reference;
+                settings.samplesPerPixel = samplesPerPixel;
+                settings.sampler = entry.second;
+
+                Camera camera = makeCamera(settings);
+                Framebuffer image(settings.width, settings.height);
+
+                auto start = std::chrono::steady_clock::now();
+                camera.render(scene, image);
+                double seconds = std::chrono::duration<double>(
+                                 std::chrono::steady_clock::now() -
+                                 start).count();
+
+                BenchmarkResult result;
+                result.name = std::string("convergence/") + entry.first +
+                              "/" + std::to_string(samplesPerPixel);
+                result.iterations = static_cast<uint64_t>(
+                                    settings.width * settings.height *
+                                    samplesPerPixel);
+                result.seconds = seconds;
+                result.metrics = {
+                    {"samples_per_pixel", samplesPerPixel},
+                    {"reference_samples_per_pixel",
+                     reference.samplesPerPixel},
+                    {"rmse", rootMeanSquareError(image, referenceImage,
+                                                     false)}
+                };
+
+                runner.record(result);
+            }
+        }
+    }
+}
+
+void runFrameBenchmarks(BenchmarkRunner& runner)
+{
+    threadRandomStream() = RandomStream();
+    Scene scene(randomScene());
+
+    int samplesPerPixel = runner.quick() ? 2 : 8;
+
+    std::vector<std::pair<int, int>> sizes = {{160, 90}, {400, 225}};
+
+    if (!runner.quick())
+    {
+        sizes.push_back({1200, 675});
+    }
+
+    for (const auto& size : sizes)
+    {
+        std::string prefix = "frame/" + std::to_string(size.first) + "x" +
+                             std::to_string(size.second);
+        FrameSettings settings = {size.first, size.second, samplesPerPixel};
+
+        runFrame(runner, prefix + "/path", scene, settings);
+
+        settings.integrator = IntegratorType::Wavefront;
+        runFrame(runner, prefix + "/wavefront", scene, settings);
+
+        // Before/after comparison for Russian roulette.
+        settings.integrator = IntegratorType::Path;
+        settings.rouletteDepth = DEMO_MAX_DEPTH;
+        runFrame(runner, prefix + "/no_roulette", scene, settings);
+    }
+
+    runConvergence(runner, scene);
+}
@@ -0,0 +1,180 @@
+#include "benchmark.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Geometry/triangleMesh.h"
+#include "Hittables/bvh.h"
+#include "Materials/materialData.h"
+#include "Math/interval.h"
+#include "Math/random.h"
+#include "Math/ray.h"
+#include "Math/transform.h"
+#include "Math/utilities.h"
+#include "Math/vector3.h"
+#include "Scene/scene.h"
+
+namespace
+{
+    const uint64_t INSTANCE_SEED = 11;
+
+    // Rays per hit benchmark iteration batch.
+    const int INSTANCE_RAY_COUNT = 4096;
+
+    // Builds a unit UV sphere of rings x segments quads (two triangles
+    // each), standing in for a tree or a character of a crowd.
+    std::shared_ptr<TriangleMesh> makeSphereMesh(uint32_t rings,
+                                                 uint32_t segments)
+    {
+        std::vector<Point3> vertices;
+        std::vector<uint32_t> indices;
+
+        for (uint32_t ring = 0; ring <= rings; ++ring)
+        {
+            float theta = PI * ring / rings;
+
+            for (uint32_t segment = 0; segment <= segments; ++segment)
+            {
+                float phi = 2.0f * PI * segment / segments;
+
+                vertices.push_back(Point3(std::sin(theta) * std::cos(phi),
+                                          std::cos(theta),
+                                          std::sin(theta) * std::sin(phi)));
+            }
+        }
+
+        for (uint32_t ring = 0; ring < rings; ++ring)
+        {
+            for (uint32_t segment = 0; segment < segments; ++segment)
+            {
+                uint32_t a = ring * (segments + 1) + segment;
+                uint32_t c = a + segments + 1;
+
+                indices.insert(indices.end(), {a, c, a + 1, a + 1, c, c + 1});
+            }
+        }
+
+        return std::make_shared<TriangleMesh>(std::move(vertices),
+                                              std::move(indices));
+    }
+
+    // Scatters count instances of mesh over a square field whose area
+    // grows with the count, with random headings and sizes.
+    void placeInstances(Scene& scene, uint32_t mesh, uint32_t count,
+                        float extent)
+    {
+        RandomStream rng(INSTANCE_SEED);
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            float scale = 0.5f + rng.nextFloat();
+            Vector3 position(extent * (2.0f * rng.nextFloat() - 1.0f), scale,
+                             extent * (2.0f * rng.nextFloat() - 1.0f));
+
+            Transform transform =
+                Transform::translation(position) *
+                Transform::rotation(1, 360.0f * rng.nextFloat()) *
+                Transform::scaling(Vector3(scale, 2.0f * scale, scale));
+
+            scene.addInstance(mesh, transform, 0);
+        }
+    }
+
+    // Rays from above the field, looking down at a slant.
+    std::vector<Ray> makeFieldRays(float extent)
+    {
+        RandomStream rng(INSTANCE_SEED + 1);
+        std::vector<Ray> rays;
+
+        for (int i = 0; i < INSTANCE_RAY_COUNT; ++i)
+        {
+            Point3 origin(extent * (2.0f * rng.nextFloat() - 1.0f), 10.0f,
+                          extent * (2.0f * rng.nextFloat() - 1.0f));
+            Vector3 direction(2.0f * rng.nextFloat() - 1.0f, -1.0f,
+                              2.0f * rng.nextFloat() - 1.0f);
+
+            rays.push_back(Ray(origin, direction));
+        }
+
+        return rays;
+    }
+}
+
+void runInstanceBenchmarks(BenchmarkRunner& runner)
+{
+    std::vector<uint32_t> counts = {1000, 10000};
+
+    if (!runner.quick())
+    {
+        counts.push_back(100000);
+    }
+
+    std::shared_ptr<TriangleMesh> mesh = makeSphereMesh(16, 32);
+
+    for (uint32_t count : counts)
+    {
+        std::string suffix = "/" + std::to_string(count);
+
+        if (!runner.enabled("instance_build" + suffix) &&
+            !runner.enabled("instance_hit" + suffix))
+        {
+            continue;
+        }
+
+        // Keep the density constant, about one instance per 4 square units.
+        float extent = std::sqrt(static_cast<float>(count));
+
+        Scene scene;
+        scene.addMaterial(MaterialData::diffuse(Color(0.5f, 0.5f, 0.5f)));
+        placeInstances(scene, scene.addMesh(mesh), count, extent);
+
+        auto start = std::chrono::steady_clock::now();
+        scene.build();
+        double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start).count();
+
+        // Memory of the two levels: the shared mesh once, and a transform
+        // plus top-level nodes per instance.
+        double meshBytes = mesh->vertices().size() * sizeof(Point3) +
+                           mesh->indices().size() * sizeof(uint32_t) +
+                           9.0 * sizeof(float) * mesh->triangleCount() +
+                           mesh->tree().nodes().size() * sizeof(BVHNode);
+        double instanceBytes = count * sizeof(MeshInstance) +
+                               scene.instanceTree().nodes().size() *
+                               sizeof(BVHNode);
+
+        if (runner.enabled("instance_build" + suffix))
+        {
+            BenchmarkResult result;
+            result.name = "instance_build" + suffix;
+            result.iterations = 1;
+            result.seconds = seconds;
+            result.metrics = {
+                {"instanced_triangles",
+                 static_cast<double>(count) * mesh->triangleCount()},
+                {"mesh_bytes", meshBytes},
+                {"instance_bytes", instanceBytes},
+                {"bytes_per_instance", instanceBytes / count}
+            };
+
+            runner.record(result);
+        }
+
+        std::vector<Ray> rays = makeFieldRays(extent);
+
+        runner.run("instance_hit" + suffix, [&](uint64_t iterations)
+                   {
+                       for (uint64_t i = 0; i < iterations; ++i)
+                       {
+                           HitRecord rec;
+                           bool hit = scene.hit(rays[i % INSTANCE_RAY_COUNT],
+                                                Interval(0.001f, INF), rec);
+                           doNotOptimize(hit);
+                       }
+                   });
+    }
+}
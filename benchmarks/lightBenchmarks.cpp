@@ -0,0 +1,150 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <string>
+
+#include "Camera/camera.h"
+#include "Materials/materialData.h"
+#include "Render/framebuffer.h"
+#include "Render/threadPool.h"
+#include "Scene/scene.h"
+
+namespace
+{
+    // Size of the compared images.
+    const int LIGHT_WIDTH = 160;
+    const int LIGHT_HEIGHT = 90;
+
+    // The large spheres of the demo scene at night, lit by four small lamps
+    // (as scenes/smallLights.scene).
+    Scene makeLampScene()
+    {
+        Scene scene;
+        scene.setSkyIntensity(0.02f);
+
+        uint32_t ground = scene.addMaterial(
+                          MaterialData::diffuse(Color(0.5f, 0.5f, 0.5f)));
+        uint32_t glass = scene.addMaterial(MaterialData::glass(1.5f));
+        uint32_t brown = scene.addMaterial(
+                         MaterialData::diffuse(Color(0.4f, 0.2f, 0.1f)));
+        uint32_t mirror = scene.addMaterial(
+                          MaterialData::metal(Color(0.7f, 0.6f, 0.5f), 0.0f));
+        uint32_t warm = scene.addMaterial(
+                        MaterialData::emissive(Color(150.0f, 100.0f, 50.0f)));
+        uint32_t cool = scene.addMaterial(
+                        MaterialData::emissive(Color(20.0f, 40.0f, 100.0f)));
+
+        scene.addSphere(Point3(0.0f, -1000.0f, 0.0f), 1000.0f, ground);
+        scene.addSphere(Point3(0.0f, 1.0f, 0.0f), 1.0f, glass);
+        scene.addSphere(Point3(-4.0f, 1.0f, 0.0f), 1.0f, brown);
+        scene.addSphere(Point3(4.0f, 1.0f, 0.0f), 1.0f, mirror);
+
+        scene.addSphere(Point3(-2.0f, 2.2f, 1.0f), 0.1f, warm);
+        scene.addSphere(Point3(2.0f, 2.4f, -0.5f), 0.1f, warm);
+        scene.addSphere(Point3(1.5f, 0.2f, 2.5f), 0.2f, cool);
+        scene.addSphere(Point3(-1.0f, 3.0f, -2.0f), 0.15f, cool);
+
+        scene.build();
+
+        return scene;
+    }
+
+    // The camera of the renderer's demo image.
+    Camera makeCamera(int samplesPerPixel, bool lightSampling,
+                      ThreadPool& pool)
+    {
+        Camera camera = makeDemoCamera(LIGHT_WIDTH, LIGHT_HEIGHT,
+                                       samplesPerPixel);
+
+        camera.setLightSampling(lightSampling);
+        camera.setThreadPool(&pool);
+
+        return camera;
+    }
+
+    // Renders the scene and returns the seconds taken.
+    double render(const Scene& scene, int samplesPerPixel, bool lightSampling,
+                  ThreadPool& pool, Framebuffer& image)
+    {
+        Camera camera = makeCamera(samplesPerPixel, lightSampling, pool);
+        image = Framebuffer(LIGHT_WIDTH, LIGHT_HEIGHT);
+
+        auto start = std::chrono::steady_clock::now();
+        camera.render(scene, image);
+
+        return std::chrono::duration<double>(
+               std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Records the error of image against the reference, clamped to the
+    // displayed range: the lamps seen directly are a hundred times brighter
+    // than anything they light, so the noise of their antialiased edges
+    // would otherwise hide that of the lighting.
+    void record(BenchmarkRunner& runner, const std::string& name,
+                int samplesPerPixel, int referenceSamples, double seconds,
+                const Framebuffer& image, const Framebuffer& reference)
+    {
+        double error = rootMeanSquareError(image, reference, true);
+
+        BenchmarkResult result;
+        result.name = name;
+        result.iterations = static_cast<uint64_t>(LIGHT_WIDTH) *
+                            LIGHT_HEIGHT * samplesPerPixel;
+        result.seconds = seconds;
+        result.metrics = {
+            {"samples_per_pixel", samplesPerPixel},
+            {"reference_samples_per_pixel", referenceSamples},
+            {"rmse", error},
+            // Inverse of the time needed to reach a given error.
+            {"efficiency", 1.0 / (error * error * seconds)}
+        };
+
+        runner.record(result);
+    }
+}
+
+void runLightBenchmarks(BenchmarkRunner& runner)
+{
+    if (!runner.enabled("lights/"))
+    {
+        return;
+    }
+
+    Scene scene = makeLampScene();
+    ThreadPool pool;
+
+    int referenceSamples = runner.quick() ? 256 : 2048;
+
+    Framebuffer reference;
+    render(scene, referenceSamples, true, pool, reference);
+
+    for (int samplesPerPixel : {4, 16, 64})
+    {
+        std::string prefix = "lights/" + std::to_string(samplesPerPixel);
+        Framebuffer image;
+
+        double seconds = render(scene, samplesPerPixel, true, pool, image);
+        record(runner, prefix + "/mis", samplesPerPixel, referenceSamples,
+               seconds, image, reference);
+
+        double scatterSeconds = render(scene, samplesPerPixel, false, pool,
+                                       image);
+        record(runner, prefix + "/scatter_only", samplesPerPixel,
+               referenceSamples, scatterSeconds, image, reference);
+
+        // Paths that only scatter are cheaper; give them the time that
+        // light sampling took.
+        int equalTimeSamples = std::max(1, static_cast<int>(
+                               std::lround(samplesPerPixel * seconds /
+                                           scatterSeconds)));
+
+        double equalTimeSeconds = render(scene, equalTimeSamples, false,
+                                         pool, image);
+        record(runner, prefix + "/scatter_only_equal_time",
+               equalTimeSamples, referenceSamples, equalTimeSeconds, image,
+               reference);
+    }
+}
@@ -0,0 +1,88 @@
+/*
+ * Benchmark suite of the renderer. Runs the micro, frame, scene loading,
+ * mesh, instancing, motion blur, animation, denoising, light sampling,
+ * environment sampling and vector backend benchmarks and writes the results
+ * as JSON to stdout or to a file.
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "benchmark.h"
+
+// Prints the supported command line options.
+void printUsage(const char* program)
+{
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --output PATH   Writes the JSON report to PATH "
+                 "(default: stdout)\n"
+              << "  --filter TEXT   Runs only benchmarks whose name "
+                 "contains TEXT\n"
+              << "  --quick         Shorter timings and smaller problem "
+                 "sizes\n";
+}
+
+int main(int argc, char* argv[])
+{
+    std::string outputPath;
+    std::string filter;
+    bool quick = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string option = argv[i];
+
+        if (option == "--quick")
+        {
+            quick = true;
+        }
+        else if (option == "--output" && i + 1 < argc)
+        {
+            outputPath = argv[++i];
+        }
+        else if (option == "--filter" && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+        else
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    BenchmarkRunner runner(filter, quick);
+
+    runMicroBenchmarks(runner);
+    runFrameBenchmarks(runner);
+    runSceneFileBenchmarks(runner);
+    runMeshBenchmarks(runner);
+    runInstanceBenchmarks(runner);
+    runMotionBenchmarks(runner);
+    runAnimationBenchmarks(runner);
+    runDenoiseBenchmarks(runner);
+    runLightBenchmarks(runner);
+    runEnvironmentBenchmarks(runner);
+    runVectorBenchmarks(runner);
+
+    if (outputPath.empty())
+    {
+        runner.writeJson(std::cout);
+
+        return 0;
+    }
+
+    std::ofstream out(outputPath);
+
+    if (!out)
+    {
+        std::cerr << "Could not open " << outputPath << " for writing.\n";
+        return 1;
+    }
+
+    runner.writeJson(out);
+
+    return out ? 0 : 1;
+}
@@ -0,0 +1,168 @@
+#include "benchmark.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Geometry/sphereKernels.h"
+#include "Geometry/triangleMesh.h"
+#include "Math/interval.h"
+#include "Math/random.h"
+#include "Math/ray.h"
+#include "Math/vector3.h"
+#include "Scene/objLoader.h"
+
+namespace
+{
+    const uint64_t MESH_SEED = 7;
+
+    // Rays per hit benchmark iteration batch.
+    const int MESH_RAY_COUNT = 4096;
+
+    // Writes a rolling terrain of resolution x resolution quads (two
+    // triangles each) as an OBJ file.
+    bool writeTerrain(const std::string& path, uint32_t resolution)
+    {
+        std::ofstream out(path);
+        char line[96];
+
+        for (uint32_t z = 0; z <= resolution; ++z)
+        {
+            for (uint32_t x = 0; x <= resolution; ++x)
+            {
+                float u = static_cast<float>(x) / resolution;
+                float v = static_cast<float>(z) / resolution;
+                float height = 0.05f * std::sin(40.0f * u) *
+                               std::cos(30.0f * v);
+
+                std::snprintf(line, sizeof(line), "v %.6f %.6f %.6f\n",
+                              2.0f * u - 1.0f, height, 2.0f * v - 1.0f);
+                out << line;
+            }
+        }
+
+        for (uint32_t z = 0; z < resolution; ++z)
+        {
+            for (uint32_t x = 0; x < resolution; ++x)
+            {
+                // OBJ indices start at 1.
+                uint32_t a = z * (resolution + 1) + x + 1;
+                uint32_t c = a + resolution + 1;
+
+                std::snprintf(line, sizeof(line), "f %u %u %u\nf %u %u %u\n",
+                              a, a + 1, c + 1, a, c + 1, c);
+                out << line;
+            }
+        }
+
+        return static_cast<bool>(out.flush());
+    }
+
+    // Rays from above the terrain in random directions that mostly hit it.
+    std::vector<Ray> makeTerrainRays()
+    {
+        RandomStream rng(MESH_SEED);
+        std::vector<Ray> rays;
+
+        for (int i = 0; i < MESH_RAY_COUNT; ++i)
+        {
+            Point3 origin(2.0f * rng.nextFloat() - 1.0f, 1.0f,
+                          2.0f * rng.nextFloat() - 1.0f);
+            Vector3 direction(rng.nextFloat() - 0.5f, -1.0f,
+                              rng.nextFloat() - 0.5f);
+
+            rays.push_back(Ray(origin, direction));
+        }
+
+        return rays;
+    }
+}
+
+void runMeshBenchmarks(BenchmarkRunner& runner)
+{
+    std::vector<uint32_t> resolutions = {100, 300};
+
+    if (!runner.quick())
+    {
+        resolutions.push_back(1000);
+    }
+
+    std::vector<Ray> rays = makeTerrainRays();
+
+    for (uint32_t resolution : resolutions)
+    {
+        std::string suffix = "/" + std::to_string(2 * resolution *
+                                                  resolution);
+
+        if (!runner.enabled("obj_load" + suffix) &&
+            !runner.enabled("mesh_build" + suffix) &&
+            !runner.enabled("mesh_hit" + suffix))
+        {
+            continue;
+        }
+
+        std::string path = "raytracer_bench" + suffix.substr(1) + ".obj";
+        std::vector<Point3> vertices;
+        std::vector<uint32_t> indices;
+
+        if (!writeTerrain(path, resolution) ||
+            !loadObj(path, vertices, indices))
+        {
+            std::remove(path.c_str());
+
+            continue;
+        }
+
+        runner.run("obj_load" + suffix, [&](uint64_t iterations)
+                   {
+                       for (uint64_t i = 0; i < iterations; ++i)
+                       {
+                           std::vector<Point3> loadedVertices;
+                           std::vector<uint32_t> loadedIndices;
+                           loadObj(path, loadedVertices, loadedIndices);
+                           doNotOptimize(loadedIndices);
+                       }
+                   });
+
+        std::remove(path.c_str());
+
+        // Includes copying the input arrays, which the mesh takes over.
+        runner.run("mesh_build" + suffix, [&](uint64_t iterations)
+                   {
+                       for (uint64_t i = 0; i < iterations; ++i)
+                       {
+                           TriangleMesh mesh(vertices, indices);
+                           doNotOptimize(mesh);
+                       }
+                   });
+
+        TriangleMesh mesh(vertices, indices);
+
+        for (SphereKernel kernel : {SphereKernel::Scalar, SphereKernel::SSE,
+                                    SphereKernel::AVX2})
+        {
+            if (!mesh.setKernel(kernel))
+            {
+                continue;
+            }
+
+            runner.run("mesh_hit" + suffix + "/" + sphereKernelName(kernel),
+                       [&](uint64_t iterations)
+                       {
+                           for (uint64_t i = 0; i < iterations; ++i)
+                           {
+                               uint32_t triangle;
+                               float t;
+                               bool hit = mesh.intersect(
+                                              rays[i % MESH_RAY_COUNT],
+                                              Interval(0.001f, INF),
+                                              triangle, t);
+                               doNotOptimize(hit);
+                           }
+                       });
+        }
+    }
+}
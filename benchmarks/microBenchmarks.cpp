@@ -0,0 +1,454 @@
+#include "benchmark.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Geometry/sphere.h"
+#include "Geometry/sphereKernels.h"
+#include "Hittables/bvh.h"
+#include "Hittables/hittable.h"
+#include "Hittables/hittableList.h"
+#include "Materials/diffuse.h"
+#include "Materials/glass.h"
+#include "Materials/material.h"
+#include "Materials/materialData.h"
+#include "Materials/metal.h"
+#include "Math/random.h"
+#include "Math/ray.h"
+#include "Math/utilities.h"
+#include "Math/vector3.h"
+#include "Sampling/sampler.h"
+#include "Sampling/warp.h"
+#include "Scene/randomScene.h"
+#include "Scene/scene.h"
+
+namespace
+{
+    // Number of precomputed rays the intersection benchmarks cycle through.
+    const uint32_t RAY_COUNT = 4096;
+
+    // Seed of every random input, so all versions see the same data.
+    const uint64_t BENCHMARK_SEED = 2024;
+
+    Vector3 randomVector(RandomStream& rng, float min, float max)
+    {
+        return Vector3(min + (max - min) * rng.nextFloat(),
+                       min + (max - min) * rng.nextFloat(),
+                       min + (max - min) * rng.nextFloat());
+    }
+
+    // Rays starting anywhere within originExtent of the origin and aimed at
+    // points within targetExtent of it.
+    std::vector<Ray> makeRays(uint64_t seed, float originExtent,
+                              float targetExtent)
+    {
+        RandomStream rng(seed);
+        std::vector<Ray> rays;
+        rays.reserve(RAY_COUNT);
+
+        for (uint32_t i = 0; i < RAY_COUNT; ++i)
+        {
+            Point3 origin = randomVector(rng, -originExtent, originExtent);
+            Point3 target = randomVector(rng, -targetExtent, targetExtent);
+
+            rays.push_back(Ray(origin, target - origin, rng.nextFloat()));
+        }
+
+        return rays;
+    }
+
+    // Rays from the demo camera position into the demo scene.
+    std::vector<Ray> makeSceneRays(uint64_t seed)
+    {
+        RandomStream rng(seed);
+        std::vector<Ray> rays;
+        rays.reserve(RAY_COUNT);
+
+        Point3 lookFrom(13.0f, 2.0f, 3.0f);
+
+        for (uint32_t i = 0; i < RAY_COUNT; ++i)
+        {
+            Point3 target(-12.0f + 24.0f * rng.nextFloat(),
+                          -1.0f + 4.0f * rng.nextFloat(),
+                          -12.0f + 24.0f * rng.nextFloat());
+
+            rays.push_back(Ray(lookFrom, target - lookFrom, rng.nextFloat()));
+        }
+
+        return rays;
+    }
+
+    // A list of count spheres scattered through a cube whose density does
+    // not depend on count.
+    HittableList makeSphereCloud(uint32_t count, uint64_t seed)
+    {
+        RandomStream rng(seed);
+        HittableList list;
+        auto material = std::make_shared<Diffuse>(Color(0.5f, 0.5f, 0.5f));
+
+        float extent = 10.0f * std::cbrt(static_cast<float>(count));
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            Point3 center = randomVector(rng, -extent, extent);
+            float radius = 0.5f + 1.5f * rng.nextFloat();
+
+            list.add(std::make_shared<Sphere>(center, radius, material));
+        }
+
+        return list;
+    }
+
+    // Times one hit query per operation against any Hittable.
+    void runHitBenchmark(BenchmarkRunner& runner, const std::string& name,
+                         const Hittable& hittable,
+                         const std::vector<Ray>& rays)
+    {
+        runner.run(name, [&](uint64_t iterations)
+                   {
+                       HitRecord rec;
+
+                       for (uint64_t i = 0; i < iterations; ++i)
+                       {
+                           bool hit = hittable.hit(rays[i % RAY_COUNT],
+                                                   Interval(0.001f, INF),
+                                                   rec);
+                           doNotOptimize(hit);
+                       }
+                   });
+    }
+
+    void runSceneHitBenchmark(BenchmarkRunner& runner,
+                              const std::string& name, const Scene& scene,
+                              const std::vector<Ray>& rays)
+    {
+        runner.run(name, [&](uint64_t iterations)
+                   {
+                       HitRecord rec;
+
+                       for (uint64_t i = 0; i < iterations; ++i)
+                       {
+                           bool hit = scene.hit(rays[i % RAY_COUNT],
+                                                Interval(0.001f, INF), rec);
+                           doNotOptimize(hit);
+                       }
+                   });
+    }
+
+    void runSphereBenchmarks(BenchmarkRunner& runner)
+    {
+        auto material = std::make_shared<Diffuse>(Color(0.5f, 0.5f, 0.5f));
+        Sphere stationary(Point3(0.0f, 0.0f, 0.0f), 1.0f, material);
+        Sphere moving(Point3(0.0f, 0.0f, 0.0f), Point3(0.0f, 0.5f, 0.0f),
+                      1.0f, material);
+
+        // About half of the rays hit the sphere.
+        std::vector<Ray> rays = makeRays(BENCHMARK_SEED, 5.0f, 1.5f);
+
+        runHitBenchmark(runner, "sphere_hit/stationary", stationary, rays);
+        runHitBenchmark(runner, "sphere_hit/moving", moving, rays);
+
+        // One leaf of eight spheres per call, as the SphereSet issues it.
+        SphereSoA spheres;
+        spheres.resize(8);
+
+        for (uint32_t i = 0; i < 8; ++i)
+        {
+            spheres.centerX[i] = -1.75f + 0.5f * i;
+            spheres.radius[i] = 0.3f;
+        }
+
+        for (SphereKernel kernel : {SphereKernel::Scalar, SphereKernel::SSE,
+                                    SphereKernel::AVX2})
+        {
+            if (!isSphereKernelSupported(kernel))
+            {
+                continue;
+            }
+
+            SphereKernelFunction intersect = sphereKernelFunction(kernel);
+
+            runner.run(std::string("sphere_kernel/") +
+                       sphereKernelName(kernel),
+                       [&](uint64_t iterations)
+                       {
+                           for (uint64_t i = 0; i < iterations; ++i)
+                           {
+                               float t;
+                               int hit = intersect(spheres, 0, 8,
+                                                   rays[i % RAY_COUNT],
+                                                   0.001f, INF, t);
+                               doNotOptimize(hit);
+                           }
+                       });
+        }
+    }
+
+    void runSceneBenchmarks(BenchmarkRunner& runner)
+    {
+        threadRandomStream() = RandomStream();
+        HittableList world = randomScene();
+        std::vector<Ray> rays = makeSceneRays(BENCHMARK_SEED);
+
+        runHitBenchmark(runner, "hittable_list_hit/random_scene", world,
+                        rays);
+
+        BVH bvh(world);
+        runHitBenchmark(runner, "bvh_hit/random_scene", bvh, rays);
+
+        Scene scene(world);
+
+        for (SphereKernel kernel : {SphereKernel::Scalar, SphereKernel::SSE,
+                                    SphereKernel::AVX2})
+        {
+            if (scene.spheres().setKernel(kernel))
+            {
+                runSceneHitBenchmark(runner,
+                                     std::string("scene_hit/random_scene/") +
+                                     sphereKernelName(kernel), scene, rays);
+            }
+        }
+    }
+
+    // Build and query cost of the acceleration structures as the number of
+    // spheres grows.
+    void runScalingBenchmarks(BenchmarkRunner& runner)
+    {
+        std::vector<uint32_t> counts = {500, 5000, 50000};
+
+        if (!runner.quick())
+        {
+            counts.push_back(500000);
+            counts.push_back(1000000);
+        }
+
+        for (uint32_t count : counts)
+        {
+            std::string suffix = "/" + std::to_string(count);
+
+            if (!runner.enabled("bvh_build" + suffix) &&
+                !runner.enabled("bvh_hit" + suffix) &&
+                !runner.enabled("scene_hit" + suffix) &&
+                !runner.enabled("hittable_list_hit" + suffix))
+            {
+                continue;
+            }
+
+            HittableList list = makeSphereCloud(count, BENCHMARK_SEED);
+            float extent = 10.0f * std::cbrt(static_cast<float>(count));
+            std::vector<Ray> rays = makeRays(BENCHMARK_SEED + 1, extent,
+                                             extent);
+
+            runner.run("bvh_build" + suffix, [&](uint64_t iterations)
+                       {
+                           for (uint64_t i = 0; i < iterations; ++i)
+                           {
+                               BVH bvh(list);
+                               doNotOptimize(bvh);
+                           }
+                       });
+
+            BVH bvh(list);
+            runHitBenchmark(runner, "bvh_hit" + suffix, bvh, rays);
+
+            Scene scene(list);
+            runSceneHitBenchmark(runner, "scene_hit" + suffix, scene, rays);
+
+            // The linear scan is only timed where it finishes in reasonable
+            // time.
+            if (count <= 5000)
+            {
+                runHitBenchmark(runner, "hittable_list_hit" + suffix, list,
+                                rays);
+            }
+        }
+    }
+
+    void runRandomBenchmarks(BenchmarkRunner& runner)
+    {
+        threadRandomStream() = RandomStream(BENCHMARK_SEED);
+
+        runner.run("rand_unit_sphere_vector", [](uint64_t iterations)
+                   {
+                       for (uint64_t i = 0; i < iterations; ++i)
+                       {
+                           Vector3 v = randUnitSphereVector();
+                           doNotOptimize(v);
+                       }
+                   });
+
+        runner.run("random_in_unit_disk", [](uint64_t iterations)
+                   {
+                       for (uint64_t i = 0; i < iterations; ++i)
+                       {
+                           Vector3 v = randomInUnitDisk();
+                           doNotOptimize(v);
+                       }
+                   });
+
+        // The warps that replaced the rejection samplers in the renderer.
+        runner.run("sample_uniform_sphere", [](uint64_t iterations)
+                   {
+                       RandomStream& rng = threadRandomStream();
+
+                       for (uint64_t i = 0; i < iterations; ++i)
+                       {
+                           Point2 u{rng.nextFloat(), rng.nextFloat()};
+                           Vector3 v = sampleUniformSphere(u);
+                           doNotOptimize(v);
+                       }
+                   });
+
+        runner.run("sample_uniform_disk_concentric", [](uint64_t iterations)
+                   {
+                       RandomStream& rng = threadRandomStream();
+
+                       for (uint64_t i = 0; i < iterations; ++i)
+                       {
+                           Point2 u{rng.nextFloat(), rng.nextFloat()};
+                           Vector3 v = sampleUniformDiskConcentric(u);
+                           doNotOptimize(v);
+                       }
+                   });
+
+        runner.run("sample_cosine_hemisphere", [](uint64_t iterations)
+                   {
+                       RandomStream& rng = threadRandomStream();
+
+                       for (uint64_t i = 0; i < iterations; ++i)
+                       {
+                           Point2 u{rng.nextFloat(), rng.nextFloat()};
+                           Vector3 v = sampleCosineHemisphere(u);
+                           doNotOptimize(v);
+                       }
+                   });
+    }
+
+    void runSamplerBenchmarks(BenchmarkRunner& runner)
+    {
+        const std::pair<const char*, SamplerType> samplers[] = {
+            {"independent", SamplerType::Independent},
+            {"stratified", SamplerType::Stratified},
+            {"sobol", SamplerType::Sobol}
+        };
+
+        for (const auto& entry : samplers)
+        {
+            std::unique_ptr<Sampler> sampler = makeSampler(entry.second, 64);
+
+            // One camera sample plus one bounce worth of dimensions.
+            runner.run(std::string("sampler/") + entry.first,
+                       [&](uint64_t iterations)
+                       {
+                           for (uint64_t i = 0; i < iterations; ++i)
+                           {
+                               sampler->startPixelSample(
+                                   static_cast<uint32_t>(i >> 6),
+                                   static_cast<uint32_t>(i & 63));
+                               Point2 pixel = sampler->getPixel2D();
+                               Point2 lens = sampler->get2D();
+                               sampler->startBounce(0);
+                               Point2 direction = sampler->get2D();
+                               doNotOptimize(pixel);
+                               doNotOptimize(lens);
+                               doNotOptimize(direction);
+                           }
+                       });
+        }
+    }
+
+    void runMaterialBenchmarks(BenchmarkRunner& runner)
+    {
+        const std::pair<const char*, std::shared_ptr<Material>> materials[] = {
+            {"diffuse", std::make_shared<Diffuse>(Color(0.5f, 0.5f, 0.5f))},
+            {"metal", std::make_shared<Metal>(Color(0.7f, 0.6f, 0.5f), 0.2f)},
+            {"mirror", std::make_shared<Metal>(Color(0.7f, 0.6f, 0.5f), 0.0f)},
+            {"glass", std::make_shared<Glass>(1.5f)}
+        };
+
+        // Hits on the upper half of a unit sphere, seen from above.
+        std::vector<Ray> rays;
+        std::vector<HitRecord> records;
+        RandomStream rng(BENCHMARK_SEED);
+
+        for (uint32_t i = 0; i < RAY_COUNT; ++i)
+        {
+            Vector3 normal = unitVector(Vector3(rng.nextFloat() - 0.5f, 1.0f,
+                                                rng.nextFloat() - 0.5f));
+            Ray r(Point3(0.0f, 3.0f, 0.0f), normal - Point3(0.0f, 3.0f, 0.0f),
+                  0.0f);
+
+            HitRecord rec;
+            rec.t = 1.0f;
+            rec.p = normal;
+            rec.setFaceNormal(r, normal);
+
+            rays.push_back(r);
+            records.push_back(rec);
+        }
+
+        std::unique_ptr<Sampler> sampler = makeSampler(
+                                               SamplerType::Independent, 1);
+
+        for (const auto& entry : materials)
+        {
+            const Material& material = *entry.second;
+
+            // Through the virtual Material interface...
+            runner.run(std::string("material_scatter/") + entry.first,
+                       [&](uint64_t iterations)
+                       {
+                           Color attenuation;
+                           Ray scattered;
+
+                           for (uint64_t i = 0; i < iterations; ++i)
+                           {
+                               uint32_t index = i % RAY_COUNT;
+                               sampler->startPixelSample(index, 0);
+                               sampler->startBounce(0);
+
+                               bool wasScattered = material.scatter(
+                                   rays[index], records[index], attenuation,
+                                   scattered, *sampler);
+                               doNotOptimize(wasScattered);
+                               doNotOptimize(scattered);
+                           }
+                       });
+
+            // ...and through the material table used while rendering.
+            const MaterialData& data = material.data();
+
+            runner.run(std::string("material_table_scatter/") + entry.first,
+                       [&](uint64_t iterations)
+                       {
+                           Color attenuation;
+                           Ray scattered;
+
+                           for (uint64_t i = 0; i < iterations; ++i)
+                           {
+                               uint32_t index = i % RAY_COUNT;
+                               sampler->startPixelSample(index, 0);
+                               sampler->startBounce(0);
+
+                               bool wasScattered = scatter(
+                                   data, rays[index], records[index],
+                                   attenuation, scattered, *sampler);
+                               doNotOptimize(wasScattered);
+                               doNotOptimize(scattered);
+                           }
+                       });
+        }
+    }
+}
+
+void runMicroBenchmarks(BenchmarkRunner& runner)
+{
+    runSphereBenchmarks(runner);
+    runSceneBenchmarks(runner);
+    runScalingBenchmarks(runner);
+    runRandomBenchmarks(runner);
+    runSamplerBenchmarks(runner);
+    runMaterialBenchmarks(runner);
+}
@@ -0,0 +1,133 @@
+#include "benchmark.h"
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Geometry/sphereSet.h"
+#include "Math/interval.h"
+#include "Math/random.h"
+#include "Math/ray.h"
+#include "Math/utilities.h"
+#include "Math/vector3.h"
+
+namespace
+{
+    const uint64_t MOTION_SEED = 17;
+
+    // Rays per hit benchmark iteration batch.
+    const int MOTION_RAY_COUNT = 4096;
+
+    // Distance over which the direction of motion changes, and how far the
+    // direction of a single sphere strays from that of its neighbours.
+    const float MOTION_FLOW_SCALE = 40.0f;
+    const float MOTION_JITTER = 0.3f;
+
+    // Returns a random direction of the given length.
+    Vector3 randomDirection(RandomStream& rng, float length)
+    {
+        while (true)
+        {
+            Vector3 v(2.0f * rng.nextFloat() - 1.0f,
+                      2.0f * rng.nextFloat() - 1.0f,
+                      2.0f * rng.nextFloat() - 1.0f);
+            float squaredLength = v.magnitudeSquared();
+
+            if (squaredLength > 1e-4f && squaredLength <= 1.0f)
+            {
+                return (length / std::sqrt(squaredLength)) * v;
+            }
+        }
+    }
+
+    // Fills set with count spheres (radii 0.5 to 2) spread through a cube of
+    // the given half extent. Each moves by motionLength over the shutter
+    // interval along a smoothly varying flow with some jitter, so nearby
+    // spheres move alike, as in a crowd, a flock or debris of an explosion.
+    void addMovingSpheres(SphereSet& set, uint32_t count, float extent,
+                          float motionLength)
+    {
+        RandomStream rng(MOTION_SEED);
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            Point3 center(extent * (2.0f * rng.nextFloat() - 1.0f),
+                          extent * (2.0f * rng.nextFloat() - 1.0f),
+                          extent * (2.0f * rng.nextFloat() - 1.0f));
+            float radius = 0.5f + 1.5f * rng.nextFloat();
+
+            Vector3 flow(std::sin(center.y() / MOTION_FLOW_SCALE),
+                         std::cos(center.z() / MOTION_FLOW_SCALE),
+                         std::sin(center.x() / MOTION_FLOW_SCALE));
+            Vector3 motion = flow + randomDirection(rng, MOTION_JITTER);
+
+            set.add(center, (motionLength / motion.magnitude()) * motion,
+                    radius, 0);
+        }
+    }
+
+    // Rays through the cube at random shutter times.
+    std::vector<Ray> makeMotionRays(float extent)
+    {
+        RandomStream rng(MOTION_SEED + 1);
+        std::vector<Ray> rays;
+
+        for (int i = 0; i < MOTION_RAY_COUNT; ++i)
+        {
+            Point3 origin(extent * (2.0f * rng.nextFloat() - 1.0f),
+                          extent * (2.0f * rng.nextFloat() - 1.0f),
+                          extent * (2.0f * rng.nextFloat() - 1.0f));
+
+            rays.push_back(Ray(origin, randomDirection(rng, 1.0f),
+                               rng.nextFloat()));
+        }
+
+        return rays;
+    }
+}
+
+void runMotionBenchmarks(BenchmarkRunner& runner)
+{
+    uint32_t count = runner.quick() ? 20000 : 200000;
+    float extent = 10.0f * std::cbrt(static_cast<float>(count));
+    std::vector<Ray> rays = makeMotionRays(extent);
+
+    // Motion lengths from none to many times the sphere size.
+    for (float motionLength : {0.0f, 1.0f, 4.0f, 16.0f, 64.0f})
+    {
+        std::string prefix = "motion_hit/" + std::to_string(count) + "/" +
+                             std::to_string(static_cast<int>(motionLength));
+
+        // Swept bounds (one box per node over the whole interval) against
+        // node bounds interpolated by ray time.
+        for (bool motionBounds : {false, true})
+        {
+            std::string name = prefix +
+                               (motionBounds ? "/interpolated" : "/swept");
+
+            if (!runner.enabled(name))
+            {
+                continue;
+            }
+
+            SphereSet set;
+            addMovingSpheres(set, count, extent, motionLength);
+            set.build(motionBounds);
+
+            runner.run(name, [&](uint64_t iterations)
+                       {
+                           for (uint64_t i = 0; i < iterations; ++i)
+                           {
+                               uint32_t sphere;
+                               float t;
+                               bool hit = set.intersect(
+                                              rays[i % MOTION_RAY_COUNT],
+                                              Interval(0.001f, INF), sphere,
+                                              t);
+                               doNotOptimize(hit);
+                           }
+                       });
+        }
+    }
+}
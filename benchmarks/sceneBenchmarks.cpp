@@ -0,0 +1,118 @@
+#include "benchmark.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Math/random.h"
+#include "Scene/scene.h"
+#include "Scene/sceneFile.h"
+
+namespace
+{
+    // Seed of the generated scenes, so all versions load the same files.
+    const uint64_t SCENE_SEED = 2024;
+
+    // Writes a text scene of count small spheres spread over a box, every
+    // fourth one moving.
+    bool writeSphereScene(const std::string& path, uint32_t count)
+    {
+        std::ofstream out(path);
+        RandomStream rng(SCENE_SEED);
+
+        out << "material gray diffuse 0.5 0.5 0.5\n"
+               "material steel metal 0.7 0.6 0.5 0.1\n"
+               "material glass glass 1.5\n";
+
+        const char* materials[3] = {"gray", "steel", "glass"};
+        char line[160];
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            float x = -100.0f + 200.0f * rng.nextFloat();
+            float y = 20.0f * rng.nextFloat();
+            float z = -100.0f + 200.0f * rng.nextFloat();
+
+            if (i % 4 == 0)
+            {
+                std::snprintf(line, sizeof(line),
+                              "sphere %.4f %.4f %.4f %.4f %.4f %.4f 0.05 %s\n",
+                              x, y, z, x, y + 0.1f, z, materials[i % 3]);
+            }
+            else
+            {
+                std::snprintf(line, sizeof(line),
+                              "sphere %.4f %.4f %.4f 0.05 %s\n", x, y, z,
+                              materials[i % 3]);
+            }
+
+            out << line;
+        }
+
+        return static_cast<bool>(out.flush());
+    }
+}
+
+void runSceneFileBenchmarks(BenchmarkRunner& runner)
+{
+    std::vector<uint32_t> counts = {10000, 100000};
+
+    if (!runner.quick())
+    {
+        counts.push_back(1000000);
+    }
+
+    for (uint32_t count : counts)
+    {
+        std::string suffix = "/" + std::to_string(count);
+
+        if (!runner.enabled("scene_load/text" + suffix) &&
+            !runner.enabled("scene_load/cache" + suffix))
+        {
+            continue;
+        }
+
+        std::string textPath = "raytracer_bench" + suffix.substr(1) +
+                               ".scene";
+        std::string cachePath = textPath + ".cache";
+
+        Scene scene;
+        SceneSettings settings;
+
+        if (!writeSphereScene(textPath, count) ||
+            !loadScene(textPath, scene, settings) ||
+            !saveSceneCache(scene, settings, cachePath))
+        {
+            std::remove(textPath.c_str());
+            std::remove(cachePath.c_str());
+
+            continue;
+        }
+
+        // Text loads include the BVH build; cache loads skip both.
+        runner.run("scene_load/text" + suffix, [&](uint64_t iterations)
+                   {
+                       for (uint64_t i = 0; i < iterations; ++i)
+                       {
+                           Scene loaded;
+                           loadScene(textPath, loaded, settings);
+                           doNotOptimize(loaded);
+                       }
+                   });
+
+        runner.run("scene_load/cache" + suffix, [&](uint64_t iterations)
+                   {
+                       for (uint64_t i = 0; i < iterations; ++i)
+                       {
+                           Scene loaded;
+                           loadScene(cachePath, loaded, settings);
+                           doNotOptimize(loaded);
+                       }
+                   });
+
+        std::remove(textPath.c_str());
+        std::remove(cachePath.c_str());
+    }
+}
@@ -0,0 +1,137 @@
+#include "benchmark.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Camera/camera.h"
+#include "Math/random.h"
+#include "Math/vector3.h"
+#include "Render/framebuffer.h"
+#include "Scene/randomScene.h"
+#include "Scene/scene.h"
+
+namespace
+{
+    // Number of precomputed vectors the operation benchmarks cycle through.
+    const uint32_t VECTOR_COUNT = 4096;
+
+    // Seed of every random input, so both backends see the same data.
+    const uint64_t BENCHMARK_SEED = 2024;
+
+    std::vector<Vector3> makeVectors(RandomStream& rng)
+    {
+        std::vector<Vector3> vectors;
+        vectors.reserve(VECTOR_COUNT);
+
+        for (uint32_t i = 0; i < VECTOR_COUNT; ++i)
+        {
+            vectors.push_back(Vector3(2.0f * rng.nextFloat() - 1.0f,
+                                      2.0f * rng.nextFloat() - 1.0f,
+                                      2.0f * rng.nextFloat() - 1.0f));
+        }
+
+        return vectors;
+    }
+
+    void runOperations(BenchmarkRunner& runner, const std::string& prefix)
+    {
+        RandomStream rng(BENCHMARK_SEED);
+        std::vector<Vector3> a = makeVectors(rng);
+        std::vector<Vector3> b = makeVectors(rng);
+
+        runner.run(prefix + "/dot", [&](uint64_t iterations)
+                   {
+                       for (uint64_t i = 0; i < iterations; ++i)
+                       {
+                           uint32_t index = i % VECTOR_COUNT;
+                           float d = dot(a[index], b[index]);
+                           doNotOptimize(d);
+                       }
+                   });
+
+        runner.run(prefix + "/cross", [&](uint64_t iterations)
+                   {
+                       for (uint64_t i = 0; i < iterations; ++i)
+                       {
+                           uint32_t index = i % VECTOR_COUNT;
+                           Vector3 c = cross(a[index], b[index]);
+                           doNotOptimize(c);
+                       }
+                   });
+
+        runner.run(prefix + "/normalize", [&](uint64_t iterations)
+                   {
+                       for (uint64_t i = 0; i < iterations; ++i)
+                       {
+                           Vector3 u = unitVector(a[i % VECTOR_COUNT]);
+                           doNotOptimize(u);
+                       }
+                   });
+
+        // A chain as the integrators write it: a shading frame from a
+        // normal and a direction, and a reflection within it.
+        runner.run(prefix + "/frame_reflect", [&](uint64_t iterations)
+                   {
+                       for (uint64_t i = 0; i < iterations; ++i)
+                       {
+                           uint32_t index = i % VECTOR_COUNT;
+                           Vector3 n = unitVector(a[index]);
+                           Vector3 t = unitVector(cross(n, b[index]));
+                           Vector3 r = reflect(b[index], n) + 0.5f * t;
+                           doNotOptimize(r);
+                       }
+                   });
+    }
+
+    // Renders the demo scene and records its throughput, the number the
+    // backend is meant to improve.
+    void runFrame(BenchmarkRunner& runner, const std::string& name)
+    {
+        if (!runner.enabled(name))
+        {
+            return;
+        }
+
+        threadRandomStream() = RandomStream();
+        Scene scene(randomScene());
+
+        int width = 400;
+        int height = 225;
+        int samplesPerPixel = runner.quick() ? 2 : 8;
+
+        Camera camera = makeDemoCamera(width, height, samplesPerPixel);
+        Framebuffer framebuffer(width, height);
+
+        auto start = std::chrono::steady_clock::now();
+        camera.render(scene, framebuffer);
+        double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start).count();
+
+        double samples = static_cast<double>(width) * height *
+                         samplesPerPixel;
+        double rays = static_cast<double>(camera.raysTraced());
+
+        BenchmarkResult result;
+        result.name = name;
+        result.iterations = static_cast<uint64_t>(samples);
+        result.seconds = seconds;
+        result.metrics = {
+            {"samples_per_pixel", samplesPerPixel},
+            {"rays_per_second", rays / seconds},
+            {"vector_bytes", static_cast<double>(sizeof(Vector3))}
+        };
+
+        runner.record(result);
+    }
+}
+
+void runVectorBenchmarks(BenchmarkRunner& runner)
+{
+    // Names carry the backend so reports of both builds can be merged.
+    std::string prefix = std::string("vector/") + VECTOR3_BACKEND;
+
+    runOperations(runner, prefix);
+    runFrame(runner, prefix + "/frame");
+}
@@ -1,10 +1,21 @@
 #include "camera.h"
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <cmath>
+#include <memory>
+#include <mutex>
 
-#include "../Math/Color.h"
-#include "../Hittables/hittable.h"
+#include "../Math/color.h"
+#include "../Math/hash.h"
+#include "../Scene/scene.h"
+#include "../Render/stats.h"
+#include "../Render/threadPool.h"
+#include "../Render/tiles.h"
+#include "../Render/wavefrontIntegrator.h"
+#include "../Sampling/sampler.h"
+#include "../Sampling/warp.h"
 
 Camera::Camera(int imageWidth, int imageHeight, int samplesPerPixel,
                int maxDepth, float aspectRatio, float verticalFOV,
@@ -21,6 +32,24 @@ Camera::Camera(int imageWidth, int imageHeight, int samplesPerPixel,
                m_viewportWidth(m_viewportHeight *
                               (static_cast<float>(m_imageWidth) /
                                m_imageHeight))
+{
+    updateView();
+
+    m_window.x0 = 0;
+    m_window.y0 = 0;
+    m_window.x1 = m_imageWidth;
+    m_window.y1 = m_imageHeight;
+}
+
+void Camera::setView(const Point3& lookFrom, const Point3& lookAt)
+{
+    m_lookFrom = lookFrom;
+    m_lookAt = lookAt;
+
+    updateView();
+}
+
+void Camera::updateView()
 {
     m_w = unitVector(m_lookFrom - m_lookAt);
     m_u = unitVector(cross(m_upVector, m_w));
@@ -43,58 +72,428 @@ Camera::Camera(int imageWidth, int imageHeight, int samplesPerPixel,
     m_originPixel = viewportUpperLeft + 0.5f * (m_pixelDeltaU + m_pixelDeltaV);
 }
 
-void Camera::render(const Hittable& world) const
+void Camera::render(const Scene& world, Framebuffer& framebuffer) const
 {
-    // Output PPM header.
-    std::cout << "P3\n" << m_imageWidth << ' ' << m_imageHeight << "\n255\n";
+    renderTiles(world, framebuffer, m_samplesPerPixel, m_adaptive.enabled);
+
+    // Inform the user that the image is finished rendering.
+    std::clog << "\rDone.                             \n";
+}
+
+void Camera::renderPass(const Scene& world, Framebuffer& framebuffer,
+                        int passSamples) const
+{
+    renderTiles(world, framebuffer, passSamples, false);
+}
+
+void Camera::renderTiles(const Scene& world, Framebuffer& framebuffer,
+                         int sampleCount, bool adaptive) const
+{
+    std::vector<Tile> tiles = makeTiles(m_window.width(), m_window.height(),
+                                        m_tileSize);
+
+    for (Tile& tile : tiles)
+    {
+        tile.x0 += m_window.x0;
+        tile.y0 += m_window.y0;
+        tile.x1 += m_window.x0;
+        tile.y1 += m_window.y0;
+    }
+
+    if (framebuffer.width() != m_window.width() ||
+        framebuffer.height() != m_window.height())
+    {
+        framebuffer = Framebuffer(m_window.width(), m_window.height());
+    }
+
+    if (m_features && (m_features->width() != m_window.width() ||
+                       m_features->height() != m_window.height()))
+    {
+        *m_features = FeatureBuffer(m_window.width(), m_window.height());
+    }
+
+    // Tiles left to render, counted down and logged under logMutex so the
+    // counts are printed in order.
+    int remainingTiles = static_cast<int>(tiles.size());
+    std::atomic<uint64_t> raysTraced(0);
+    std::mutex logMutex;
+
+    RT_STATS_TIMER(timer, StatsPhase::Render);
+    std::unique_ptr<ThreadPool> ownPool;
+    ThreadPool* pool = m_threadPool;
+
+    if (!pool)
+    {
+        ownPool.reset(new ThreadPool(m_threadCount));
+        pool = ownPool.get();
+    }
+
+    pool->parallelFor(static_cast<uint32_t>(tiles.size()),
+                     [&](uint32_t index, int)
+                     {
+                         raysTraced += renderTile(world, tiles[index],
+                                                  framebuffer, sampleCount,
+                                                  adaptive);
+
+                         // Log the remaining tiles to render.
+                         std::lock_guard<std::mutex> lock(logMutex);
+
+                         std::clog << "\rRemaining tiles to render: "
+                                   << --remainingTiles << ' ' << std::flush;
+                     });
+
+    m_raysTraced = raysTraced;
+    RT_STATS_ADD(phaseRays[static_cast<int>(StatsPhase::Render)],
+                 m_raysTraced);
+}
+
+uint64_t Camera::renderTile(const Scene& world, const Tile& tile,
+                            Framebuffer& framebuffer, int sampleCount,
+                            bool adaptive) const
+{
+    // Accumulate into a buffer owned by this thread so that workers never
+    // write to the same cache lines while rendering.
+    Framebuffer tileBuffer(tile.width(), tile.height());
+
+    int maxSamples = adaptive ? m_adaptive.maxSamples : m_samplesPerPixel;
+    std::unique_ptr<Sampler> sampler = makeSampler(m_samplerType, maxSamples);
+    uint64_t raysTraced = 0;
+
+    if (m_integrator == IntegratorType::Wavefront)
+    {
+        raysTraced = renderTileWavefront(world, tile, framebuffer, tileBuffer,
+                                         *sampler, sampleCount, adaptive);
+    }
+    else
+    {
+        for (int i = tile.y0; i < tile.y1; ++i)
+        {
+            for (int j = tile.x0; j < tile.x1; ++j)
+            {
+                // Continue the pixel's sample sequence where earlier passes
+                // (or a resumed checkpoint) left off, so no sample repeats.
+                int firstSample = m_sampleOffset + static_cast<int>(
+                                  framebuffer.sampleCount(j - m_window.x0,
+                                                          i - m_window.y0));
+
+                Color pixelColor(0.0f, 0.0f, 0.0f);
+                int samplesTaken = 0;
+
+                if (!adaptive)
+                {
+                    pixelColor = samplePixel(world, *sampler, i, j,
+                                             firstSample, sampleCount,
+                                             nullptr, raysTraced);
+                    samplesTaken = sampleCount;
+                }
+                else
+                {
+                    // Add batches of samples until the pixel's error
+                    // estimate drops below the threshold or the budget is
+                    // spent.
+                    PixelVarianceEstimator estimator;
+                    int batchSize = std::max(1, m_adaptive.minSamples);
+
+                    while (samplesTaken < maxSamples)
+                    {
+                        int count = std::min(batchSize,
+                                             maxSamples - samplesTaken);
+
+                        pixelColor += samplePixel(world, *sampler, i, j,
+                                                  firstSample + samplesTaken,
+                                                  count, &estimator,
+                                                  raysTraced);
+                        samplesTaken += count;
+
+                        if (estimator.displayError() <
+                            m_adaptive.errorThreshold)
+                        {
+                            break;
+                        }
+                    }
+                }
+
+                tileBuffer.addSamples(j - tile.x0, i - tile.y0,
+                                      pixelColor,
+                                      static_cast<uint32_t>(samplesTaken));
+            }
+        }
+    }
+
+    if (m_features)
+    {
+        renderTileFeatures(world, tile, framebuffer, tileBuffer, *sampler);
+    }
+
+    // Tiles never overlap, so no synchronization is needed.
+    for (int i = tile.y0; i < tile.y1; ++i)
+    {
+        for (int j = tile.x0; j < tile.x1; ++j)
+        {
+            framebuffer.addSamples(j - m_window.x0, i - m_window.y0,
+                                   tileBuffer.sampleSum(j - tile.x0,
+                                                        i - tile.y0),
+                                   tileBuffer.sampleCount(j - tile.x0,
+                                                          i - tile.y0));
+        }
+    }
+
+    // Make this tile's counters visible to the thread collecting them.
+    RT_STATS_FLUSH();
+
+    return raysTraced;
+}
+
+uint64_t Camera::renderTileWavefront(const Scene& world, const Tile& tile,
+                                     const Framebuffer& framebuffer,
+                                     Framebuffer& tileBuffer,
+                                     Sampler& sampler, int sampleCount,
+                                     bool adaptive) const
+{
+    struct PixelState
+    {
+        int i, j;
+        int firstSample;
+        int samplesTaken;
+        Color sum;
+        PixelVarianceEstimator estimator;
+    };
+
+    int maxSamples = adaptive ? m_adaptive.maxSamples : sampleCount;
 
-    for (int i = 0; i < m_imageHeight; ++i)
+    // Adaptive rounds match the batches of renderTile so pixels converge
+    // after the same samples; otherwise rounds only bound the batch size.
+    int pixelCount = tile.width() * tile.height();
+    int roundSamples = adaptive ? std::max(1, m_adaptive.minSamples) :
+                       std::max(1, WAVEFRONT_BATCH_SIZE / pixelCount);
+
+    std::vector<PixelState> pixels;
+    pixels.reserve(pixelCount);
+
+    for (int i = tile.y0; i < tile.y1; ++i)
     {
-        // Log the remaining lines to render.
-        std::clog << "\rRemaining lines to render: " << (m_imageHeight - i)
-                  << ' ' << std::flush;
+        for (int j = tile.x0; j < tile.x1; ++j)
+        {
+            PixelState pixel;
+            pixel.i = i;
+            pixel.j = j;
+            pixel.firstSample = m_sampleOffset + static_cast<int>(
+                                framebuffer.sampleCount(j - m_window.x0,
+                                                        i - m_window.y0));
+            pixel.samplesTaken = 0;
+            pixel.sum = Color(0.0f, 0.0f, 0.0f);
+            pixels.push_back(pixel);
+        }
+    }
+
+    std::vector<uint32_t> active(pixels.size());
+
+    for (size_t p = 0; p < pixels.size(); ++p)
+    {
+        active[p] = static_cast<uint32_t>(p);
+    }
+
+    WavefrontIntegrator integrator(m_maxDepth, m_rouletteDepth,
+                                   m_lightSampling);
+    uint64_t raysTraced = 0;
+
+    while (!active.empty())
+    {
+        integrator.clear();
+
+        for (uint32_t p : active)
+        {
+            const PixelState& pixel = pixels[p];
+            uint32_t pixelIndex = static_cast<uint32_t>(pixel.i *
+                                                        m_imageWidth +
+                                                        pixel.j);
+            int count = std::min(roundSamples,
+                                 maxSamples - pixel.samplesTaken);
+
+            for (int k = 0; k < count; ++k)
+            {
+                uint32_t sample = static_cast<uint32_t>(pixel.firstSample +
+                                                        pixel.samplesTaken +
+                                                        k);
+
+                sampler.startPixelSample(pixelIndex, sample);
+                integrator.addPath(getRay(pixel.j, pixel.i, sampler),
+                                   pixelIndex, sample);
+            }
+        }
+
+        const std::vector<Color>& colors = integrator.trace(world, sampler);
+        raysTraced += integrator.raysTraced();
 
-        for (int j = 0; j < m_imageWidth; ++j)
+        // Sum the samples of every pixel in sample order, as samplePixel
+        // does, so the result matches the path integrator bit for bit.
+        size_t path = 0;
+        std::vector<uint32_t> stillActive;
+
+        for (uint32_t p : active)
         {
-            Color pixelColor(0.0f, 0.0f, 0.0f);
+            PixelState& pixel = pixels[p];
+            int count = std::min(roundSamples,
+                                 maxSamples - pixel.samplesTaken);
+            Color batchSum(0.0f, 0.0f, 0.0f);
 
-            for (int sample = 0; sample < m_samplesPerPixel; ++sample)
+            for (int k = 0; k < count; ++k)
             {
-                Ray r = getRay(j, i);
-                pixelColor += rayColor(r, m_maxDepth, world);
+                const Color& sampleColor = colors[path++];
+
+                if (adaptive)
+                {
+                    pixel.estimator.add(luminance(sampleColor));
+                    batchSum += sampleColor;
+                }
+                else
+                {
+                    pixel.sum += sampleColor;
+                }
             }
 
-            // Output final color pixel.
-            writeColor(std::cout, pixelColor, m_samplesPerPixel, true);
+            if (adaptive)
+            {
+                pixel.sum += batchSum;
+            }
+
+            pixel.samplesTaken += count;
+
+            bool converged = adaptive && pixel.estimator.displayError() <
+                                         m_adaptive.errorThreshold;
+
+            if (pixel.samplesTaken < maxSamples && !converged)
+            {
+                stillActive.push_back(p);
+            }
         }
+
+        active.swap(stillActive);
     }
 
-    // Inform the user that the PPM file is finished rendering.
-    std::clog << "\rDone.\n";
+    for (const PixelState& pixel : pixels)
+    {
+        tileBuffer.addSamples(pixel.j - tile.x0, pixel.i - tile.y0, pixel.sum,
+                              static_cast<uint32_t>(pixel.samplesTaken));
+    }
+
+    return raysTraced;
 }
 
-Ray Camera::getRay(int i, int j) const
+void Camera::renderTileFeatures(const Scene& world, const Tile& tile,
+                                const Framebuffer& framebuffer,
+                                const Framebuffer& tileBuffer,
+                                Sampler& sampler) const
+{
+    for (int i = tile.y0; i < tile.y1; ++i)
+    {
+        for (int j = tile.x0; j < tile.x1; ++j)
+        {
+            uint32_t pixelIndex = static_cast<uint32_t>(i * m_imageWidth +
+                                                        j);
+            int firstSample = m_sampleOffset + static_cast<int>(
+                              framebuffer.sampleCount(j - m_window.x0,
+                                                      i - m_window.y0));
+            int count = std::min(FEATURE_SAMPLES, static_cast<int>(
+                                 tileBuffer.sampleCount(j - tile.x0,
+                                                        i - tile.y0)));
+
+            Color albedo(0.0f, 0.0f, 0.0f);
+            Vector3 normal(0.0f, 0.0f, 0.0f);
+            float depth = 0.0f;
+
+            for (int sample = firstSample; sample < firstSample + count;
+                 ++sample)
+            {
+                // Regenerate the sample's primary ray.
+                sampler.startPixelSample(pixelIndex,
+                                         static_cast<uint32_t>(sample));
+
+                Ray r = getRay(j, i, sampler);
+                HitRecord rec;
+
+                if (!world.hit(r, Interval(0.001f, INF), rec))
+                {
+                    albedo += world.background(r);
+                    continue;
+                }
+
+                // Glass passes all light on, and lights are taken as white
+                // surfaces so their color survives the denoiser.
+                bool white = rec.material->type == MaterialType::Glass ||
+                             rec.material->type == MaterialType::Emissive;
+                albedo += white ? Color(1.0f, 1.0f, 1.0f) :
+                                  rec.material->albedo;
+                normal += rec.normal;
+                depth += rec.t * r.direction().magnitude();
+            }
+
+            m_features->addSamples(j - m_window.x0, i - m_window.y0, albedo,
+                                   normal, depth,
+                                   static_cast<uint32_t>(count));
+        }
+    }
+}
+
+Color Camera::samplePixel(const Scene& world, Sampler& sampler, int i,
+                          int j, int firstSample, int sampleCount,
+                          PixelVarianceEstimator* estimator,
+                          uint64_t& raysTraced) const
+{
+    uint32_t pixelIndex = static_cast<uint32_t>(i * m_imageWidth + j);
+    Color pixelColor(0.0f, 0.0f, 0.0f);
+
+    for (int sample = firstSample; sample < firstSample + sampleCount;
+         ++sample)
+    {
+        // Sample values only depend on the pixel and sample index, so the
+        // result does not depend on which thread renders the pixel or in
+        // which order.
+        sampler.startPixelSample(pixelIndex, static_cast<uint32_t>(sample));
+
+        Ray r = getRay(j, i, sampler);
+        int pathLength;
+        Color sampleColor = rayColor(r, m_maxDepth, world, sampler,
+                                     m_rouletteDepth, m_lightSampling,
+                                     &pathLength);
+        raysTraced += static_cast<uint64_t>(pathLength);
+
+        if (estimator)
+        {
+            estimator->add(luminance(sampleColor));
+        }
+
+        pixelColor += sampleColor;
+    }
+
+    return pixelColor;
+}
+
+Ray Camera::getRay(int i, int j, Sampler& sampler) const
 {
     Vector3 pixelCenter = m_originPixel + (static_cast<float>(i) *
                                            m_pixelDeltaU)
                                         + (static_cast<float>(j) *
                                            m_pixelDeltaV);
 
-    Vector3 pixelSample = pixelCenter + pixelSampleSquare();
+    Vector3 pixelSample = pixelCenter +
+                          pixelSampleSquare(sampler.getPixel2D());
+
+    // Always consume the lens dimensions so the time dimension stays put.
+    Point2 lensSample = sampler.get2D();
     Vector3 rayOrigin = (m_defocusAngle <= 0.0f) ? m_lookFrom :
-                                                   defocusDiskSample();
+                                                   defocusDiskSample(lensSample);
     Vector3 rayDirection = pixelSample - rayOrigin;
 
-    float rayTime = randomFloat();
+    float rayTime = sampler.get1D();
 
     return Ray(rayOrigin, rayDirection, rayTime);
 }
 
-Vector3 Camera::pixelSampleSquare() const
+Vector3 Camera::pixelSampleSquare(const Point2& u) const
 {
-    
-    float xCoordinate = randomFloat() - 0.5f;
-    float yCoordinate = randomFloat() - 0.5f;
+    float xCoordinate = u.x - 0.5f;
+    float yCoordinate = u.y - 0.5f;
 
     return (xCoordinate * m_pixelDeltaU) + (yCoordinate * m_pixelDeltaV);
 }
@@ -107,9 +506,9 @@ Vector3 Camera::pixelSampleDisk(float radius) const
     return (pixel[0] * m_pixelDeltaU) + (pixel[1] * m_pixelDeltaV);
 }
 
-Point3 Camera::defocusDiskSample() const
+Point3 Camera::defocusDiskSample(const Point2& u) const
 {
-    Vector3 pixel = randomInUnitDisk();
+    Vector3 pixel = sampleUniformDiskConcentric(u);
 
     // Horizontal radius of the defocus disk.
     Vector3 defocusDiskU;
@@ -126,3 +525,27 @@ Point3 Camera::defocusDiskSample() const
 
     return m_lookFrom + (pixel[0] * defocusDiskU) + (pixel[1] * defocusDiskV);
 }
+
+uint64_t Camera::settingsHash(bool withSampleCount) const
+{
+    bool sampleCountMatters = withSampleCount ||
+                              m_samplerType == SamplerType::Stratified;
+
+    int32_t integers[] = {
+        m_imageWidth, m_imageHeight,
+        sampleCountMatters ? m_samplesPerPixel : 0, m_maxDepth,
+        m_rouletteDepth, m_lightSampling ? 1 : 0,
+        static_cast<int32_t>(m_samplerType), m_adaptive.enabled ? 1 : 0,
+        m_adaptive.minSamples, m_adaptive.maxSamples
+    };
+    float floats[] = {
+        m_verticalFOV, m_defocusAngle, m_focusDistance,
+        m_adaptive.errorThreshold,
+        m_lookFrom.x(), m_lookFrom.y(), m_lookFrom.z(),
+        m_lookAt.x(), m_lookAt.y(), m_lookAt.z(),
+        m_upVector.x(), m_upVector.y(), m_upVector.z()
+    };
+
+    return contentHash(floats, sizeof(floats),
+                       contentHash(integers, sizeof(integers)));
+}
@@ -5,8 +5,24 @@
 
 #pragma once
 
+#include <cstdint>
+#include <vector>
+
 #include "../Math/vector3.h"
-#include "../Hittables/hittable.h"
+#include "../Math/color.h"
+#include "../Scene/scene.h"
+#include "../Render/adaptiveSampling.h"
+#include "../Render/featureBuffer.h"
+#include "../Render/framebuffer.h"
+#include "../Render/threadPool.h"
+#include "../Render/tiles.h"
+#include "../Render/wavefrontIntegrator.h"
+#include "../Sampling/sampler.h"
+#include "../Math/point2.h"
+
+// Most primary rays per pixel and render (or pass) whose first hit is
+// recorded as features. Features converge long before the image does.
+const int FEATURE_SAMPLES = 16;
 
 class Camera
 {
@@ -17,10 +33,102 @@ public:
            float focusDistance, Point3 lookFrom, Point3 lookAt,
            Vector3 upVector);
 
-    // Outputs all of the image's RGB values for each pixel to std::cout
-    // (a PPM file) and continuously displays the number of lines left to
-    // render in the console.
-    void render(const Hittable& world) const;
+    // Renders the image in tiles on a pool of worker threads into a linear
+    // float framebuffer, continuously displaying the number of tiles left
+    // to render in the console. The image is identical for any thread count
+    // or tile size.
+    void render(const Scene& world, Framebuffer& framebuffer) const;
+
+    // Adds passSamples samples to every pixel of the framebuffer. Each
+    // pixel continues its sample sequence after the samples it already
+    // holds, so passes (even across a checkpoint and resume) add up to the
+    // same estimate as a single render.
+    void renderPass(const Scene& world, Framebuffer& framebuffer,
+                    int passSamples) const;
+
+    int imageWidth() const { return m_imageWidth; }
+    int imageHeight() const { return m_imageHeight; }
+
+    int samplesPerPixel() const { return m_samplesPerPixel; }
+
+    // Moves the camera to lookFrom, looking at lookAt. The field of view,
+    // focus distance and up vector are kept.
+    void setView(const Point3& lookFrom, const Point3& lookAt);
+
+    void setSamplesPerPixel(int samplesPerPixel)
+    {
+        m_samplesPerPixel = samplesPerPixel;
+    }
+
+    // Restricts render and renderPass to the pixels of window, which must
+    // lie within the image (the whole image by default). The framebuffer
+    // then holds only the window, its top-left pixel at (0, 0), and every
+    // pixel gets the same samples as in a render of the whole image.
+    void setWindow(const Tile& window) { m_window = window; }
+
+    // Sets the index of the first sample every pixel takes, on top of the
+    // samples the framebuffer already holds. Renders of consecutive sample
+    // ranges then take the samples of one longer render.
+    void setSampleOffset(int sampleOffset) { m_sampleOffset = sampleOffset; }
+
+    // Makes render and renderPass also record the albedo, normal and depth
+    // of the first hit of up to FEATURE_SAMPLES primary rays per pixel in
+    // features, which covers the same pixels as the framebuffer (null
+    // disables them). The rays are those of the pixel's first samples, so
+    // the features line up with the image.
+    void setFeatureBuffer(FeatureBuffer* features) { m_features = features; }
+
+    // Returns the number of rays traced by the last render or pass.
+    uint64_t raysTraced() const { return m_raysTraced; }
+
+    // Sets the number of render threads (0 selects the hardware
+    // concurrency).
+    void setThreadCount(int threadCount) { m_threadCount = threadCount; }
+
+    // Renders on the threads of pool instead of starting threads for every
+    // render or pass, which dominates small renders (null restores the
+    // default). The pool must outlive the renders.
+    void setThreadPool(ThreadPool* pool) { m_threadPool = pool; }
+
+    // Sets the edge length, in pixels, of the square render tiles.
+    void setTileSize(int tileSize) { m_tileSize = tileSize; }
+
+    // Selects how sample values are distributed across a pixel.
+    void setSampler(SamplerType samplerType) { m_samplerType = samplerType; }
+
+    // Selects whether samples are traced one path at a time or in
+    // wavefront batches. Both produce the same image.
+    void setIntegrator(IntegratorType integrator)
+    {
+        m_integrator = integrator;
+    }
+
+    // Sets the number of bounces after which Russian roulette may end a
+    // path (a value of at least the maximum depth disables it).
+    void setRouletteDepth(int rouletteDepth)
+    {
+        m_rouletteDepth = rouletteDepth;
+    }
+
+    // Enables or disables sampling the scene's lights with shadow rays
+    // (enabled by default). Without it, paths only find lights by chance.
+    void setLightSampling(bool enabled) { m_lightSampling = enabled; }
+
+    // Enables or disables adaptive sampling. While enabled, every pixel
+    // takes between settings.minSamples and settings.maxSamples samples
+    // instead of exactly samplesPerPixel.
+    void setAdaptiveSampling(const AdaptiveSettings& settings)
+    {
+        m_adaptive = settings;
+    }
+
+    // Hash of every setting the samples of a pixel depend on, so sample
+    // sums can only be added to those of the same render. The thread
+    // count, tile size and integrator leave the image unchanged and are
+    // left out. Without withSampleCount the samples per pixel are left out
+    // too, so a checkpoint can be resumed with a higher target, unless the
+    // stratified sampler sizes its strata by them.
+    uint64_t settingsHash(bool withSampleCount = true) const;
 
 private:
     // Rendered image width in pixels.
@@ -35,6 +143,42 @@ private:
     // Maximum number of bounces per Ray into the scene.
     int m_maxDepth;
 
+    // Bounces before Russian roulette starts terminating paths.
+    int m_rouletteDepth = ROULETTE_MIN_DEPTH;
+
+    // Whether or not paths sample lights with shadow rays.
+    bool m_lightSampling = true;
+
+    // Number of render threads (0 = hardware concurrency).
+    int m_threadCount = 0;
+
+    // First-hit features recorded along with the image, if any.
+    FeatureBuffer* m_features = nullptr;
+
+    // Shared render threads, or null to start them for every render.
+    ThreadPool* m_threadPool = nullptr;
+
+    // Edge length of the square render tiles in pixels.
+    int m_tileSize = 32;
+
+    // Pixels covered by the framebuffer.
+    Tile m_window;
+
+    // Index of the first sample of every pixel.
+    int m_sampleOffset = 0;
+
+    // Rays traced by the last render or pass.
+    mutable uint64_t m_raysTraced = 0;
+
+    // Integrator tracing the samples.
+    IntegratorType m_integrator = IntegratorType::Path;
+
+    // Sampler used for the pixel, lens, time and bounce dimensions.
+    SamplerType m_samplerType = SamplerType::Sobol;
+
+    // Per-pixel convergence criteria of adaptive sampling.
+    AdaptiveSettings m_adaptive;
+
     // Ratio = Image width : Image height.
     float m_aspectRatio;
 
@@ -76,17 +220,57 @@ private:
     // Relative up direction of the camera.
     Vector3 m_upVector;
 
-    // Generates a random point in the square [-0.5, 1.0) surrounding a pixel
-    // at the origin.
-    Vector3 pixelSampleSquare() const;
+    // Maps a sample to a point in the square [-0.5, 0.5) surrounding a
+    // pixel at the origin.
+    Vector3 pixelSampleSquare(const Point2& u) const;
 
-    // Generates a random point within the camera defocus disk.
-    Point3 defocusDiskSample() const;
+    // Computes the camera basis and the pixel grid from the view.
+    void updateView();
+
+    // Maps a sample to a point within the camera defocus disk.
+    Point3 defocusDiskSample(const Point2& u) const;
 
     // Generates a random point in the disk of the specified radius around a
     // pixel at the origin.
     Vector3 pixelSampleDisk(float radius) const;
 
-    // Retrieves the ray at the specified (i, j) position.
-    Ray getRay(int i, int j) const;
+    // Retrieves the ray at the specified (i, j) position for the sampler's
+    // current pixel sample.
+    Ray getRay(int i, int j, Sampler& sampler) const;
+
+    // Adds sampleCount samples (or, if adaptive, as many as the pixel needs
+    // to converge) to every pixel of the framebuffer, rendering the tiles in
+    // parallel.
+    void renderTiles(const Scene& world, Framebuffer& framebuffer,
+                     int sampleCount, bool adaptive) const;
+
+    // Renders every pixel of the tile into a tile-local buffer and adds
+    // the result to the framebuffer. Returns the number of rays traced.
+    uint64_t renderTile(const Scene& world, const Tile& tile,
+                        Framebuffer& framebuffer, int sampleCount,
+                        bool adaptive) const;
+
+    // Wavefront counterpart of the pixel loop in renderTile: traces the
+    // samples of all pixels of the tile in batches and adds them to the
+    // tile buffer. Returns the number of rays traced.
+    uint64_t renderTileWavefront(const Scene& world, const Tile& tile,
+                                 const Framebuffer& framebuffer,
+                                 Framebuffer& tileBuffer, Sampler& sampler,
+                                 int sampleCount, bool adaptive) const;
+
+    // Records the first-hit features of the primary rays of the samples the
+    // tile buffer holds, which start at the samples the framebuffer held.
+    void renderTileFeatures(const Scene& world, const Tile& tile,
+                            const Framebuffer& framebuffer,
+                            const Framebuffer& tileBuffer,
+                            Sampler& sampler) const;
+
+    // Traces samples [firstSample, firstSample + sampleCount) of the pixel
+    // at (i, j) and returns the sum of their colors. The luminance of every
+    // sample is also fed to the estimator, if one is given, and the rays
+    // traced are added to raysTraced.
+    Color samplePixel(const Scene& world, Sampler& sampler, int i, int j,
+                      int firstSample, int sampleCount,
+                      PixelVarianceEstimator* estimator,
+                      uint64_t& raysTraced) const;
 };
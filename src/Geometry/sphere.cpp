@@ -8,16 +8,30 @@
 #include "../Materials/material.h"
 
 Sphere::Sphere() : m_center{0.0f, 0.0f, 0.0f}, m_radius(1.0f),
-                   m_isMoving(false) {}
+                   m_isMoving(false),
+                   m_bbox(Point3(-1.0f, -1.0f, -1.0f), Point3(1.0f, 1.0f, 1.0f))
+{}
 
 Sphere::Sphere(Point3 center, float radius, std::shared_ptr<Material> matPtr) :
                m_center(center), m_radius(radius), m_matPtr(matPtr),
-               m_isMoving(false) {}
+               m_isMoving(false)
+{
+    Vector3 radiusVector(radius, radius, radius);
+    m_bbox = AABB(center - radiusVector, center + radiusVector);
+}
 
 Sphere::Sphere(Point3 centerBegin, Point3 centerEnd, float radius,
                std::shared_ptr<Material> matPtr) :
                m_center(centerBegin), m_radius(radius), m_matPtr(matPtr),
-               m_isMoving(true), m_centerVector(centerEnd - centerBegin) {}
+               m_isMoving(true), m_centerVector(centerEnd - centerBegin)
+{
+    // Enclose the sphere at both ends of the shutter interval.
+    Vector3 radiusVector(radius, radius, radius);
+    AABB boxBegin(centerBegin - radiusVector, centerBegin + radiusVector);
+    AABB boxEnd(centerEnd - radiusVector, centerEnd + radiusVector);
+
+    m_bbox = AABB(boxBegin, boxEnd);
+}
 
 bool Sphere::hit(const Ray& r, Interval ray_t, HitRecord& rec) const
 {
@@ -62,12 +76,13 @@ bool Sphere::hit(const Ray& r, Interval ray_t, HitRecord& rec) const
     rec.t = root;
     rec.p = r.at(rec.t);
 
-    // Negate normal, if necessary.
-    Vector3 outwardNormal = (rec.p - m_center) / m_radius;
+    // Negate normal, if necessary (relative to the center at the ray's
+    // time, so moving spheres are shaded where they were hit).
+    Vector3 outwardNormal = (rec.p - center) / m_radius;
     rec.setFaceNormal(r, outwardNormal);
 
-    // Set sphere material pointer.
-    rec.matPtr = m_matPtr;
+    // Set sphere material.
+    rec.material = &m_matPtr->data();
 
     return true;
 }
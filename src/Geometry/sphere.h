@@ -30,11 +30,28 @@ public:
     virtual bool hit(const Ray& r, Interval ray_t, HitRecord& rec) const
                                                                    override;
 
+    // Returns the sphere bounds (swept from start to end for moving spheres).
+    AABB boundingBox() const override { return m_bbox; }
+
+    // Center at time zero.
+    const Point3& center() const { return m_center; }
+
+    // Distance travelled by the center from time zero to time one.
+    Vector3 motion() const
+    {
+        return m_isMoving ? m_centerVector : Vector3(0.0f, 0.0f, 0.0f);
+    }
+
+    float radius() const { return m_radius; }
+
+    const std::shared_ptr<Material>& material() const { return m_matPtr; }
+
 private:
     bool m_isMoving;
     float m_radius;
     Point3 m_center;
     Vector3 m_centerVector;
+    AABB m_bbox;
 
     // Material pointer.
     std::shared_ptr<Material> m_matPtr;
@@ -0,0 +1,449 @@
+#include "sphereKernels.h"
+
+#include <cmath>
+#include <cstdint>
+
+#include "../Math/ray.h"
+#include "../Math/utilities.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+    defined(_M_IX86)
+#define RT_SPHERE_KERNELS_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only emit vector instructions for functions marked with the
+// matching target; MSVC accepts the intrinsics anywhere.
+#if defined(__GNUC__) || defined(__clang__)
+#define RT_TARGET_SSE __attribute__((target("sse2")))
+#define RT_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define RT_TARGET_SSE
+#define RT_TARGET_AVX2
+#endif
+
+void SphereSoA::resize(uint32_t sphereCount)
+{
+    count = sphereCount;
+
+    size_t size = static_cast<size_t>(sphereCount) + SPHERE_PADDING;
+
+    centerX.assign(size, 0.0f);
+    centerY.assign(size, 0.0f);
+    centerZ.assign(size, 0.0f);
+    radius.assign(size, 0.0f);
+    motionX.assign(size, 0.0f);
+    motionY.assign(size, 0.0f);
+    motionZ.assign(size, 0.0f);
+    materialIndex.assign(size, 0u);
+}
+
+namespace
+{
+    // Same arithmetic as Sphere::hit, one sphere at a time.
+    int intersectScalar(const SphereSoA& spheres, uint32_t first,
+                        uint32_t count, const Ray& r, float tMin, float tMax,
+                        float& tHit)
+    {
+        Point3 origin = r.origin();
+        Vector3 direction = r.direction();
+        float time = r.time();
+        float a = direction.magnitudeSquared();
+
+        int nearest = -1;
+        float closestSoFar = tMax;
+
+        for (uint32_t k = 0; k < count; ++k)
+        {
+            uint32_t i = first + k;
+
+            float ocX = origin.x() - (spheres.centerX[i] +
+                                      time * spheres.motionX[i]);
+            float ocY = origin.y() - (spheres.centerY[i] +
+                                      time * spheres.motionY[i]);
+            float ocZ = origin.z() - (spheres.centerZ[i] +
+                                      time * spheres.motionZ[i]);
+
+            float halfB = ocX * direction.x() + ocY * direction.y() +
+                          ocZ * direction.z();
+            float c = (ocX * ocX + ocY * ocY + ocZ * ocZ) -
+                      spheres.radius[i] * spheres.radius[i];
+            float discriminant = halfB * halfB - a * c;
+
+            if (discriminant < 0.0f)
+            {
+                continue;
+            }
+
+            float sqrtd = std::sqrt(discriminant);
+            float root = (-halfB - sqrtd) / a;
+
+            if (!(tMin < root && root < closestSoFar))
+            {
+                root = (-halfB + sqrtd) / a;
+
+                if (!(tMin < root && root < closestSoFar))
+                {
+                    continue;
+                }
+            }
+
+            closestSoFar = root;
+            nearest = static_cast<int>(k);
+        }
+
+        tHit = closestSoFar;
+
+        return nearest;
+    }
+
+#ifdef RT_SPHERE_KERNELS_X86
+    // Computes the nearest valid root of four spheres starting at index i;
+    // lanes without a hit (or beyond laneCount) are set to +INF.
+    RT_TARGET_SSE
+    __m128 rootsSSE(const SphereSoA& spheres, uint32_t i, uint32_t laneCount,
+                    __m128 ox, __m128 oy, __m128 oz, __m128 dx, __m128 dy,
+                    __m128 dz, __m128 time, __m128 a, __m128 tMin,
+                    __m128 tMax)
+    {
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+        const __m128 infinity = _mm_set1_ps(INF);
+
+        __m128 ocX = _mm_sub_ps(ox, _mm_add_ps(
+                         _mm_loadu_ps(&spheres.centerX[i]),
+                         _mm_mul_ps(time, _mm_loadu_ps(&spheres.motionX[i]))));
+        __m128 ocY = _mm_sub_ps(oy, _mm_add_ps(
+                         _mm_loadu_ps(&spheres.centerY[i]),
+                         _mm_mul_ps(time, _mm_loadu_ps(&spheres.motionY[i]))));
+        __m128 ocZ = _mm_sub_ps(oz, _mm_add_ps(
+                         _mm_loadu_ps(&spheres.centerZ[i]),
+                         _mm_mul_ps(time, _mm_loadu_ps(&spheres.motionZ[i]))));
+        __m128 radius = _mm_loadu_ps(&spheres.radius[i]);
+
+        __m128 halfB = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ocX, dx),
+                                             _mm_mul_ps(ocY, dy)),
+                                  _mm_mul_ps(ocZ, dz));
+        __m128 c = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ocX, ocX),
+                                                    _mm_mul_ps(ocY, ocY)),
+                                         _mm_mul_ps(ocZ, ocZ)),
+                              _mm_mul_ps(radius, radius));
+        __m128 discriminant = _mm_sub_ps(_mm_mul_ps(halfB, halfB),
+                                         _mm_mul_ps(a, c));
+
+        __m128 sqrtd = _mm_sqrt_ps(_mm_max_ps(discriminant,
+                                              _mm_setzero_ps()));
+        __m128 negHalfB = _mm_xor_ps(halfB, signMask);
+        __m128 root0 = _mm_div_ps(_mm_sub_ps(negHalfB, sqrtd), a);
+        __m128 root1 = _mm_div_ps(_mm_add_ps(negHalfB, sqrtd), a);
+
+        __m128 valid0 = _mm_and_ps(_mm_cmplt_ps(tMin, root0),
+                                   _mm_cmplt_ps(root0, tMax));
+        __m128 valid1 = _mm_and_ps(_mm_cmplt_ps(tMin, root1),
+                                   _mm_cmplt_ps(root1, tMax));
+
+        // Prefer the near root, fall back to the far one.
+        __m128 root = _mm_or_ps(_mm_and_ps(valid0, root0),
+                                _mm_andnot_ps(valid0, root1));
+
+        __m128 lanes = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+        __m128 inRange = _mm_cmplt_ps(lanes, _mm_set1_ps(
+                                      static_cast<float>(laneCount)));
+        __m128 valid = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(discriminant,
+                                                          _mm_setzero_ps()),
+                                             _mm_or_ps(valid0, valid1)),
+                                  inRange);
+
+        return _mm_or_ps(_mm_and_ps(valid, root),
+                         _mm_andnot_ps(valid, infinity));
+    }
+
+    // Returns the lane holding the smallest value of four, or -1 if every
+    // lane is +INF.
+    RT_TARGET_SSE
+    int nearestLaneSSE(__m128 roots, float& tHit)
+    {
+        __m128 m = _mm_min_ps(roots, _mm_shuffle_ps(roots, roots,
+                                                    _MM_SHUFFLE(2, 3, 0, 1)));
+        m = _mm_min_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 0, 3, 2)));
+
+        float nearest = _mm_cvtss_f32(m);
+
+        if (nearest == INF)
+        {
+            return -1;
+        }
+
+        tHit = nearest;
+
+        int mask = _mm_movemask_ps(_mm_cmpeq_ps(roots, m));
+
+#ifdef _MSC_VER
+        unsigned long lane;
+        _BitScanForward(&lane, static_cast<unsigned long>(mask));
+
+        return static_cast<int>(lane);
+#else
+        return __builtin_ctz(static_cast<unsigned>(mask));
+#endif
+    }
+
+    RT_TARGET_SSE
+    int intersectSSE(const SphereSoA& spheres, uint32_t first, uint32_t count,
+                     const Ray& r, float tMin, float tMax, float& tHit)
+    {
+        Point3 origin = r.origin();
+        Vector3 direction = r.direction();
+
+        __m128 ox = _mm_set1_ps(origin.x());
+        __m128 oy = _mm_set1_ps(origin.y());
+        __m128 oz = _mm_set1_ps(origin.z());
+        __m128 dx = _mm_set1_ps(direction.x());
+        __m128 dy = _mm_set1_ps(direction.y());
+        __m128 dz = _mm_set1_ps(direction.z());
+        __m128 time = _mm_set1_ps(r.time());
+        __m128 a = _mm_set1_ps(direction.magnitudeSquared());
+        __m128 tMinVector = _mm_set1_ps(tMin);
+
+        int nearest = -1;
+        float closestSoFar = tMax;
+
+        for (uint32_t base = 0; base < count; base += 4)
+        {
+            __m128 roots = rootsSSE(spheres, first + base, count - base, ox,
+                                    oy, oz, dx, dy, dz, time, a, tMinVector,
+                                    _mm_set1_ps(closestSoFar));
+            float t;
+            int lane = nearestLaneSSE(roots, t);
+
+            if (lane >= 0)
+            {
+                closestSoFar = t;
+                nearest = static_cast<int>(base) + lane;
+            }
+        }
+
+        tHit = closestSoFar;
+
+        return nearest;
+    }
+
+    RT_TARGET_AVX2
+    int intersectAVX2(const SphereSoA& spheres, uint32_t first,
+                      uint32_t count, const Ray& r, float tMin, float tMax,
+                      float& tHit)
+    {
+        const __m256 signMask = _mm256_set1_ps(-0.0f);
+        const __m256 infinity = _mm256_set1_ps(INF);
+        const __m256 zero = _mm256_setzero_ps();
+
+        Point3 origin = r.origin();
+        Vector3 direction = r.direction();
+
+        __m256 dx = _mm256_set1_ps(direction.x());
+        __m256 dy = _mm256_set1_ps(direction.y());
+        __m256 dz = _mm256_set1_ps(direction.z());
+        __m256 time = _mm256_set1_ps(r.time());
+        __m256 a = _mm256_set1_ps(direction.magnitudeSquared());
+        __m256 tMinVector = _mm256_set1_ps(tMin);
+        __m256 tMaxVector = _mm256_set1_ps(tMax);
+
+        uint32_t i = first;
+
+        __m256 ocX = _mm256_sub_ps(_mm256_set1_ps(origin.x()), _mm256_add_ps(
+                         _mm256_loadu_ps(&spheres.centerX[i]),
+                         _mm256_mul_ps(time,
+                                       _mm256_loadu_ps(&spheres.motionX[i]))));
+        __m256 ocY = _mm256_sub_ps(_mm256_set1_ps(origin.y()), _mm256_add_ps(
+                         _mm256_loadu_ps(&spheres.centerY[i]),
+                         _mm256_mul_ps(time,
+                                       _mm256_loadu_ps(&spheres.motionY[i]))));
+        __m256 ocZ = _mm256_sub_ps(_mm256_set1_ps(origin.z()), _mm256_add_ps(
+                         _mm256_loadu_ps(&spheres.centerZ[i]),
+                         _mm256_mul_ps(time,
+                                       _mm256_loadu_ps(&spheres.motionZ[i]))));
+        __m256 radius = _mm256_loadu_ps(&spheres.radius[i]);
+
+        __m256 halfB = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ocX, dx),
+                                                   _mm256_mul_ps(ocY, dy)),
+                                     _mm256_mul_ps(ocZ, dz));
+        __m256 c = _mm256_sub_ps(
+                       _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ocX, ocX),
+                                                   _mm256_mul_ps(ocY, ocY)),
+                                     _mm256_mul_ps(ocZ, ocZ)),
+                       _mm256_mul_ps(radius, radius));
+        __m256 discriminant = _mm256_sub_ps(_mm256_mul_ps(halfB, halfB),
+                                            _mm256_mul_ps(a, c));
+
+        __m256 sqrtd = _mm256_sqrt_ps(_mm256_max_ps(discriminant, zero));
+        __m256 negHalfB = _mm256_xor_ps(halfB, signMask);
+        __m256 root0 = _mm256_div_ps(_mm256_sub_ps(negHalfB, sqrtd), a);
+        __m256 root1 = _mm256_div_ps(_mm256_add_ps(negHalfB, sqrtd), a);
+
+        __m256 valid0 = _mm256_and_ps(
+                            _mm256_cmp_ps(tMinVector, root0, _CMP_LT_OQ),
+                            _mm256_cmp_ps(root0, tMaxVector, _CMP_LT_OQ));
+        __m256 valid1 = _mm256_and_ps(
+                            _mm256_cmp_ps(tMinVector, root1, _CMP_LT_OQ),
+                            _mm256_cmp_ps(root1, tMaxVector, _CMP_LT_OQ));
+
+        // Prefer the near root, fall back to the far one.
+        __m256 root = _mm256_blendv_ps(root1, root0, valid0);
+
+        __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        __m256 inRange = _mm256_castsi256_ps(_mm256_cmpgt_epi32(
+                             _mm256_set1_epi32(static_cast<int>(count)),
+                             lanes));
+        __m256 valid = _mm256_and_ps(
+                           _mm256_and_ps(_mm256_cmp_ps(discriminant, zero,
+                                                       _CMP_GE_OQ),
+                                         _mm256_or_ps(valid0, valid1)),
+                           inRange);
+
+        __m256 roots = _mm256_blendv_ps(infinity, root, valid);
+
+        // Horizontal minimum across all eight lanes.
+        __m256 m = _mm256_min_ps(roots, _mm256_permute2f128_ps(roots, roots,
+                                                               1));
+        m = _mm256_min_ps(m, _mm256_shuffle_ps(m, m, _MM_SHUFFLE(1, 0, 3, 2)));
+        m = _mm256_min_ps(m, _mm256_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+
+        float nearest = _mm256_cvtss_f32(m);
+
+        if (nearest == INF)
+        {
+            tHit = tMax;
+
+            return -1;
+        }
+
+        tHit = nearest;
+
+        int mask = _mm256_movemask_ps(_mm256_cmp_ps(roots, m, _CMP_EQ_OQ));
+
+#ifdef _MSC_VER
+        unsigned long lane;
+        _BitScanForward(&lane, static_cast<unsigned long>(mask));
+
+        return static_cast<int>(lane);
+#else
+        return __builtin_ctz(static_cast<unsigned>(mask));
+#endif
+    }
+#endif
+}
+
+SphereKernel detectSphereKernel()
+{
+    if (isSphereKernelSupported(SphereKernel::AVX2))
+    {
+        return SphereKernel::AVX2;
+    }
+
+    if (isSphereKernelSupported(SphereKernel::SSE))
+    {
+        return SphereKernel::SSE;
+    }
+
+    return SphereKernel::Scalar;
+}
+
+bool isSphereKernelSupported(SphereKernel kernel)
+{
+    if (kernel == SphereKernel::Scalar)
+    {
+        return true;
+    }
+
+#ifdef RT_SPHERE_KERNELS_X86
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+
+    bool sse2 = (info[3] & (1 << 26)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+
+    if (kernel == SphereKernel::SSE)
+    {
+        return sse2;
+    }
+
+    // The OS must also save the upper halves of the YMM registers.
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+    {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+
+    if (kernel == SphereKernel::SSE)
+    {
+        return __builtin_cpu_supports("sse2");
+    }
+
+    return __builtin_cpu_supports("avx2");
+#endif
+#else
+    return false;
+#endif
+}
+
+SphereKernelFunction sphereKernelFunction(SphereKernel kernel)
+{
+#ifdef RT_SPHERE_KERNELS_X86
+    if (kernel == SphereKernel::AVX2)
+    {
+        return intersectAVX2;
+    }
+
+    if (kernel == SphereKernel::SSE)
+    {
+        return intersectSSE;
+    }
+#endif
+
+    return intersectScalar;
+}
+
+const char* sphereKernelName(SphereKernel kernel)
+{
+    switch (kernel)
+    {
+    case SphereKernel::AVX2:
+        return "avx2";
+    case SphereKernel::SSE:
+        return "sse";
+    case SphereKernel::Scalar:
+    default:
+        return "scalar";
+    }
+}
+
+bool parseSphereKernel(const std::string& name, SphereKernel& kernel)
+{
+    if (name == "scalar")
+    {
+        kernel = SphereKernel::Scalar;
+    }
+    else if (name == "sse")
+    {
+        kernel = SphereKernel::SSE;
+    }
+    else if (name == "avx2")
+    {
+        kernel = SphereKernel::AVX2;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,68 @@
+/*
+ * This file provides ray/sphere intersection kernels over spheres stored as
+ * a structure of arrays. The SSE and AVX2 kernels test one ray against 4 or
+ * 8 spheres at once and select the nearest valid root with lane masks; the
+ * scalar kernel is the portable fallback. The best kernel supported by the
+ * CPU is selected at runtime.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../Math/ray.h"
+
+// Sphere data in structure-of-arrays layout. Every array holds at least
+// SPHERE_PADDING entries more than there are spheres, so a kernel may load
+// a full vector starting at any sphere.
+struct SphereSoA
+{
+    static const int SPHERE_PADDING = 8;
+
+    // Center at time zero.
+    std::vector<float> centerX, centerY, centerZ;
+
+    std::vector<float> radius;
+
+    // Distance travelled by the center from time zero to time one.
+    std::vector<float> motionX, motionY, motionZ;
+
+    std::vector<uint32_t> materialIndex;
+
+    // Number of spheres (excluding padding).
+    uint32_t count = 0;
+
+    // Resizes every array for sphereCount spheres plus padding.
+    void resize(uint32_t sphereCount);
+};
+
+enum class SphereKernel
+{
+    Scalar,
+    SSE,
+    AVX2
+};
+
+// Intersects the ray with spheres [first, first + count), count <= 8, and
+// returns the offset (relative to first) of the nearest sphere hit within
+// (tMin, tMax), or -1. The distance of the hit is stored in tHit.
+using SphereKernelFunction = int (*)(const SphereSoA& spheres, uint32_t first,
+                                     uint32_t count, const Ray& r, float tMin,
+                                     float tMax, float& tHit);
+
+// Returns the widest kernel supported by the CPU running the program.
+SphereKernel detectSphereKernel();
+
+// Returns whether the CPU can run the given kernel.
+bool isSphereKernelSupported(SphereKernel kernel);
+
+// Returns the implementation of the given kernel.
+SphereKernelFunction sphereKernelFunction(SphereKernel kernel);
+
+// Returns a printable name of the given kernel.
+const char* sphereKernelName(SphereKernel kernel);
+
+// Parses "scalar", "sse" or "avx2". Returns false for unknown names.
+bool parseSphereKernel(const std::string& name, SphereKernel& kernel);
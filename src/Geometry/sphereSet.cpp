@@ -0,0 +1,214 @@
+#include "sphereSet.h"
+
+#include <utility>
+
+#include "../Render/stats.h"
+
+namespace
+{
+    // Leaves hold at most one AVX2 vector of spheres, which the kernels
+    // test at roughly the cost of a single sphere.
+    const int SPHERE_LEAF_SIZE = 8;
+}
+
+SphereSet::SphereSet() : m_kernel(detectSphereKernel()),
+                         m_intersect(sphereKernelFunction(m_kernel)) {}
+
+void SphereSet::add(const Point3& center, const Vector3& motion, float radius,
+                    uint32_t materialId)
+{
+    m_center.push_back(center);
+    m_motion.push_back(motion);
+    m_radius.push_back(radius);
+    m_materialId.push_back(materialId);
+}
+
+bool SphereSet::hasMotion() const
+{
+    for (const Vector3& motion : m_motion)
+    {
+        if (motion.x() != 0.0f || motion.y() != 0.0f || motion.z() != 0.0f)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::vector<AABB> SphereSet::sphereBounds(float time) const
+{
+    std::vector<AABB> bounds;
+    bounds.reserve(m_radius.size());
+
+    for (size_t i = 0; i < m_radius.size(); ++i)
+    {
+        Vector3 extent(m_radius[i], m_radius[i], m_radius[i]);
+        Point3 center = m_center[i] + time * m_motion[i];
+
+        bounds.push_back(AABB(center - extent, center + extent));
+    }
+
+    return bounds;
+}
+
+std::vector<AABB> SphereSet::sweptBounds() const
+{
+    std::vector<AABB> begin = sphereBounds(0.0f);
+    std::vector<AABB> end = sphereBounds(1.0f);
+
+    for (size_t i = 0; i < begin.size(); ++i)
+    {
+        begin[i] = AABB(begin[i], end[i]);
+    }
+
+    return begin;
+}
+
+void SphereSet::build(bool motionBounds)
+{
+    if (motionBounds && hasMotion())
+    {
+        // Split the spheres where they are on average; the interpolated
+        // node bounds then follow them through the interval.
+        m_tree.build(sphereBounds(0.5f), SPHERE_LEAF_SIZE, SPHERE_LEAF_SIZE);
+        m_tree.setMotionBounds(sphereBounds(0.0f), sphereBounds(1.0f));
+    }
+    else
+    {
+        // Bound every sphere over the whole shutter interval.
+        m_tree.build(sweptBounds(), SPHERE_LEAF_SIZE, SPHERE_LEAF_SIZE);
+    }
+
+    copyLeafOrder();
+}
+
+void SphereSet::setCenter(uint32_t sphere, const Point3& center)
+{
+    m_center[sphere] = center;
+}
+
+void SphereSet::refit()
+{
+    if (m_tree.hasMotionBounds())
+    {
+        m_tree.setMotionBounds(sphereBounds(0.0f), sphereBounds(1.0f));
+    }
+    else
+    {
+        m_tree.refit(sweptBounds());
+    }
+
+    copyLeafOrder();
+}
+
+void SphereSet::copyLeafOrder()
+{
+    const auto& order = m_tree.primitiveIndices();
+
+    m_spheres.resize(static_cast<uint32_t>(order.size()));
+
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        uint32_t index = order[i];
+
+        m_spheres.centerX[i] = m_center[index].x();
+        m_spheres.centerY[i] = m_center[index].y();
+        m_spheres.centerZ[i] = m_center[index].z();
+        m_spheres.radius[i] = m_radius[index];
+        m_spheres.motionX[i] = m_motion[index].x();
+        m_spheres.motionY[i] = m_motion[index].y();
+        m_spheres.motionZ[i] = m_motion[index].z();
+        m_spheres.materialIndex[i] = m_materialId[index];
+    }
+}
+
+void SphereSet::assign(SphereSoA spheres, std::vector<BVHNode> nodes)
+{
+    m_spheres = std::move(spheres);
+    m_tree.assign(std::move(nodes), m_spheres.count);
+
+    // Keep the insertion order arrays (now in leaf order) so that spheres
+    // can still be added and the set rebuilt.
+    uint32_t count = m_spheres.count;
+
+    m_center.resize(count);
+    m_motion.resize(count);
+    m_radius.assign(m_spheres.radius.begin(),
+                    m_spheres.radius.begin() + count);
+    m_materialId.assign(m_spheres.materialIndex.begin(),
+                        m_spheres.materialIndex.begin() + count);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        m_center[i] = Point3(m_spheres.centerX[i], m_spheres.centerY[i],
+                             m_spheres.centerZ[i]);
+        m_motion[i] = Vector3(m_spheres.motionX[i], m_spheres.motionY[i],
+                              m_spheres.motionZ[i]);
+    }
+
+    // The motion bounds are not cached; they follow from the spheres.
+    if (hasMotion())
+    {
+        m_tree.setMotionBounds(sphereBounds(0.0f), sphereBounds(1.0f));
+    }
+}
+
+bool SphereSet::setKernel(SphereKernel kernel)
+{
+    if (!isSphereKernelSupported(kernel))
+    {
+        return false;
+    }
+
+    m_kernel = kernel;
+    m_intersect = sphereKernelFunction(kernel);
+
+    return true;
+}
+
+bool SphereSet::intersect(const Ray& r, Interval ray_t, uint32_t& sphere,
+                          float& tHit) const
+{
+    return m_tree.traverse(r, ray_t,
+                           [&](uint32_t first, uint32_t count, Interval range,
+                               float& closestSoFar)
+                           {
+                               float t;
+                               RT_STATS_ADD(primitiveTests, count);
+
+                               int offset = m_intersect(m_spheres, first,
+                                                        count, r, range.min,
+                                                        closestSoFar, t);
+
+                               if (offset < 0)
+                               {
+                                   return false;
+                               }
+
+                               sphere = first + offset;
+                               closestSoFar = t;
+                               tHit = t;
+
+                               return true;
+                           });
+}
+
+uint32_t SphereSet::surface(const Ray& r, uint32_t sphere, float tHit,
+                            HitRecord& rec) const
+{
+    Point3 center(m_spheres.centerX[sphere] +
+                  r.time() * m_spheres.motionX[sphere],
+                  m_spheres.centerY[sphere] +
+                  r.time() * m_spheres.motionY[sphere],
+                  m_spheres.centerZ[sphere] +
+                  r.time() * m_spheres.motionZ[sphere]);
+
+    rec.t = tHit;
+    rec.p = r.at(rec.t);
+
+    Vector3 outwardNormal = (rec.p - center) / m_spheres.radius[sphere];
+    rec.setFaceNormal(r, outwardNormal);
+
+    return m_spheres.materialIndex[sphere];
+}
@@ -0,0 +1,101 @@
+/*
+ * This class stores spheres in one structure of arrays and intersects them
+ * with the SIMD kernels from sphereKernels.h. The spheres are ordered along a
+ * BVH whose leaves hold up to one vector width of spheres, so every leaf is
+ * tested with a single kernel call.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "sphereKernels.h"
+#include "../Hittables/bvh.h"
+#include "../Hittables/hittable.h"
+#include "../Math/aabb.h"
+#include "../Math/interval.h"
+#include "../Math/ray.h"
+#include "../Math/vector3.h"
+
+class SphereSet
+{
+public:
+    // Default constructor (selects the widest supported kernel).
+    SphereSet();
+
+    // Adds a sphere whose center moves by motion over the shutter interval.
+    // The set must be rebuilt before it is intersected again.
+    void add(const Point3& center, const Vector3& motion, float radius,
+             uint32_t materialId);
+
+    // Reorders the spheres along a new BVH. If any sphere moves, the BVH is
+    // built over the spheres at mid-shutter and keeps node bounds at both
+    // shutter ends (see BVHMotionBounds); without motionBounds it bounds
+    // every sphere over the whole interval instead.
+    void build(bool motionBounds = true);
+
+    // Moves a sphere (by insertion index) to a new center; its motion over
+    // the shutter interval is kept. The set must be refitted or rebuilt
+    // before it is intersected again.
+    void setCenter(uint32_t sphere, const Point3& center);
+
+    // Updates the spheres in leaf order and the BVH bounds after spheres
+    // were moved, keeping the hierarchy of the last build.
+    void refit();
+
+    // Replaces the set with spheres already in leaf order and the BVH built
+    // over them, as returned by spheres() and tree() of a built set.
+    void assign(SphereSoA spheres, std::vector<BVHNode> nodes);
+
+    // Finds the nearest sphere hit within ray_t. Returns its index and
+    // distance without computing any shading information.
+    bool intersect(const Ray& r, Interval ray_t, uint32_t& sphere,
+                   float& tHit) const;
+
+    // Fills the position and normal of a hit found by intersect() and
+    // returns the material index of the sphere.
+    uint32_t surface(const Ray& r, uint32_t sphere, float tHit,
+                     HitRecord& rec) const;
+
+    AABB boundingBox() const { return m_tree.bounds(); }
+
+    // Selects the intersection kernel. Unsupported kernels are ignored and
+    // false is returned.
+    bool setKernel(SphereKernel kernel);
+
+    SphereKernel kernel() const { return m_kernel; }
+
+    uint32_t size() const { return static_cast<uint32_t>(m_radius.size()); }
+
+    // Spheres in leaf order and the hierarchy over them.
+    const SphereSoA& spheres() const { return m_spheres; }
+    const BVHTree& tree() const { return m_tree; }
+
+private:
+    // Checks whether or not any sphere moves.
+    bool hasMotion() const;
+
+    // Bounds of every sphere at the given shutter time.
+    std::vector<AABB> sphereBounds(float time) const;
+
+    // Bounds of every sphere over the whole shutter interval.
+    std::vector<AABB> sweptBounds() const;
+
+    // Copies the spheres into m_spheres in the leaf order of the BVH.
+    void copyLeafOrder();
+
+    // Spheres in insertion order.
+    std::vector<Point3> m_center;
+    std::vector<Vector3> m_motion;
+    std::vector<float> m_radius;
+    std::vector<uint32_t> m_materialId;
+
+    // The same spheres in leaf order.
+    SphereSoA m_spheres;
+
+    BVHTree m_tree;
+
+    SphereKernel m_kernel;
+    SphereKernelFunction m_intersect;
+};
@@ -0,0 +1,453 @@
+#include "triangleKernels.h"
+
+#include <cmath>
+#include <cstdint>
+
+#include "../Math/ray.h"
+#include "../Math/utilities.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+    defined(_M_IX86)
+#define RT_TRIANGLE_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+// GCC and Clang only emit vector instructions for functions marked with the
+// matching target; MSVC accepts the intrinsics anywhere.
+#if defined(__GNUC__) || defined(__clang__)
+#define RT_TARGET_SSE __attribute__((target("sse2")))
+#define RT_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define RT_TARGET_SSE
+#define RT_TARGET_AVX2
+#endif
+
+void TriangleSoA::resize(uint32_t triangleCount)
+{
+    count = triangleCount;
+
+    size_t size = static_cast<size_t>(triangleCount) + TRIANGLE_PADDING;
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        p0[axis].assign(size, 0.0f);
+        p1[axis].assign(size, 0.0f);
+        p2[axis].assign(size, 0.0f);
+    }
+}
+
+TriangleRay::TriangleRay(const Ray& r)
+{
+    Vector3 direction = r.direction();
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        origin[axis] = r.origin()[axis];
+    }
+
+    // Permute the axes so that the largest direction component becomes z,
+    // and swap x and y if needed to keep the winding order.
+    kz = 0;
+
+    if (std::fabs(direction.y()) > std::fabs(direction[kz]))
+    {
+        kz = 1;
+    }
+
+    if (std::fabs(direction.z()) > std::fabs(direction[kz]))
+    {
+        kz = 2;
+    }
+
+    kx = (kz + 1) % 3;
+    ky = (kx + 1) % 3;
+
+    if (direction[kz] < 0.0f)
+    {
+        int swap = kx;
+        kx = ky;
+        ky = swap;
+    }
+
+    shearX = direction[kx] / direction[kz];
+    shearY = direction[ky] / direction[kz];
+    shearZ = 1.0f / direction[kz];
+}
+
+namespace
+{
+    // Watertight test of triangle i. Returns whether it is hit within
+    // (tMin, tMax) and stores the distance in t.
+    bool intersectTriangle(const TriangleSoA& triangles, uint32_t i,
+                           const TriangleRay& r, float tMin, float tMax,
+                           float& t)
+    {
+        // Vertices relative to the ray origin.
+        float ax = triangles.p0[r.kx][i] - r.origin[r.kx];
+        float ay = triangles.p0[r.ky][i] - r.origin[r.ky];
+        float az = triangles.p0[r.kz][i] - r.origin[r.kz];
+        float bx = triangles.p1[r.kx][i] - r.origin[r.kx];
+        float by = triangles.p1[r.ky][i] - r.origin[r.ky];
+        float bz = triangles.p1[r.kz][i] - r.origin[r.kz];
+        float cx = triangles.p2[r.kx][i] - r.origin[r.kx];
+        float cy = triangles.p2[r.ky][i] - r.origin[r.ky];
+        float cz = triangles.p2[r.kz][i] - r.origin[r.kz];
+
+        // Shear the vertices into the ray's space.
+        ax = ax - r.shearX * az;
+        ay = ay - r.shearY * az;
+        bx = bx - r.shearX * bz;
+        by = by - r.shearY * bz;
+        cx = cx - r.shearX * cz;
+        cy = cy - r.shearY * cz;
+
+        // Scaled barycentric coordinates (edge functions).
+        float u = cx * by - cy * bx;
+        float v = ax * cy - ay * cx;
+        float w = bx * ay - by * ax;
+
+        // An edge passing exactly through the ray is resolved in double
+        // precision, so neighbouring triangles agree on who owns it.
+        if (u == 0.0f || v == 0.0f || w == 0.0f)
+        {
+            u = static_cast<float>(static_cast<double>(cx) * by -
+                                   static_cast<double>(cy) * bx);
+            v = static_cast<float>(static_cast<double>(ax) * cy -
+                                   static_cast<double>(ay) * cx);
+            w = static_cast<float>(static_cast<double>(bx) * ay -
+                                   static_cast<double>(by) * ax);
+        }
+
+        // Both orientations are hit; mixed signs miss.
+        if ((u < 0.0f || v < 0.0f || w < 0.0f) &&
+            (u > 0.0f || v > 0.0f || w > 0.0f))
+        {
+            return false;
+        }
+
+        float determinant = u + v + w;
+
+        if (determinant == 0.0f)
+        {
+            return false;
+        }
+
+        float scaledT = u * (r.shearZ * az) + v * (r.shearZ * bz) +
+                        w * (r.shearZ * cz);
+        float distance = scaledT / determinant;
+
+        if (!(tMin < distance && distance < tMax))
+        {
+            return false;
+        }
+
+        t = distance;
+
+        return true;
+    }
+
+    // Picks the nearest of laneCount lane distances (+INF for misses),
+    // preferring the lowest lane on ties.
+    int nearestLane(const float* distances, int laneCount, float& tHit)
+    {
+        int nearest = -1;
+        float closestSoFar = INF;
+
+        for (int lane = 0; lane < laneCount; ++lane)
+        {
+            if (distances[lane] < closestSoFar)
+            {
+                closestSoFar = distances[lane];
+                nearest = lane;
+            }
+        }
+
+        if (nearest >= 0)
+        {
+            tHit = closestSoFar;
+        }
+
+        return nearest;
+    }
+
+    int intersectScalar(const TriangleSoA& triangles, uint32_t first,
+                        uint32_t count, const TriangleRay& r, float tMin,
+                        float tMax, float& tHit)
+    {
+        int nearest = -1;
+        float closestSoFar = tMax;
+
+        for (uint32_t k = 0; k < count; ++k)
+        {
+            float t;
+
+            if (intersectTriangle(triangles, first + k, r, tMin,
+                                  closestSoFar, t))
+            {
+                closestSoFar = t;
+                nearest = static_cast<int>(k);
+            }
+        }
+
+        tHit = closestSoFar;
+
+        return nearest;
+    }
+
+#ifdef RT_TRIANGLE_KERNELS_X86
+    // Computes the distances to four triangles starting at index i; lanes
+    // without a hit (or beyond laneCount) are set to +INF. Lanes whose edge
+    // functions need the double precision fallback are set in fallbackMask.
+    RT_TARGET_SSE
+    __m128 distancesSSE(const TriangleSoA& triangles, uint32_t i,
+                        uint32_t laneCount, const TriangleRay& r,
+                        __m128 tMin, __m128 tMax, int& fallbackMask)
+    {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 infinity = _mm_set1_ps(INF);
+
+        __m128 ox = _mm_set1_ps(r.origin[r.kx]);
+        __m128 oy = _mm_set1_ps(r.origin[r.ky]);
+        __m128 oz = _mm_set1_ps(r.origin[r.kz]);
+        __m128 shearX = _mm_set1_ps(r.shearX);
+        __m128 shearY = _mm_set1_ps(r.shearY);
+        __m128 shearZ = _mm_set1_ps(r.shearZ);
+
+        __m128 az = _mm_sub_ps(_mm_loadu_ps(&triangles.p0[r.kz][i]), oz);
+        __m128 bz = _mm_sub_ps(_mm_loadu_ps(&triangles.p1[r.kz][i]), oz);
+        __m128 cz = _mm_sub_ps(_mm_loadu_ps(&triangles.p2[r.kz][i]), oz);
+
+        __m128 ax = _mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(&triangles.p0[r.kx][i]),
+                                          ox), _mm_mul_ps(shearX, az));
+        __m128 ay = _mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(&triangles.p0[r.ky][i]),
+                                          oy), _mm_mul_ps(shearY, az));
+        __m128 bx = _mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(&triangles.p1[r.kx][i]),
+                                          ox), _mm_mul_ps(shearX, bz));
+        __m128 by = _mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(&triangles.p1[r.ky][i]),
+                                          oy), _mm_mul_ps(shearY, bz));
+        __m128 cx = _mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(&triangles.p2[r.kx][i]),
+                                          ox), _mm_mul_ps(shearX, cz));
+        __m128 cy = _mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(&triangles.p2[r.ky][i]),
+                                          oy), _mm_mul_ps(shearY, cz));
+
+        __m128 u = _mm_sub_ps(_mm_mul_ps(cx, by), _mm_mul_ps(cy, bx));
+        __m128 v = _mm_sub_ps(_mm_mul_ps(ax, cy), _mm_mul_ps(ay, cx));
+        __m128 w = _mm_sub_ps(_mm_mul_ps(bx, ay), _mm_mul_ps(by, ax));
+
+        __m128 lanes = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+        __m128 inRange = _mm_cmplt_ps(lanes, _mm_set1_ps(
+                                      static_cast<float>(laneCount)));
+
+        __m128 edgeZero = _mm_or_ps(_mm_or_ps(_mm_cmpeq_ps(u, zero),
+                                              _mm_cmpeq_ps(v, zero)),
+                                    _mm_cmpeq_ps(w, zero));
+        fallbackMask = _mm_movemask_ps(_mm_and_ps(edgeZero, inRange));
+
+        __m128 anyNegative = _mm_or_ps(_mm_or_ps(_mm_cmplt_ps(u, zero),
+                                                 _mm_cmplt_ps(v, zero)),
+                                       _mm_cmplt_ps(w, zero));
+        __m128 anyPositive = _mm_or_ps(_mm_or_ps(_mm_cmpgt_ps(u, zero),
+                                                 _mm_cmpgt_ps(v, zero)),
+                                       _mm_cmpgt_ps(w, zero));
+
+        __m128 determinant = _mm_add_ps(_mm_add_ps(u, v), w);
+        __m128 scaledT = _mm_add_ps(
+                             _mm_add_ps(_mm_mul_ps(u, _mm_mul_ps(shearZ, az)),
+                                        _mm_mul_ps(v, _mm_mul_ps(shearZ, bz))),
+                             _mm_mul_ps(w, _mm_mul_ps(shearZ, cz)));
+        __m128 distance = _mm_div_ps(scaledT, determinant);
+
+        __m128 valid = _mm_andnot_ps(_mm_and_ps(anyNegative, anyPositive),
+                                     _mm_cmpneq_ps(determinant, zero));
+        valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmplt_ps(tMin, distance),
+                                             _mm_cmplt_ps(distance, tMax)));
+        valid = _mm_and_ps(valid, inRange);
+
+        return _mm_or_ps(_mm_and_ps(valid, distance),
+                         _mm_andnot_ps(valid, infinity));
+    }
+
+    RT_TARGET_SSE
+    int intersectSSE(const TriangleSoA& triangles, uint32_t first,
+                     uint32_t count, const TriangleRay& r, float tMin,
+                     float tMax, float& tHit)
+    {
+        __m128 tMinVector = _mm_set1_ps(tMin);
+
+        int nearest = -1;
+        float closestSoFar = tMax;
+
+        for (uint32_t base = 0; base < count; base += 4)
+        {
+            int fallbackMask;
+            alignas(16) float distances[4];
+
+            _mm_store_ps(distances,
+                         distancesSSE(triangles, first + base, count - base, r,
+                                      tMinVector, _mm_set1_ps(closestSoFar),
+                                      fallbackMask));
+
+            for (int lane = 0; fallbackMask != 0; ++lane, fallbackMask >>= 1)
+            {
+                float t;
+
+                if (fallbackMask & 1)
+                {
+                    distances[lane] = intersectTriangle(triangles,
+                                                        first + base + lane,
+                                                        r, tMin, closestSoFar,
+                                                        t) ? t : INF;
+                }
+            }
+
+            float t;
+            int lane = nearestLane(distances, 4, t);
+
+            if (lane >= 0)
+            {
+                closestSoFar = t;
+                nearest = static_cast<int>(base) + lane;
+            }
+        }
+
+        tHit = closestSoFar;
+
+        return nearest;
+    }
+
+    RT_TARGET_AVX2
+    int intersectAVX2(const TriangleSoA& triangles, uint32_t first,
+                      uint32_t count, const TriangleRay& r, float tMin,
+                      float tMax, float& tHit)
+    {
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 infinity = _mm256_set1_ps(INF);
+
+        uint32_t i = first;
+
+        __m256 ox = _mm256_set1_ps(r.origin[r.kx]);
+        __m256 oy = _mm256_set1_ps(r.origin[r.ky]);
+        __m256 oz = _mm256_set1_ps(r.origin[r.kz]);
+        __m256 shearX = _mm256_set1_ps(r.shearX);
+        __m256 shearY = _mm256_set1_ps(r.shearY);
+        __m256 shearZ = _mm256_set1_ps(r.shearZ);
+
+        __m256 az = _mm256_sub_ps(_mm256_loadu_ps(&triangles.p0[r.kz][i]),
+                                  oz);
+        __m256 bz = _mm256_sub_ps(_mm256_loadu_ps(&triangles.p1[r.kz][i]),
+                                  oz);
+        __m256 cz = _mm256_sub_ps(_mm256_loadu_ps(&triangles.p2[r.kz][i]),
+                                  oz);
+
+        __m256 ax = _mm256_sub_ps(
+                        _mm256_sub_ps(_mm256_loadu_ps(&triangles.p0[r.kx][i]),
+                                      ox), _mm256_mul_ps(shearX, az));
+        __m256 ay = _mm256_sub_ps(
+                        _mm256_sub_ps(_mm256_loadu_ps(&triangles.p0[r.ky][i]),
+                                      oy), _mm256_mul_ps(shearY, az));
+        __m256 bx = _mm256_sub_ps(
+                        _mm256_sub_ps(_mm256_loadu_ps(&triangles.p1[r.kx][i]),
+                                      ox), _mm256_mul_ps(shearX, bz));
+        __m256 by = _mm256_sub_ps(
+                        _mm256_sub_ps(_mm256_loadu_ps(&triangles.p1[r.ky][i]),
+                                      oy), _mm256_mul_ps(shearY, bz));
+        __m256 cx = _mm256_sub_ps(
+                        _mm256_sub_ps(_mm256_loadu_ps(&triangles.p2[r.kx][i]),
+                                      ox), _mm256_mul_ps(shearX, cz));
+        __m256 cy = _mm256_sub_ps(
+                        _mm256_sub_ps(_mm256_loadu_ps(&triangles.p2[r.ky][i]),
+                                      oy), _mm256_mul_ps(shearY, cz));
+
+        __m256 u = _mm256_sub_ps(_mm256_mul_ps(cx, by),
+                                 _mm256_mul_ps(cy, bx));
+        __m256 v = _mm256_sub_ps(_mm256_mul_ps(ax, cy),
+                                 _mm256_mul_ps(ay, cx));
+        __m256 w = _mm256_sub_ps(_mm256_mul_ps(bx, ay),
+                                 _mm256_mul_ps(by, ax));
+
+        __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        __m256 inRange = _mm256_castsi256_ps(_mm256_cmpgt_epi32(
+                             _mm256_set1_epi32(static_cast<int>(count)),
+                             lanes));
+
+        __m256 edgeZero = _mm256_or_ps(
+                              _mm256_or_ps(_mm256_cmp_ps(u, zero, _CMP_EQ_OQ),
+                                           _mm256_cmp_ps(v, zero, _CMP_EQ_OQ)),
+                              _mm256_cmp_ps(w, zero, _CMP_EQ_OQ));
+        int fallbackMask = _mm256_movemask_ps(_mm256_and_ps(edgeZero,
+                                                            inRange));
+
+        __m256 anyNegative = _mm256_or_ps(
+                                 _mm256_or_ps(_mm256_cmp_ps(u, zero,
+                                                            _CMP_LT_OQ),
+                                              _mm256_cmp_ps(v, zero,
+                                                            _CMP_LT_OQ)),
+                                 _mm256_cmp_ps(w, zero, _CMP_LT_OQ));
+        __m256 anyPositive = _mm256_or_ps(
+                                 _mm256_or_ps(_mm256_cmp_ps(u, zero,
+                                                            _CMP_GT_OQ),
+                                              _mm256_cmp_ps(v, zero,
+                                                            _CMP_GT_OQ)),
+                                 _mm256_cmp_ps(w, zero, _CMP_GT_OQ));
+
+        __m256 determinant = _mm256_add_ps(_mm256_add_ps(u, v), w);
+        __m256 scaledT = _mm256_add_ps(
+                             _mm256_add_ps(
+                                 _mm256_mul_ps(u, _mm256_mul_ps(shearZ, az)),
+                                 _mm256_mul_ps(v, _mm256_mul_ps(shearZ, bz))),
+                             _mm256_mul_ps(w, _mm256_mul_ps(shearZ, cz)));
+        __m256 distance = _mm256_div_ps(scaledT, determinant);
+
+        __m256 valid = _mm256_andnot_ps(
+                           _mm256_and_ps(anyNegative, anyPositive),
+                           _mm256_cmp_ps(determinant, zero, _CMP_NEQ_UQ));
+        valid = _mm256_and_ps(valid, _mm256_and_ps(
+                    _mm256_cmp_ps(_mm256_set1_ps(tMin), distance, _CMP_LT_OQ),
+                    _mm256_cmp_ps(distance, _mm256_set1_ps(tMax),
+                                  _CMP_LT_OQ)));
+        valid = _mm256_and_ps(valid, inRange);
+
+        alignas(32) float distances[8];
+        _mm256_store_ps(distances, _mm256_blendv_ps(infinity, distance,
+                                                     valid));
+
+        for (int lane = 0; fallbackMask != 0; ++lane, fallbackMask >>= 1)
+        {
+            float t;
+
+            if (fallbackMask & 1)
+            {
+                distances[lane] = intersectTriangle(triangles, i + lane, r,
+                                                    tMin, tMax, t) ? t : INF;
+            }
+        }
+
+        int nearest = nearestLane(distances, 8, tHit);
+
+        if (nearest < 0)
+        {
+            tHit = tMax;
+        }
+
+        return nearest;
+    }
+#endif
+}
+
+TriangleKernelFunction triangleKernelFunction(SphereKernel kernel)
+{
+#ifdef RT_TRIANGLE_KERNELS_X86
+    switch (kernel)
+    {
+    case SphereKernel::AVX2:
+        return intersectAVX2;
+    case SphereKernel::SSE:
+        return intersectSSE;
+    case SphereKernel::Scalar:
+    default:
+        break;
+    }
+#endif
+
+    return intersectScalar;
+}
@@ -0,0 +1,59 @@
+/*
+ * This file provides watertight ray/triangle intersection kernels (Woop,
+ * Benthin and Wald, "Watertight Ray/Triangle Intersection", 2013) over
+ * triangles stored as a structure of arrays. Rays are sheared so that they
+ * point along +z, which makes the edge tests exact enough that a ray never
+ * slips through the shared edge of two triangles. The SSE and AVX2 kernels
+ * test 4 or 8 triangles at once; they come in the same widths as the sphere
+ * kernels and are selected with the same SphereKernel values.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "sphereKernels.h"
+#include "../Math/ray.h"
+
+// Triangle vertices in structure-of-arrays layout, indexed by axis (e.g.
+// p1[2][i] is the z coordinate of the second vertex of triangle i). Every
+// array holds at least TRIANGLE_PADDING entries more than there are
+// triangles, so a kernel may load a full vector starting at any triangle.
+struct TriangleSoA
+{
+    static const int TRIANGLE_PADDING = 8;
+
+    std::vector<float> p0[3], p1[3], p2[3];
+
+    // Number of triangles (excluding padding).
+    uint32_t count = 0;
+
+    // Resizes every array for triangleCount triangles plus padding.
+    void resize(uint32_t triangleCount);
+};
+
+// Per-ray constants of the watertight test.
+struct TriangleRay
+{
+    explicit TriangleRay(const Ray& r);
+
+    float origin[3];
+
+    // Axes of the ray direction in sheared space; kz is the dominant one.
+    int kx, ky, kz;
+
+    // Shear that maps the ray direction to (0, 0, 1).
+    float shearX, shearY, shearZ;
+};
+
+// Intersects the ray with triangles [first, first + count), count <= 8,
+// and returns the offset (relative to first) of the nearest triangle hit
+// within (tMin, tMax), or -1. The distance of the hit is stored in tHit.
+using TriangleKernelFunction = int (*)(const TriangleSoA& triangles,
+                                       uint32_t first, uint32_t count,
+                                       const TriangleRay& r, float tMin,
+                                       float tMax, float& tHit);
+
+// Returns the implementation of the given kernel.
+TriangleKernelFunction triangleKernelFunction(SphereKernel kernel);
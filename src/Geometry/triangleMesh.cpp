@@ -0,0 +1,167 @@
+#include "triangleMesh.h"
+
+#include <utility>
+
+#include "../Render/stats.h"
+
+namespace
+{
+    // Leaves hold at most one AVX2 vector of triangles, which the kernels
+    // test at roughly the cost of a single triangle.
+    const int TRIANGLE_LEAF_SIZE = 8;
+}
+
+TriangleMesh::TriangleMesh(std::vector<Point3> vertices,
+                           std::vector<uint32_t> indices,
+                           std::shared_ptr<Material> material) :
+                           m_vertices(std::move(vertices)),
+                           m_indices(std::move(indices)),
+                           m_material(std::move(material)),
+                           m_kernel(detectSphereKernel()),
+                           m_intersect(triangleKernelFunction(m_kernel))
+{
+    build();
+}
+
+TriangleMesh::TriangleMesh(std::vector<Point3> vertices,
+                           std::vector<uint32_t> indices,
+                           std::vector<BVHNode> nodes) :
+                           m_vertices(std::move(vertices)),
+                           m_indices(std::move(indices)),
+                           m_kernel(detectSphereKernel()),
+                           m_intersect(triangleKernelFunction(m_kernel))
+{
+    gatherTriangles();
+    m_tree.assign(std::move(nodes), m_triangles.count);
+}
+
+void TriangleMesh::build()
+{
+    uint32_t count = static_cast<uint32_t>(m_indices.size() / 3);
+    std::vector<AABB> bounds;
+    bounds.reserve(count);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const Point3& a = m_vertices[m_indices[3 * i]];
+        const Point3& b = m_vertices[m_indices[3 * i + 1]];
+        const Point3& c = m_vertices[m_indices[3 * i + 2]];
+
+        bounds.push_back(AABB(AABB(a, b), AABB(c, c)));
+    }
+
+    m_tree.build(bounds, TRIANGLE_LEAF_SIZE, TRIANGLE_LEAF_SIZE);
+
+    // Store the triangles in leaf order, so triangle i is leaf slot i.
+    const auto& order = m_tree.primitiveIndices();
+    std::vector<uint32_t> indices(3 * static_cast<size_t>(count));
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            indices[3 * i + corner] = m_indices[3 * order[i] + corner];
+        }
+    }
+
+    m_indices.swap(indices);
+
+    gatherTriangles();
+}
+
+void TriangleMesh::gatherTriangles()
+{
+    uint32_t count = static_cast<uint32_t>(m_indices.size() / 3);
+
+    m_triangles.resize(count);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const Point3& a = m_vertices[m_indices[3 * i]];
+        const Point3& b = m_vertices[m_indices[3 * i + 1]];
+        const Point3& c = m_vertices[m_indices[3 * i + 2]];
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            m_triangles.p0[axis][i] = a[axis];
+            m_triangles.p1[axis][i] = b[axis];
+            m_triangles.p2[axis][i] = c[axis];
+        }
+    }
+}
+
+bool TriangleMesh::setKernel(SphereKernel kernel)
+{
+    if (!isSphereKernelSupported(kernel))
+    {
+        return false;
+    }
+
+    m_kernel = kernel;
+    m_intersect = triangleKernelFunction(kernel);
+
+    return true;
+}
+
+bool TriangleMesh::intersect(const Ray& r, Interval ray_t,
+                             uint32_t& triangle, float& tHit) const
+{
+    TriangleRay shearedRay(r);
+
+    return m_tree.traverse(r, ray_t,
+                           [&](uint32_t first, uint32_t count, Interval range,
+                               float& closestSoFar)
+                           {
+                               float t;
+                               RT_STATS_ADD(primitiveTests, count);
+
+                               int offset = m_intersect(m_triangles, first,
+                                                        count, shearedRay,
+                                                        range.min,
+                                                        closestSoFar, t);
+
+                               if (offset < 0)
+                               {
+                                   return false;
+                               }
+
+                               triangle = first + offset;
+                               closestSoFar = t;
+                               tHit = t;
+
+                               return true;
+                           });
+}
+
+void TriangleMesh::surface(const Ray& r, uint32_t triangle, float tHit,
+                           HitRecord& rec) const
+{
+    Point3 a(m_triangles.p0[0][triangle], m_triangles.p0[1][triangle],
+             m_triangles.p0[2][triangle]);
+    Point3 b(m_triangles.p1[0][triangle], m_triangles.p1[1][triangle],
+             m_triangles.p1[2][triangle]);
+    Point3 c(m_triangles.p2[0][triangle], m_triangles.p2[1][triangle],
+             m_triangles.p2[2][triangle]);
+
+    rec.t = tHit;
+    rec.p = r.at(rec.t);
+
+    // Counter-clockwise triangles face the viewer.
+    rec.setFaceNormal(r, unitVector(cross(b - a, c - a)));
+}
+
+bool TriangleMesh::hit(const Ray& r, Interval ray_t, HitRecord& rec) const
+{
+    uint32_t triangle;
+    float tHit;
+
+    if (!intersect(r, ray_t, triangle, tHit))
+    {
+        return false;
+    }
+
+    surface(r, triangle, tHit, rec);
+    rec.material = &m_material->data();
+
+    return true;
+}
@@ -0,0 +1,88 @@
+/*
+ * This class represents an indexed triangle mesh: one shared vertex buffer
+ * and three 32-bit vertex indices per triangle. The mesh builds its own BVH
+ * whose leaves hold up to one vector width of triangles, copied in leaf
+ * order into a structure of arrays for the SIMD kernels of
+ * triangleKernels.h.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "sphereKernels.h"
+#include "triangleKernels.h"
+#include "../Hittables/bvh.h"
+#include "../Hittables/hittable.h"
+#include "../Materials/material.h"
+#include "../Math/aabb.h"
+#include "../Math/interval.h"
+#include "../Math/ray.h"
+#include "../Math/vector3.h"
+
+class TriangleMesh : public Hittable
+{
+public:
+    // Builds the BVH over the triangles. Every index must refer to a vertex;
+    // the material is only needed when the mesh is used as a Hittable.
+    TriangleMesh(std::vector<Point3> vertices, std::vector<uint32_t> indices,
+                 std::shared_ptr<Material> material = nullptr);
+
+    // Adopts triangles already in leaf order and the BVH built over them, as
+    // returned by indices() and tree() of another mesh.
+    TriangleMesh(std::vector<Point3> vertices, std::vector<uint32_t> indices,
+                 std::vector<BVHNode> nodes);
+
+    // Checks whether or not any triangle of the mesh was hit.
+    bool hit(const Ray& r, Interval ray_t, HitRecord& rec) const override;
+
+    AABB boundingBox() const override { return m_tree.bounds(); }
+
+    // Finds the nearest triangle hit within ray_t. Returns its index and
+    // distance without computing any shading information.
+    bool intersect(const Ray& r, Interval ray_t, uint32_t& triangle,
+                   float& tHit) const;
+
+    // Fills the position and (geometric) normal of a hit found by
+    // intersect().
+    void surface(const Ray& r, uint32_t triangle, float tHit,
+                 HitRecord& rec) const;
+
+    // Selects the intersection kernel. Unsupported kernels are ignored and
+    // false is returned.
+    bool setKernel(SphereKernel kernel);
+
+    SphereKernel kernel() const { return m_kernel; }
+
+    uint32_t triangleCount() const { return m_triangles.count; }
+
+    const std::vector<Point3>& vertices() const { return m_vertices; }
+
+    // Vertex indices of the triangles, in leaf order after the build.
+    const std::vector<uint32_t>& indices() const { return m_indices; }
+
+    const BVHTree& tree() const { return m_tree; }
+
+    const std::shared_ptr<Material>& material() const { return m_material; }
+
+private:
+    // Builds the BVH and reorders the triangles into leaf order.
+    void build();
+
+    // Copies the vertices of every triangle into the structure of arrays.
+    void gatherTriangles();
+
+    std::vector<Point3> m_vertices;
+    std::vector<uint32_t> m_indices;
+
+    TriangleSoA m_triangles;
+
+    BVHTree m_tree;
+
+    std::shared_ptr<Material> m_material;
+
+    SphereKernel m_kernel;
+    TriangleKernelFunction m_intersect;
+};
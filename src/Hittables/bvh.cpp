@@ -0,0 +1,380 @@
+#include "bvh.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "../Math/aabb.h"
+#include "../Math/interval.h"
+#include "../Math/ray.h"
+
+namespace
+{
+    // Number of candidate split planes evaluated per axis.
+    const int SAH_BIN_COUNT = 12;
+
+    // Cost of visiting an interior node relative to one primitive test.
+    const float SAH_TRAVERSAL_COST = 1.0f;
+
+    // Below this depth only object median splits are made. Each halves the
+    // primitives, so even 2^32 of them reach single-primitive leaves within
+    // the remaining 32 levels, whatever their distribution.
+    const int MEDIAN_SPLIT_DEPTH = BVHTree::MAX_DEPTH - 32;
+
+    struct SAHBin
+    {
+        AABB bounds;
+        uint32_t count = 0;
+    };
+
+    // Maps a centroid coordinate to its bin along the given axis.
+    int binIndex(float coordinate, const Interval& extent)
+    {
+        int bin = static_cast<int>(SAH_BIN_COUNT *
+                                   ((coordinate - extent.min) /
+                                    extent.size()));
+
+        return std::min(std::max(bin, 0), SAH_BIN_COUNT - 1);
+    }
+}
+
+void BVHTree::build(const std::vector<AABB>& primitiveBounds,
+                    int maxLeafSize, int leafWidth)
+{
+    m_maxLeafSize = std::max(1, std::min(maxLeafSize, 0xFFFF));
+    m_leafWidth = std::max(1, leafWidth);
+    m_nodes.clear();
+    m_primitiveIndices.clear();
+    m_motionBounds.clear();
+
+    if (primitiveBounds.empty())
+    {
+        return;
+    }
+
+    std::vector<BuildPrimitive> primitives(primitiveBounds.size());
+
+    for (size_t i = 0; i < primitiveBounds.size(); ++i)
+    {
+        primitives[i].bounds = primitiveBounds[i];
+        primitives[i].centroid = primitiveBounds[i].centroid();
+        primitives[i].index = static_cast<uint32_t>(i);
+    }
+
+    m_nodes.reserve(2 * primitives.size());
+    m_primitiveIndices.reserve(primitives.size());
+
+    buildRecursive(primitives, 0, static_cast<uint32_t>(primitives.size()),
+                   0);
+}
+
+void BVHTree::assign(std::vector<BVHNode> nodes, uint32_t primitiveCount)
+{
+    m_nodes = std::move(nodes);
+    m_primitiveIndices.resize(primitiveCount);
+    m_motionBounds.clear();
+
+    for (uint32_t i = 0; i < primitiveCount; ++i)
+    {
+        m_primitiveIndices[i] = i;
+    }
+}
+
+void BVHTree::setMotionBounds(const std::vector<AABB>& beginBounds,
+                              const std::vector<AABB>& endBounds)
+{
+    m_motionBounds.assign(m_nodes.size(), BVHMotionBounds());
+
+    // Children follow their parent, so a reverse sweep visits them first.
+    for (size_t i = m_nodes.size(); i-- > 0;)
+    {
+        BVHNode& node = m_nodes[i];
+        BVHMotionBounds& motion = m_motionBounds[i];
+
+        if (node.primitiveCount > 0)
+        {
+            for (uint32_t slot = node.offset;
+                 slot < node.offset + node.primitiveCount; ++slot)
+            {
+                uint32_t primitive = m_primitiveIndices[slot];
+
+                motion.begin = AABB(motion.begin, beginBounds[primitive]);
+                motion.end = AABB(motion.end, endBounds[primitive]);
+            }
+        }
+        else
+        {
+            const BVHMotionBounds& first = m_motionBounds[i + 1];
+            const BVHMotionBounds& second = m_motionBounds[node.offset];
+
+            motion.begin = AABB(first.begin, second.begin);
+            motion.end = AABB(first.end, second.end);
+        }
+
+        node.bounds = AABB(motion.begin, motion.end);
+    }
+}
+
+void BVHTree::refit(const std::vector<AABB>& primitiveBounds)
+{
+    // Children follow their parent, so a reverse sweep visits them first.
+    for (size_t i = m_nodes.size(); i-- > 0;)
+    {
+        BVHNode& node = m_nodes[i];
+
+        if (node.primitiveCount > 0)
+        {
+            AABB bounds;
+
+            for (uint32_t slot = node.offset;
+                 slot < node.offset + node.primitiveCount; ++slot)
+            {
+                bounds = AABB(bounds,
+                              primitiveBounds[m_primitiveIndices[slot]]);
+            }
+
+            node.bounds = bounds;
+        }
+        else
+        {
+            node.bounds = AABB(m_nodes[i + 1].bounds,
+                               m_nodes[node.offset].bounds);
+        }
+    }
+}
+
+float BVHTree::cost() const
+{
+    if (m_nodes.empty() || m_nodes[0].bounds.surfaceArea() <= 0.0f)
+    {
+        return 0.0f;
+    }
+
+    float total = 0.0f;
+
+    for (const BVHNode& node : m_nodes)
+    {
+        float tests = node.primitiveCount > 0 ?
+                      static_cast<float>((node.primitiveCount +
+                                          m_leafWidth - 1) / m_leafWidth) :
+                      SAH_TRAVERSAL_COST;
+
+        total += node.bounds.surfaceArea() * tests;
+    }
+
+    return total / m_nodes[0].bounds.surfaceArea();
+}
+
+uint32_t BVHTree::buildRecursive(std::vector<BuildPrimitive>& primitives,
+                                 uint32_t begin, uint32_t end, int depth)
+{
+    uint32_t nodeIndex = static_cast<uint32_t>(m_nodes.size());
+    m_nodes.emplace_back();
+
+    AABB bounds;
+    AABB centroidBounds;
+
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        bounds = AABB(bounds, primitives[i].bounds);
+        centroidBounds = AABB(centroidBounds,
+                              AABB(primitives[i].centroid,
+                                   primitives[i].centroid));
+    }
+
+    m_nodes[nodeIndex].bounds = bounds;
+
+    uint32_t count = end - begin;
+
+    if (count == 1)
+    {
+        makeLeaf(m_nodes[nodeIndex], primitives, begin, end);
+
+        return nodeIndex;
+    }
+
+    // Evaluate the surface area heuristic at every bin boundary of every
+    // axis and keep the cheapest split. Clustered primitives can make it
+    // peel off a few at a time, so deep nodes skip it to bound the depth.
+    float bestCost = INF;
+    int bestAxis = -1;
+    int bestSplit = 0;
+    int sahAxisCount = depth < MEDIAN_SPLIT_DEPTH ? 3 : 0;
+
+    for (int axis = 0; axis < sahAxisCount; ++axis)
+    {
+        const Interval& extent = centroidBounds.axis(axis);
+
+        if (extent.size() <= 0.0f)
+        {
+            continue;
+        }
+
+        SAHBin bins[SAH_BIN_COUNT];
+
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            SAHBin& bin = bins[binIndex(primitives[i].centroid[axis], extent)];
+            bin.bounds = AABB(bin.bounds, primitives[i].bounds);
+            ++bin.count;
+        }
+
+        // Sweep from the right to accumulate the area of each right side.
+        float rightArea[SAH_BIN_COUNT];
+        uint32_t rightCount[SAH_BIN_COUNT];
+        AABB accumulated;
+        uint32_t accumulatedCount = 0;
+
+        for (int b = SAH_BIN_COUNT - 1; b > 0; --b)
+        {
+            accumulated = AABB(accumulated, bins[b].bounds);
+            accumulatedCount += bins[b].count;
+            rightArea[b] = accumulated.surfaceArea();
+            rightCount[b] = accumulatedCount;
+        }
+
+        accumulated = AABB();
+        accumulatedCount = 0;
+
+        for (int b = 1; b < SAH_BIN_COUNT; ++b)
+        {
+            accumulated = AABB(accumulated, bins[b - 1].bounds);
+            accumulatedCount += bins[b - 1].count;
+
+            if (accumulatedCount == 0 || rightCount[b] == 0)
+            {
+                continue;
+            }
+
+            float cost = accumulated.surfaceArea() * accumulatedCount +
+                         rightArea[b] * rightCount[b];
+
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = b;
+            }
+        }
+    }
+
+    float parentArea = bounds.surfaceArea();
+    float leafCost = static_cast<float>((count + m_leafWidth - 1) /
+                                        m_leafWidth);
+
+    if (bestAxis >= 0 && parentArea > 0.0f)
+    {
+        bestCost = SAH_TRAVERSAL_COST + bestCost / parentArea;
+    }
+
+    if (count <= static_cast<uint32_t>(m_maxLeafSize) && leafCost <= bestCost)
+    {
+        makeLeaf(m_nodes[nodeIndex], primitives, begin, end);
+
+        return nodeIndex;
+    }
+
+    uint32_t mid = begin;
+
+    if (bestAxis >= 0)
+    {
+        const Interval& extent = centroidBounds.axis(bestAxis);
+
+        auto split = std::partition(primitives.begin() + begin,
+                                    primitives.begin() + end,
+                                    [&](const BuildPrimitive& p)
+                                    {
+                                        return binIndex(p.centroid[bestAxis],
+                                                        extent) < bestSplit;
+                                    });
+
+        mid = static_cast<uint32_t>(split - primitives.begin());
+    }
+
+    // Fall back to an object median split when the primitives could not be
+    // separated (e.g. coincident centroids).
+    if (mid == begin || mid == end)
+    {
+        int axis = centroidBounds.longestAxis();
+        mid = begin + count / 2;
+
+        std::nth_element(primitives.begin() + begin, primitives.begin() + mid,
+                         primitives.begin() + end,
+                         [axis](const BuildPrimitive& a,
+                                const BuildPrimitive& b)
+                         {
+                             return a.centroid[axis] < b.centroid[axis];
+                         });
+
+        bestAxis = axis;
+    }
+
+    m_nodes[nodeIndex].axis = static_cast<uint8_t>(bestAxis);
+    m_nodes[nodeIndex].primitiveCount = 0;
+
+    // The first child is always stored right after its parent.
+    buildRecursive(primitives, begin, mid, depth + 1);
+    uint32_t secondChild = buildRecursive(primitives, mid, end, depth + 1);
+
+    m_nodes[nodeIndex].offset = secondChild;
+
+    return nodeIndex;
+}
+
+void BVHTree::makeLeaf(BVHNode& node, std::vector<BuildPrimitive>& primitives,
+                       uint32_t begin, uint32_t end)
+{
+    node.offset = static_cast<uint32_t>(m_primitiveIndices.size());
+    node.primitiveCount = static_cast<uint16_t>(end - begin);
+    node.axis = 0;
+
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        m_primitiveIndices.push_back(primitives[i].index);
+    }
+}
+
+BVH::BVH(const HittableList& list, int maxLeafSize)
+{
+    const auto& objects = list.objects();
+
+    std::vector<AABB> bounds;
+    bounds.reserve(objects.size());
+
+    for (const auto& object : objects)
+    {
+        bounds.push_back(object->boundingBox());
+    }
+
+    m_tree.build(bounds, maxLeafSize);
+
+    // Store the objects in leaf order so leaves index them directly.
+    m_objects.reserve(objects.size());
+
+    for (uint32_t index : m_tree.primitiveIndices())
+    {
+        m_objects.push_back(objects[index]);
+    }
+}
+
+bool BVH::hit(const Ray& r, Interval ray_t, HitRecord& rec) const
+{
+    return m_tree.traverse(r, ray_t,
+                           [&](uint32_t first, uint32_t count, Interval range,
+                               float& closestSoFar)
+                           {
+                               bool wasHit = false;
+
+                               for (uint32_t i = first; i < first + count; ++i)
+                               {
+                                   if (m_objects[i]->hit(r,
+                                           Interval(range.min, closestSoFar),
+                                           rec))
+                                   {
+                                       wasHit = true;
+                                       closestSoFar = rec.t;
+                                   }
+                               }
+
+                               return wasHit;
+                           });
+}
@@ -0,0 +1,320 @@
+/*
+ * This file provides a bounding volume hierarchy (BVH) built with the surface
+ * area heuristic (SAH). BVHTree holds the flattened node array and is shared
+ * by every acceleration structure in the codebase, while BVH wraps it as a
+ * Hittable built over the objects of a HittableList.
+ *
+ * For moving primitives a BVHTree can also keep every node's bounds at both
+ * ends of the shutter interval. Rays then test the box interpolated to
+ * their time instead of the box swept over the whole interval, which stays
+ * as tight as a static BVH however far the primitives move.
+ */
+
+#pragma once
+
+#include "hittable.h"
+#include "hittableList.h"
+
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "../Math/aabb.h"
+#include "../Math/ray.h"
+#include "../Math/interval.h"
+#include "../Render/stats.h"
+
+struct BVHNode
+{
+    // Bounds of every primitive below this node.
+    AABB bounds;
+
+    // Leaf: index of the first primitive. Interior: index of the second
+    // child (the first child always immediately follows its parent).
+    uint32_t offset;
+
+    // Number of primitives in a leaf (zero for interior nodes).
+    uint16_t primitiveCount;
+
+    // Split axis of an interior node.
+    uint8_t axis;
+};
+
+// Bounds of a node at the start and the end of the shutter interval.
+struct BVHMotionBounds
+{
+    AABB begin;
+    AABB end;
+
+    // Checks whether or not the ray passes through the bounds interpolated
+    // to its time, which enclose every primitive of the node that moves
+    // linearly. Like AABB::hit(), but each axis is only interpolated once
+    // the previous ones overlap.
+    bool hit(const Point3& origin, const Vector3& invDirection, float time,
+             Interval ray_t, float& tEnter) const
+    {
+        for (int a = 0; a < 3; ++a)
+        {
+            const Interval& first = begin.axis(a);
+            const Interval& last = end.axis(a);
+
+            float low = first.min + time * (last.min - first.min);
+            float high = first.max + time * (last.max - first.max);
+
+            float t0 = (low - origin[a]) * invDirection[a];
+            float t1 = (high - origin[a]) * invDirection[a];
+
+            if (invDirection[a] < 0.0f)
+            {
+                float temp = t0;
+                t0 = t1;
+                t1 = temp;
+            }
+
+            ray_t.min = t0 > ray_t.min ? t0 : ray_t.min;
+            ray_t.max = t1 < ray_t.max ? t1 : ray_t.max;
+
+            if (ray_t.max <= ray_t.min)
+            {
+                return false;
+            }
+        }
+
+        tEnter = ray_t.min;
+
+        return true;
+    }
+};
+
+class BVHTree
+{
+public:
+    // Deepest level of a node below the root (at level 0). build() never
+    // exceeds it and traversal sizes its stack by it, so hierarchies from
+    // elsewhere (see assign()) must be checked against it.
+    static const int MAX_DEPTH = 64;
+
+    // Builds the hierarchy over the given primitive bounds. Leaves reference
+    // contiguous ranges of primitiveIndices(). leafWidth is the number of
+    // primitives a leaf intersects at the cost of one (e.g. a SIMD width).
+    void build(const std::vector<AABB>& primitiveBounds, int maxLeafSize = 4,
+               int leafWidth = 1);
+
+    // Returns a box enclosing the whole hierarchy.
+    AABB bounds() const
+    {
+        return m_nodes.empty() ? AABB() : m_nodes[0].bounds;
+    }
+
+    // Maps each leaf slot to the index of the primitive passed to build().
+    const std::vector<uint32_t>& primitiveIndices() const
+    {
+        return m_primitiveIndices;
+    }
+
+    const std::vector<BVHNode>& nodes() const { return m_nodes; }
+
+    // Adopts a hierarchy built earlier (e.g. loaded from a scene cache)
+    // whose leaves reference primitives [0, primitiveCount) in order.
+    void assign(std::vector<BVHNode> nodes, uint32_t primitiveCount);
+
+    // Computes the bounds of every node at both ends of the shutter interval
+    // from those of the primitives (indexed like the bounds passed to
+    // build()), which traversal then interpolates by ray time. The node
+    // bounds become the union of both ends. Building or assigning a new
+    // hierarchy drops the motion bounds.
+    void setMotionBounds(const std::vector<AABB>& beginBounds,
+                         const std::vector<AABB>& endBounds);
+
+    bool hasMotionBounds() const { return !m_motionBounds.empty(); }
+
+    // Recomputes the bounds of every node from new primitive bounds
+    // (indexed like those passed to build()) while keeping the hierarchy.
+    // This is far cheaper than a rebuild, but the hierarchy gets worse as
+    // the primitives move away from where it was built (see cost()).
+    void refit(const std::vector<AABB>& primitiveBounds);
+
+    // Surface area heuristic cost of the hierarchy: the expected number of
+    // node visits and primitive tests (counted per leaf width) of a ray
+    // passing through the root.
+    float cost() const;
+
+    // Walks the hierarchy front to back. For every leaf reached, calls
+    // intersectLeaf(first, count, ray_t, closestSoFar), which must return
+    // whether a primitive was hit and shrink closestSoFar accordingly.
+    template <typename LeafFunction>
+    bool traverse(const Ray& r, Interval ray_t,
+                  LeafFunction&& intersectLeaf) const;
+
+private:
+    struct BuildPrimitive
+    {
+        AABB bounds;
+        Point3 centroid;
+        uint32_t index;
+    };
+
+    // Recursively builds the node for primitives [begin, end) at the given
+    // depth and returns its index.
+    uint32_t buildRecursive(std::vector<BuildPrimitive>& primitives,
+                            uint32_t begin, uint32_t end, int depth);
+
+    // Appends a leaf holding primitives [begin, end) to the node array.
+    void makeLeaf(BVHNode& node, std::vector<BuildPrimitive>& primitives,
+                  uint32_t begin, uint32_t end);
+
+    int m_maxLeafSize = 4;
+    int m_leafWidth = 1;
+
+    // Tests the ray against the bounds of a node at the ray's time.
+    bool hitNode(uint32_t node, const Point3& origin,
+                 const Vector3& invDirection, float time, Interval ray_t,
+                 float& tEnter) const
+    {
+        if (m_motionBounds.empty())
+        {
+            return m_nodes[node].bounds.hit(origin, invDirection, ray_t,
+                                            tEnter);
+        }
+
+        return m_motionBounds[node].hit(origin, invDirection, time, ray_t,
+                                        tEnter);
+    }
+
+    std::vector<BVHNode> m_nodes;
+    std::vector<uint32_t> m_primitiveIndices;
+
+    // Per-node bounds at both shutter ends (empty for static hierarchies).
+    std::vector<BVHMotionBounds> m_motionBounds;
+};
+
+class BVH : public Hittable
+{
+public:
+    // Builds the hierarchy over every object in the list.
+    BVH(const HittableList& list, int maxLeafSize = 4);
+
+    // Checks whether or not any of the primitives in the BVH were hit.
+    bool hit(const Ray& r, Interval ray_t, HitRecord& rec) const override;
+
+    AABB boundingBox() const override { return m_tree.bounds(); }
+
+private:
+    // Objects reordered so that every leaf covers a contiguous range.
+    std::vector<std::shared_ptr<Hittable>> m_objects;
+
+    BVHTree m_tree;
+};
+
+template <typename LeafFunction>
+inline bool BVHTree::traverse(const Ray& r, Interval ray_t,
+                              LeafFunction&& intersectLeaf) const
+{
+    struct StackEntry
+    {
+        uint32_t node;
+        float tEnter;
+    };
+
+    if (m_nodes.empty())
+    {
+        return false;
+    }
+
+    Point3 origin = r.origin();
+    Vector3 direction = r.direction();
+    Vector3 invDirection(1.0f / direction.x(), 1.0f / direction.y(),
+                         1.0f / direction.z());
+    float time = r.time();
+
+    float tEnter;
+
+    if (!hitNode(0, origin, invDirection, time, ray_t, tEnter))
+    {
+        return false;
+    }
+
+    // A node at depth d has at most d deferred siblings above it.
+    StackEntry stack[MAX_DEPTH];
+    int stackSize = 0;
+
+    uint32_t current = 0;
+    float closestSoFar = ray_t.max;
+    bool wasHit = false;
+
+    while (true)
+    {
+        const BVHNode& node = m_nodes[current];
+        RT_STATS_ADD(nodesVisited, 1);
+
+        if (node.primitiveCount > 0)
+        {
+            if (intersectLeaf(node.offset, node.primitiveCount,
+                              Interval(ray_t.min, closestSoFar),
+                              closestSoFar))
+            {
+                wasHit = true;
+            }
+        }
+        else
+        {
+            // Visit the child the ray enters first and defer the other one.
+            uint32_t nearChild = current + 1;
+            uint32_t farChild = node.offset;
+            Interval range(ray_t.min, closestSoFar);
+
+            float tNear, tFar;
+            bool hitNear = hitNode(nearChild, origin, invDirection, time,
+                                   range, tNear);
+            bool hitFar = hitNode(farChild, origin, invDirection, time, range,
+                                  tFar);
+
+            if (hitNear && hitFar)
+            {
+                if (tFar < tNear)
+                {
+                    std::swap(nearChild, farChild);
+                    std::swap(tNear, tFar);
+                }
+
+                assert(stackSize < MAX_DEPTH);
+                stack[stackSize++] = {farChild, tFar};
+                current = nearChild;
+
+                continue;
+            }
+
+            if (hitNear || hitFar)
+            {
+                current = hitNear ? nearChild : farChild;
+
+                continue;
+            }
+        }
+
+        // Pop the next deferred node that may still hold a closer hit.
+        bool found = false;
+
+        while (stackSize > 0)
+        {
+            const StackEntry& entry = stack[--stackSize];
+
+            if (entry.tEnter < closestSoFar)
+            {
+                current = entry.node;
+                found = true;
+
+                break;
+            }
+        }
+
+        if (!found)
+        {
+            break;
+        }
+    }
+
+    return wasHit;
+}
@@ -6,18 +6,28 @@
 
 #pragma once
 
-#include <memory>
+#include <cstdint>
 
-#include "../Materials/material.h"
 #include "../Math/vector3.h"
 #include "../Math/ray.h"
 #include "../Math/interval.h"
+#include "../Math/aabb.h"
+
+// Forward declarations.
+struct HitRecord;
+struct MaterialData;
+
+// Light of a hit surface that the scene's light set does not sample.
+const uint32_t NO_LIGHT = 0xFFFFFFFFu;
 
 class Hittable
 {
 public:
     // Checks whether or not the general primitive was hit.
     virtual bool hit(const Ray& r, Interval ray_t, HitRecord& rec) const = 0;
+
+    // Returns a box enclosing the primitive over the whole shutter interval.
+    virtual AABB boundingBox() const = 0;
 };
 
 struct HitRecord
@@ -33,8 +43,12 @@ struct HitRecord
 
     Vector3 normal;
 
-    // Pointer to primitive material type.
-    std::shared_ptr<Material> matPtr;
+    // Material of the primitive (an entry of the scene's material table,
+    // never owned by the record).
+    const MaterialData* material = nullptr;
+
+    // Index of the surface in the scene's light set, or NO_LIGHT.
+    uint32_t light = NO_LIGHT;
 
     // Negates the surface normal direction, if required.
     inline void setFaceNormal(const Ray& r, const Vector3& outwardNormal)
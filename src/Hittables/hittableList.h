@@ -23,18 +23,34 @@ public:
     HittableList(std::shared_ptr<Hittable> object);
 
     // Clears all objects in the HittableList.
-    inline void clear() { m_objects.clear(); }
+    inline void clear()
+    {
+        m_objects.clear();
+        m_bbox = AABB();
+    }
 
     // Adds an object to the HittableList.
     inline void add(std::shared_ptr<Hittable> object)
     {
         m_objects.push_back(object);
+        m_bbox = AABB(m_bbox, object->boundingBox());
     }
 
+    // Returns all objects in the HittableList.
+    inline const std::vector<std::shared_ptr<Hittable>>& objects() const
+    {
+        return m_objects;
+    }
+
+    // Returns a box enclosing every object in the HittableList.
+    AABB boundingBox() const override { return m_bbox; }
+
 private:
     // Checks whether or not any of the primitives in the HittableList were
     // hit.
     bool hit(const Ray& r, Interval interval, HitRecord& rec) const override;
 
     std::vector<std::shared_ptr<Hittable>> m_objects;
+
+    AABB m_bbox;
 };
@@ -0,0 +1,23 @@
+#include "instance.h"
+
+#include <utility>
+
+Instance::Instance(std::shared_ptr<Hittable> object,
+                   const Transform& transform) :
+                   m_object(std::move(object)), m_transform(transform),
+                   m_bbox(transform.bounds(m_object->boundingBox())) {}
+
+bool Instance::hit(const Ray& r, Interval ray_t, HitRecord& rec) const
+{
+    if (!m_object->hit(m_transform.toObject(r), ray_t, rec))
+    {
+        return false;
+    }
+
+    // Distances agree in both spaces, and the normal keeps facing against
+    // the ray, so only the point and the normal need to move.
+    rec.p = r.at(rec.t);
+    rec.normal = unitVector(m_transform.normal(rec.normal));
+
+    return true;
+}
@@ -0,0 +1,43 @@
+/*
+ * This class places shared geometry in the scene with an affine transform.
+ * The geometry (and its acceleration structure) is referenced, not copied,
+ * so any number of instances cost one transform each; rays are moved into
+ * object space when they are intersected.
+ */
+
+#pragma once
+
+#include "hittable.h"
+
+#include <memory>
+
+#include "../Math/aabb.h"
+#include "../Math/interval.h"
+#include "../Math/ray.h"
+#include "../Math/transform.h"
+
+class Instance : public Hittable
+{
+public:
+    // Places object with the given transform; the linear part of the
+    // transform must be invertible.
+    Instance(std::shared_ptr<Hittable> object, const Transform& transform);
+
+    // Checks whether or not the transformed object was hit.
+    bool hit(const Ray& r, Interval ray_t, HitRecord& rec) const override;
+
+    AABB boundingBox() const override { return m_bbox; }
+
+    const std::shared_ptr<Hittable>& object() const { return m_object; }
+
+    const Transform& transform() const { return m_transform; }
+
+private:
+    std::shared_ptr<Hittable> m_object;
+
+    // Object to world transform.
+    Transform m_transform;
+
+    // World space bounds.
+    AABB m_bbox;
+};
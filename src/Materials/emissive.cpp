@@ -0,0 +1,7 @@
+#include "emissive.h"
+
+#include "materialData.h"
+#include "../Math/vector3.h"
+
+Emissive::Emissive(const Color& emission) :
+                   Material(MaterialData::emissive(emission)) {}
@@ -0,0 +1,17 @@
+/*
+ * This class represents a light source: a surface that emits light from its
+ * front face and absorbs all light reaching it.
+ */
+
+#pragma once
+
+#include "material.h"
+
+#include "../Math/vector3.h"
+
+class Emissive : public Material
+{
+public:
+    // Default constructor.
+    Emissive(const Color& emission);
+};
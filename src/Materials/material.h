@@ -1,19 +1,70 @@
 /*
- * This is an abstract class that represents a generic material.
+ * This class represents a generic material. It is a thin wrapper around a
+ * MaterialData record, kept so scenes can still be assembled from shared
+ * Material objects; rendering only uses the plain data (see materialData.h).
  */
 
 #pragma once
 
+#include "materialData.h"
+
 #include "../Math/vector3.h"
 #include "../Math/ray.h"
 
-// Forward declaration.
+// Forward declarations.
 struct HitRecord;
+class Sampler;
 
 class Material
 {
 public:
-    // Scatters light rays according to the material.
+    // Initialization constructor.
+    Material(const MaterialData& data) : m_data(data) {}
+
+    virtual ~Material() = default;
+
+    // Scatters light rays according to the material, drawing the random
+    // decisions from the sampler's dimensions for the current bounce.
     virtual bool scatter(const Ray& inputRay, const HitRecord& rec,
-                         Color& attenuation, Ray& scattered) const = 0;
+                         Color& attenuation, Ray& scattered,
+                         Sampler& sampler) const
+    {
+        return ::scatter(m_data, inputRay, rec, attenuation, scattered,
+                         sampler);
+    }
+
+    // Picks a scattered direction with its reflected light and density
+    // (see sampleScatter).
+    virtual bool sample(const Ray& inputRay, const HitRecord& rec,
+                        Sampler& sampler, ScatterSample& result) const
+    {
+        return sampleScatter(m_data, inputRay, rec, sampler, result);
+    }
+
+    // Returns the light reflected towards the input ray per unit of
+    // radiance arriving from direction (see evaluateScatter).
+    virtual Color evaluate(const Ray& inputRay, const HitRecord& rec,
+                           const Vector3& direction) const
+    {
+        return evaluateScatter(m_data, inputRay, rec, direction);
+    }
+
+    // Returns the solid angle density with which sample picks direction.
+    virtual float pdf(const Ray& inputRay, const HitRecord& rec,
+                      const Vector3& direction) const
+    {
+        return scatterPdf(m_data, inputRay, rec, direction);
+    }
+
+    // Returns the radiance emitted towards the ray that hit the surface.
+    virtual Color emitted(const HitRecord& rec) const
+    {
+        return ::emitted(m_data, rec);
+    }
+
+    // Returns the plain data describing the material.
+    const MaterialData& data() const { return m_data; }
+
+protected:
+    MaterialData m_data;
 };
@@ -0,0 +1,301 @@
+#include "materialData.h"
+
+#include <cmath>
+
+#include "microfacet.h"
+#include "../Hittables/hittable.h"
+#include "../Math/utilities.h"
+#include "../Math/vector3.h"
+#include "../Math/ray.h"
+#include "../Sampling/sampler.h"
+#include "../Sampling/warp.h"
+
+namespace
+{
+    // Returns a float with reflectivity that varies with angle.
+    float reflectance(const float cosine, const float refIdx)
+    {
+        // Use Schlick's approximation for reflectance.
+        float r0 = (1.0f - refIdx) / (1.0f + refIdx);
+        r0 = r0 * r0;
+
+        return r0 + (1.0f - r0) * powf((1.0f - cosine), 5);
+    }
+
+    // Smallest fuzz that is not a mirror; rougher GGX lobes than this
+    // stay within float range.
+    const float MIN_FUZZ = 1e-3f;
+
+    // GGX roughness of a metal (see sampleMetal).
+    float metalRoughness(const MaterialData& material)
+    {
+        return 0.5f * material.fuzz;
+    }
+}
+
+bool sampleDiffuse(const MaterialData& material, const Ray& inputRay,
+                   const HitRecord& rec, Sampler& sampler,
+                   ScatterSample& sample)
+{
+    ShadingFrame frame(rec.normal);
+    Vector3 local = sampleCosineHemisphere(sampler.get2D());
+    float cosine = local.z();
+
+    sample.direction = frame.toWorld(local);
+    sample.pdf = cosine / PI;
+    sample.value = sample.pdf * material.albedo;
+    sample.weight = material.albedo;
+
+    return true;
+}
+
+bool sampleMetal(const MaterialData& material, const Ray& inputRay,
+                 const HitRecord& rec, Sampler& sampler,
+                 ScatterSample& sample)
+{
+    Vector3 unitDirection = unitVector(inputRay.direction());
+
+    if (material.fuzz <= 0.0f)
+    {
+        sample.direction = reflect(unitDirection, rec.normal);
+        sample.pdf = 0.0f;
+        sample.value = schlickFresnel(material.albedo,
+                                      -dot(unitDirection, rec.normal));
+        sample.weight = sample.value;
+
+        return dot(sample.direction, rec.normal) > 0.0f;
+    }
+
+    ShadingFrame frame(rec.normal);
+    Vector3 wo = frame.toLocal(-unitDirection);
+    float alpha = metalRoughness(material);
+
+    if (wo.z() <= 0.0f)
+    {
+        return false;
+    }
+
+    Vector3 h = sampleGGXVisibleNormal(wo, alpha, sampler.get2D());
+    float cosine = dot(wo, h);
+    Vector3 wi = 2.0f * cosine * h - wo;
+
+    // Facets may reflect the ray below the surface, where it is lost.
+    if (wi.z() <= 0.0f)
+    {
+        return false;
+    }
+
+    Color fresnel = schlickFresnel(material.albedo, cosine);
+    float distribution = ggxDistribution(h, alpha);
+    float masking = ggxMasking(wo, alpha);
+    float maskingShadowing = ggxMaskingShadowing(wo, wi, alpha);
+
+    sample.direction = frame.toWorld(wi);
+    sample.pdf = masking * distribution / (4.0f * wo.z());
+    sample.value = (distribution * maskingShadowing / (4.0f * wo.z())) *
+                   fresnel;
+    sample.weight = (maskingShadowing / masking) * fresnel;
+
+    return true;
+}
+
+bool sampleGlass(const MaterialData& material, const Ray& inputRay,
+                 const HitRecord& rec, Sampler& sampler,
+                 ScatterSample& sample)
+{
+    // Calculate refraction ratio.
+    float refractionRatio = rec.frontFace ?
+                            (1.0f / material.refractionIndex) :
+                            material.refractionIndex;
+
+    Vector3 unitDirection = unitVector(inputRay.direction());
+
+    float cosTheta = fmin(dot(-unitDirection, rec.normal), 1.0f);
+    float sinTheta = sqrt(1.0f - cosTheta * cosTheta);
+
+    bool cannotRefract = refractionRatio * sinTheta > 1.0f;
+
+    if (cannotRefract ||
+        reflectance(cosTheta, refractionRatio) > sampler.get1D())
+    {
+        sample.direction = reflect(unitDirection, rec.normal);
+    }
+    else
+    {
+        sample.direction = refract(unitDirection, rec.normal,
+                                   refractionRatio);
+    }
+
+    sample.pdf = 0.0f;
+    sample.value = Color(1.0f, 1.0f, 1.0f);
+    sample.weight = sample.value;
+
+    return true;
+}
+
+bool sampleEmissive(const MaterialData& material, const Ray& inputRay,
+                    const HitRecord& rec, Sampler& sampler,
+                    ScatterSample& sample)
+{
+    return false;
+}
+
+MaterialData MaterialData::diffuse(const Color& albedo)
+{
+    MaterialData material;
+    material.type = MaterialType::Diffuse;
+    material.albedo = albedo;
+
+    return material;
+}
+
+MaterialData MaterialData::metal(const Color& albedo, float fuzz)
+{
+    MaterialData material;
+    material.type = MaterialType::Metal;
+    material.albedo = albedo;
+    material.fuzz = fuzz < 1.0f ? fuzz : 1.0f;
+
+    if (!(material.fuzz >= MIN_FUZZ))
+    {
+        material.fuzz = 0.0f;
+    }
+
+    return material;
+}
+
+MaterialData MaterialData::glass(float refractionIndex)
+{
+    MaterialData material;
+    material.type = MaterialType::Glass;
+    material.albedo = Color(1.0f, 1.0f, 1.0f);
+    material.refractionIndex = refractionIndex;
+
+    return material;
+}
+
+MaterialData MaterialData::emissive(const Color& emission)
+{
+    MaterialData material;
+    material.type = MaterialType::Emissive;
+    material.emission = emission;
+
+    return material;
+}
+
+bool sampleScatter(const MaterialData& material, const Ray& inputRay,
+                   const HitRecord& rec, Sampler& sampler,
+                   ScatterSample& sample)
+{
+    switch (material.type)
+    {
+    case MaterialType::Diffuse:
+        return sampleDiffuse(material, inputRay, rec, sampler, sample);
+    case MaterialType::Metal:
+        return sampleMetal(material, inputRay, rec, sampler, sample);
+    case MaterialType::Glass:
+        return sampleGlass(material, inputRay, rec, sampler, sample);
+    case MaterialType::Emissive:
+        return sampleEmissive(material, inputRay, rec, sampler, sample);
+    }
+
+    return false;
+}
+
+bool scatter(const MaterialData& material, const Ray& inputRay,
+             const HitRecord& rec, Color& attenuation, Ray& scattered,
+             Sampler& sampler)
+{
+    ScatterSample sample;
+
+    if (!sampleScatter(material, inputRay, rec, sampler, sample))
+    {
+        return false;
+    }
+
+    attenuation = sample.weight;
+    scattered = Ray(rec.p, sample.direction, inputRay.time());
+
+    return true;
+}
+
+Color evaluateScatter(const MaterialData& material, const Ray& inputRay,
+                      const HitRecord& rec, const Vector3& direction)
+{
+    Vector3 unitDirection = unitVector(direction);
+
+    if (material.type == MaterialType::Diffuse)
+    {
+        // Lambertian reflection: albedo / pi times the cosine.
+        float cosine = dot(unitDirection, rec.normal);
+
+        return cosine > 0.0f ? (cosine / PI) * material.albedo :
+                               Color(0.0f, 0.0f, 0.0f);
+    }
+
+    if (!hasScatterPdf(material))
+    {
+        return Color(0.0f, 0.0f, 0.0f);
+    }
+
+    // GGX reflection: F D G / (4 cos(wo) cos(wi)) times cos(wi).
+    ShadingFrame frame(rec.normal);
+    Vector3 wo = frame.toLocal(-unitVector(inputRay.direction()));
+    Vector3 wi = frame.toLocal(unitDirection);
+
+    if (wo.z() <= 0.0f || wi.z() <= 0.0f)
+    {
+        return Color(0.0f, 0.0f, 0.0f);
+    }
+
+    float alpha = metalRoughness(material);
+    Vector3 h = unitVector(wo + wi);
+
+    return (ggxDistribution(h, alpha) * ggxMaskingShadowing(wo, wi, alpha) /
+            (4.0f * wo.z())) *
+           schlickFresnel(material.albedo, dot(wo, h));
+}
+
+float scatterPdf(const MaterialData& material, const Ray& inputRay,
+                 const HitRecord& rec, const Vector3& direction)
+{
+    Vector3 unitDirection = unitVector(direction);
+
+    if (material.type == MaterialType::Diffuse)
+    {
+        float cosine = dot(unitDirection, rec.normal);
+
+        return cosine > 0.0f ? cosine / PI : 0.0f;
+    }
+
+    if (!hasScatterPdf(material))
+    {
+        return 0.0f;
+    }
+
+    // Visible normal density over the Jacobian of the reflection.
+    ShadingFrame frame(rec.normal);
+    Vector3 wo = frame.toLocal(-unitVector(inputRay.direction()));
+    Vector3 wi = frame.toLocal(unitDirection);
+
+    if (wo.z() <= 0.0f || wi.z() <= 0.0f)
+    {
+        return 0.0f;
+    }
+
+    float alpha = metalRoughness(material);
+    Vector3 h = unitVector(wo + wi);
+
+    return ggxMasking(wo, alpha) * ggxDistribution(h, alpha) /
+           (4.0f * wo.z());
+}
+
+Color emitted(const MaterialData& material, const HitRecord& rec)
+{
+    if (material.type != MaterialType::Emissive || !rec.frontFace)
+    {
+        return Color(0.0f, 0.0f, 0.0f);
+    }
+
+    return material.emission;
+}
@@ -0,0 +1,147 @@
+/*
+ * This file provides the plain data representation of every material the
+ * renderer supports. Scenes keep their materials in a flat table of
+ * MaterialData referenced by 32-bit indices, and scattering dispatches on
+ * the material type with a switch instead of a virtual call.
+ *
+ * Materials sample a scattered direction together with the light they
+ * reflect along it and its density (a ScatterSample), and can evaluate both
+ * for any other direction. Light sampling uses them to weigh shadow rays
+ * against scattered rays (multiple importance sampling). Every sampling
+ * routine is closed form, so each consumes a fixed set of sampler
+ * dimensions.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "../Math/vector3.h"
+#include "../Math/ray.h"
+
+// Forward declarations.
+struct HitRecord;
+class Sampler;
+
+enum class MaterialType : uint8_t
+{
+    Diffuse,
+    Metal,
+    Glass,
+    Emissive
+};
+
+// Number of MaterialType values.
+const int MATERIAL_TYPE_COUNT = 4;
+
+struct MaterialData
+{
+    MaterialType type = MaterialType::Diffuse;
+
+    // Reflected color (diffuse and metal).
+    Color albedo;
+
+    // Roughness of the reflection (metal), from 0 (a mirror) to 1.
+    float fuzz = 0.0f;
+
+    // Index of refraction (glass).
+    float refractionIndex = 1.0f;
+
+    // Radiance leaving the front face (emissive).
+    Color emission;
+
+    // Lambertian surface of the given color.
+    static MaterialData diffuse(const Color& albedo);
+
+    // Reflective surface; fuzz is clamped to [0, 1], and values too small to
+    // see become a mirror.
+    static MaterialData metal(const Color& albedo, float fuzz);
+
+    // Dielectric with the given index of refraction.
+    static MaterialData glass(float refractionIndex);
+
+    // Light source that absorbs the light reaching it.
+    static MaterialData emissive(const Color& emission);
+};
+
+// A direction picked by sampleScatter and the light the surface reflects
+// along it.
+struct ScatterSample
+{
+    // Unit direction of the scattered ray.
+    Vector3 direction;
+
+    // Light reflected towards the input ray per unit of radiance arriving
+    // from direction, as evaluateScatter returns it.
+    Color value;
+
+    // Solid angle density of direction; 0 for the single direction of a
+    // mirror or glass, which no other strategy can pick.
+    float pdf = 0.0f;
+
+    // Factor the path throughput is multiplied by: value / pdf, computed
+    // without the division where it cancels, or the reflected fraction of
+    // a single direction.
+    Color weight;
+};
+
+// Picks a direction with a density proportional to its cosine with the
+// normal, in the normal's shading frame.
+bool sampleDiffuse(const MaterialData& material, const Ray& inputRay,
+                   const HitRecord& rec, Sampler& sampler,
+                   ScatterSample& sample);
+
+// Reflects about the normal (without fuzz) or about a GGX microfacet normal
+// visible from the input ray (see microfacet.h). The roughness of the
+// facets is half the fuzz, about the spread of a reflection that used to
+// be perturbed within a ball of radius fuzz.
+bool sampleMetal(const MaterialData& material, const Ray& inputRay,
+                 const HitRecord& rec, Sampler& sampler,
+                 ScatterSample& sample);
+
+// Refracts or reflects, in proportion to the Fresnel reflectance.
+bool sampleGlass(const MaterialData& material, const Ray& inputRay,
+                 const HitRecord& rec, Sampler& sampler,
+                 ScatterSample& sample);
+
+// Absorbs every light ray.
+bool sampleEmissive(const MaterialData& material, const Ray& inputRay,
+                    const HitRecord& rec, Sampler& sampler,
+                    ScatterSample& sample);
+
+// Picks the direction light arriving at rec is scattered from towards the
+// input ray, drawing the random decisions from the sampler's dimensions for
+// the current bounce. Returns false if the ray was absorbed.
+bool sampleScatter(const MaterialData& material, const Ray& inputRay,
+                   const HitRecord& rec, Sampler& sampler,
+                   ScatterSample& sample);
+
+// Scatters light rays according to the material (sampleScatter without the
+// density): attenuation is the weight of the sample.
+bool scatter(const MaterialData& material, const Ray& inputRay,
+             const HitRecord& rec, Color& attenuation, Ray& scattered,
+             Sampler& sampler);
+
+// Checks whether or not the material scatters into a continuum of
+// directions with a density known to scatterPdf. Only such surfaces gain
+// from light sampling; mirrors and glass reflect a single direction.
+inline bool hasScatterPdf(const MaterialData& material)
+{
+    return material.type == MaterialType::Diffuse ||
+           (material.type == MaterialType::Metal && material.fuzz > 0.0f);
+}
+
+// Returns the light the surface reflects towards the input ray per unit of
+// radiance arriving from direction (the BSDF times the cosine of the
+// direction with the normal). Zero unless hasScatterPdf(material).
+Color evaluateScatter(const MaterialData& material, const Ray& inputRay,
+                      const HitRecord& rec, const Vector3& direction);
+
+// Returns the solid angle density with which scatter picks direction. Zero
+// unless hasScatterPdf(material).
+float scatterPdf(const MaterialData& material, const Ray& inputRay,
+                 const HitRecord& rec, const Vector3& direction);
+
+// Returns the radiance the surface emits towards the ray that hit it.
+// Light leaves the front face of emissive surfaces only.
+Color emitted(const MaterialData& material, const HitRecord& rec);
@@ -0,0 +1,84 @@
+/*
+ * This file implements the GGX (Trowbridge-Reitz) microfacet distribution
+ * that rough metals reflect with. Directions are given in a shading frame
+ * whose +z axis is the surface normal (see ShadingFrame in warp.h), and
+ * alpha is the isotropic roughness.
+ *
+ * Microfacet normals are sampled from the distribution of normals visible
+ * from the outgoing direction, with the spherical cap method of Dupuy and
+ * Benyoub (2023). It needs no branches and, unlike sampling the full
+ * distribution, never picks facets that face away, so the weight of a
+ * sample stays close to the Fresnel term at any roughness.
+ */
+
+#pragma once
+
+#include <cmath>
+
+#include "../Math/point2.h"
+#include "../Math/utilities.h"
+#include "../Math/vector3.h"
+
+// Density of microfacet normals around h (projected onto the surface, it
+// integrates to 1).
+inline float ggxDistribution(const Vector3& h, float alpha)
+{
+    float alphaSquared = alpha * alpha;
+    float d = h.z() * h.z() * (alphaSquared - 1.0f) + 1.0f;
+
+    return alphaSquared / (PI * d * d);
+}
+
+// Smith's auxiliary function: the shadowed fraction of facets seen from w
+// is lambda / (1 + lambda).
+inline float ggxLambda(const Vector3& w, float alpha)
+{
+    float cosSquared = w.z() * w.z();
+    float tanSquared = std::fmax(0.0f, 1.0f - cosSquared) / cosSquared;
+
+    return 0.5f * (std::sqrt(1.0f + alpha * alpha * tanSquared) - 1.0f);
+}
+
+// Fraction of facets seen from w that are not shadowed.
+inline float ggxMasking(const Vector3& w, float alpha)
+{
+    return 1.0f / (1.0f + ggxLambda(w, alpha));
+}
+
+// Fraction of facets both seen from wo and lit from wi (height-correlated).
+inline float ggxMaskingShadowing(const Vector3& wo, const Vector3& wi,
+                                 float alpha)
+{
+    return 1.0f / (1.0f + ggxLambda(wo, alpha) + ggxLambda(wi, alpha));
+}
+
+// Maps the unit square onto a microfacet normal visible from wo (z > 0),
+// with density ggxMasking(wo) * max(0, dot(wo, h)) * D(h) / wo.z.
+inline Vector3 sampleGGXVisibleNormal(const Vector3& wo, float alpha,
+                                      const Point2& u)
+{
+    // Stretch the view so the facets become a hemisphere.
+    Vector3 stretched = unitVector(Vector3(alpha * wo.x(), alpha * wo.y(),
+                                           wo.z()));
+
+    // Visible normals of a hemisphere are the sum of the view and a point
+    // on the spherical cap below it.
+    float phi = 2.0f * PI * u.x;
+    float z = (1.0f - u.y) * (1.0f + stretched.z()) - stretched.z();
+    float sinTheta = std::sqrt(std::fmax(0.0f, 1.0f - z * z));
+    Vector3 h = Vector3(sinTheta * std::cos(phi), sinTheta * std::sin(phi),
+                        z) + stretched;
+
+    return unitVector(Vector3(alpha * h.x(), alpha * h.y(),
+                              std::fmax(0.0f, h.z())));
+}
+
+// Schlick's approximation of the Fresnel reflectance of a conductor whose
+// reflectance at normal incidence is f0.
+inline Color schlickFresnel(const Color& f0, float cosine)
+{
+    float m = std::fmax(0.0f, 1.0f - cosine);
+    float m2 = m * m;
+
+    return f0 + (m2 * m2 * m) * (Color(1.0f, 1.0f, 1.0f) - f0);
+}
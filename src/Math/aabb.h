@@ -0,0 +1,136 @@
+/*
+ * This class represents an axis-aligned bounding box (i.e. the region of space
+ * enclosed by an interval along each of the three axes) and is used to cull
+ * rays against groups of primitives.
+ */
+
+#pragma once
+
+#include "interval.h"
+#include "vector3.h"
+#include "ray.h"
+
+class AABB
+{
+public:
+    // Default constructor (empty box).
+    AABB() {}
+
+    // Initialization constructor.
+    AABB(const Interval& ix, const Interval& iy, const Interval& iz) :
+         x(ix), y(iy), z(iz)
+    {
+        padToMinimums();
+    }
+
+    // Treats the two points as extrema of the box.
+    AABB(const Point3& a, const Point3& b) :
+         x(fmin(a[0], b[0]), fmax(a[0], b[0])),
+         y(fmin(a[1], b[1]), fmax(a[1], b[1])),
+         z(fmin(a[2], b[2]), fmax(a[2], b[2]))
+    {
+        padToMinimums();
+    }
+
+    // Creates the tightest box enclosing both input boxes.
+    AABB(const AABB& box0, const AABB& box1) :
+         x(box0.x, box1.x), y(box0.y, box1.y), z(box0.z, box1.z) {}
+
+    Interval x, y, z;
+
+    const Interval& axis(int n) const
+    {
+        if (n == 1) return y;
+        if (n == 2) return z;
+
+        return x;
+    }
+
+    bool isEmpty() const
+    {
+        return x.min > x.max || y.min > y.max || z.min > z.max;
+    }
+
+    Point3 centroid() const
+    {
+        return Point3(0.5f * (x.min + x.max), 0.5f * (y.min + y.max),
+                      0.5f * (z.min + z.max));
+    }
+
+    // Returns the index of the axis with the largest extent.
+    int longestAxis() const
+    {
+        if (x.size() > y.size())
+            return x.size() > z.size() ? 0 : 2;
+
+        return y.size() > z.size() ? 1 : 2;
+    }
+
+    float surfaceArea() const
+    {
+        if (isEmpty())
+            return 0.0f;
+
+        float dx = x.size();
+        float dy = y.size();
+        float dz = z.size();
+
+        return 2.0f * (dx * dy + dy * dz + dz * dx);
+    }
+
+    // Slab test using a precomputed reciprocal ray direction. On a hit,
+    // tEnter receives the distance at which the ray enters the box.
+    bool hit(const Point3& origin, const Vector3& invDirection,
+             Interval ray_t, float& tEnter) const
+    {
+        for (int a = 0; a < 3; ++a)
+        {
+            const Interval& ax = axis(a);
+
+            float t0 = (ax.min - origin[a]) * invDirection[a];
+            float t1 = (ax.max - origin[a]) * invDirection[a];
+
+            if (invDirection[a] < 0.0f)
+            {
+                float temp = t0;
+                t0 = t1;
+                t1 = temp;
+            }
+
+            ray_t.min = t0 > ray_t.min ? t0 : ray_t.min;
+            ray_t.max = t1 < ray_t.max ? t1 : ray_t.max;
+
+            if (ray_t.max <= ray_t.min)
+            {
+                return false;
+            }
+        }
+
+        tEnter = ray_t.min;
+
+        return true;
+    }
+
+    // Checks whether or not the ray passes through the box within ray_t.
+    bool hit(const Ray& r, Interval ray_t) const
+    {
+        Vector3 direction = r.direction();
+        Vector3 invDirection(1.0f / direction.x(), 1.0f / direction.y(),
+                             1.0f / direction.z());
+        float tEnter;
+
+        return hit(r.origin(), invDirection, ray_t, tEnter);
+    }
+
+private:
+    // Pads degenerate (flat) axes so the slab test never divides a zero
+    // width interval.
+    void padToMinimums()
+    {
+        const float delta = 0.0001f;
+
+        if (x.size() < delta) x = x.expand(delta);
+        if (y.size() < delta) y = y.expand(delta);
+        if (z.size() < delta) z = z.expand(delta);
+    }
+};
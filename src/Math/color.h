@@ -1,74 +1,237 @@
 /*
- * This class provides the necessary functionality to manipulate and output
- * colors.
+ * This file provides the necessary functionality to compute the color
+ * carried by a ray.
+ *
+ * At every surface with a known scattering density, paths sample the
+ * scene's lights with a shadow ray (next event estimation). Light found by
+ * shadow rays and light found by scattered rays are both kept and weighted
+ * against each other with the power heuristic, so neither small lights nor
+ * glossy reflections of large ones turn noisy. An environment map is
+ * sampled and weighted the same way (see environment.h).
  */
 
 #pragma once
 
-#include <ostream>
+#include <cmath>
 
 #include "vector3.h"
 #include "ray.h"
 #include "utilities.h"
-#include "../Materials/material.h"
+#include "../Materials/materialData.h"
 #include "../Hittables/hittable.h"
+#include "../Scene/scene.h"
+#include "../Sampling/sampler.h"
+#include "../Render/stats.h"
 
-// Writes RGB triplets to standard output in PPM format.
-void inline writeColor(std::ostream& out, const Color& pixelColor,
-                const int samplesPerPixel, const bool msaa)
+// Returns the relative luminance (Rec. 709) of a linear color.
+inline float luminance(const Color& c)
 {
-    // Multisample anti-aliasing disabled.
-    if (!msaa)
+    return 0.2126f * c.x() + 0.7152f * c.y() + 0.0722f * c.z();
+}
+
+// Bounces a path makes before Russian roulette may terminate it.
+const int ROULETTE_MIN_DEPTH = 3;
+
+// Returns the color of the sky seen along the ray.
+inline Color skyColor(const Ray& r)
+{
+    Vector3 unitDirection = unitVector(r.direction());
+    float a = 0.5f * (unitDirection.y() + 1.0f);
+
+    return (1.0f - a) * Color(1.0f, 1.0f, 1.0f) + a * Color(0.5f, 0.7f, 1.0f);
+}
+
+// Returns the multiple importance sampling weight of a sample drawn with
+// density pdf against another strategy that draws it with otherPdf (the
+// power heuristic).
+inline float powerHeuristic(float pdf, float otherPdf)
+{
+    float a = pdf * pdf;
+    float b = otherPdf * otherPdf;
+
+    return a / (a + b);
+}
+
+// Samples a light of the scene from the surface at rec with one shadow ray
+// and returns the light it reflects along r back towards the ray's origin,
+// weighted against finding the light by scattering. The light sample values
+// come from the sampler's light dimensions of the bounce.
+inline Color sampleDirectLight(const Ray& r, const HitRecord& rec,
+                               const Scene& world, const Sampler& sampler,
+                               int bounce)
+{
+    Vector3 direction;
+    float lightPdf;
+    uint32_t target;
+
+    if (!world.lights().sample(rec.p, r.time(), sampler.getLight1D(bounce),
+                               sampler.getLight2D(bounce), direction,
+                               lightPdf, target) ||
+        dot(direction, rec.normal) <= 0.0f)
+    {
+        return Color(0.0f, 0.0f, 0.0f);
+    }
+
+    RT_STATS_ADD(shadowRays, 1);
+
+    // Only the light that was sampled counts, since the density is its
+    // alone; anything else in the way (other emitters included) shadows
+    // it. Those are found by scattering instead.
+    Ray shadowRay(rec.p, direction, r.time());
+    HitRecord lightRec;
+    Color light;
+
+    if (!world.hit(shadowRay, Interval(0.001f, INF), lightRec))
     {
-        out << static_cast<int>(255.999 * pixelColor.x()) << ' '
-            << static_cast<int>(255.999 * pixelColor.y()) << ' '
-            << static_cast<int>(255.999 * pixelColor.z()) << std::endl;
+        if (target != NO_LIGHT)
+        {
+            return Color(0.0f, 0.0f, 0.0f);
+        }
 
-        return;
+        light = world.background(shadowRay);
+    }
+    else if (target != NO_LIGHT && lightRec.light == target)
+    {
+        light = emitted(*lightRec.material, lightRec);
+    }
+    else
+    {
+        return Color(0.0f, 0.0f, 0.0f);
     }
 
-    // Get RGB triplet.
-    float r = pixelColor.x();
-    float g = pixelColor.y();
-    float b = pixelColor.z();
+    float weight = powerHeuristic(lightPdf,
+                                  scatterPdf(*rec.material, r, rec,
+                                             direction));
 
-    // Calculate color intensity.
-    float scale = 1.0f / samplesPerPixel;
+    return (weight / lightPdf) *
+           (evaluateScatter(*rec.material, r, rec, direction) * light);
+}
 
-    // Apply gamma correction (gamma = 2.0).
-    r = sqrt(scale * r);
-    g = sqrt(scale * g);
-    b = sqrt(scale * b);
+// Returns the weight of the light of the environment found by ray, which
+// left the scene after it was scattered with density rayPdf (0 if light
+// sampling could not have found it, e.g. for camera rays or after a
+// mirror), against light sampling.
+inline float emissionWeight(const Ray& ray, float rayPdf, const Scene& world)
+{
+    if (rayPdf <= 0.0f)
+    {
+        return 1.0f;
+    }
 
-    out << static_cast<int>(256.0f * clamp(r, 0.0f, 0.999f)) << ' '
-        << static_cast<int>(256.0f * clamp(g, 0.0f, 0.999f)) << ' '
-        << static_cast<int>(256.0f * clamp(b, 0.0f, 0.999f)) << '\n';
+    return powerHeuristic(rayPdf, world.lights().environmentPdf(
+                                      unitVector(ray.direction())));
 }
 
-// Calculates the pixel color for the given ray.
-Color inline rayColor(const Ray& r, int depth, const Hittable& world)
+// Returns the weight of the light of the emitter at rec found by ray, which
+// was scattered with density rayPdf, against light sampling. Only the light
+// hit is evaluated.
+inline float emissionWeight(const Ray& ray, float rayPdf, const Scene& world,
+                            const HitRecord& rec)
 {
-    // If we've exceeded the Ray bounce limit, no more light is gathered.
-    if (depth <= 0)
-        return Color(0.0f, 0.0f, 0.0f);
+    if (rayPdf <= 0.0f || rec.light == NO_LIGHT)
+    {
+        return 1.0f;
+    }
+
+    return powerHeuristic(rayPdf, world.lights().pdf(ray.origin(),
+                                                     ray.time(), rec.light));
+}
+
+// Calculates the pixel color for the given ray by following its path for at
+// most maxDepth bounces. Random decisions at every bounce are drawn from the
+// sampler's dimensions for that bounce. After rouletteDepth bounces, a path
+// survives each further bounce with a probability equal to its largest
+// throughput component and carries the inverse probability as weight, which
+// keeps the estimate unbiased. With sampleLights, the scene's lights are
+// sampled at every bounce off a surface that allows it. The number of rays
+// traced (shadow rays aside) is stored in pathLength, if given.
+Color inline rayColor(const Ray& r, int maxDepth, const Scene& world,
+                      Sampler& sampler,
+                      int rouletteDepth = ROULETTE_MIN_DEPTH,
+                      bool sampleLights = true, int* pathLength = nullptr)
+{
+    Color throughput(1.0f, 1.0f, 1.0f);
+    Color radiance(0.0f, 0.0f, 0.0f);
+    Ray ray = r;
+    int raysTraced = 0;
 
-    HitRecord rec;
+    sampleLights = sampleLights && !world.lights().empty();
 
-    if (world.hit(r, Interval(0.001f, INF), rec))
+    // Density with which the current ray was scattered (see emissionWeight).
+    float rayPdf = 0.0f;
+
+    // The bounce limit stays a hard cap: no light is gathered beyond it.
+    for (int bounce = 0; bounce < maxDepth; ++bounce)
     {
-        Ray scattered;
-        Color attenuation;
+        HitRecord rec;
+        ++raysTraced;
 
-        if (rec.matPtr->scatter(r, rec, attenuation, scattered))
+        if (!world.hit(ray, Interval(0.001f, INF), rec))
         {
-            return attenuation * rayColor(scattered, depth - 1, world);
+            radiance += emissionWeight(ray, rayPdf, world) *
+                        (throughput * world.background(ray));
+            RT_STATS_ADD(escapedPaths, 1);
+
+            break;
         }
 
-        return Color(0.0f, 0.0f, 0.0f);
+        if (rec.material->type == MaterialType::Emissive)
+        {
+            radiance += emissionWeight(ray, rayPdf, world, rec) *
+                        (throughput * emitted(*rec.material, rec));
+        }
+
+        ScatterSample sample;
+
+        sampler.startBounce(bounce);
+
+        if (sampleLights && hasScatterPdf(*rec.material))
+        {
+            radiance += throughput * sampleDirectLight(ray, rec, world,
+                                                       sampler, bounce);
+        }
+
+        RT_STATS_ADD(scatterCalls[static_cast<int>(rec.material->type)], 1);
+
+        if (!sampleScatter(*rec.material, ray, rec, sampler, sample))
+        {
+            RT_STATS_ADD(absorbedPaths, 1);
+
+            break;
+        }
+
+        throughput = throughput * sample.weight;
+        rayPdf = sampleLights ? sample.pdf : 0.0f;
+        ray = Ray(rec.p, sample.direction, ray.time());
+
+        if (bounce + 1 >= rouletteDepth)
+        {
+            float survival = std::fmax(throughput.x(),
+                                       std::fmax(throughput.y(),
+                                                 throughput.z()));
+
+            if (survival < 1.0f)
+            {
+                if (sampler.getRoulette1D(bounce) >= survival)
+                {
+                    RT_STATS_ADD(rouletteTerminatedPaths, 1);
+
+                    break;
+                }
+
+                throughput = throughput / survival;
+            }
+        }
     }
 
-    Vector3 unitDirection = unitVector(r.direction());
-    float a = 0.5f * (unitDirection.y() + 1.0f);
+    RT_STATS_ADD(primaryRays, 1);
+    RT_STATS_ADD(secondaryRays, raysTraced - 1);
+    RT_STATS_ADD(pathLengths[pathLengthBucket(raysTraced)], 1);
 
-    return (1.0f - a) * Color(1.0f, 1.0f, 1.0f) + a * Color(0.5f, 0.7f, 1.0f);
+    if (pathLength)
+    {
+        *pathLength = raysTraced;
+    }
+
+    return radiance;
 }
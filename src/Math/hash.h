@@ -0,0 +1,41 @@
+/*
+ * This file hashes the contents of files and scenes, so two copies can be
+ * told apart without comparing them byte by byte (scene caches of the
+ * render server, checkpoints and distributed workers). It is not meant to
+ * resist deliberate collisions.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+const uint64_t FNV_OFFSET = 0xcbf29ce484222325ull;
+const uint64_t FNV_PRIME = 0x100000001b3ull;
+
+// 64-bit FNV-1a over the 8-byte words of the data, then its tail. Several
+// buffers are hashed together by passing each result on as hash.
+inline uint64_t contentHash(const void* data, size_t size,
+                            uint64_t hash = FNV_OFFSET)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    size_t i = 0;
+
+    hash ^= size;
+
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, sizeof(word));
+
+        hash = (hash ^ word) * FNV_PRIME;
+    }
+
+    for (; i < size; ++i)
+    {
+        hash = (hash ^ bytes[i]) * FNV_PRIME;
+    }
+
+    return hash;
+}
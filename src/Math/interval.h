@@ -13,6 +13,11 @@ public:
 
     Interval(float min, float max) : min(min), max(max) {}
 
+    // Creates the tightest interval enclosing both input intervals.
+    Interval(const Interval& a, const Interval& b) :
+        min(a.min <= b.min ? a.min : b.min),
+        max(a.max >= b.max ? a.max : b.max) {}
+
     float min, max;
 
     bool contains(float x) const
@@ -25,6 +30,19 @@ public:
         return min < x && x < max;
     }
 
+    float size() const
+    {
+        return max - min;
+    }
+
+    // Returns the interval padded by delta / 2 on both ends.
+    Interval expand(float delta) const
+    {
+        float padding = delta / 2.0f;
+
+        return Interval(min - padding, max + padding);
+    }
+
     static const Interval empty, universe;
 };
 
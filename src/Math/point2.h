@@ -0,0 +1,18 @@
+/*
+ * This struct represents a point in two dimensions, e.g. a sample within the
+ * unit square handed out by a Sampler.
+ */
+
+#pragma once
+
+struct Point2
+{
+public:
+    // Default constructor.
+    Point2() : x(0.0f), y(0.0f) {}
+
+    // Initialization constructor.
+    Point2(float x, float y) : x(x), y(y) {}
+
+    float x, y;
+};
@@ -0,0 +1,86 @@
+/*
+ * This class provides a counter-based random number generator. Instead of
+ * carrying a large mutable state (e.g. the 2.5 KB of std::mt19937), every
+ * value is a hash of a 64-bit stream key and a counter, so a stream is 12
+ * bytes, costs a handful of integer operations per value and can be keyed
+ * by (pixel, sample, bounce). The same key always yields the same numbers,
+ * which makes a frame independent of thread count and tile order.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+class RandomStream
+{
+public:
+    // Default constructor (stream zero).
+    RandomStream() : m_key(0), m_counter(0) {}
+
+    // Stream identified by an arbitrary 64-bit key.
+    explicit RandomStream(uint64_t key) : m_key(mix(key)), m_counter(0) {}
+
+    // Stream identified by a pixel, a sample index within the pixel and a
+    // bounce along the path.
+    RandomStream(uint32_t pixel, uint32_t sample, uint32_t bounce) :
+                 m_key(makeKey(pixel, sample, bounce)), m_counter(0) {}
+
+    // Returns the next 32 random bits of the stream.
+    uint32_t nextUint()
+    {
+        return static_cast<uint32_t>(valueAt(m_counter++) >> 32);
+    }
+
+    // Returns the next random float of the stream within the range [0, 1).
+    float nextFloat()
+    {
+        return floatAt(m_counter++);
+    }
+
+    // Returns random float number "counter" of the stream within [0, 1)
+    // without advancing the stream.
+    float floatAt(uint32_t counter) const
+    {
+        // Keep 24 bits so the result is exactly representable (and < 1).
+        return static_cast<float>(valueAt(counter) >> 40) *
+               (1.0f / 16777216.0f);
+    }
+
+    // Returns the key of the (pixel, sample, bounce) stream.
+    static uint64_t makeKey(uint32_t pixel, uint32_t sample, uint32_t bounce)
+    {
+        uint64_t key = mix((static_cast<uint64_t>(sample) << 32) | pixel);
+
+        return mix(key ^ (static_cast<uint64_t>(bounce) + 1) *
+                         0xD1B54A32D192ED03ULL);
+    }
+
+    // SplitMix64 finalizer; a fast, well-distributed 64-bit hash.
+    static uint64_t mix(uint64_t z)
+    {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+        return z ^ (z >> 31);
+    }
+
+private:
+    // Value number "counter" of the stream (SplitMix64 indexed directly).
+    uint64_t valueAt(uint32_t counter) const
+    {
+        return mix(m_key + (static_cast<uint64_t>(counter) + 1) *
+                           0x9E3779B97F4A7C15ULL);
+    }
+
+    uint64_t m_key;
+    uint32_t m_counter;
+};
+
+// Returns the random stream that randomFloat() draws from on the calling
+// thread. Each thread has its own, so drawing numbers is lock-free.
+inline RandomStream& threadRandomStream()
+{
+    thread_local RandomStream stream;
+
+    return stream;
+}
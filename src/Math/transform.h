@@ -0,0 +1,302 @@
+/*
+ * This class represents an affine transform (a 3x3 linear part plus a
+ * translation) together with its inverse, as used to place shared geometry
+ * in a scene. Rays are moved into object space with the inverse, which
+ * keeps their distances unchanged because directions are not normalized.
+ */
+
+#pragma once
+
+#include <cmath>
+
+#include "aabb.h"
+#include "interval.h"
+#include "ray.h"
+#include "utilities.h"
+#include "vector3.h"
+
+class Transform
+{
+public:
+    // Default constructor (identity).
+    Transform()
+    {
+        setIdentity(m_matrix);
+        setIdentity(m_inverse);
+    }
+
+    // Creates the transform with the given rows of the 3x4 matrix. The
+    // linear part must be invertible (see isInvertible()).
+    explicit Transform(const float matrix[12])
+    {
+        for (int row = 0; row < 3; ++row)
+        {
+            for (int column = 0; column < 4; ++column)
+            {
+                m_matrix[row][column] = matrix[4 * row + column];
+            }
+        }
+
+        invert();
+    }
+
+    // Creates the transform from the rows of both 3x4 matrices (e.g. as
+    // stored by rows() and inverseRows()), which must be inverses.
+    Transform(const float matrix[12], const float inverse[12])
+    {
+        for (int row = 0; row < 3; ++row)
+        {
+            for (int column = 0; column < 4; ++column)
+            {
+                m_matrix[row][column] = matrix[4 * row + column];
+                m_inverse[row][column] = inverse[4 * row + column];
+            }
+        }
+    }
+
+    static Transform translation(const Vector3& offset)
+    {
+        Transform transform;
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            transform.m_matrix[axis][3] = offset[axis];
+            transform.m_inverse[axis][3] = -offset[axis];
+        }
+
+        return transform;
+    }
+
+    // Scales by factor along each axis; no factor may be zero.
+    static Transform scaling(const Vector3& factor)
+    {
+        Transform transform;
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            transform.m_matrix[axis][axis] = factor[axis];
+            transform.m_inverse[axis][axis] = 1.0f / factor[axis];
+        }
+
+        return transform;
+    }
+
+    // Rotates counter-clockwise by degrees around the given axis (0, 1 or 2
+    // for x, y or z) when looking down the axis towards the origin.
+    static Transform rotation(int axis, float degrees)
+    {
+        Transform transform;
+
+        float radians = degreesToRadians(degrees);
+        float cosTheta = std::cos(radians);
+        float sinTheta = std::sin(radians);
+
+        int a = (axis + 1) % 3;
+        int b = (axis + 2) % 3;
+
+        transform.m_matrix[a][a] = cosTheta;
+        transform.m_matrix[a][b] = -sinTheta;
+        transform.m_matrix[b][a] = sinTheta;
+        transform.m_matrix[b][b] = cosTheta;
+
+        // The inverse of a rotation is its transpose.
+        transform.m_inverse[a][a] = cosTheta;
+        transform.m_inverse[a][b] = sinTheta;
+        transform.m_inverse[b][a] = -sinTheta;
+        transform.m_inverse[b][b] = cosTheta;
+
+        return transform;
+    }
+
+    // Returns the transform that applies other first and then this one.
+    Transform operator*(const Transform& other) const
+    {
+        Transform result;
+
+        multiply(m_matrix, other.m_matrix, result.m_matrix);
+        multiply(other.m_inverse, m_inverse, result.m_inverse);
+
+        return result;
+    }
+
+    // Checks whether or not the linear part has a usable inverse.
+    bool isInvertible() const
+    {
+        for (int row = 0; row < 3; ++row)
+        {
+            for (int column = 0; column < 4; ++column)
+            {
+                if (!std::isfinite(m_inverse[row][column]))
+                {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    Point3 point(const Point3& p) const
+    {
+        return apply(m_matrix, p, 1.0f);
+    }
+
+    Vector3 vector(const Vector3& v) const
+    {
+        return apply(m_matrix, v, 0.0f);
+    }
+
+    // Transforms a surface normal (with the inverse transpose); the result
+    // is not normalized.
+    Vector3 normal(const Vector3& n) const
+    {
+        float result[3];
+
+        for (int row = 0; row < 3; ++row)
+        {
+            result[row] = m_inverse[0][row] * n[0] +
+                          m_inverse[1][row] * n[1] +
+                          m_inverse[2][row] * n[2];
+        }
+
+        return Vector3(result[0], result[1], result[2]);
+    }
+
+    // Moves a world space ray into object space.
+    Ray toObject(const Ray& r) const
+    {
+        return Ray(apply(m_inverse, r.origin(), 1.0f),
+                   apply(m_inverse, r.direction(), 0.0f), r.time());
+    }
+
+    // Returns the tightest box enclosing the transformed box (Arvo,
+    // "Transforming Axis-Aligned Bounding Boxes", 1990).
+    AABB bounds(const AABB& box) const
+    {
+        Interval result[3];
+
+        for (int row = 0; row < 3; ++row)
+        {
+            float low = m_matrix[row][3];
+            float high = m_matrix[row][3];
+
+            for (int column = 0; column < 3; ++column)
+            {
+                float a = m_matrix[row][column] * box.axis(column).min;
+                float b = m_matrix[row][column] * box.axis(column).max;
+
+                low += a < b ? a : b;
+                high += a < b ? b : a;
+            }
+
+            result[row] = Interval(low, high);
+        }
+
+        return AABB(result[0], result[1], result[2]);
+    }
+
+    // Rows of the 3x4 matrix, as accepted by the matrix constructors.
+    void rows(float matrix[12]) const
+    {
+        copyRows(m_matrix, matrix);
+    }
+
+    // Rows of the inverse matrix.
+    void inverseRows(float inverse[12]) const
+    {
+        copyRows(m_inverse, inverse);
+    }
+
+private:
+    static void setIdentity(float matrix[3][4])
+    {
+        for (int row = 0; row < 3; ++row)
+        {
+            for (int column = 0; column < 4; ++column)
+            {
+                matrix[row][column] = row == column ? 1.0f : 0.0f;
+            }
+        }
+    }
+
+    static void copyRows(const float matrix[3][4], float rows[12])
+    {
+        for (int row = 0; row < 3; ++row)
+        {
+            for (int column = 0; column < 4; ++column)
+            {
+                rows[4 * row + column] = matrix[row][column];
+            }
+        }
+    }
+
+    // result = a * b, treating both as 4x4 matrices with a last row of
+    // (0, 0, 0, 1).
+    static void multiply(const float a[3][4], const float b[3][4],
+                         float result[3][4])
+    {
+        for (int row = 0; row < 3; ++row)
+        {
+            for (int column = 0; column < 4; ++column)
+            {
+                result[row][column] = a[row][0] * b[0][column] +
+                                      a[row][1] * b[1][column] +
+                                      a[row][2] * b[2][column] +
+                                      (column == 3 ? a[row][3] : 0.0f);
+            }
+        }
+    }
+
+    static Vector3 apply(const float matrix[3][4], const Vector3& v, float w)
+    {
+        return Vector3(matrix[0][0] * v[0] + matrix[0][1] * v[1] +
+                       matrix[0][2] * v[2] + matrix[0][3] * w,
+                       matrix[1][0] * v[0] + matrix[1][1] * v[1] +
+                       matrix[1][2] * v[2] + matrix[1][3] * w,
+                       matrix[2][0] * v[0] + matrix[2][1] * v[1] +
+                       matrix[2][2] * v[2] + matrix[2][3] * w);
+    }
+
+    // Computes m_inverse from m_matrix (adjugate over determinant). A
+    // singular matrix yields non-finite entries.
+    void invert()
+    {
+        const float (*m)[4] = m_matrix;
+
+        float c00 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+        float c01 = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+        float c02 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+
+        float determinant = m[0][0] * c00 + m[0][1] * c01 + m[0][2] * c02;
+        float inverseDeterminant = 1.0f / determinant;
+
+        float (*inverse)[4] = m_inverse;
+
+        inverse[0][0] = c00 * inverseDeterminant;
+        inverse[1][0] = c01 * inverseDeterminant;
+        inverse[2][0] = c02 * inverseDeterminant;
+        inverse[0][1] = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) *
+                        inverseDeterminant;
+        inverse[1][1] = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) *
+                        inverseDeterminant;
+        inverse[2][1] = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) *
+                        inverseDeterminant;
+        inverse[0][2] = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) *
+                        inverseDeterminant;
+        inverse[1][2] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) *
+                        inverseDeterminant;
+        inverse[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) *
+                        inverseDeterminant;
+
+        // The inverse translation undoes the translation in object space.
+        for (int row = 0; row < 3; ++row)
+        {
+            inverse[row][3] = -(inverse[row][0] * m[0][3] +
+                                inverse[row][1] * m[1][3] +
+                                inverse[row][2] * m[2][3]);
+        }
+    }
+
+    float m_matrix[3][4];
+    float m_inverse[3][4];
+};
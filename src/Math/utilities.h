@@ -5,8 +5,10 @@
 
 #pragma once
 
+#include <cstdint>
 #include <limits>
-#include <random>
+
+#include "random.h"
 
 const float INF = std::numeric_limits<float>::infinity();
 const float PI = 3.1415926f;
@@ -19,10 +21,7 @@ inline float degreesToRadians(float degrees)
 // Returns a random float within the range [0, 1).
 inline float randomFloat()
 {
-    static std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
-    static std::mt19937 generator;
-
-    return distribution(generator);
+    return threadRandomStream().nextFloat();
 }
 
 // Returns a random float within the range [min, max).
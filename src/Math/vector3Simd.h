@@ -0,0 +1,250 @@
+/*
+ * This file implements Vector3 in the four lanes of a 16-byte SSE2
+ * register. The fourth lane is kept at 0, so dot products can add all four
+ * lanes without masking. It is selected by defining RAYTRACER_SIMD_VECTOR;
+ * include vector3.h instead of this file. Other instruction sets use the
+ * scalar backend.
+ *
+ * Vectors are stored 16-byte aligned and loaded into a register by every
+ * operation; once inlined, the compiler keeps them in registers across
+ * chains of operations. unitVector multiplies by a reciprocal square root
+ * estimate refined with Newton-Raphson steps to about full float precision
+ * instead of dividing by a square root.
+ */
+
+#pragma once
+
+#include <array>
+#include <cmath>
+
+#include "utilities.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#else
+#error "RAYTRACER_SIMD_VECTOR needs SSE2; build the scalar backend instead"
+#endif
+
+namespace simd
+{
+	// Name of the backend, reported by the benchmarks.
+	const char* const BACKEND = "sse";
+
+	using Lanes = __m128;
+
+	// Newton-Raphson steps that bring the 12-bit estimate of rsqrtps to
+	// about 23 bits.
+	const int RSQRT_STEPS = 1;
+
+	inline Lanes load(const float* p) { return _mm_load_ps(p); }
+	inline void store(float* p, Lanes a) { _mm_store_ps(p, a); }
+	inline Lanes splat(float t) { return _mm_set1_ps(t); }
+	inline Lanes add(Lanes a, Lanes b) { return _mm_add_ps(a, b); }
+	inline Lanes subtract(Lanes a, Lanes b) { return _mm_sub_ps(a, b); }
+	inline Lanes multiply(Lanes a, Lanes b) { return _mm_mul_ps(a, b); }
+
+	inline Lanes negate(Lanes a)
+	{
+		return _mm_xor_ps(a, _mm_set1_ps(-0.0f));
+	}
+
+	// Returns the sum of the four lanes.
+	inline float sum(Lanes a)
+	{
+		Lanes pairs = _mm_add_ps(a, _mm_movehl_ps(a, a));
+
+		return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(
+		                                pairs, pairs, _MM_SHUFFLE(1, 1, 1, 1))));
+	}
+
+	// Moves (x, y, z, w) to (y, z, x, w).
+	inline Lanes rotate(Lanes a)
+	{
+		return _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+	}
+
+	inline float reciprocalSqrtEstimate(float x)
+	{
+		return _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+	}
+
+	// Returns 1 / sqrt(x), refined from the hardware estimate.
+	inline float reciprocalSqrt(float x)
+	{
+		float y = reciprocalSqrtEstimate(x);
+
+		for (int i = 0; i < RSQRT_STEPS; ++i)
+		{
+			y = y * (1.5f - 0.5f * x * y * y);
+		}
+
+		return y;
+	}
+}
+
+// Name of the backend, reported by the benchmarks.
+const char* const VECTOR3_BACKEND = simd::BACKEND;
+
+struct alignas(16) Vector3
+{
+public:
+	// Default constructor.
+	Vector3() : vals{0.0f, 0.0f, 0.0f, 0.0f} {}
+
+	// Initialization constructor.
+	Vector3(float vals0, float vals1, float vals2) :
+		vals{vals0, vals1, vals2, 0.0f}
+	{}
+
+	// Wraps register lanes whose fourth lane is 0.
+	explicit Vector3(simd::Lanes lanes)
+	{
+		simd::store(vals.data(), lanes);
+	}
+
+	simd::Lanes lanes() const
+	{
+		return simd::load(vals.data());
+	}
+
+	float x() const
+	{
+		return vals[0];
+	}
+
+	float y() const
+	{
+		return vals[1];
+	}
+
+	float z() const
+	{
+		return vals[2];
+	}
+
+	float magnitude() const
+	{
+		return sqrt(magnitudeSquared());
+	}
+
+	float magnitudeSquared() const
+	{
+		simd::Lanes v = lanes();
+
+		return simd::sum(simd::multiply(v, v));
+	}
+
+	float operator[](int i) const
+	{
+		return vals[i];
+	}
+
+	float& operator[](int i)
+	{
+		return vals[i];
+	}
+
+	Vector3 operator-() const
+	{
+		return Vector3(simd::negate(lanes()));
+	}
+
+	Vector3& operator+=(const Vector3& v)
+	{
+		simd::store(vals.data(), simd::add(lanes(), v.lanes()));
+
+		return *this;
+	}
+
+	Vector3& operator*=(const float t)
+	{
+		simd::store(vals.data(), simd::multiply(lanes(), simd::splat(t)));
+
+		return *this;
+	}
+
+	Vector3& operator/=(const float t)
+	{
+		return *this *= 1.0f / t;
+	}
+
+	// Returns a vector with random components in the range [0, 1).
+	inline static Vector3 random()
+	{
+		return Vector3(randomFloat(), randomFloat(), randomFloat());
+	}
+
+	// Returns a vector with random components in the range [min, max).
+	inline static Vector3 random(float min, float max)
+	{
+		return Vector3(randomFloat(min, max),
+					randomFloat(min, max),
+					randomFloat(min, max));
+	}
+
+	bool nearZero() const
+	{
+		// Return true if the vector is close to zero in all dimensions.
+		const float s = 1e-8f;
+
+		return (fabs(vals[0]) < s) &&
+			   (fabs(vals[1]) < s) &&
+			   (fabs(vals[2]) < s);
+	}
+
+	// Represents the standard basis vector, padded with a 0 to fill the
+	// register.
+	std::array<float, 4> vals;
+};
+
+inline Vector3 operator+(const Vector3& u, const Vector3& v)
+{
+	return Vector3(simd::add(u.lanes(), v.lanes()));
+}
+
+inline Vector3 operator-(const Vector3& u, const Vector3& v)
+{
+	return Vector3(simd::subtract(u.lanes(), v.lanes()));
+}
+
+// Multiplies two vectors.
+inline Vector3 operator*(const Vector3& u, const Vector3& v)
+{
+	return Vector3(simd::multiply(u.lanes(), v.lanes()));
+}
+
+// Multiplies a float and a vector.
+inline Vector3 operator*(float t, const Vector3& u)
+{
+	return Vector3(simd::multiply(simd::splat(t), u.lanes()));
+}
+
+inline Vector3 operator/(Vector3 u, float t)
+{
+	return (1 / t) * u;
+}
+
+// Vector dot product: one multiplication of all lanes and a horizontal sum.
+inline float dot(const Vector3& u, const Vector3& v)
+{
+	return simd::sum(simd::multiply(u.lanes(), v.lanes()));
+}
+
+// Vector cross product: u = <a, b, c>, v = <d, e, f>
+// u cross v = <bf - ce, cd - af, ae - bd>, computed as the rotation of
+// u * rotate(v) - rotate(u) * v.
+inline Vector3 cross(const Vector3& u, const Vector3& v)
+{
+	simd::Lanes a = u.lanes();
+	simd::Lanes b = v.lanes();
+
+	return Vector3(simd::rotate(simd::subtract(
+	               simd::multiply(a, simd::rotate(b)),
+	               simd::multiply(simd::rotate(a), b))));
+}
+
+inline Vector3 unitVector(Vector3 u)
+{
+	return simd::reciprocalSqrt(dot(u, u)) * u;
+}
@@ -0,0 +1,29 @@
+#include "adaptiveSampling.h"
+
+#include "framebuffer.h"
+#include "../Math/utilities.h"
+
+Framebuffer makeSampleCountHeatmap(const Framebuffer& framebuffer,
+                                   int maxSamples)
+{
+    Framebuffer heatmap(framebuffer.width(), framebuffer.height());
+
+    for (int y = 0; y < framebuffer.height(); ++y)
+    {
+        for (int x = 0; x < framebuffer.width(); ++x)
+        {
+            float t = clamp(static_cast<float>(framebuffer.sampleCount(x, y)) /
+                            static_cast<float>(maxSamples), 0.0f, 1.0f);
+
+            // Blue -> green -> red ramp.
+            Color display = t < 0.5f ?
+                Color(0.0f, 2.0f * t, 1.0f - 2.0f * t) :
+                Color(2.0f * t - 1.0f, 2.0f - 2.0f * t, 0.0f);
+
+            // The writers apply gamma 2.0, so store the squared values.
+            heatmap.addSamples(x, y, display * display, 1);
+        }
+    }
+
+    return heatmap;
+}
@@ -0,0 +1,79 @@
+/*
+ * This file provides adaptive sampling: a running variance estimate per
+ * pixel decides when a pixel has converged, so flat regions (e.g. the sky)
+ * stop early and the remaining samples go to noisy regions such as glass or
+ * defocused edges.
+ */
+
+#pragma once
+
+#include <cmath>
+
+#include "framebuffer.h"
+#include "../Math/vector3.h"
+
+struct AdaptiveSettings
+{
+    // Whether pixels stop sampling once converged.
+    bool enabled = false;
+
+    // Largest accepted standard error of a pixel, measured after gamma
+    // correction (1 / 255 is one 8-bit step).
+    float errorThreshold = 0.005f;
+
+    // Samples every pixel takes before its error is first estimated; also
+    // the number of samples added between two estimates.
+    int minSamples = 16;
+
+    // Samples after which a pixel stops even if it has not converged.
+    int maxSamples = 1024;
+};
+
+// Welford's running mean and variance of the luminance of a pixel.
+class PixelVarianceEstimator
+{
+public:
+    void add(float value)
+    {
+        ++m_count;
+
+        float delta = value - m_mean;
+        m_mean += delta / m_count;
+        m_m2 += delta * (value - m_mean);
+    }
+
+    int count() const { return m_count; }
+
+    float mean() const { return m_mean; }
+
+    float variance() const
+    {
+        return m_count > 1 ? m_m2 / (m_count - 1) : 0.0f;
+    }
+
+    // Standard error of the mean after gamma correction (gamma = 2.0). The
+    // display value is sqrt(L), whose slope is 1 / (2 sqrt(L)), so the same
+    // absolute noise matters more in dark pixels than in bright ones.
+    float displayError() const
+    {
+        if (m_count < 2)
+        {
+            return INF;
+        }
+
+        float standardError = std::sqrt(variance() / m_count);
+
+        return standardError / (2.0f * std::sqrt(std::fmax(m_mean, 0.0f)) +
+                                1e-4f);
+    }
+
+private:
+    int m_count = 0;
+    float m_mean = 0.0f;
+    float m_m2 = 0.0f;
+};
+
+// Returns an image visualizing the number of samples every pixel took, from
+// blue (none) over green to red (maxSamples).
+Framebuffer makeSampleCountHeatmap(const Framebuffer& framebuffer,
+                                   int maxSamples);
@@ -0,0 +1,163 @@
+#include "checkpoint.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include "framebuffer.h"
+
+namespace
+{
+    const char CHECKPOINT_MAGIC[4] = {'R', 'T', 'C', 'P'};
+    const uint32_t CHECKPOINT_VERSION = 2;
+
+    template <typename T>
+    void writeValue(std::ostream& out, const T& value)
+    {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    bool readValue(std::istream& in, T& value)
+    {
+        return static_cast<bool>(in.read(reinterpret_cast<char*>(&value),
+                                          sizeof(T)));
+    }
+}
+
+bool saveCheckpoint(const Framebuffer& framebuffer, uint64_t renderHash,
+                    const std::string& path)
+{
+    std::string temporaryPath = path + ".tmp";
+
+    {
+        std::ofstream out(temporaryPath, std::ios::binary);
+
+        if (!out)
+        {
+            std::cerr << "Could not open " << temporaryPath
+                      << " for writing.\n";
+
+            return false;
+        }
+
+        out.write(CHECKPOINT_MAGIC, 4);
+        writeValue(out, CHECKPOINT_VERSION);
+        writeValue(out, static_cast<int32_t>(framebuffer.width()));
+        writeValue(out, static_cast<int32_t>(framebuffer.height()));
+        writeValue(out, renderHash);
+
+        std::vector<float> sums;
+        sums.reserve(framebuffer.pixelCount() * 3);
+
+        for (const Color& sum : framebuffer.sums())
+        {
+            sums.push_back(sum.x());
+            sums.push_back(sum.y());
+            sums.push_back(sum.z());
+        }
+
+        out.write(reinterpret_cast<const char*>(sums.data()),
+                  static_cast<std::streamsize>(sums.size() * sizeof(float)));
+        out.write(reinterpret_cast<const char*>(
+                      framebuffer.sampleCounts().data()),
+                  static_cast<std::streamsize>(framebuffer.pixelCount() *
+                                               sizeof(uint32_t)));
+
+        if (!out.flush())
+        {
+            std::cerr << "Could not write " << temporaryPath << ".\n";
+
+            return false;
+        }
+    }
+
+    // std::rename does not replace existing files on every platform.
+    std::remove(path.c_str());
+
+    if (std::rename(temporaryPath.c_str(), path.c_str()) != 0)
+    {
+        std::cerr << "Could not move " << temporaryPath << " to " << path
+                  << ".\n";
+
+        return false;
+    }
+
+    return true;
+}
+
+bool loadCheckpoint(Framebuffer& framebuffer, const std::string& path,
+                    int width, int height, uint64_t renderHash)
+{
+    std::ifstream in(path, std::ios::binary);
+
+    if (!in)
+    {
+        std::cerr << "Could not open checkpoint " << path << ".\n";
+
+        return false;
+    }
+
+    char magic[4];
+    uint32_t version;
+    int32_t storedWidth, storedHeight;
+    uint64_t storedHash;
+
+    if (!in.read(magic, 4) || std::memcmp(magic, CHECKPOINT_MAGIC, 4) != 0 ||
+        !readValue(in, version) || version != CHECKPOINT_VERSION ||
+        !readValue(in, storedWidth) || !readValue(in, storedHeight) ||
+        !readValue(in, storedHash))
+    {
+        std::cerr << path << " is not a valid checkpoint.\n";
+
+        return false;
+    }
+
+    // The size is checked before anything is allocated from it.
+    if (storedWidth != width || storedHeight != height)
+    {
+        std::cerr << "Checkpoint " << path << " is " << storedWidth << 'x'
+                  << storedHeight << ", expected " << width << 'x' << height
+                  << ".\n";
+
+        return false;
+    }
+
+    if (storedHash != renderHash)
+    {
+        std::cerr << "Checkpoint " << path << " was rendered from a "
+                     "different scene or with different settings.\n";
+
+        return false;
+    }
+
+    Framebuffer restored(width, height);
+    std::vector<float> sums(restored.pixelCount() * 3);
+
+    in.read(reinterpret_cast<char*>(sums.data()),
+            static_cast<std::streamsize>(sums.size() * sizeof(float)));
+    in.read(reinterpret_cast<char*>(restored.sampleCounts().data()),
+            static_cast<std::streamsize>(restored.pixelCount() *
+                                         sizeof(uint32_t)));
+
+    if (!in)
+    {
+        std::cerr << "Checkpoint " << path << " is truncated.\n";
+
+        return false;
+    }
+
+    for (size_t i = 0; i < restored.pixelCount(); ++i)
+    {
+        restored.sums()[i] = Color(sums[3 * i], sums[3 * i + 1],
+                                   sums[3 * i + 2]);
+    }
+
+    framebuffer = std::move(restored);
+
+    return true;
+}
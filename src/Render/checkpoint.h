@@ -0,0 +1,33 @@
+/*
+ * This file saves and restores the accumulation state of a render (the
+ * per-pixel sample sums and counts of a Framebuffer) in a compact binary
+ * checkpoint, so a preempted job can resume without losing finished work.
+ *
+ * Layout (native byte order):
+ *   char     magic[4]   "RTCP"
+ *   uint32_t version
+ *   int32_t  width, height
+ *   uint64_t renderHash
+ *   float    sums[width * height * 3]
+ *   uint32_t sampleCounts[width * height]
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "framebuffer.h"
+
+// Writes the framebuffer to path, tagged with renderHash, which identifies
+// the scene and settings its samples were rendered with. The file is
+// written next to the target first and then moved into place, so an
+// interrupted write never destroys the previous checkpoint.
+bool saveCheckpoint(const Framebuffer& framebuffer, uint64_t renderHash,
+                    const std::string& path);
+
+// Replaces the framebuffer with the checkpoint stored at path. Fails,
+// before reading the samples, unless the checkpoint is width x height and
+// tagged with renderHash.
+bool loadCheckpoint(Framebuffer& framebuffer, const std::string& path,
+                    int width, int height, uint64_t renderHash);
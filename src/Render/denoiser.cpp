@@ -0,0 +1,194 @@
+#include "denoiser.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    // Albedo below which a channel is not divided out, since the lighting
+    // of a dark surface cannot be recovered from its color.
+    const float MIN_ALBEDO = 0.01f;
+
+    // Weights of the B3 spline kernel along one axis.
+    const float KERNEL[5] = {1.0f / 16.0f, 1.0f / 4.0f, 3.0f / 8.0f,
+                             1.0f / 4.0f, 1.0f / 16.0f};
+
+    Color demodulate(const Color& color, const Color& albedo)
+    {
+        return Color(color.x() / std::max(albedo.x(), MIN_ALBEDO),
+                     color.y() / std::max(albedo.y(), MIN_ALBEDO),
+                     color.z() / std::max(albedo.z(), MIN_ALBEDO));
+    }
+
+    Color modulate(const Color& irradiance, const Color& albedo)
+    {
+        return Color(irradiance.x() * std::max(albedo.x(), MIN_ALBEDO),
+                     irradiance.y() * std::max(albedo.y(), MIN_ALBEDO),
+                     irradiance.z() * std::max(albedo.z(), MIN_ALBEDO));
+    }
+
+    // Features of every pixel, gathered once for all iterations.
+    struct Guide
+    {
+        std::vector<Color> albedo;
+        std::vector<Vector3> normal;
+        std::vector<float> depth;
+
+        // Inverse of the sample count, which noise variance is
+        // proportional to.
+        std::vector<float> inverseSamples;
+    };
+
+    // Filters one row of input into output with taps step pixels apart.
+    void filterRow(int y, int step, float colorSigma,
+                   const DenoiseSettings& settings, const Guide& guide,
+                   int width, int height, const std::vector<Color>& input,
+                   std::vector<Color>& output)
+    {
+        float normalScale = 1.0f / (settings.normalSigma *
+                                    settings.normalSigma);
+        float albedoScale = 1.0f / (settings.albedoSigma *
+                                    settings.albedoSigma);
+
+        for (int x = 0; x < width; ++x)
+        {
+            size_t center = static_cast<size_t>(y) * width + x;
+
+            const Color& color = input[center];
+            const Color& albedo = guide.albedo[center];
+            const Vector3& normal = guide.normal[center];
+            float depth = guide.depth[center];
+            float colorScale = 1.0f / (colorSigma * colorSigma *
+                                       guide.inverseSamples[center]);
+
+            Color sum(0.0f, 0.0f, 0.0f);
+            float weightSum = 0.0f;
+
+            for (int dy = -2; dy <= 2; ++dy)
+            {
+                int ty = y + dy * step;
+
+                if (ty < 0 || ty >= height)
+                {
+                    continue;
+                }
+
+                for (int dx = -2; dx <= 2; ++dx)
+                {
+                    int tx = x + dx * step;
+
+                    if (tx < 0 || tx >= width)
+                    {
+                        continue;
+                    }
+
+                    size_t tap = static_cast<size_t>(ty) * width + tx;
+
+                    float colorDistance = (input[tap] - color).
+                                          magnitudeSquared();
+                    float normalDistance = (guide.normal[tap] - normal).
+                                           magnitudeSquared();
+                    float albedoDistance = (guide.albedo[tap] - albedo).
+                                           magnitudeSquared();
+
+                    // Depth changes along a surface in proportion to the
+                    // distance between the taps, so scale it by that.
+                    float pixels = std::sqrt(static_cast<float>(
+                                             dx * dx + dy * dy)) * step;
+                    float depthDistance = std::fabs(guide.depth[tap] -
+                                                    depth) /
+                                          (settings.depthSigma * pixels *
+                                           depth + 1e-4f);
+
+                    float weight = KERNEL[dx + 2] * KERNEL[dy + 2] *
+                                   std::exp(-colorDistance * colorScale -
+                                            normalDistance * normalScale -
+                                            albedoDistance * albedoScale -
+                                            depthDistance);
+
+                    sum += weight * input[tap];
+                    weightSum += weight;
+                }
+            }
+
+            // The center tap always has a positive weight.
+            output[center] = sum / weightSum;
+        }
+    }
+}
+
+Framebuffer denoise(const Framebuffer& image, const FeatureBuffer& features,
+                    const DenoiseSettings& settings, ThreadPool& pool)
+{
+    int width = image.width();
+    int height = image.height();
+    size_t pixelCount = image.pixelCount();
+
+    Guide guide;
+    guide.albedo.resize(pixelCount);
+    guide.normal.resize(pixelCount);
+    guide.depth.resize(pixelCount);
+    guide.inverseSamples.resize(pixelCount);
+
+    std::vector<Color> current(pixelCount);
+    std::vector<Color> next(pixelCount);
+
+    pool.parallelFor(static_cast<uint32_t>(height),
+                     [&](uint32_t row, int)
+                     {
+                         int y = static_cast<int>(row);
+
+                         for (int x = 0; x < width; ++x)
+                         {
+                             size_t index = static_cast<size_t>(y) * width +
+                                            x;
+
+                             guide.albedo[index] = features.albedo(x, y);
+                             guide.normal[index] = features.normal(x, y);
+                             guide.depth[index] = features.depth(x, y);
+                             guide.inverseSamples[index] = 1.0f /
+                                 std::max(image.sampleCount(x, y), 1u);
+                             current[index] = demodulate(
+                                              image.pixel(x, y),
+                                              guide.albedo[index]);
+                         }
+                     });
+
+    float colorSigma = settings.colorSigma;
+    int iterations = std::min(std::max(settings.iterations, 0),
+                              MAX_DENOISE_ITERATIONS);
+
+    for (int i = 0; i < iterations; ++i)
+    {
+        int step = 1 << i;
+
+        pool.parallelFor(static_cast<uint32_t>(height),
+                         [&](uint32_t row, int)
+                         {
+                             filterRow(static_cast<int>(row), step,
+                                       colorSigma, settings, guide, width,
+                                       height, current, next);
+                         });
+
+        current.swap(next);
+        colorSigma *= 0.5f;
+    }
+
+    Framebuffer result(width, height);
+
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            size_t index = static_cast<size_t>(y) * width + x;
+            uint32_t count = image.sampleCount(x, y);
+
+            result.addSamples(x, y, static_cast<float>(count) *
+                              modulate(current[index], guide.albedo[index]),
+                              count);
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,50 @@
+/*
+ * This file implements an edge-avoiding à-trous wavelet denoiser (Dammertz
+ * et al. 2010) for rendered images. The image is smoothed by a 5x5 B3
+ * spline kernel whose taps spread twice as far with every iteration, so a
+ * few iterations cover a wide footprint at 25 taps per pixel each. The
+ * weight of every tap is cut down where the albedo, normal or depth of the
+ * first hit (see featureBuffer.h) or the color itself differs from that of
+ * the center pixel, which keeps edges sharp.
+ *
+ * The image is divided by its albedo before filtering and multiplied by it
+ * afterwards, so the filter smooths lighting but leaves surface colors
+ * alone. Rows are filtered in parallel on a thread pool.
+ */
+
+#pragma once
+
+#include "featureBuffer.h"
+#include "framebuffer.h"
+#include "threadPool.h"
+
+// Most filter iterations. The last one spreads its taps 2^15 pixels apart,
+// beyond the size of any image.
+const int MAX_DENOISE_ITERATIONS = 16;
+
+struct DenoiseSettings
+{
+    // Filter iterations, clamped to 0..MAX_DENOISE_ITERATIONS; the last one
+    // spreads its taps 2^(iterations - 1) pixels apart.
+    int iterations = 5;
+
+    // Scale of the differences at which the weight of a tap falls to 1/e.
+    // The color scale is that of a pixel with one sample; it shrinks with
+    // the standard deviation of the noise as pixels take more samples, and
+    // is halved with every iteration, since each one leaves less noise to
+    // tell apart from edges. The defaults give the least error on the demo
+    // scene from 4 to 64 samples per pixel.
+    float colorSigma = 1.6f;
+    float normalSigma = 0.3f;
+    float albedoSigma = 0.3f;
+
+    // Depth difference relative to the depth of the center pixel, per pixel
+    // of distance between the taps.
+    float depthSigma = 0.05f;
+};
+
+// Returns a denoised copy of image, which must have the size of features.
+// Pixels keep their sample counts, so the result can be written like any
+// other image.
+Framebuffer denoise(const Framebuffer& image, const FeatureBuffer& features,
+                    const DenoiseSettings& settings, ThreadPool& pool);
@@ -0,0 +1,519 @@
+#include "distributedRenderer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "messages.h"
+#include "socket.h"
+#include "tiles.h"
+
+namespace
+{
+    const uint32_t PROTOCOL_VERSION = 3;
+
+    // Milliseconds the coordinator waits for a connection before checking
+    // whether the frame is done.
+    const int ACCEPT_POLL_MILLISECONDS = 200;
+
+    // A worker keeps trying to reach a coordinator that is not up yet for
+    // CONNECT_ATTEMPTS * CONNECT_RETRY_MILLISECONDS.
+    const int CONNECT_ATTEMPTS = 120;
+    const int CONNECT_RETRY_MILLISECONDS = 500;
+
+    // Seconds a connecting worker has to introduce itself.
+    const double HELLO_TIMEOUT = 10.0;
+
+    enum class MessageType : uint32_t
+    {
+        Hello = 1,
+        Job,
+        Assign,
+        Result,
+        Finish
+    };
+
+    // One job: the pixels of a window and a range of their samples.
+    struct WorkUnit
+    {
+        int32_t index;
+        int32_t x0, y0, x1, y1;
+        int32_t firstSample;
+        int32_t sampleCount;
+
+        int32_t width() const { return x1 - x0; }
+        int32_t height() const { return y1 - y0; }
+
+        size_t pixelCount() const
+        {
+            return static_cast<size_t>(width()) * height();
+        }
+    };
+
+    // Bytes of a Result payload for the unit.
+    size_t resultSize(const WorkUnit& unit)
+    {
+        return sizeof(WorkUnit) + pixelDataSize(unit.pixelCount());
+    }
+
+    // Sends the sample sums and counts of a job.
+    bool sendResult(Socket& socket, const WorkUnit& unit,
+                    const Framebuffer& framebuffer)
+    {
+        return sendHeader(socket, MessageType::Result, resultSize(unit)) &&
+               socket.send(&unit, sizeof(unit)) &&
+               sendPixels(socket, framebuffer);
+    }
+
+    // Receives the result of the given job into a framebuffer the size of
+    // its window.
+    bool receiveResult(Socket& socket, const WorkUnit& unit,
+                       Framebuffer& framebuffer)
+    {
+        WorkUnit received;
+
+        if (!receiveHeader(socket, MessageType::Result, resultSize(unit)) ||
+            !socket.receive(&received, sizeof(received)) ||
+            std::memcmp(&received, &unit, sizeof(unit)) != 0)
+        {
+            return false;
+        }
+
+        framebuffer = Framebuffer(unit.width(), unit.height());
+
+        return receivePixels(socket, framebuffer);
+    }
+
+    // Splits the frame into the jobs of the chosen split.
+    std::vector<WorkUnit> makeWorkUnits(const RenderJob& job,
+                                        const DistributedSettings& settings)
+    {
+        std::vector<WorkUnit> units;
+
+        if (settings.split == WorkSplit::Tiles)
+        {
+            int tileSize = settings.jobSize > 0 ? settings.jobSize :
+                                                  DEFAULT_JOB_TILE_SIZE;
+
+            for (const Tile& tile : makeTiles(job.imageWidth,
+                                              job.imageHeight, tileSize))
+            {
+                WorkUnit unit;
+                unit.index = static_cast<int32_t>(units.size());
+                unit.x0 = tile.x0;
+                unit.y0 = tile.y0;
+                unit.x1 = tile.x1;
+                unit.y1 = tile.y1;
+                unit.firstSample = 0;
+                unit.sampleCount = job.samplesPerPixel;
+
+                units.push_back(unit);
+            }
+        }
+        else
+        {
+            int samples = settings.jobSize > 0 ? settings.jobSize :
+                                                 DEFAULT_JOB_SAMPLES;
+
+            for (int first = 0; first < job.samplesPerPixel; first += samples)
+            {
+                WorkUnit unit;
+                unit.index = static_cast<int32_t>(units.size());
+                unit.x0 = 0;
+                unit.y0 = 0;
+                unit.x1 = job.imageWidth;
+                unit.y1 = job.imageHeight;
+                unit.firstSample = first;
+                unit.sampleCount = std::min(samples,
+                                            job.samplesPerPixel - first);
+
+                units.push_back(unit);
+            }
+        }
+
+        return units;
+    }
+
+    // Shared state of the coordinator: the queue of jobs and the merge of
+    // their results. Every connected worker is served by its own thread.
+    class Coordinator
+    {
+    public:
+        Coordinator(const RenderJob& job, const DistributedSettings& settings,
+                    Framebuffer& framebuffer) :
+                    m_job(job), m_settings(settings),
+                    m_framebuffer(framebuffer),
+                    m_units(makeWorkUnits(job, settings)),
+                    m_remaining(m_units.size())
+        {
+            for (const WorkUnit& unit : m_units)
+            {
+                m_queue.push_back(unit.index);
+            }
+        }
+
+        bool finished()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            return m_remaining == 0;
+        }
+
+        // Hands out jobs to the worker on socket until the frame is done or
+        // the worker fails.
+        void serve(Socket socket, int worker);
+
+    private:
+        // Waits for a job to hand out. Returns false once the frame is done.
+        bool takeJob(int& unit);
+
+        // Puts the job of a failed worker back at the front of the queue.
+        void returnJob(int unit);
+
+        // Merges the result of a job into the framebuffer.
+        void completeJob(int unit, Framebuffer result);
+
+        // Adds a window sized result to the framebuffer.
+        void addResult(const WorkUnit& unit, const Framebuffer& result);
+
+        const RenderJob& m_job;
+        const DistributedSettings& m_settings;
+        Framebuffer& m_framebuffer;
+
+        std::vector<WorkUnit> m_units;
+
+        // Jobs waiting for a worker.
+        std::deque<int> m_queue;
+
+        // Jobs not merged yet.
+        size_t m_remaining;
+
+        // Sample split: results that arrived before those of earlier
+        // ranges, and the next range to merge.
+        std::map<int, Framebuffer> m_waitingResults;
+        int m_nextMerge = 0;
+
+        std::mutex m_mutex;
+        std::condition_variable m_changed;
+    };
+
+    void Coordinator::serve(Socket socket, int worker)
+    {
+        uint32_t version = 0;
+
+        socket.setReceiveTimeout(HELLO_TIMEOUT);
+
+        if (!receiveHeader(socket, MessageType::Hello, sizeof(version)) ||
+            !socket.receive(&version, sizeof(version)) ||
+            version != PROTOCOL_VERSION ||
+            !sendMessage(socket, MessageType::Job, &m_job, sizeof(m_job)))
+        {
+            std::clog << "\nWorker " << worker
+                      << " failed to introduce itself and was dropped.\n";
+            return;
+        }
+
+        socket.setReceiveTimeout(m_settings.workerTimeout);
+        std::clog << "\nWorker " << worker << " connected.\n";
+
+        int unit;
+
+        while (takeJob(unit))
+        {
+            Framebuffer result;
+
+            if (!sendMessage(socket, MessageType::Assign, &m_units[unit],
+                             sizeof(WorkUnit)) ||
+                !receiveResult(socket, m_units[unit], result))
+            {
+                std::clog << "\nWorker " << worker << " was lost; its job "
+                          << unit << " goes to another worker.\n";
+
+                returnJob(unit);
+                return;
+            }
+
+            completeJob(unit, std::move(result));
+        }
+
+        sendMessage(socket, MessageType::Finish, nullptr, 0);
+    }
+
+    bool Coordinator::takeJob(int& unit)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        // Wait rather than leave while jobs are out: a failing worker may
+        // return one.
+        m_changed.wait(lock, [this]
+                       {
+                           return !m_queue.empty() || m_remaining == 0;
+                       });
+
+        if (m_remaining == 0)
+        {
+            return false;
+        }
+
+        unit = m_queue.front();
+        m_queue.pop_front();
+
+        return true;
+    }
+
+    void Coordinator::returnJob(int unit)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_queue.push_front(unit);
+        m_changed.notify_all();
+    }
+
+    void Coordinator::completeJob(int unit, Framebuffer result)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_settings.split == WorkSplit::Tiles)
+        {
+            // Tiles cover disjoint pixels, so their order does not matter.
+            addResult(m_units[unit], result);
+        }
+        else
+        {
+            // Add the sample ranges in order, so the floating point sums
+            // come out the same whichever worker finishes first.
+            m_waitingResults.emplace(unit, std::move(result));
+
+            auto next = m_waitingResults.find(m_nextMerge);
+
+            while (next != m_waitingResults.end())
+            {
+                addResult(m_units[m_nextMerge], next->second);
+                m_waitingResults.erase(next);
+                next = m_waitingResults.find(++m_nextMerge);
+            }
+        }
+
+        --m_remaining;
+        std::clog << "\rRemaining jobs: " << m_remaining << ' ' << std::flush;
+
+        m_changed.notify_all();
+    }
+
+    void Coordinator::addResult(const WorkUnit& unit,
+                                const Framebuffer& result)
+    {
+        for (int y = unit.y0; y < unit.y1; ++y)
+        {
+            for (int x = unit.x0; x < unit.x1; ++x)
+            {
+                m_framebuffer.addSamples(x, y,
+                                         result.sampleSum(x - unit.x0,
+                                                          y - unit.y0),
+                                         result.sampleCount(x - unit.x0,
+                                                            y - unit.y0));
+            }
+        }
+    }
+}
+
+bool parseWorkSplit(const std::string& name, WorkSplit& split)
+{
+    if (name == "tiles")
+    {
+        split = WorkSplit::Tiles;
+        return true;
+    }
+
+    if (name == "samples")
+    {
+        split = WorkSplit::Samples;
+        return true;
+    }
+
+    std::cerr << "Unknown work split \"" << name
+              << "\" (expected tiles or samples).\n";
+
+    return false;
+}
+
+bool coordinateRender(const RenderJob& job,
+                      const DistributedSettings& settings,
+                      Framebuffer& framebuffer)
+{
+    if (settings.split == WorkSplit::Samples && job.adaptive)
+    {
+        std::cerr << "Adaptive sampling decides the sample count of every "
+                     "pixel and cannot be split by samples; use the tile "
+                     "split.\n";
+        return false;
+    }
+
+    Socket listener;
+
+    if (!listener.listen(settings.address))
+    {
+        return false;
+    }
+
+    framebuffer = Framebuffer(job.imageWidth, job.imageHeight);
+
+    Coordinator coordinator(job, settings, framebuffer);
+    std::vector<std::thread> workers;
+
+    std::clog << "Waiting for workers at " << settings.address << ".\n";
+
+    while (!coordinator.finished())
+    {
+        Socket client;
+
+        if (listener.accept(client, ACCEPT_POLL_MILLISECONDS))
+        {
+            int worker = static_cast<int>(workers.size()) + 1;
+
+            workers.emplace_back([&coordinator, worker](Socket socket)
+                                 {
+                                     coordinator.serve(std::move(socket),
+                                                       worker);
+                                 },
+                                 std::move(client));
+        }
+    }
+
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+
+    std::clog << "\rDone.                             \n";
+
+    return true;
+}
+
+bool runWorker(const std::string& address, Camera& camera,
+               const Scene& world)
+{
+    Socket socket;
+    int attempt = 0;
+
+    while (!socket.connect(address))
+    {
+        if (++attempt == CONNECT_ATTEMPTS)
+        {
+            std::cerr << "Cannot reach a coordinator at " << address
+                      << ".\n";
+            return false;
+        }
+
+        std::this_thread::sleep_for(
+            std::chrono::milliseconds(CONNECT_RETRY_MILLISECONDS));
+    }
+
+    RenderJob job;
+
+    if (!sendMessage(socket, MessageType::Hello, &PROTOCOL_VERSION,
+                     sizeof(PROTOCOL_VERSION)) ||
+        !receiveHeader(socket, MessageType::Job, sizeof(job)) ||
+        !socket.receive(&job, sizeof(job)))
+    {
+        std::cerr << "The coordinator at " << address
+                  << " did not send a job.\n";
+        return false;
+    }
+
+    if (job.imageWidth != camera.imageWidth() ||
+        job.imageHeight != camera.imageHeight())
+    {
+        std::cerr << "The coordinator renders a " << job.imageWidth << 'x'
+                  << job.imageHeight << " image, not " << camera.imageWidth()
+                  << 'x' << camera.imageHeight() << ".\n";
+        return false;
+    }
+
+    if (job.sceneHash != world.contentHash())
+    {
+        std::cerr << "The coordinator renders a different scene.\n";
+        return false;
+    }
+
+    AdaptiveSettings adaptive;
+    adaptive.enabled = job.adaptive != 0;
+    adaptive.errorThreshold = job.errorThreshold;
+    adaptive.minSamples = job.minSamples;
+    adaptive.maxSamples = job.maxSamples;
+
+    camera.setSamplesPerPixel(job.samplesPerPixel);
+    camera.setSampler(static_cast<SamplerType>(job.sampler));
+    camera.setIntegrator(static_cast<IntegratorType>(job.integrator));
+    camera.setRouletteDepth(job.rouletteDepth);
+    camera.setLightSampling(job.lightSampling != 0);
+    camera.setAdaptiveSampling(adaptive);
+
+    // The view, lens and depth are not sent, so they must match already.
+    if (job.cameraHash != camera.settingsHash())
+    {
+        std::cerr << "The coordinator renders with a different camera.\n";
+        return false;
+    }
+
+    while (true)
+    {
+        MessageHeader header;
+        WorkUnit unit;
+
+        if (!socket.receive(&header, sizeof(header)))
+        {
+            std::cerr << "Lost the connection to the coordinator.\n";
+            return false;
+        }
+
+        if (header.type == static_cast<uint32_t>(MessageType::Finish))
+        {
+            return true;
+        }
+
+        if (header.type != static_cast<uint32_t>(MessageType::Assign) ||
+            header.size != sizeof(unit) ||
+            !socket.receive(&unit, sizeof(unit)))
+        {
+            std::cerr << "Received an invalid message from the "
+                         "coordinator.\n";
+            return false;
+        }
+
+        Tile window;
+        window.x0 = unit.x0;
+        window.y0 = unit.y0;
+        window.x1 = unit.x1;
+        window.y1 = unit.y1;
+
+        camera.setWindow(window);
+        camera.setSampleOffset(unit.firstSample);
+
+        Framebuffer framebuffer;
+
+        if (unit.firstSample == 0 && unit.sampleCount == job.samplesPerPixel)
+        {
+            camera.render(world, framebuffer);
+        }
+        else
+        {
+            camera.renderPass(world, framebuffer, unit.sampleCount);
+        }
+
+        if (!sendResult(socket, unit, framebuffer))
+        {
+            std::cerr << "Lost the connection to the coordinator.\n";
+            return false;
+        }
+    }
+}
@@ -0,0 +1,104 @@
+/*
+ * This file renders a frame on several processes or machines. A coordinator
+ * splits the frame into jobs, either tiles of the image or ranges of the
+ * samples of every pixel, and hands them to the workers that connect to it.
+ * Every worker loads the same scene, renders its jobs with Camera::render
+ * and sends back the float sample sums and counts of each job.
+ *
+ * The merge is deterministic: tiles cover disjoint pixels, and sample ranges
+ * are added in range order whichever worker finishes first. A tile split
+ * therefore produces exactly the image of a single-machine render, and a
+ * sample split that of a progressive render (--progressive) with passes of
+ * the job size. A worker that disconnects, or stays silent for longer than
+ * the worker timeout, has its job handed to another worker.
+ *
+ * Messages are a MessageHeader followed by its payload, in native byte
+ * order (as in checkpoints):
+ *   worker -> coordinator  Hello   (protocol version)
+ *   coordinator -> worker  Job     (RenderJob, once)
+ *   coordinator -> worker  Assign  (WorkUnit)
+ *   worker -> coordinator  Result  (WorkUnit, float sums[3 * pixels],
+ *                                   uint32_t sampleCounts[pixels])
+ *   coordinator -> worker  Finish  (no payload)
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "framebuffer.h"
+#include "../Camera/camera.h"
+#include "../Scene/scene.h"
+
+// How the coordinator splits the frame into jobs.
+enum class WorkSplit
+{
+    Tiles,
+    Samples
+};
+
+// Parses a split name ("tiles" or "samples"). Returns false and reports
+// the valid names if the name is unknown.
+bool parseWorkSplit(const std::string& name, WorkSplit& split);
+
+// Everything a worker needs besides the scene to render exactly the
+// samples the coordinator would, sent to every worker once it connects.
+struct RenderJob
+{
+    // Image size, checked against the worker's camera.
+    int32_t imageWidth;
+    int32_t imageHeight;
+
+    // Scene::contentHash() of the coordinator's scene and
+    // Camera::settingsHash() of its camera, checked against the worker's
+    // once it applied the settings below.
+    uint64_t sceneHash;
+    uint64_t cameraHash;
+
+    int32_t samplesPerPixel;
+    int32_t sampler;
+    int32_t integrator;
+    int32_t rouletteDepth;
+    int32_t lightSampling;
+
+    // Adaptive sampling (tile split only).
+    int32_t adaptive;
+    float errorThreshold;
+    int32_t minSamples;
+    int32_t maxSamples;
+};
+
+struct DistributedSettings
+{
+    // Address the coordinator listens at (see socket.h).
+    std::string address;
+
+    WorkSplit split = WorkSplit::Tiles;
+
+    // Edge length of the job tiles in pixels (tile split), or samples per
+    // pixel per job (sample split).
+    int jobSize = 0;
+
+    // Seconds a worker may take to return a job before it is considered
+    // dead (0 waits as long as the connection stays open).
+    double workerTimeout = 0.0;
+};
+
+// Job size used when DistributedSettings::jobSize is not set.
+const int DEFAULT_JOB_TILE_SIZE = 128;
+const int DEFAULT_JOB_SAMPLES = 16;
+
+// Renders the frame described by job on the workers connecting at
+// settings.address and merges their results into framebuffer. Returns
+// false if the address cannot be used or the settings cannot be split.
+bool coordinateRender(const RenderJob& job,
+                      const DistributedSettings& settings,
+                      Framebuffer& framebuffer);
+
+// Connects to the coordinator at address (retrying while it starts up) and
+// renders the jobs it assigns with the camera, whose render settings are
+// replaced by those of the coordinator. Returns false if the coordinator
+// cannot be reached, the scene does not match or the connection breaks.
+bool runWorker(const std::string& address, Camera& camera,
+               const Scene& world);
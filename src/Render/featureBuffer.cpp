@@ -0,0 +1,66 @@
+#include "featureBuffer.h"
+
+#include <algorithm>
+
+namespace
+{
+    // Stores one value per pixel as an image with a single sample each.
+    template <typename Feature>
+    Framebuffer featureImage(int width, int height, Feature feature)
+    {
+        Framebuffer image(width, height);
+
+        for (int y = 0; y < height; ++y)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                image.addSamples(x, y, feature(x, y), 1);
+            }
+        }
+
+        return image;
+    }
+}
+
+FeatureBuffer::FeatureBuffer(int width, int height) :
+                             m_width(width), m_height(height),
+                             m_albedo(static_cast<size_t>(width) * height),
+                             m_normal(static_cast<size_t>(width) * height),
+                             m_depth(static_cast<size_t>(width) * height,
+                                     0.0f),
+                             m_counts(static_cast<size_t>(width) * height, 0)
+{}
+
+void FeatureBuffer::clear()
+{
+    std::fill(m_albedo.begin(), m_albedo.end(), Color(0.0f, 0.0f, 0.0f));
+    std::fill(m_normal.begin(), m_normal.end(), Vector3(0.0f, 0.0f, 0.0f));
+    std::fill(m_depth.begin(), m_depth.end(), 0.0f);
+    std::fill(m_counts.begin(), m_counts.end(), 0u);
+}
+
+Framebuffer FeatureBuffer::albedoImage() const
+{
+    return featureImage(m_width, m_height, [this](int x, int y)
+                        {
+                            return albedo(x, y);
+                        });
+}
+
+Framebuffer FeatureBuffer::normalImage() const
+{
+    return featureImage(m_width, m_height, [this](int x, int y)
+                        {
+                            return normal(x, y);
+                        });
+}
+
+Framebuffer FeatureBuffer::depthImage() const
+{
+    return featureImage(m_width, m_height, [this](int x, int y)
+                        {
+                            float d = depth(x, y);
+
+                            return Color(d, d, d);
+                        });
+}
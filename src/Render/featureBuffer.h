@@ -0,0 +1,96 @@
+/*
+ * This class holds the auxiliary buffers (AOVs) of a render: the albedo,
+ * shading normal and distance of the first surface seen through every pixel,
+ * accumulated as sums over the primary rays of the pixel's samples. They
+ * guide the denoiser and can be written as images of their own.
+ *
+ * Rays that hit nothing get the sky color as albedo, a zero normal and a
+ * depth of 0.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "framebuffer.h"
+#include "../Math/vector3.h"
+
+class FeatureBuffer
+{
+public:
+    // Default constructor (empty buffers).
+    FeatureBuffer() : m_width(0), m_height(0) {}
+
+    // Initialization constructor (buffers without any samples).
+    FeatureBuffer(int width, int height);
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+
+    // Number of pixels in the buffers.
+    size_t pixelCount() const { return m_counts.size(); }
+
+    // Adds the sums of count feature samples to the pixel at (x, y).
+    void addSamples(int x, int y, const Color& albedoSum,
+                    const Vector3& normalSum, float depthSum, uint32_t count)
+    {
+        size_t index = static_cast<size_t>(y) * m_width + x;
+
+        m_albedo[index] += albedoSum;
+        m_normal[index] += normalSum;
+        m_depth[index] += depthSum;
+        m_counts[index] += count;
+    }
+
+    // Mean albedo of the pixel at (x, y).
+    Color albedo(int x, int y) const
+    {
+        size_t index = static_cast<size_t>(y) * m_width + x;
+
+        return mean(m_albedo[index], m_counts[index]);
+    }
+
+    // Mean shading normal of the pixel at (x, y); shorter than unit length
+    // where the pixel covers differently oriented surfaces.
+    Vector3 normal(int x, int y) const
+    {
+        size_t index = static_cast<size_t>(y) * m_width + x;
+
+        return mean(m_normal[index], m_counts[index]);
+    }
+
+    // Mean distance from the camera to the first hit at (x, y).
+    float depth(int x, int y) const
+    {
+        size_t index = static_cast<size_t>(y) * m_width + x;
+
+        return m_counts[index] > 0 ?
+               m_depth[index] / static_cast<float>(m_counts[index]) : 0.0f;
+    }
+
+    // Removes every sample from the buffers.
+    void clear();
+
+    // Returns one of the buffers as an image for writing. Normals keep
+    // their signed components and depth is stored in every channel, so
+    // these are best written as PFM.
+    Framebuffer albedoImage() const;
+    Framebuffer normalImage() const;
+    Framebuffer depthImage() const;
+
+private:
+    static Vector3 mean(const Vector3& sum, uint32_t count)
+    {
+        return count > 0 ? sum / static_cast<float>(count) :
+                           Vector3(0.0f, 0.0f, 0.0f);
+    }
+
+    int m_width;
+    int m_height;
+
+    std::vector<Color> m_albedo;
+    std::vector<Vector3> m_normal;
+    std::vector<float> m_depth;
+    std::vector<uint32_t> m_counts;
+};
@@ -0,0 +1,15 @@
+#include "framebuffer.h"
+
+#include <algorithm>
+
+Framebuffer::Framebuffer(int width, int height) :
+                         m_width(width), m_height(height),
+                         m_sums(static_cast<size_t>(width) * height),
+                         m_sampleCounts(static_cast<size_t>(width) * height, 0)
+{}
+
+void Framebuffer::clear()
+{
+    std::fill(m_sums.begin(), m_sums.end(), Color(0.0f, 0.0f, 0.0f));
+    std::fill(m_sampleCounts.begin(), m_sampleCounts.end(), 0u);
+}
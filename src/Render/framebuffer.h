@@ -0,0 +1,78 @@
+/*
+ * This class holds a rendered image in memory as linear floating point
+ * sample sums plus a sample count per pixel. Renderers accumulate into it
+ * and the image writers encode it once the frame is done.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "../Math/vector3.h"
+
+class Framebuffer
+{
+public:
+    // Default constructor (empty image).
+    Framebuffer() : m_width(0), m_height(0) {}
+
+    // Initialization constructor (black image without any samples).
+    Framebuffer(int width, int height);
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+
+    // Number of pixels in the image.
+    size_t pixelCount() const { return m_sums.size(); }
+
+    // Adds the sum of count radiance samples to the pixel at (x, y).
+    void addSamples(int x, int y, const Color& sum, uint32_t count)
+    {
+        size_t index = static_cast<size_t>(y) * m_width + x;
+
+        m_sums[index] += sum;
+        m_sampleCounts[index] += count;
+    }
+
+    // Returns the linear radiance estimate (mean of the samples) at (x, y).
+    Color pixel(int x, int y) const
+    {
+        size_t index = static_cast<size_t>(y) * m_width + x;
+        uint32_t count = m_sampleCounts[index];
+
+        return count > 0 ? m_sums[index] / static_cast<float>(count) :
+                           Color(0.0f, 0.0f, 0.0f);
+    }
+
+    // Sum of all samples of the pixel at (x, y).
+    const Color& sampleSum(int x, int y) const
+    {
+        return m_sums[static_cast<size_t>(y) * m_width + x];
+    }
+
+    // Number of samples accumulated in the pixel at (x, y).
+    uint32_t sampleCount(int x, int y) const
+    {
+        return m_sampleCounts[static_cast<size_t>(y) * m_width + x];
+    }
+
+    // Row-major sample sums and counts.
+    std::vector<Color>& sums() { return m_sums; }
+    const std::vector<Color>& sums() const { return m_sums; }
+    std::vector<uint32_t>& sampleCounts() { return m_sampleCounts; }
+    const std::vector<uint32_t>& sampleCounts() const
+    {
+        return m_sampleCounts;
+    }
+
+    // Removes every sample from the image.
+    void clear();
+
+private:
+    int m_width;
+    int m_height;
+
+    std::vector<Color> m_sums;
+    std::vector<uint32_t> m_sampleCounts;
+};
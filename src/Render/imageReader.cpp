@@ -0,0 +1,320 @@
+#include "imageReader.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "imageWriter.h"
+
+namespace
+{
+    // Most pixels accepted (a 16384x8192 environment map), which keeps
+    // corrupt or hostile headers from allocating absurd images.
+    const uint64_t MAX_IMAGE_PIXELS = 1ull << 27;
+
+    // Returns the number of bytes between the read position and the end.
+    uint64_t remainingBytes(std::istream& in)
+    {
+        std::streampos position = in.tellg();
+
+        if (position < 0 || !in.seekg(0, std::ios::end))
+        {
+            return 0;
+        }
+
+        std::streampos end = in.tellg();
+        in.seekg(position);
+
+        return end > position ? static_cast<uint64_t>(end - position) : 0;
+    }
+
+    // Checks a size read from a header against the pixel limit and against
+    // rowBytes, the fewest bytes a row of width pixels is stored in, times
+    // height: a file too short to hold the image is rejected before the
+    // image is allocated.
+    bool validSize(int width, int height, uint64_t rowBytes,
+                   uint64_t available)
+    {
+        return width > 0 && height > 0 &&
+               static_cast<uint64_t>(width) * static_cast<uint64_t>(height) <=
+               MAX_IMAGE_PIXELS &&
+               rowBytes * static_cast<uint64_t>(height) <= available;
+    }
+
+    // Fewest bytes a Radiance scanline of width pixels takes: flat, or run
+    // length encoded with a 4-byte start and every component in runs of at
+    // most 127 pixels of 2 bytes each.
+    uint64_t minimumScanlineBytes(int width)
+    {
+        uint64_t flat = 4 * static_cast<uint64_t>(width);
+        uint64_t encoded = 4 + 8 * ((static_cast<uint64_t>(width) + 126) /
+                                    127);
+
+        return width >= 8 && width < 0x8000 ? std::min(flat, encoded) :
+                                               flat;
+    }
+
+    Color fromRGBE(const unsigned char* rgbe)
+    {
+        if (rgbe[3] == 0)
+        {
+            return Color(0.0f, 0.0f, 0.0f);
+        }
+
+        // The writer truncates, so decode to the middle of each step.
+        float scale = std::ldexp(1.0f, static_cast<int>(rgbe[3]) - 136);
+
+        return Color((rgbe[0] + 0.5f) * scale, (rgbe[1] + 0.5f) * scale,
+                     (rgbe[2] + 0.5f) * scale);
+    }
+
+    // Reads one scanline of width RGBE pixels, either flat or in the run
+    // length encoding that stores each component separately.
+    bool readScanline(std::istream& in, int width,
+                      std::vector<unsigned char>& row)
+    {
+        unsigned char start[4];
+
+        if (!in.read(reinterpret_cast<char*>(start), 4))
+        {
+            return false;
+        }
+
+        bool encoded = width >= 8 && width < 0x8000 && start[0] == 2 &&
+                       start[1] == 2 && (start[2] & 0x80) == 0;
+
+        if (!encoded)
+        {
+            std::memcpy(row.data(), start, 4);
+
+            return static_cast<bool>(
+                   in.read(reinterpret_cast<char*>(row.data() + 4),
+                           static_cast<std::streamsize>(4 * width - 4)));
+        }
+
+        if (((start[2] << 8) | start[3]) != width)
+        {
+            return false;
+        }
+
+        for (int component = 0; component < 4; ++component)
+        {
+            int x = 0;
+
+            while (x < width)
+            {
+                int count = in.get();
+
+                if (count == EOF || count == 0)
+                {
+                    return false;
+                }
+
+                // Counts above 128 repeat the next byte count - 128 times.
+                bool run = count > 128;
+
+                if (run)
+                {
+                    count -= 128;
+                }
+
+                if (x + count > width)
+                {
+                    return false;
+                }
+
+                for (int i = 0; i < count; ++i)
+                {
+                    int value = run && i > 0 ? row[4 * (x - 1) + component] :
+                                               in.get();
+
+                    if (value == EOF)
+                    {
+                        return false;
+                    }
+
+                    row[4 * x + component] = static_cast<unsigned char>(
+                                             value);
+                    ++x;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    bool readHDR(std::istream& in, Framebuffer& image)
+    {
+        std::string line;
+
+        if (!std::getline(in, line) || line.compare(0, 2, "#?") != 0)
+        {
+            return false;
+        }
+
+        // Header lines end with an empty line before the resolution.
+        while (std::getline(in, line) && !line.empty())
+        {
+            if (line.compare(0, 7, "FORMAT=") == 0 &&
+                line != "FORMAT=32-bit_rle_rgbe")
+            {
+                std::cerr << "Unsupported Radiance format " << line.substr(7)
+                          << ".\n";
+
+                return false;
+            }
+        }
+
+        char yAxis[3] = {}, xAxis[3] = {};
+        int width = 0, height = 0;
+
+        if (!std::getline(in, line) ||
+            std::sscanf(line.c_str(), "%2s %d %2s %d", yAxis, &height,
+                        xAxis, &width) != 4 ||
+            std::strcmp(yAxis, "-Y") != 0 || std::strcmp(xAxis, "+X") != 0)
+        {
+            std::cerr << "Unsupported Radiance resolution \"" << line
+                      << "\" (only -Y h +X w is read).\n";
+
+            return false;
+        }
+
+        if (!validSize(width, height, minimumScanlineBytes(width),
+                       remainingBytes(in)))
+        {
+            return false;
+        }
+
+        image = Framebuffer(width, height);
+        std::vector<unsigned char> row(static_cast<size_t>(width) * 4);
+
+        for (int y = 0; y < height; ++y)
+        {
+            if (!readScanline(in, width, row))
+            {
+                return false;
+            }
+
+            for (int x = 0; x < width; ++x)
+            {
+                image.addSamples(x, y, fromRGBE(&row[4 * x]), 1);
+            }
+        }
+
+        return true;
+    }
+
+    bool readPFM(std::istream& in, Framebuffer& image)
+    {
+        std::string magic;
+        int width = 0, height = 0;
+        float scale = 0.0f;
+
+        if (!(in >> magic >> width >> height >> scale) ||
+            (magic != "PF" && magic != "Pf") || scale == 0.0f)
+        {
+            return false;
+        }
+
+        // A single whitespace character separates the header from the data.
+        in.get();
+
+        int channels = magic == "PF" ? 3 : 1;
+
+        if (!validSize(width, height,
+                       4 * static_cast<uint64_t>(width) * channels,
+                       remainingBytes(in)))
+        {
+            return false;
+        }
+
+        size_t rowValues = static_cast<size_t>(width) * channels;
+        std::vector<unsigned char> row(rowValues * 4);
+
+        // A negative scale marks little-endian data.
+        uint16_t probe = 1;
+        bool littleEndianHost = *reinterpret_cast<unsigned char*>(&probe) == 1;
+        bool swap = (scale < 0.0f) != littleEndianHost;
+
+        image = Framebuffer(width, height);
+
+        // Rows are stored bottom to top.
+        for (int y = height - 1; y >= 0; --y)
+        {
+            if (!in.read(reinterpret_cast<char*>(row.data()),
+                         static_cast<std::streamsize>(row.size())))
+            {
+                return false;
+            }
+
+            for (int x = 0; x < width; ++x)
+            {
+                float values[3];
+
+                for (int channel = 0; channel < channels; ++channel)
+                {
+                    unsigned char* bytes = &row[4 * (x * channels + channel)];
+
+                    if (swap)
+                    {
+                        std::swap(bytes[0], bytes[3]);
+                        std::swap(bytes[1], bytes[2]);
+                    }
+
+                    std::memcpy(&values[channel], bytes, 4);
+                }
+
+                if (channels == 1)
+                {
+                    values[1] = values[2] = values[0];
+                }
+
+                image.addSamples(x, y, Color(values[0], values[1], values[2]),
+                                 1);
+            }
+        }
+
+        return true;
+    }
+}
+
+bool readImage(const std::string& path, Framebuffer& image)
+{
+    ImageFormat format;
+
+    if (!imageFormatFromPath(path, format) ||
+        (format != ImageFormat::HDR && format != ImageFormat::PFM))
+    {
+        std::cerr << "Cannot read " << path
+                  << " (only .hdr and .pfm images are read).\n";
+
+        return false;
+    }
+
+    std::ifstream in(path, std::ios::binary);
+
+    if (!in)
+    {
+        std::cerr << "Could not open " << path << ".\n";
+
+        return false;
+    }
+
+    bool read = format == ImageFormat::HDR ? readHDR(in, image) :
+                                             readPFM(in, image);
+
+    if (!read)
+    {
+        std::cerr << "Could not read " << path
+                  << " (truncated or not a valid image).\n";
+    }
+
+    return read;
+}
@@ -0,0 +1,16 @@
+/*
+ * This file decodes the float image formats written by imageWriter.h back
+ * into a Framebuffer, for images that light a scene. Radiance HDR files may
+ * be uncompressed or use the run length encoded scanlines most tools write;
+ * PFM files may be color or grayscale and of either byte order.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "framebuffer.h"
+
+// Reads a .hdr or .pfm file into image, one sample per pixel, with the top
+// row first. Returns false (and reports why) if it cannot be read.
+bool readImage(const std::string& path, Framebuffer& image);
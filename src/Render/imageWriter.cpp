@@ -0,0 +1,593 @@
+#include "imageWriter.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#include "framebuffer.h"
+
+namespace
+{
+    // Returns the image as interleaved 8-bit RGB, top row first.
+    std::vector<unsigned char> toDisplayBytes(const Framebuffer& framebuffer)
+    {
+        std::vector<unsigned char> bytes;
+        bytes.reserve(framebuffer.pixelCount() * 3);
+
+        for (int y = 0; y < framebuffer.height(); ++y)
+        {
+            for (int x = 0; x < framebuffer.width(); ++x)
+            {
+                Color pixelColor = framebuffer.pixel(x, y);
+
+                bytes.push_back(toDisplayByte(pixelColor.x()));
+                bytes.push_back(toDisplayByte(pixelColor.y()));
+                bytes.push_back(toDisplayByte(pixelColor.z()));
+            }
+        }
+
+        return bytes;
+    }
+
+    bool writePPM(const Framebuffer& framebuffer, std::ostream& out)
+    {
+        std::vector<unsigned char> bytes = toDisplayBytes(framebuffer);
+
+        out << "P6\n" << framebuffer.width() << ' ' << framebuffer.height()
+            << "\n255\n";
+        out.write(reinterpret_cast<const char*>(bytes.data()),
+                  static_cast<std::streamsize>(bytes.size()));
+
+        return static_cast<bool>(out);
+    }
+
+    bool writePFM(const Framebuffer& framebuffer, std::ostream& out)
+    {
+        // A negative scale marks little-endian data; rows go bottom to top.
+        out << "PF\n" << framebuffer.width() << ' ' << framebuffer.height()
+            << "\n-1.0\n";
+
+        std::vector<float> row(static_cast<size_t>(framebuffer.width()) * 3);
+
+        for (int y = framebuffer.height() - 1; y >= 0; --y)
+        {
+            for (int x = 0; x < framebuffer.width(); ++x)
+            {
+                Color pixelColor = framebuffer.pixel(x, y);
+
+                row[3 * x + 0] = pixelColor.x();
+                row[3 * x + 1] = pixelColor.y();
+                row[3 * x + 2] = pixelColor.z();
+            }
+
+            for (float value : row)
+            {
+                uint32_t bits;
+                std::memcpy(&bits, &value, sizeof(bits));
+
+                char bytes[4] = {static_cast<char>(bits & 0xFF),
+                                 static_cast<char>((bits >> 8) & 0xFF),
+                                 static_cast<char>((bits >> 16) & 0xFF),
+                                 static_cast<char>((bits >> 24) & 0xFF)};
+                out.write(bytes, 4);
+            }
+        }
+
+        return static_cast<bool>(out);
+    }
+
+    bool writeHDR(const Framebuffer& framebuffer, std::ostream& out)
+    {
+        out << "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y "
+            << framebuffer.height() << " +X " << framebuffer.width() << '\n';
+
+        std::vector<unsigned char> row(static_cast<size_t>(
+                                       framebuffer.width()) * 4);
+
+        for (int y = 0; y < framebuffer.height(); ++y)
+        {
+            for (int x = 0; x < framebuffer.width(); ++x)
+            {
+                Color pixelColor = framebuffer.pixel(x, y);
+                float r = std::fmax(pixelColor.x(), 0.0f);
+                float g = std::fmax(pixelColor.y(), 0.0f);
+                float b = std::fmax(pixelColor.z(), 0.0f);
+                float brightest = std::fmax(r, std::fmax(g, b));
+
+                // Shared exponent encoding (uncompressed scanlines).
+                unsigned char* rgbe = &row[4 * x];
+
+                if (brightest < 1e-32f)
+                {
+                    rgbe[0] = rgbe[1] = rgbe[2] = rgbe[3] = 0;
+
+                    continue;
+                }
+
+                int exponent;
+                float scale = std::frexp(brightest, &exponent) * 256.0f /
+                              brightest;
+
+                rgbe[0] = static_cast<unsigned char>(r * scale);
+                rgbe[1] = static_cast<unsigned char>(g * scale);
+                rgbe[2] = static_cast<unsigned char>(b * scale);
+                rgbe[3] = static_cast<unsigned char>(exponent + 128);
+            }
+
+            out.write(reinterpret_cast<const char*>(row.data()),
+                      static_cast<std::streamsize>(row.size()));
+        }
+
+        return static_cast<bool>(out);
+    }
+
+    // Accumulates bits least significant first, as required by deflate.
+    class BitWriter
+    {
+    public:
+        explicit BitWriter(std::vector<unsigned char>& out) : m_out(out) {}
+
+        void write(uint32_t bits, int count)
+        {
+            m_buffer |= static_cast<uint64_t>(bits) << m_count;
+            m_count += count;
+
+            while (m_count >= 8)
+            {
+                m_out.push_back(static_cast<unsigned char>(m_buffer & 0xFF));
+                m_buffer >>= 8;
+                m_count -= 8;
+            }
+        }
+
+        // Writes a Huffman code, which deflate stores most significant
+        // bit first.
+        void writeCode(uint32_t code, int length)
+        {
+            uint32_t reversed = 0;
+
+            for (int i = 0; i < length; ++i)
+            {
+                reversed = (reversed << 1) | ((code >> i) & 1u);
+            }
+
+            write(reversed, length);
+        }
+
+        void flush()
+        {
+            if (m_count > 0)
+            {
+                m_out.push_back(static_cast<unsigned char>(m_buffer & 0xFF));
+            }
+
+            m_buffer = 0;
+            m_count = 0;
+        }
+
+    private:
+        std::vector<unsigned char>& m_out;
+        uint64_t m_buffer = 0;
+        int m_count = 0;
+    };
+
+    const uint16_t LENGTH_BASE[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17,
+                                      19, 23, 27, 31, 35, 43, 51, 59, 67, 83,
+                                      99, 115, 131, 163, 195, 227, 258};
+    const uint8_t LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2,
+                                      2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5,
+                                      5, 5, 0};
+    const uint16_t DISTANCE_BASE[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33,
+                                        49, 65, 97, 129, 193, 257, 385, 513,
+                                        769, 1025, 1537, 2049, 3073, 4097,
+                                        6145, 8193, 12289, 16385, 24577};
+    const uint8_t DISTANCE_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4,
+                                        5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10,
+                                        11, 11, 12, 12, 13, 13};
+
+    // Writes a literal/length symbol with the fixed Huffman code.
+    void writeLiteralLength(BitWriter& bits, int symbol)
+    {
+        if (symbol < 144)
+            bits.writeCode(0x30 + symbol, 8);
+        else if (symbol < 256)
+            bits.writeCode(0x190 + (symbol - 144), 9);
+        else if (symbol < 280)
+            bits.writeCode(symbol - 256, 7);
+        else
+            bits.writeCode(0xC0 + (symbol - 280), 8);
+    }
+
+    void writeMatch(BitWriter& bits, int length, int distance)
+    {
+        int code = 28;
+
+        while (LENGTH_BASE[code] > length)
+        {
+            --code;
+        }
+
+        writeLiteralLength(bits, 257 + code);
+        bits.write(length - LENGTH_BASE[code], LENGTH_EXTRA[code]);
+
+        code = 29;
+
+        while (DISTANCE_BASE[code] > distance)
+        {
+            --code;
+        }
+
+        bits.writeCode(code, 5);
+        bits.write(distance - DISTANCE_BASE[code], DISTANCE_EXTRA[code]);
+    }
+
+    // Compresses data into a zlib stream (a single fixed Huffman deflate
+    // block with greedy LZ77 matching over hash chains).
+    std::vector<unsigned char> zlibCompress(
+        const std::vector<unsigned char>& data)
+    {
+        const int WINDOW_SIZE = 32768;
+        const int HASH_SIZE = 1 << 15;
+        const int MIN_MATCH = 3;
+        const int MAX_MATCH = 258;
+        const int MAX_CHAIN = 32;
+
+        std::vector<unsigned char> out = {0x78, 0x01};
+        BitWriter bits(out);
+
+        // Final block, fixed Huffman codes.
+        bits.write(1, 1);
+        bits.write(1, 2);
+
+        std::vector<int> head(HASH_SIZE, -1);
+        std::vector<int> previous(WINDOW_SIZE, -1);
+
+        auto hashAt = [&](size_t i)
+        {
+            return ((data[i] << 10) ^ (data[i + 1] << 5) ^ data[i + 2]) &
+                   (HASH_SIZE - 1);
+        };
+
+        auto insert = [&](size_t i)
+        {
+            if (i + MIN_MATCH > data.size())
+            {
+                return;
+            }
+
+            int hash = hashAt(i);
+            previous[i % WINDOW_SIZE] = head[hash];
+            head[hash] = static_cast<int>(i);
+        };
+
+        size_t i = 0;
+
+        while (i < data.size())
+        {
+            int bestLength = 0;
+            int bestDistance = 0;
+
+            if (i + MIN_MATCH <= data.size())
+            {
+                int candidate = head[hashAt(i)];
+                int maxLength = static_cast<int>(std::min<size_t>(
+                                                 MAX_MATCH, data.size() - i));
+
+                for (int chain = 0; chain < MAX_CHAIN && candidate >= 0 &&
+                     static_cast<int>(i) - candidate <= WINDOW_SIZE; ++chain)
+                {
+                    int length = 0;
+
+                    while (length < maxLength &&
+                           data[candidate + length] == data[i + length])
+                    {
+                        ++length;
+                    }
+
+                    if (length > bestLength)
+                    {
+                        bestLength = length;
+                        bestDistance = static_cast<int>(i) - candidate;
+
+                        if (length == maxLength)
+                        {
+                            break;
+                        }
+                    }
+
+                    candidate = previous[candidate % WINDOW_SIZE];
+                }
+            }
+
+            if (bestLength >= MIN_MATCH)
+            {
+                writeMatch(bits, bestLength, bestDistance);
+
+                for (int k = 0; k < bestLength; ++k)
+                {
+                    insert(i + k);
+                }
+
+                i += bestLength;
+            }
+            else
+            {
+                writeLiteralLength(bits, data[i]);
+                insert(i);
+                ++i;
+            }
+        }
+
+        // End of block.
+        writeLiteralLength(bits, 256);
+        bits.flush();
+
+        // Adler-32 checksum of the uncompressed data.
+        uint32_t a = 1, b = 0;
+
+        for (unsigned char byte : data)
+        {
+            a = (a + byte) % 65521;
+            b = (b + a) % 65521;
+        }
+
+        uint32_t adler = (b << 16) | a;
+
+        out.push_back(static_cast<unsigned char>(adler >> 24));
+        out.push_back(static_cast<unsigned char>(adler >> 16));
+        out.push_back(static_cast<unsigned char>(adler >> 8));
+        out.push_back(static_cast<unsigned char>(adler));
+
+        return out;
+    }
+
+    // Table of the CRC of every byte value (the PNG polynomial).
+    std::array<uint32_t, 256> makeCrcTable()
+    {
+        std::array<uint32_t, 256> table;
+
+        for (uint32_t n = 0; n < 256; ++n)
+        {
+            uint32_t c = n;
+
+            for (int k = 0; k < 8; ++k)
+            {
+                c = (c & 1u) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+
+            table[n] = c;
+        }
+
+        return table;
+    }
+
+    uint32_t crc32(const unsigned char* data, size_t size,
+                   uint32_t crc = 0xFFFFFFFFu)
+    {
+        // Built once even when several threads write images at a time.
+        static const std::array<uint32_t, 256> table = makeCrcTable();
+
+        for (size_t i = 0; i < size; ++i)
+        {
+            crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        }
+
+        return crc;
+    }
+
+    void writeBigEndian(std::ostream& out, uint32_t value)
+    {
+        char bytes[4] = {static_cast<char>(value >> 24),
+                         static_cast<char>(value >> 16),
+                         static_cast<char>(value >> 8),
+                         static_cast<char>(value)};
+        out.write(bytes, 4);
+    }
+
+    void writeChunk(std::ostream& out, const char* type,
+                    const std::vector<unsigned char>& data)
+    {
+        writeBigEndian(out, static_cast<uint32_t>(data.size()));
+        out.write(type, 4);
+        out.write(reinterpret_cast<const char*>(data.data()),
+                  static_cast<std::streamsize>(data.size()));
+
+        uint32_t crc = crc32(reinterpret_cast<const unsigned char*>(type), 4);
+        crc = crc32(data.data(), data.size(), crc);
+
+        writeBigEndian(out, crc ^ 0xFFFFFFFFu);
+    }
+
+    unsigned char paethPredictor(int a, int b, int c)
+    {
+        int p = a + b - c;
+        int pa = std::abs(p - a);
+        int pb = std::abs(p - b);
+        int pc = std::abs(p - c);
+
+        if (pa <= pb && pa <= pc) return static_cast<unsigned char>(a);
+        if (pb <= pc) return static_cast<unsigned char>(b);
+
+        return static_cast<unsigned char>(c);
+    }
+
+    bool writePNG(const Framebuffer& framebuffer, std::ostream& out)
+    {
+        const size_t stride = static_cast<size_t>(framebuffer.width()) * 3;
+        std::vector<unsigned char> pixels = toDisplayBytes(framebuffer);
+
+        // Filter every row with whichever PNG filter gives the smallest sum
+        // of absolute residuals, which usually compresses best.
+        std::vector<unsigned char> filtered;
+        filtered.reserve((stride + 1) * framebuffer.height());
+
+        std::vector<unsigned char> candidate(stride);
+        std::vector<unsigned char> best(stride);
+
+        for (int y = 0; y < framebuffer.height(); ++y)
+        {
+            const unsigned char* row = &pixels[y * stride];
+            const unsigned char* above = y > 0 ? row - stride : nullptr;
+
+            long bestScore = -1;
+            unsigned char bestFilter = 0;
+
+            for (unsigned char filter = 0; filter < 5; ++filter)
+            {
+                long score = 0;
+
+                for (size_t i = 0; i < stride; ++i)
+                {
+                    int left = i >= 3 ? row[i - 3] : 0;
+                    int up = above ? above[i] : 0;
+                    int upLeft = (above && i >= 3) ? above[i - 3] : 0;
+                    int prediction = 0;
+
+                    switch (filter)
+                    {
+                    case 1: prediction = left; break;
+                    case 2: prediction = up; break;
+                    case 3: prediction = (left + up) / 2; break;
+                    case 4: prediction = paethPredictor(left, up, upLeft);
+                            break;
+                    default: break;
+                    }
+
+                    candidate[i] = static_cast<unsigned char>(row[i] -
+                                                              prediction);
+                    score += std::abs(static_cast<signed char>(candidate[i]));
+                }
+
+                if (bestScore < 0 || score < bestScore)
+                {
+                    bestScore = score;
+                    bestFilter = filter;
+                    best.swap(candidate);
+                }
+            }
+
+            filtered.push_back(bestFilter);
+            filtered.insert(filtered.end(), best.begin(), best.end());
+        }
+
+        static const char SIGNATURE[8] = {'\x89', 'P', 'N', 'G',
+                                          '\r', '\n', '\x1A', '\n'};
+        out.write(SIGNATURE, 8);
+
+        std::vector<unsigned char> header(13);
+        uint32_t width = static_cast<uint32_t>(framebuffer.width());
+        uint32_t height = static_cast<uint32_t>(framebuffer.height());
+
+        for (int i = 0; i < 4; ++i)
+        {
+            header[i] = static_cast<unsigned char>(width >> (24 - 8 * i));
+            header[4 + i] = static_cast<unsigned char>(height >> (24 - 8 * i));
+        }
+
+        // 8-bit RGB, deflate, adaptive filtering, no interlacing.
+        header[8] = 8;
+        header[9] = 2;
+
+        writeChunk(out, "IHDR", header);
+        writeChunk(out, "IDAT", zlibCompress(filtered));
+        writeChunk(out, "IEND", {});
+
+        return static_cast<bool>(out);
+    }
+}
+
+bool imageFormatFromPath(const std::string& path, ImageFormat& format)
+{
+    size_t dot = path.find_last_of('.');
+
+    if (dot == std::string::npos)
+    {
+        return false;
+    }
+
+    std::string extension = path.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c)
+                   {
+                       return static_cast<char>(std::tolower(c));
+                   });
+
+    if (extension == "ppm")
+        format = ImageFormat::PPM;
+    else if (extension == "pfm")
+        format = ImageFormat::PFM;
+    else if (extension == "hdr")
+        format = ImageFormat::HDR;
+    else if (extension == "png")
+        format = ImageFormat::PNG;
+    else
+        return false;
+
+    return true;
+}
+
+bool writeImage(const Framebuffer& framebuffer, std::ostream& out,
+                ImageFormat format)
+{
+    switch (format)
+    {
+    case ImageFormat::PFM:
+        return writePFM(framebuffer, out);
+    case ImageFormat::HDR:
+        return writeHDR(framebuffer, out);
+    case ImageFormat::PNG:
+        return writePNG(framebuffer, out);
+    case ImageFormat::PPM:
+    default:
+        return writePPM(framebuffer, out);
+    }
+}
+
+bool writeImage(const Framebuffer& framebuffer, const std::string& path)
+{
+    if (path == "-")
+    {
+#ifdef _WIN32
+        // Keep the console from translating bytes of the binary image.
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+        bool written = writeImage(framebuffer, std::cout, ImageFormat::PPM);
+        std::cout.flush();
+
+        return written;
+    }
+
+    ImageFormat format;
+
+    if (!imageFormatFromPath(path, format))
+    {
+        std::cerr << "Unsupported image format: " << path << '\n';
+
+        return false;
+    }
+
+    std::ofstream file(path, std::ios::binary);
+
+    if (!file)
+    {
+        std::cerr << "Could not open " << path << " for writing.\n";
+
+        return false;
+    }
+
+    return writeImage(framebuffer, file, format);
+}
@@ -0,0 +1,41 @@
+/*
+ * This file encodes a Framebuffer into image files in a single pass. 8-bit
+ * formats (binary PPM and PNG) are gamma corrected (gamma = 2.0) and
+ * clamped; float formats (PFM and Radiance HDR) keep the linear radiance.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <ostream>
+#include <string>
+
+#include "framebuffer.h"
+#include "../Math/utilities.h"
+
+enum class ImageFormat
+{
+    PPM,
+    PFM,
+    HDR,
+    PNG
+};
+
+// Derives the image format from a file extension (.ppm, .pfm, .hdr, .png).
+bool imageFormatFromPath(const std::string& path, ImageFormat& format);
+
+// Writes the framebuffer to the stream in the given format.
+bool writeImage(const Framebuffer& framebuffer, std::ostream& out,
+                ImageFormat format);
+
+// Writes the framebuffer to a file, choosing the format from its
+// extension. A path of "-" writes a binary PPM to standard output.
+bool writeImage(const Framebuffer& framebuffer, const std::string& path);
+
+// Converts a linear color component to an 8-bit gamma corrected value.
+inline unsigned char toDisplayByte(float linear)
+{
+    float value = linear > 0.0f ? std::sqrt(linear) : 0.0f;
+
+    return static_cast<unsigned char>(256.0f * clamp(value, 0.0f, 0.999f));
+}
@@ -0,0 +1,40 @@
+#include "messages.h"
+
+#include <vector>
+
+bool sendPixels(Socket& socket, const Framebuffer& framebuffer)
+{
+    std::vector<float> sums;
+    sums.reserve(framebuffer.pixelCount() * 3);
+
+    for (const Color& sum : framebuffer.sums())
+    {
+        sums.push_back(sum.x());
+        sums.push_back(sum.y());
+        sums.push_back(sum.z());
+    }
+
+    return socket.send(sums.data(), sums.size() * sizeof(float)) &&
+           socket.send(framebuffer.sampleCounts().data(),
+                       framebuffer.pixelCount() * sizeof(uint32_t));
+}
+
+bool receivePixels(Socket& socket, Framebuffer& framebuffer)
+{
+    std::vector<float> sums(framebuffer.pixelCount() * 3);
+
+    if (!socket.receive(sums.data(), sums.size() * sizeof(float)) ||
+        !socket.receive(framebuffer.sampleCounts().data(),
+                        framebuffer.pixelCount() * sizeof(uint32_t)))
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < framebuffer.pixelCount(); ++i)
+    {
+        framebuffer.sums()[i] = Color(sums[3 * i], sums[3 * i + 1],
+                                      sums[3 * i + 2]);
+    }
+
+    return true;
+}
@@ -0,0 +1,66 @@
+/*
+ * This file frames the messages of the render protocols (distributed
+ * rendering and the render server). A message is a MessageHeader followed
+ * by its payload, both in native byte order as in checkpoints, and pixels
+ * travel as the float sample sums and counts of a framebuffer.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "framebuffer.h"
+#include "socket.h"
+
+struct MessageHeader
+{
+    uint32_t type;
+
+    // Bytes of payload following the header.
+    uint32_t size;
+};
+
+template <typename MessageType>
+bool sendHeader(Socket& socket, MessageType type, size_t size)
+{
+    MessageHeader header;
+    header.type = static_cast<uint32_t>(type);
+    header.size = static_cast<uint32_t>(size);
+
+    return socket.send(&header, sizeof(header));
+}
+
+template <typename MessageType>
+bool sendMessage(Socket& socket, MessageType type, const void* payload,
+                 size_t size)
+{
+    return sendHeader(socket, type, size) &&
+           (size == 0 || socket.send(payload, size));
+}
+
+// Receives a header and checks that it announces the given message with
+// the given payload size.
+template <typename MessageType>
+bool receiveHeader(Socket& socket, MessageType type, size_t size)
+{
+    MessageHeader header;
+
+    return socket.receive(&header, sizeof(header)) &&
+           header.type == static_cast<uint32_t>(type) &&
+           header.size == size;
+}
+
+// Bytes of the pixels of a framebuffer with pixelCount pixels:
+// float sums[3 * pixelCount], uint32_t sampleCounts[pixelCount].
+inline size_t pixelDataSize(size_t pixelCount)
+{
+    return pixelCount * (3 * sizeof(float) + sizeof(uint32_t));
+}
+
+// Sends the sample sums and counts of every pixel of the framebuffer.
+bool sendPixels(Socket& socket, const Framebuffer& framebuffer);
+
+// Receives the sample sums and counts of every pixel into a framebuffer
+// that already has the size of the image sent.
+bool receivePixels(Socket& socket, Framebuffer& framebuffer);
@@ -0,0 +1,102 @@
+#include "progressiveRenderer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <utility>
+
+#include "checkpoint.h"
+#include "framebuffer.h"
+#include "../Math/hash.h"
+
+namespace
+{
+    // Returns the smallest number of samples held by any pixel.
+    int minimumSampleCount(const Framebuffer& framebuffer)
+    {
+        const auto& counts = framebuffer.sampleCounts();
+
+        if (counts.empty())
+        {
+            return 0;
+        }
+
+        return static_cast<int>(*std::min_element(counts.begin(),
+                                                  counts.end()));
+    }
+
+    // Identifies the scene and settings whose samples a checkpoint holds.
+    // The target samples per pixel only bounds the passes, so a render can
+    // be resumed to take more.
+    uint64_t renderHash(const Camera& camera, const Scene& world)
+    {
+        uint64_t settings = camera.settingsHash(false);
+
+        return contentHash(&settings, sizeof(settings), world.contentHash());
+    }
+}
+
+bool renderProgressive(const Camera& camera, const Scene& world,
+                       Framebuffer& framebuffer,
+                       const ProgressiveSettings& settings,
+                       const PassCallback& onPassComplete)
+{
+    uint64_t hash = renderHash(camera, world);
+
+    if (!settings.resumePath.empty())
+    {
+        Framebuffer restored;
+
+        if (!loadCheckpoint(restored, settings.resumePath,
+                            framebuffer.width(), framebuffer.height(), hash))
+        {
+            return false;
+        }
+
+        framebuffer = std::move(restored);
+
+        std::clog << "Resuming at " << minimumSampleCount(framebuffer)
+                  << " samples per pixel.\n";
+    }
+
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point lastCheckpoint = Clock::now();
+
+    int samplesPerPass = std::max(1, settings.samplesPerPass);
+    int completed = minimumSampleCount(framebuffer);
+
+    while (completed < camera.samplesPerPixel())
+    {
+        int passSamples = std::min(samplesPerPass,
+                                   camera.samplesPerPixel() - completed);
+
+        camera.renderPass(world, framebuffer, passSamples);
+        completed += passSamples;
+
+        std::clog << "\rPass complete: " << completed << " / "
+                  << camera.samplesPerPixel() << " samples per pixel.\n";
+
+        if (onPassComplete)
+        {
+            onPassComplete(framebuffer, completed);
+        }
+
+        bool finished = completed >= camera.samplesPerPixel();
+        double elapsed = std::chrono::duration<double>(
+                         Clock::now() - lastCheckpoint).count();
+
+        if (!settings.checkpointPath.empty() &&
+            (finished || elapsed >= settings.checkpointInterval))
+        {
+            if (!saveCheckpoint(framebuffer, hash, settings.checkpointPath))
+            {
+                return false;
+            }
+
+            lastCheckpoint = Clock::now();
+        }
+    }
+
+    return true;
+}
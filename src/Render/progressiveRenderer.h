@@ -0,0 +1,42 @@
+/*
+ * This file renders a frame progressively: the whole image is refined in
+ * passes of a few samples per pixel, every finished pass is handed out for
+ * preview, and the accumulation buffer is checkpointed at regular intervals
+ * so a preempted render can resume where it stopped.
+ */
+
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "framebuffer.h"
+#include "../Camera/camera.h"
+#include "../Scene/scene.h"
+
+struct ProgressiveSettings
+{
+    // Samples added to every pixel per pass.
+    int samplesPerPass = 16;
+
+    // Checkpoint file (no checkpoints are written if empty).
+    std::string checkpointPath;
+
+    // Minimum number of seconds between two checkpoints. A checkpoint is
+    // always written after the last pass.
+    double checkpointInterval = 300.0;
+
+    // Checkpoint to resume from (a fresh render if empty).
+    std::string resumePath;
+};
+
+// Called after every finished pass with the accumulated image and the
+// number of samples every pixel holds.
+using PassCallback = std::function<void(const Framebuffer&, int)>;
+
+// Renders passes until every pixel holds camera.samplesPerPixel() samples.
+// Returns false if the checkpoint could not be read or written.
+bool renderProgressive(const Camera& camera, const Scene& world,
+                       Framebuffer& framebuffer,
+                       const ProgressiveSettings& settings,
+                       const PassCallback& onPassComplete = PassCallback());
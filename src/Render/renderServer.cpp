@@ -0,0 +1,834 @@
+#include "renderServer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "messages.h"
+#include "socket.h"
+#include "threadPool.h"
+#include "../Camera/camera.h"
+#include "../Math/hash.h"
+#include "../Scene/animation.h"
+#include "../Scene/mappedFile.h"
+#include "../Scene/scene.h"
+#include "../Scene/sceneFile.h"
+
+namespace
+{
+    const uint32_t SERVER_PROTOCOL_VERSION = 1;
+
+    // Seconds a connecting client has to introduce itself.
+    const double HELLO_TIMEOUT = 10.0;
+
+    // Longest scene path a client may submit.
+    const size_t MAX_SCENE_PATH = 4096;
+
+    // Milliseconds between checks for finished clients and a stop request
+    // while no client connects.
+    const int ACCEPT_POLL_MILLISECONDS = 200;
+
+    // Pause after a connection could not be accepted (e.g. out of file
+    // descriptors), which would otherwise be retried at once forever.
+    const int ACCEPT_RETRY_MILLISECONDS = 1000;
+
+    enum class ServerMessage : uint32_t
+    {
+        Hello = 1,
+        Submit,
+        Accepted,
+        Progress,
+        Complete,
+        Failed,
+        Cancel
+    };
+
+    // A scene ready to render, posed at one frame.
+    struct LoadedScene
+    {
+        Scene scene;
+        SceneSettings settings;
+    };
+
+    // The most recently used scenes, keyed by the hash of their file and
+    // the frame they are posed at.
+    class SceneCache
+    {
+    public:
+        explicit SceneCache(size_t capacity) : m_capacity(capacity) {}
+
+        // Returns the scene at path posed at frame, loading it unless a
+        // scene with the same contents and frame is cached. Returns null
+        // and describes the problem in error if it cannot be loaded.
+        std::shared_ptr<const LoadedScene> acquire(const std::string& path,
+                                                   int frame,
+                                                   std::string& error);
+
+    private:
+        struct Entry
+        {
+            uint64_t hash;
+            int frame;
+
+            // Shared with the jobs rendering it, so an evicted scene lives
+            // until they finish.
+            std::shared_ptr<const LoadedScene> scene;
+        };
+
+        // Most recently used first.
+        std::list<Entry> m_entries;
+        size_t m_capacity;
+    };
+
+    std::shared_ptr<const LoadedScene> SceneCache::acquire(
+        const std::string& path, int frame, std::string& error)
+    {
+        uint64_t hash;
+
+        {
+            MappedFile file;
+
+            if (!file.open(path))
+            {
+                error = "Cannot open the scene " + path;
+                return nullptr;
+            }
+
+            hash = contentHash(file.data(), file.size());
+        }
+
+        for (auto entry = m_entries.begin(); entry != m_entries.end();
+             ++entry)
+        {
+            if (entry->hash == hash && entry->frame == frame)
+            {
+                m_entries.splice(m_entries.begin(), m_entries, entry);
+
+                return m_entries.front().scene;
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        auto loaded = std::make_shared<LoadedScene>();
+        Animation animation;
+
+        if (!loadScene(path, loaded->scene, loaded->settings, &animation))
+        {
+            error = "Cannot load the scene " + path;
+            return nullptr;
+        }
+
+        if (frame < 0 || frame >= animation.frameCount())
+        {
+            error = path + " has no frame " + std::to_string(frame);
+            return nullptr;
+        }
+
+        if (animation.animated())
+        {
+            animation.cameraAt(frame, loaded->settings.lookFrom,
+                               loaded->settings.lookAt);
+            animation.poseScene(frame, loaded->scene);
+
+            if (!loaded->scene.refit())
+            {
+                loaded->scene.build();
+            }
+        }
+
+        std::clog << "Loaded " << path << " (frame " << frame << ") in "
+                  << std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start).count()
+                  << " s.\n";
+
+        m_entries.push_front(Entry{hash, frame, std::move(loaded)});
+
+        if (m_entries.size() > m_capacity)
+        {
+            m_entries.pop_back();
+        }
+
+        return m_entries.front().scene;
+    }
+
+    // Joins the scene path a client sent onto root. Returns false if the
+    // path could name a file outside of root: absolute paths, drive paths
+    // and paths with a ".." component.
+    bool resolveScenePath(const std::string& root, const std::string& path,
+                          std::string& resolved)
+    {
+        if (path.empty() || path[0] == '/' || path[0] == '\\' ||
+            path.find(':') != std::string::npos ||
+            path.find('\0') != std::string::npos)
+        {
+            return false;
+        }
+
+        for (size_t begin = 0; begin <= path.size();)
+        {
+            size_t end = std::min(path.find_first_of("/\\", begin),
+                                  path.size());
+
+            if (path.compare(begin, end - begin, "..") == 0)
+            {
+                return false;
+            }
+
+            begin = end + 1;
+        }
+
+        resolved = root.empty() ? path : root + '/' + path;
+
+        return true;
+    }
+
+    // Returns why the server will not render request, or null if it will.
+    // The image size and samples are checked again once the scene fills in
+    // a 0.
+    const char* checkRequest(const RenderRequest& request,
+                             const ServerSettings& settings)
+    {
+        if (request.imageWidth < 0 || request.imageHeight < 0 ||
+            request.samplesPerPixel < 0 || request.samplesPerPass < 0)
+        {
+            return "The request is malformed";
+        }
+
+        if (static_cast<uint64_t>(request.imageWidth) > settings.maxPixels ||
+            static_cast<uint64_t>(request.imageHeight) > settings.maxPixels ||
+            static_cast<uint64_t>(request.imageWidth) *
+            static_cast<uint64_t>(request.imageHeight) > settings.maxPixels)
+        {
+            return "The image is larger than the server renders";
+        }
+
+        // Preemption happens between passes only, so an endless job would
+        // keep its priority forever.
+        if (request.samplesPerPixel > settings.maxSamplesPerPixel)
+        {
+            return "The job takes more samples than the server renders";
+        }
+
+        if (request.sampler < 0 || request.sampler >
+            static_cast<int32_t>(SamplerType::Sobol))
+        {
+            return "The sampler is unknown";
+        }
+
+        if (request.integrator < 0 || request.integrator >
+            static_cast<int32_t>(IntegratorType::Wavefront))
+        {
+            return "The integrator is unknown";
+        }
+
+        return nullptr;
+    }
+
+    // A client connection. The reader thread of the connection receives its
+    // requests while the scheduler streams results to it.
+    struct Connection
+    {
+        explicit Connection(Socket s) : socket(std::move(s)) {}
+
+        Socket socket;
+
+        // Serializes the messages sent to the client.
+        std::mutex sendMutex;
+
+        // Cleared once the connection broke; its jobs are dropped.
+        std::atomic<bool> open{true};
+
+        // Set when the reader thread is done, so it can be joined.
+        std::atomic<bool> finished{false};
+    };
+
+    // A connected client and the thread that receives its requests.
+    struct ClientReader
+    {
+        std::shared_ptr<Connection> connection;
+        std::thread thread;
+    };
+
+    // Tells a client that its job failed. The caller holds the send mutex
+    // of the client.
+    bool sendFailure(Connection& client, uint32_t job,
+                     const std::string& error)
+    {
+        std::vector<char> message(sizeof(job) + error.size());
+        std::memcpy(message.data(), &job, sizeof(job));
+        std::memcpy(message.data() + sizeof(job), error.data(), error.size());
+
+        return sendMessage(client.socket, ServerMessage::Failed,
+                           message.data(), message.size());
+    }
+
+    struct ServerJob
+    {
+        uint32_t id;
+        RenderRequest request;
+
+        // As sent by the client, and joined onto the scene root.
+        std::string scenePath;
+        std::string filePath;
+
+        std::shared_ptr<Connection> client;
+
+        bool cancelled = false;
+
+        // Set up when the job first renders.
+        std::shared_ptr<const LoadedScene> scene;
+        std::unique_ptr<Camera> camera;
+        Framebuffer framebuffer;
+        int samples = 0;
+        int samplesPerPass = 0;
+    };
+
+    class RenderServer
+    {
+    public:
+        explicit RenderServer(const ServerSettings& settings) :
+                              m_settings(settings),
+                              m_pool(settings.threadCount),
+                              m_scenes(std::max<size_t>(
+                                  settings.sceneCacheSize, 1)) {}
+
+        // Receives the requests of a client until it disconnects.
+        void serveClient(std::shared_ptr<Connection> client);
+
+        // Renders the queued jobs pass by pass until stop() is called.
+        void schedule();
+
+        // Makes schedule() return after its current pass.
+        void stop();
+
+    private:
+        // Waits for the next job to render a pass of. Returns null once
+        // the server stops.
+        std::shared_ptr<ServerJob> nextJob();
+
+        // Loads the scene of a job and sets up its camera. Returns false
+        // and tells the client if it cannot.
+        bool startJob(ServerJob& job);
+
+        // Sends the image of a job after a pass. Returns false if the
+        // client is gone.
+        bool sendPass(ServerJob& job, bool complete);
+
+        void removeJob(uint32_t id);
+
+        const ServerSettings& m_settings;
+
+        // Render threads shared by every job.
+        ThreadPool m_pool;
+
+        // Used by the scheduler thread only.
+        SceneCache m_scenes;
+
+        // Queued and running jobs by id; ids grow with submission time.
+        std::map<uint32_t, std::shared_ptr<ServerJob>> m_jobs;
+        uint32_t m_nextId = 1;
+        bool m_stopping = false;
+
+        std::mutex m_mutex;
+        std::condition_variable m_jobAdded;
+    };
+
+    void RenderServer::serveClient(std::shared_ptr<Connection> client)
+    {
+        Socket& socket = client->socket;
+        uint32_t version = 0;
+
+        socket.setReceiveTimeout(HELLO_TIMEOUT);
+
+        if (!receiveHeader(socket, ServerMessage::Hello, sizeof(version)) ||
+            !socket.receive(&version, sizeof(version)) ||
+            version != SERVER_PROTOCOL_VERSION)
+        {
+            client->open = false;
+            return;
+        }
+
+        // Clients may stay idle for as long as they like.
+        socket.setReceiveTimeout(0.0);
+
+        while (true)
+        {
+            MessageHeader header;
+
+            if (!socket.receive(&header, sizeof(header)))
+            {
+                break;
+            }
+
+            if (header.type == static_cast<uint32_t>(ServerMessage::Submit) &&
+                header.size > sizeof(RenderRequest) &&
+                header.size <= sizeof(RenderRequest) + MAX_SCENE_PATH)
+            {
+                auto job = std::make_shared<ServerJob>();
+                job->client = client;
+                job->scenePath.resize(header.size - sizeof(RenderRequest));
+
+                if (!socket.receive(&job->request, sizeof(RenderRequest)) ||
+                    !socket.receive(&job->scenePath[0],
+                                    job->scenePath.size()))
+                {
+                    break;
+                }
+
+                const char* error = checkRequest(job->request, m_settings);
+
+                if (!error && !resolveScenePath(m_settings.sceneRoot,
+                                                job->scenePath,
+                                                job->filePath))
+                {
+                    error = "The scene path leaves the scene root";
+                }
+
+                // Queue the job and acknowledge it before the scheduler can
+                // send its first pass. Rejected jobs fail right away.
+                std::lock_guard<std::mutex> sendLock(client->sendMutex);
+
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+
+                    job->id = m_nextId++;
+
+                    if (!error)
+                    {
+                        m_jobs.emplace(job->id, job);
+                    }
+                }
+
+                if (!error)
+                {
+                    m_jobAdded.notify_one();
+                }
+                else
+                {
+                    std::cerr << "Job " << job->id << ": " << error
+                              << ".\n";
+                }
+
+                if (!sendMessage(socket, ServerMessage::Accepted, &job->id,
+                                 sizeof(job->id)) ||
+                    (error && !sendFailure(*client, job->id, error)))
+                {
+                    break;
+                }
+            }
+            else if (header.type ==
+                     static_cast<uint32_t>(ServerMessage::Cancel) &&
+                     header.size == sizeof(uint32_t))
+            {
+                uint32_t id;
+
+                if (!socket.receive(&id, sizeof(id)))
+                {
+                    break;
+                }
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                auto job = m_jobs.find(id);
+
+                // Clients may only cancel their own jobs.
+                if (job != m_jobs.end() && job->second->client == client)
+                {
+                    job->second->cancelled = true;
+                }
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        client->open = false;
+    }
+
+    std::shared_ptr<ServerJob> RenderServer::nextJob()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        while (!m_stopping)
+        {
+            std::shared_ptr<ServerJob> best;
+
+            for (auto job = m_jobs.begin(); job != m_jobs.end();)
+            {
+                if (job->second->cancelled || !job->second->client->open)
+                {
+                    job = m_jobs.erase(job);
+                    continue;
+                }
+
+                // Ids grow with submission time, so the first job of the
+                // highest priority is the oldest.
+                if (!best ||
+                    job->second->request.priority > best->request.priority)
+                {
+                    best = job->second;
+                }
+
+                ++job;
+            }
+
+            if (best)
+            {
+                return best;
+            }
+
+            m_jobAdded.wait(lock);
+        }
+
+        return nullptr;
+    }
+
+    bool RenderServer::startJob(ServerJob& job)
+    {
+        std::string error;
+        job.scene = m_scenes.acquire(job.filePath, job.request.frame, error);
+
+        // Only the log names the file; the client learns about the path it
+        // sent.
+        if (!job.scene)
+        {
+            std::cerr << "Job " << job.id << ": " << error << ".\n";
+
+            std::lock_guard<std::mutex> lock(job.client->sendMutex);
+            sendFailure(*job.client, job.id,
+                        "Cannot render the scene " + job.scenePath);
+
+            return false;
+        }
+
+        SceneSettings settings = job.scene->settings;
+        const RenderRequest& request = job.request;
+
+        settings.resizeImage(request.imageWidth, request.imageHeight);
+
+        int samplesPerPixel = request.samplesPerPixel > 0 ?
+                              request.samplesPerPixel :
+                              settings.samplesPerPixel;
+
+        // A single 0 takes the aspect ratio of the scene, which can make the
+        // other side too large; the samples of the scene may be too many.
+        if (settings.imageWidth <= 0 || settings.imageHeight <= 0 ||
+            static_cast<uint64_t>(settings.imageWidth) *
+            static_cast<uint64_t>(settings.imageHeight) >
+            m_settings.maxPixels)
+        {
+            error = "The image is larger than the server renders";
+        }
+        else if (samplesPerPixel > m_settings.maxSamplesPerPixel)
+        {
+            error = "The job takes more samples than the server renders";
+        }
+
+        if (!error.empty())
+        {
+            std::cerr << "Job " << job.id << ": " << error << ".\n";
+
+            std::lock_guard<std::mutex> lock(job.client->sendMutex);
+            sendFailure(*job.client, job.id, error);
+
+            return false;
+        }
+
+        if (request.overrideView)
+        {
+            settings.lookFrom = Point3(request.lookFrom[0],
+                                       request.lookFrom[1],
+                                       request.lookFrom[2]);
+            settings.lookAt = Point3(request.lookAt[0], request.lookAt[1],
+                                     request.lookAt[2]);
+        }
+
+        job.camera.reset(new Camera(settings.imageWidth,
+                                    settings.imageHeight, samplesPerPixel,
+                                    settings.maxDepth,
+                                    static_cast<float>(settings.imageWidth) /
+                                    settings.imageHeight,
+                                    settings.verticalFOV,
+                                    settings.defocusAngle,
+                                    settings.focusDistance,
+                                    settings.lookFrom, settings.lookAt,
+                                    settings.upVector));
+
+        job.camera->setThreadPool(&m_pool);
+        job.camera->setTileSize(m_settings.tileSize);
+        job.camera->setSampler(static_cast<SamplerType>(request.sampler));
+        job.camera->setIntegrator(
+            static_cast<IntegratorType>(request.integrator));
+
+        job.samplesPerPass = request.samplesPerPass > 0 ?
+                             request.samplesPerPass :
+                             m_settings.samplesPerPass;
+
+        return true;
+    }
+
+    bool RenderServer::sendPass(ServerJob& job, bool complete)
+    {
+        JobProgress progress;
+        progress.job = job.id;
+        progress.imageWidth = job.framebuffer.width();
+        progress.imageHeight = job.framebuffer.height();
+        progress.samples = job.samples;
+        progress.samplesPerPixel = job.camera->samplesPerPixel();
+
+        std::lock_guard<std::mutex> lock(job.client->sendMutex);
+        Socket& socket = job.client->socket;
+
+        return sendHeader(socket, complete ? ServerMessage::Complete :
+                                             ServerMessage::Progress,
+                          sizeof(progress) +
+                          pixelDataSize(job.framebuffer.pixelCount())) &&
+               socket.send(&progress, sizeof(progress)) &&
+               sendPixels(socket, job.framebuffer);
+    }
+
+    void RenderServer::removeJob(uint32_t id)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_jobs.erase(id);
+    }
+
+    void RenderServer::stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            m_stopping = true;
+        }
+
+        m_jobAdded.notify_all();
+    }
+
+    void RenderServer::schedule()
+    {
+        while (std::shared_ptr<ServerJob> job = nextJob())
+        {
+            if (!job->camera && !startJob(*job))
+            {
+                removeJob(job->id);
+                continue;
+            }
+
+            int samplesPerPixel = job->camera->samplesPerPixel();
+            int passSamples = std::min(job->samplesPerPass,
+                                       samplesPerPixel - job->samples);
+
+            job->camera->renderPass(job->scene->scene, job->framebuffer,
+                                    passSamples);
+            job->samples += passSamples;
+
+            bool complete = job->samples >= samplesPerPixel;
+
+            if (!sendPass(*job, complete))
+            {
+                job->client->open = false;
+            }
+
+            if (complete)
+            {
+                std::clog << "\rJob " << job->id << " done ("
+                          << job->framebuffer.width() << 'x'
+                          << job->framebuffer.height() << ", "
+                          << samplesPerPixel << " spp).          \n";
+
+                removeJob(job->id);
+            }
+        }
+    }
+}
+
+bool runRenderServer(const ServerSettings& settings)
+{
+    Socket listener;
+
+    if (!listener.listen(settings.address))
+    {
+        return false;
+    }
+
+    RenderServer server(settings);
+    std::thread scheduler([&server] { server.schedule(); });
+    std::list<ClientReader> clients;
+
+    std::clog << "Serving render jobs at " << settings.address << ".\n";
+
+    while (!settings.stop || !*settings.stop)
+    {
+        // Join the readers of clients that disconnected.
+        for (auto client = clients.begin(); client != clients.end();)
+        {
+            if (client->connection->finished)
+            {
+                client->thread.join();
+                client = clients.erase(client);
+            }
+            else
+            {
+                ++client;
+            }
+        }
+
+        Socket socket;
+        bool failed;
+
+        if (!listener.accept(socket, ACCEPT_POLL_MILLISECONDS, &failed))
+        {
+            if (failed)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(
+                                            ACCEPT_RETRY_MILLISECONDS));
+            }
+
+            continue;
+        }
+
+        if (clients.size() >= static_cast<size_t>(
+                                  std::max(settings.maxClients, 1)))
+        {
+            std::cerr << "Refused a client: " << clients.size()
+                      << " clients are connected.\n";
+            continue;
+        }
+
+        auto connection = std::make_shared<Connection>(std::move(socket));
+        std::thread reader([&server, connection]
+                           {
+                               server.serveClient(connection);
+                               connection->finished = true;
+                           });
+
+        clients.push_back(ClientReader{connection, std::move(reader)});
+    }
+
+    // Wake the readers blocked on their clients and let the scheduler end
+    // its pass.
+    server.stop();
+
+    for (ClientReader& client : clients)
+    {
+        client.connection->socket.shutdown();
+        client.thread.join();
+    }
+
+    scheduler.join();
+
+    std::clog << "Stopped serving render jobs.\n";
+
+    return true;
+}
+
+bool requestRender(const std::string& address, const std::string& scenePath,
+                   const RenderRequest& request, Framebuffer& framebuffer,
+                   const PassCallback& onPass)
+{
+    Socket socket;
+    uint32_t job;
+
+    if (!socket.connect(address))
+    {
+        std::cerr << "Cannot reach a render server at " << address << ".\n";
+        return false;
+    }
+
+    if (scenePath.empty() || scenePath.size() > MAX_SCENE_PATH)
+    {
+        std::cerr << "The render server needs the path of a scene file.\n";
+        return false;
+    }
+
+    if (!sendMessage(socket, ServerMessage::Hello, &SERVER_PROTOCOL_VERSION,
+                     sizeof(SERVER_PROTOCOL_VERSION)) ||
+        !sendHeader(socket, ServerMessage::Submit,
+                    sizeof(request) + scenePath.size()) ||
+        !socket.send(&request, sizeof(request)) ||
+        !socket.send(scenePath.data(), scenePath.size()) ||
+        !receiveHeader(socket, ServerMessage::Accepted, sizeof(job)) ||
+        !socket.receive(&job, sizeof(job)))
+    {
+        std::cerr << "The render server at " << address
+                  << " did not accept the job.\n";
+        return false;
+    }
+
+    while (true)
+    {
+        MessageHeader header;
+        JobProgress progress;
+
+        if (!socket.receive(&header, sizeof(header)))
+        {
+            break;
+        }
+
+        if (header.type == static_cast<uint32_t>(ServerMessage::Failed) &&
+            header.size >= sizeof(job))
+        {
+            std::string message(header.size, '\0');
+
+            if (socket.receive(&message[0], message.size()))
+            {
+                std::cerr << "The render server failed the job: "
+                          << message.substr(sizeof(job)) << ".\n";
+            }
+
+            return false;
+        }
+
+        bool complete = header.type ==
+                        static_cast<uint32_t>(ServerMessage::Complete);
+
+        if ((!complete &&
+             header.type != static_cast<uint32_t>(ServerMessage::Progress)) ||
+            header.size < sizeof(progress) ||
+            !socket.receive(&progress, sizeof(progress)) ||
+            progress.job != job || progress.imageWidth <= 0 ||
+            progress.imageHeight <= 0)
+        {
+            break;
+        }
+
+        if (framebuffer.width() != progress.imageWidth ||
+            framebuffer.height() != progress.imageHeight)
+        {
+            framebuffer = Framebuffer(progress.imageWidth,
+                                      progress.imageHeight);
+        }
+
+        if (header.size != sizeof(progress) +
+                           pixelDataSize(framebuffer.pixelCount()) ||
+            !receivePixels(socket, framebuffer))
+        {
+            break;
+        }
+
+        if (onPass)
+        {
+            onPass(framebuffer, progress.samples);
+        }
+
+        if (complete)
+        {
+            return true;
+        }
+    }
+
+    std::cerr << "Lost the connection to the render server.\n";
+
+    return false;
+}
@@ -0,0 +1,146 @@
+/*
+ * This file implements a long-lived render server and its client. The server
+ * keeps recently used scenes and their BVHs in memory, keyed by a hash of
+ * the scene file contents (and the animation frame), so a job on a cached
+ * scene starts rendering right away instead of parsing and building it
+ * again. All jobs render on one shared pool of threads.
+ *
+ * Each client is served by a reader thread of its own, up to a limit of
+ * connected clients beyond which new connections are closed right away.
+ *
+ * Jobs are rendered progressively, one pass at a time. Before every pass
+ * the server picks the job of highest priority, the oldest among equals, so
+ * a job of higher priority preempts the running one at the end of its
+ * current pass. Every pass is streamed back to the client. Jobs are
+ * cancelled by a Cancel message or when their client disconnects.
+ *
+ * Messages (framed as described in messages.h):
+ *   client -> server  Hello     (uint32_t protocol version)
+ *   client -> server  Submit    (RenderRequest, char scenePath[])
+ *   server -> client  Accepted  (uint32_t job)
+ *   server -> client  Progress  (JobProgress, pixels) after every pass
+ *   server -> client  Complete  (JobProgress, pixels) after the last pass
+ *   server -> client  Failed    (uint32_t job, char message[])
+ *   client -> server  Cancel    (uint32_t job)
+ *
+ * Scene paths are relative to the scene root of the server; absolute paths
+ * and paths with a ".." component are refused. Requests for more pixels or
+ * samples than the server allows, or with an unknown sampler or
+ * integrator, fail right after they are accepted. Only the scene file is hashed, so edits to
+ * the OBJ files a cached scene references go unnoticed until the scene
+ * leaves the cache.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "framebuffer.h"
+#include "progressiveRenderer.h"
+
+// A render job as submitted to the server.
+struct RenderRequest
+{
+    // Image size; 0 takes the size of the scene, and a single 0 keeps the
+    // aspect ratio of the scene.
+    int32_t imageWidth = 0;
+    int32_t imageHeight = 0;
+
+    // Samples per pixel (0 takes those of the scene) and per pass (0 takes
+    // the server's default).
+    int32_t samplesPerPixel = 0;
+    int32_t samplesPerPass = 0;
+
+    // Jobs of higher priority render first.
+    int32_t priority = 0;
+
+    // Frame of an animated scene.
+    int32_t frame = 0;
+
+    int32_t sampler = 0;
+    int32_t integrator = 0;
+
+    // Replaces the camera position and target of the scene if non-zero.
+    int32_t overrideView = 0;
+    float lookFrom[3] = {0.0f, 0.0f, 0.0f};
+    float lookAt[3] = {0.0f, 0.0f, 0.0f};
+};
+
+// State of a job sent with every streamed pass.
+struct JobProgress
+{
+    uint32_t job;
+    int32_t imageWidth;
+    int32_t imageHeight;
+
+    // Samples every pixel holds so far, and will hold when done.
+    int32_t samples;
+    int32_t samplesPerPixel;
+};
+
+// Scenes kept in memory by default.
+const size_t DEFAULT_SCENE_CACHE_SIZE = 8;
+
+// Samples per pass of jobs that do not choose their own. Small passes keep
+// preemption quick at a small cost in overhead per pass.
+const int DEFAULT_SERVER_PASS_SAMPLES = 8;
+
+// Largest image a job may ask for by default (8192x8192 pixels).
+const uint64_t DEFAULT_SERVER_MAX_PIXELS = 1ull << 26;
+
+// Most samples per pixel of a job by default.
+const int DEFAULT_SERVER_MAX_SAMPLES = 4096;
+
+// Clients connected at once by default.
+const int DEFAULT_SERVER_MAX_CLIENTS = 64;
+
+struct ServerSettings
+{
+    // Address to listen at (see socket.h).
+    std::string address;
+
+    // Directory the scene paths of jobs are relative to (empty selects the
+    // working directory). Symbolic links inside it are followed.
+    std::string sceneRoot;
+
+    // Most pixels of a job's image.
+    uint64_t maxPixels = DEFAULT_SERVER_MAX_PIXELS;
+
+    // Most samples per pixel of a job, which bounds how long a job of high
+    // priority keeps the others waiting.
+    int maxSamplesPerPixel = DEFAULT_SERVER_MAX_SAMPLES;
+
+    // Most clients connected at once.
+    int maxClients = DEFAULT_SERVER_MAX_CLIENTS;
+
+    // Once set, the server stops accepting clients, disconnects those
+    // connected, finishes the current pass and returns. May be null.
+    const std::atomic<bool>* stop = nullptr;
+
+    // Render threads (0 selects the hardware concurrency).
+    int threadCount = 0;
+
+    // Edge length of the render tiles in pixels.
+    int tileSize = 32;
+
+    // Most scenes kept in memory.
+    size_t sceneCacheSize = DEFAULT_SCENE_CACHE_SIZE;
+
+    int samplesPerPass = DEFAULT_SERVER_PASS_SAMPLES;
+};
+
+// Serves render jobs at settings.address until settings.stop is set.
+// Returns false if the address cannot be used.
+bool runRenderServer(const ServerSettings& settings);
+
+// Submits a job for the scene at scenePath (relative to the scene root of
+// the server) to the server at address and receives its passes into
+// framebuffer, calling onPass after each. Returns false and reports the
+// error if the server cannot be reached, the job fails or the connection
+// breaks.
+bool requestRender(const std::string& address, const std::string& scenePath,
+                   const RenderRequest& request, Framebuffer& framebuffer,
+                   const PassCallback& onPass = PassCallback());
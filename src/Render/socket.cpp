@@ -0,0 +1,511 @@
+#include "socket.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    const char* UNIX_PREFIX = "unix:";
+
+    // Connections waiting to be accepted by a listening socket.
+    const int LISTEN_BACKLOG = 64;
+
+#ifdef _WIN32
+    using NativeSocket = SOCKET;
+
+    // Starts Winsock once for the lifetime of the process.
+    bool initializeSockets()
+    {
+        static const bool initialized = []
+        {
+            WSADATA data;
+
+            return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+        }();
+
+        return initialized;
+    }
+
+    void closeNative(NativeSocket handle)
+    {
+        closesocket(handle);
+    }
+
+    int pollSockets(pollfd* sockets, int count, int timeoutMilliseconds)
+    {
+        return WSAPoll(sockets, count, timeoutMilliseconds);
+    }
+#else
+    using NativeSocket = int;
+
+    bool initializeSockets()
+    {
+        return true;
+    }
+
+    void closeNative(NativeSocket handle)
+    {
+        ::close(handle);
+    }
+
+    int pollSockets(pollfd* sockets, int count, int timeoutMilliseconds)
+    {
+        return poll(sockets, count, timeoutMilliseconds);
+    }
+#endif
+
+    // Splits "host:port" (or "[host]:port"). Returns false if there is no
+    // port.
+    bool splitHostPort(const std::string& address, std::string& host,
+                       std::string& port)
+    {
+        size_t colon = address.find_last_of(':');
+
+        if (colon == std::string::npos || colon + 1 == address.size())
+        {
+            return false;
+        }
+
+        host = address.substr(0, colon);
+        port = address.substr(colon + 1);
+
+        if (host.size() >= 2 && host.front() == '[' && host.back() == ']')
+        {
+            host = host.substr(1, host.size() - 2);
+        }
+
+        return true;
+    }
+
+    bool isUnixAddress(const std::string& address)
+    {
+        return address.compare(0, std::strlen(UNIX_PREFIX), UNIX_PREFIX) == 0;
+    }
+
+#ifndef _WIN32
+    // Fills in the address of a Unix domain socket. Returns false if the
+    // path does not fit.
+    bool unixAddress(const std::string& path, sockaddr_un& address)
+    {
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+
+        if (path.empty() || path.size() >= sizeof(address.sun_path))
+        {
+            return false;
+        }
+
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+        return true;
+    }
+#endif
+
+    // Resolves a TCP address; for listening sockets an empty host or "*"
+    // stands for every interface.
+    addrinfo* resolve(const std::string& address, bool passive)
+    {
+        std::string host;
+        std::string port;
+
+        if (!splitHostPort(address, host, port))
+        {
+            std::cerr << "Invalid address " << address
+                      << " (expected host:port or unix:path).\n";
+            return nullptr;
+        }
+
+        addrinfo hints;
+        std::memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = passive ? AI_PASSIVE : 0;
+
+        bool anyHost = host.empty() || host == "*";
+        addrinfo* result = nullptr;
+        int error = getaddrinfo(anyHost ? nullptr : host.c_str(),
+                                port.c_str(), &hints, &result);
+
+        if (error != 0)
+        {
+            std::cerr << "Cannot resolve " << address << ": "
+                      << gai_strerror(error) << '\n';
+            return nullptr;
+        }
+
+        return result;
+    }
+}
+
+Socket::~Socket()
+{
+    close();
+}
+
+Socket::Socket(Socket&& other) :
+               m_handle(other.m_handle),
+               m_unixPath(std::move(other.m_unixPath))
+{
+    other.m_handle = INVALID_HANDLE;
+    other.m_unixPath.clear();
+}
+
+Socket& Socket::operator=(Socket&& other)
+{
+    if (this != &other)
+    {
+        close();
+
+        m_handle = other.m_handle;
+        m_unixPath = std::move(other.m_unixPath);
+
+        other.m_handle = INVALID_HANDLE;
+        other.m_unixPath.clear();
+    }
+
+    return *this;
+}
+
+bool Socket::listen(const std::string& address)
+{
+    close();
+
+    if (!initializeSockets())
+    {
+        std::cerr << "Cannot initialize sockets.\n";
+        return false;
+    }
+
+    if (isUnixAddress(address))
+    {
+#ifdef _WIN32
+        std::cerr << "Unix domain sockets are not supported on Windows; "
+                     "use host:port.\n";
+        return false;
+#else
+        std::string path = address.substr(std::strlen(UNIX_PREFIX));
+        sockaddr_un local;
+
+        if (!unixAddress(path, local))
+        {
+            std::cerr << "Invalid Unix socket path " << path << ".\n";
+            return false;
+        }
+
+        // A socket left behind by an earlier run would block the bind.
+        unlink(path.c_str());
+
+        NativeSocket handle = socket(AF_UNIX, SOCK_STREAM, 0);
+
+        if (handle < 0 ||
+            bind(handle, reinterpret_cast<sockaddr*>(&local),
+                 sizeof(local)) != 0 ||
+            ::listen(handle, LISTEN_BACKLOG) != 0)
+        {
+            std::cerr << "Cannot listen at " << address << ": "
+                      << std::strerror(errno) << '\n';
+
+            if (handle >= 0)
+            {
+                closeNative(handle);
+            }
+
+            return false;
+        }
+
+        m_handle = handle;
+        m_unixPath = path;
+
+        return true;
+#endif
+    }
+
+    addrinfo* addresses = resolve(address, true);
+
+    if (!addresses)
+    {
+        return false;
+    }
+
+    for (addrinfo* info = addresses; info; info = info->ai_next)
+    {
+        NativeSocket handle = socket(info->ai_family, info->ai_socktype,
+                                     info->ai_protocol);
+
+        if (handle == static_cast<NativeSocket>(INVALID_HANDLE))
+        {
+            continue;
+        }
+
+        // Allow restarting a coordinator right away on the same port.
+        int reuse = 1;
+        setsockopt(handle, SOL_SOCKET, SO_REUSEADDR,
+                   reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+        if (bind(handle, info->ai_addr,
+                 static_cast<int>(info->ai_addrlen)) == 0 &&
+            ::listen(handle, LISTEN_BACKLOG) == 0)
+        {
+            m_handle = static_cast<intptr_t>(handle);
+            break;
+        }
+
+        closeNative(handle);
+    }
+
+    freeaddrinfo(addresses);
+
+    if (!isOpen())
+    {
+        std::cerr << "Cannot listen at " << address << ".\n";
+        return false;
+    }
+
+    return true;
+}
+
+bool Socket::connect(const std::string& address)
+{
+    close();
+
+    if (!initializeSockets())
+    {
+        std::cerr << "Cannot initialize sockets.\n";
+        return false;
+    }
+
+    if (isUnixAddress(address))
+    {
+#ifdef _WIN32
+        std::cerr << "Unix domain sockets are not supported on Windows; "
+                     "use host:port.\n";
+        return false;
+#else
+        std::string path = address.substr(std::strlen(UNIX_PREFIX));
+        sockaddr_un remote;
+
+        if (!unixAddress(path, remote))
+        {
+            std::cerr << "Invalid Unix socket path " << path << ".\n";
+            return false;
+        }
+
+        NativeSocket handle = socket(AF_UNIX, SOCK_STREAM, 0);
+
+        if (handle < 0)
+        {
+            return false;
+        }
+
+        if (::connect(handle, reinterpret_cast<sockaddr*>(&remote),
+                      sizeof(remote)) != 0)
+        {
+            closeNative(handle);
+            return false;
+        }
+
+        m_handle = handle;
+
+        return true;
+#endif
+    }
+
+    addrinfo* addresses = resolve(address, false);
+
+    if (!addresses)
+    {
+        return false;
+    }
+
+    for (addrinfo* info = addresses; info; info = info->ai_next)
+    {
+        NativeSocket handle = socket(info->ai_family, info->ai_socktype,
+                                     info->ai_protocol);
+
+        if (handle == static_cast<NativeSocket>(INVALID_HANDLE))
+        {
+            continue;
+        }
+
+        if (::connect(handle, info->ai_addr,
+                      static_cast<int>(info->ai_addrlen)) == 0)
+        {
+            // Messages are written whole, so there is nothing to coalesce.
+            int noDelay = 1;
+            setsockopt(handle, IPPROTO_TCP, TCP_NODELAY,
+                       reinterpret_cast<const char*>(&noDelay),
+                       sizeof(noDelay));
+
+            m_handle = static_cast<intptr_t>(handle);
+            break;
+        }
+
+        closeNative(handle);
+    }
+
+    freeaddrinfo(addresses);
+
+    return isOpen();
+}
+
+bool Socket::accept(Socket& client, int timeoutMilliseconds, bool* failed)
+{
+    client.close();
+
+    if (failed)
+    {
+        *failed = false;
+    }
+
+    pollfd listener;
+    listener.fd = static_cast<NativeSocket>(m_handle);
+    listener.events = POLLIN;
+    listener.revents = 0;
+
+    if (pollSockets(&listener, 1, timeoutMilliseconds) <= 0)
+    {
+        return false;
+    }
+
+    NativeSocket handle = ::accept(static_cast<NativeSocket>(m_handle),
+                                   nullptr, nullptr);
+
+    if (handle == static_cast<NativeSocket>(INVALID_HANDLE))
+    {
+#ifdef _WIN32
+        std::cerr << "Cannot accept a connection (error "
+                  << WSAGetLastError() << ").\n";
+#else
+        std::cerr << "Cannot accept a connection: " << std::strerror(errno)
+                  << '\n';
+#endif
+
+        if (failed)
+        {
+            *failed = true;
+        }
+
+        return false;
+    }
+
+    client.m_handle = static_cast<intptr_t>(handle);
+
+    return true;
+}
+
+bool Socket::setReceiveTimeout(double seconds)
+{
+#ifdef _WIN32
+    DWORD timeout = static_cast<DWORD>(seconds * 1000.0);
+#else
+    timeval timeout;
+    timeout.tv_sec = static_cast<time_t>(seconds);
+    timeout.tv_usec = static_cast<suseconds_t>(
+                      (seconds - static_cast<double>(timeout.tv_sec)) * 1e6);
+#endif
+
+    return setsockopt(static_cast<NativeSocket>(m_handle), SOL_SOCKET,
+                      SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout),
+                      sizeof(timeout)) == 0;
+}
+
+bool Socket::send(const void* data, size_t size)
+{
+    const char* bytes = static_cast<const char*>(data);
+
+    // A peer that died must fail the call, not raise SIGPIPE.
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL;
+#else
+    const int flags = 0;
+#endif
+
+    while (size > 0)
+    {
+        int chunk = static_cast<int>(size < (1u << 30) ? size : (1u << 30));
+        auto sent = ::send(static_cast<NativeSocket>(m_handle), bytes, chunk,
+                           flags);
+
+        if (sent <= 0)
+        {
+            return false;
+        }
+
+        bytes += sent;
+        size -= static_cast<size_t>(sent);
+    }
+
+    return true;
+}
+
+bool Socket::receive(void* data, size_t size)
+{
+    char* bytes = static_cast<char*>(data);
+
+    while (size > 0)
+    {
+        int chunk = static_cast<int>(size < (1u << 30) ? size : (1u << 30));
+        auto received = recv(static_cast<NativeSocket>(m_handle), bytes,
+                             chunk, 0);
+
+        if (received <= 0)
+        {
+            return false;
+        }
+
+        bytes += received;
+        size -= static_cast<size_t>(received);
+    }
+
+    return true;
+}
+
+void Socket::shutdown()
+{
+    if (isOpen())
+    {
+#ifdef _WIN32
+        ::shutdown(static_cast<NativeSocket>(m_handle), SD_BOTH);
+#else
+        ::shutdown(static_cast<NativeSocket>(m_handle), SHUT_RDWR);
+#endif
+    }
+}
+
+void Socket::close()
+{
+    if (isOpen())
+    {
+        closeNative(static_cast<NativeSocket>(m_handle));
+        m_handle = INVALID_HANDLE;
+    }
+
+#ifndef _WIN32
+    if (!m_unixPath.empty())
+    {
+        unlink(m_unixPath.c_str());
+    }
+#endif
+
+    m_unixPath.clear();
+}
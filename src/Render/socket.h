@@ -0,0 +1,77 @@
+/*
+ * This class wraps a blocking stream socket, either TCP or a Unix domain
+ * socket, for the coordinator and workers of a distributed render and for
+ * the render server and its clients.
+ *
+ * Addresses are written as "host:port" for TCP (an empty host or "*" listens
+ * on every interface; IPv6 hosts go in brackets, "[::1]:7000") or as
+ * "unix:PATH" for a Unix domain socket, which lets several processes on one
+ * machine render together without opening a port.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class Socket
+{
+public:
+    // Default constructor (not connected).
+    Socket() {}
+
+    ~Socket();
+
+    Socket(const Socket&) = delete;
+    Socket& operator=(const Socket&) = delete;
+
+    Socket(Socket&& other);
+    Socket& operator=(Socket&& other);
+
+    // Listens for connections at address. Returns false and reports the
+    // error if the address is invalid or cannot be bound.
+    bool listen(const std::string& address);
+
+    // Connects to a listening socket at address. Returns false and reports
+    // the error if the address is invalid; a refused connection fails
+    // without a report, so callers may retry.
+    bool connect(const std::string& address);
+
+    // Waits up to timeoutMilliseconds for a connection on a listening
+    // socket. Returns false if none arrived (client is left closed); if one
+    // arrived but could not be accepted (e.g. out of file descriptors), the
+    // error is reported and failed, if given, is set.
+    bool accept(Socket& client, int timeoutMilliseconds,
+                bool* failed = nullptr);
+
+    // Makes receive() fail once no data arrived for the given number of
+    // seconds (0 waits forever).
+    bool setReceiveTimeout(double seconds);
+
+    // Sends or receives exactly size bytes. Both fail once the connection
+    // is closed, broken or (for receive) timed out.
+    bool send(const void* data, size_t size);
+    bool receive(void* data, size_t size);
+
+    bool isOpen() const { return m_handle != INVALID_HANDLE; }
+
+    // Ends the connection in both directions, which makes calls blocked in
+    // send or receive on other threads fail. The socket stays open until
+    // close().
+    void shutdown();
+
+    // Closes the connection (and removes the path of a listening Unix
+    // domain socket).
+    void close();
+
+private:
+    // Native socket handle (a SOCKET on Windows, a file descriptor
+    // elsewhere).
+    static const intptr_t INVALID_HANDLE = -1;
+
+    intptr_t m_handle = INVALID_HANDLE;
+
+    // Path of a listening Unix domain socket, removed on close.
+    std::string m_unixPath;
+};
@@ -0,0 +1,189 @@
+#include "stats.h"
+
+#include <fstream>
+#include <iostream>
+#include <mutex>
+
+#include "../Materials/materialData.h"
+
+static_assert(STATS_MATERIAL_TYPE_COUNT == MATERIAL_TYPE_COUNT,
+              "RenderStats must count every material type");
+
+namespace
+{
+    const char* PHASE_NAMES[STATS_PHASE_COUNT] = {
+        "scene_build", "scene_refit", "render", "extend", "shade"
+    };
+
+    const char* MATERIAL_NAMES[STATS_MATERIAL_TYPE_COUNT] = {
+        "diffuse", "metal", "glass", "emissive"
+    };
+
+    std::mutex& totalsMutex()
+    {
+        static std::mutex mutex;
+
+        return mutex;
+    }
+
+    RenderStats& totals()
+    {
+        static RenderStats stats;
+
+        return stats;
+    }
+
+    double ratio(double numerator, double denominator)
+    {
+        return denominator > 0.0 ? numerator / denominator : 0.0;
+    }
+}
+
+void RenderStats::merge(const RenderStats& other)
+{
+    primaryRays += other.primaryRays;
+    secondaryRays += other.secondaryRays;
+    shadowRays += other.shadowRays;
+    primitiveTests += other.primitiveTests;
+    nodesVisited += other.nodesVisited;
+
+    for (int i = 0; i <= STATS_MAX_PATH_LENGTH; ++i)
+    {
+        pathLengths[i] += other.pathLengths[i];
+    }
+
+    for (int i = 0; i < STATS_MATERIAL_TYPE_COUNT; ++i)
+    {
+        scatterCalls[i] += other.scatterCalls[i];
+    }
+
+    escapedPaths += other.escapedPaths;
+    absorbedPaths += other.absorbedPaths;
+    rouletteTerminatedPaths += other.rouletteTerminatedPaths;
+
+    for (int i = 0; i < STATS_PHASE_COUNT; ++i)
+    {
+        phaseSeconds[i] += other.phaseSeconds[i];
+        phaseRays[i] += other.phaseRays[i];
+    }
+}
+
+void flushThreadStats()
+{
+    RenderStats& stats = threadStats();
+
+    {
+        std::lock_guard<std::mutex> lock(totalsMutex());
+        totals().merge(stats);
+    }
+
+    stats = RenderStats();
+}
+
+RenderStats collectStats()
+{
+    flushThreadStats();
+
+    std::lock_guard<std::mutex> lock(totalsMutex());
+
+    return totals();
+}
+
+void resetStats()
+{
+    threadStats() = RenderStats();
+
+    std::lock_guard<std::mutex> lock(totalsMutex());
+    totals() = RenderStats();
+}
+
+bool writeStatsReport(const RenderStats& stats, const std::string& path)
+{
+    std::ofstream out(path);
+
+    if (!out)
+    {
+        std::cerr << "Could not open " << path << " for writing.\n";
+
+        return false;
+    }
+
+    double rays = static_cast<double>(stats.rays());
+    uint64_t paths = stats.paths();
+
+    // The histogram is trimmed after the longest path seen.
+    int longestPath = 0;
+
+    for (int i = 0; i <= STATS_MAX_PATH_LENGTH; ++i)
+    {
+        if (stats.pathLengths[i] > 0)
+        {
+            longestPath = i;
+        }
+    }
+
+    out << "{\n";
+    out << "  \"rays\": {\"primary\": " << stats.primaryRays
+        << ", \"secondary\": " << stats.secondaryRays
+        << ", \"shadow\": " << stats.shadowRays
+        << ", \"total\": " << stats.rays() << "},\n";
+    out << "  \"primitive_tests\": " << stats.primitiveTests << ",\n";
+    out << "  \"primitive_tests_per_ray\": "
+        << ratio(static_cast<double>(stats.primitiveTests), rays) << ",\n";
+    out << "  \"nodes_visited\": " << stats.nodesVisited << ",\n";
+    out << "  \"nodes_visited_per_ray\": "
+        << ratio(static_cast<double>(stats.nodesVisited), rays) << ",\n";
+    out << "  \"paths\": {\"total\": " << paths
+        << ", \"escaped\": " << stats.escapedPaths
+        << ", \"absorbed\": " << stats.absorbedPaths
+        << ", \"roulette_terminated\": " << stats.rouletteTerminatedPaths
+        << ", \"max_depth\": " << stats.maxDepthPaths()
+        << ", \"average_length\": "
+        << ratio(static_cast<double>(stats.primaryRays + stats.secondaryRays),
+                 static_cast<double>(paths))
+        << "},\n";
+
+    // Entry i counts the paths that traced i rays; the last entry also
+    // holds every longer path.
+    out << "  \"path_length_histogram\": [";
+
+    for (int i = 0; i <= longestPath; ++i)
+    {
+        out << (i > 0 ? ", " : "") << stats.pathLengths[i];
+    }
+
+    out << "],\n";
+    out << "  \"scatter_calls\": {";
+
+    for (int i = 0; i < STATS_MATERIAL_TYPE_COUNT; ++i)
+    {
+        out << (i > 0 ? ", " : "") << '"' << MATERIAL_NAMES[i] << "\": "
+            << stats.scatterCalls[i];
+    }
+
+    out << "},\n";
+    out << "  \"phases\": {";
+
+    for (int i = 0; i < STATS_PHASE_COUNT; ++i)
+    {
+        double seconds = stats.phaseSeconds[i];
+        double phaseRays = static_cast<double>(stats.phaseRays[i]);
+
+        out << (i > 0 ? "," : "") << "\n    \"" << PHASE_NAMES[i]
+            << "\": {\"seconds\": " << seconds
+            << ", \"rays\": " << stats.phaseRays[i]
+            << ", \"mrays_per_second\": "
+            << ratio(phaseRays, seconds) / 1e6 << '}';
+    }
+
+    out << "\n  }\n}\n";
+
+    if (!out.flush())
+    {
+        std::cerr << "Could not write " << path << ".\n";
+
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,154 @@
+/*
+ * This file provides render statistics: ray counts, intersection work, path
+ * lengths, material usage and the time spent in each render phase. Every
+ * thread counts into its own RenderStats without synchronization; the
+ * counters are merged into a global total after each tile.
+ *
+ * Statistics are only collected when RAYTRACER_STATS is defined. Otherwise
+ * the RT_STATS_* macros expand to nothing and cost nothing.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Longest path length with its own histogram bucket. Longer paths share the
+// last bucket.
+const int STATS_MAX_PATH_LENGTH = 64;
+
+enum class StatsPhase
+{
+    // Building the acceleration structures.
+    SceneBuild,
+
+    // Refitting them to moved geometry.
+    SceneRefit,
+
+    // Rendering a frame or pass (wall time).
+    Render,
+
+    // Wavefront intersection stage (summed over threads).
+    Extend,
+
+    // Wavefront shading stage (summed over threads).
+    Shade
+};
+
+// Returns the histogram bucket of a path that traced length rays.
+inline int pathLengthBucket(int length)
+{
+    return length < STATS_MAX_PATH_LENGTH ? length : STATS_MAX_PATH_LENGTH;
+}
+
+// Number of StatsPhase values.
+const int STATS_PHASE_COUNT = 5;
+
+// Number of material types counted, equal to MATERIAL_TYPE_COUNT (checked
+// in stats.cpp). Kept here so the geometry code that counts its work does
+// not depend on the materials.
+const int STATS_MATERIAL_TYPE_COUNT = 4;
+
+struct RenderStats
+{
+    // Camera rays, rays spawned by scattering and rays towards sampled
+    // lights.
+    uint64_t primaryRays = 0;
+    uint64_t secondaryRays = 0;
+    uint64_t shadowRays = 0;
+
+    // Ray/primitive intersection tests.
+    uint64_t primitiveTests = 0;
+
+    // Acceleration structure nodes visited.
+    uint64_t nodesVisited = 0;
+
+    // Number of paths by the number of rays they traced.
+    uint64_t pathLengths[STATS_MAX_PATH_LENGTH + 1] = {};
+
+    // Scatter calls by material type.
+    uint64_t scatterCalls[STATS_MATERIAL_TYPE_COUNT] = {};
+
+    // How paths ended: left the scene, absorbed by a material or terminated
+    // by Russian roulette. Every other path was cut off at the maximum depth.
+    uint64_t escapedPaths = 0;
+    uint64_t absorbedPaths = 0;
+    uint64_t rouletteTerminatedPaths = 0;
+
+    // Time spent and rays traced in each phase.
+    double phaseSeconds[STATS_PHASE_COUNT] = {};
+    uint64_t phaseRays[STATS_PHASE_COUNT] = {};
+
+    // Adds the counters of other to these.
+    void merge(const RenderStats& other);
+
+    uint64_t rays() const
+    {
+        return primaryRays + secondaryRays + shadowRays;
+    }
+
+    // Every path starts with one primary ray.
+    uint64_t paths() const { return primaryRays; }
+
+    uint64_t maxDepthPaths() const
+    {
+        return paths() - escapedPaths - absorbedPaths -
+               rouletteTerminatedPaths;
+    }
+};
+
+// Returns the counters of the calling thread. Defined inline so that the
+// counters in hot loops are a thread-local access, not a call.
+inline RenderStats& threadStats()
+{
+    thread_local RenderStats stats;
+
+    return stats;
+}
+
+// Adds the counters of the calling thread to the global totals and resets
+// them.
+void flushThreadStats();
+
+// Flushes the calling thread and returns the global totals.
+RenderStats collectStats();
+
+// Resets the global totals and the counters of the calling thread.
+void resetStats();
+
+// Writes the statistics as a JSON document. Returns false on failure.
+bool writeStatsReport(const RenderStats& stats, const std::string& path);
+
+// Adds the lifetime of the object to a phase of the thread's statistics.
+class ScopedStatsTimer
+{
+public:
+    explicit ScopedStatsTimer(StatsPhase phase) :
+                              m_phase(phase),
+                              m_start(std::chrono::steady_clock::now()) {}
+
+    ~ScopedStatsTimer()
+    {
+        threadStats().phaseSeconds[static_cast<int>(m_phase)] +=
+            std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                          m_start).count();
+    }
+
+    ScopedStatsTimer(const ScopedStatsTimer&) = delete;
+    ScopedStatsTimer& operator=(const ScopedStatsTimer&) = delete;
+
+private:
+    StatsPhase m_phase;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+#ifdef RAYTRACER_STATS
+#define RT_STATS_ADD(counter, value) (threadStats().counter += (value))
+#define RT_STATS_TIMER(name, phase) ScopedStatsTimer name(phase)
+#define RT_STATS_FLUSH() flushThreadStats()
+#else
+#define RT_STATS_ADD(counter, value) ((void)0)
+#define RT_STATS_TIMER(name, phase) ((void)0)
+#define RT_STATS_FLUSH() ((void)0)
+#endif
@@ -0,0 +1,153 @@
+#include "threadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(int threadCount)
+{
+    if (threadCount <= 0)
+    {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (int i = 0; i < threadCount; ++i)
+    {
+        m_queues.push_back(std::make_unique<WorkQueue>());
+    }
+
+    for (int i = 0; i < threadCount; ++i)
+    {
+        m_threads.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+
+    m_wakeWorkers.notify_all();
+
+    for (std::thread& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+void ThreadPool::parallelFor(uint32_t taskCount,
+                             const std::function<void(uint32_t, int)>& task)
+{
+    if (taskCount == 0)
+    {
+        return;
+    }
+
+    // Deal the tasks out in contiguous chunks.
+    uint32_t workerCount = static_cast<uint32_t>(m_queues.size());
+    uint32_t chunkSize = (taskCount + workerCount - 1) / workerCount;
+
+    for (uint32_t w = 0; w < workerCount; ++w)
+    {
+        std::lock_guard<std::mutex> lock(m_queues[w]->mutex);
+
+        uint32_t begin = std::min(taskCount, w * chunkSize);
+        uint32_t end = std::min(taskCount, begin + chunkSize);
+
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            m_queues[w]->tasks.push_back(i);
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    m_task = &task;
+    m_activeWorkers = static_cast<int>(workerCount);
+    ++m_generation;
+
+    m_wakeWorkers.notify_all();
+    m_batchDone.wait(lock, [this] { return m_activeWorkers == 0; });
+
+    m_task = nullptr;
+}
+
+void ThreadPool::workerLoop(int workerIndex)
+{
+    uint64_t seenGeneration = 0;
+
+    while (true)
+    {
+        const std::function<void(uint32_t, int)>* task;
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            m_wakeWorkers.wait(lock, [&]
+            {
+                return m_stopping || m_generation != seenGeneration;
+            });
+
+            if (m_stopping)
+            {
+                return;
+            }
+
+            seenGeneration = m_generation;
+            task = m_task;
+        }
+
+        uint32_t index;
+
+        while (nextTask(workerIndex, index))
+        {
+            (*task)(index, workerIndex);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            if (--m_activeWorkers == 0)
+            {
+                m_batchDone.notify_one();
+            }
+        }
+    }
+}
+
+bool ThreadPool::nextTask(int workerIndex, uint32_t& task)
+{
+    // Take work from the front of our own queue first.
+    {
+        WorkQueue& own = *m_queues[workerIndex];
+        std::lock_guard<std::mutex> lock(own.mutex);
+
+        if (!own.tasks.empty())
+        {
+            task = own.tasks.front();
+            own.tasks.pop_front();
+
+            return true;
+        }
+    }
+
+    // Otherwise steal from the back of the other workers' queues, which is
+    // the work their owners would reach last.
+    int workerCount = static_cast<int>(m_queues.size());
+
+    for (int offset = 1; offset < workerCount; ++offset)
+    {
+        WorkQueue& victim = *m_queues[(workerIndex + offset) % workerCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+
+        if (!victim.tasks.empty())
+        {
+            task = victim.tasks.back();
+            victim.tasks.pop_back();
+
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,72 @@
+/*
+ * This class provides a fixed set of worker threads that execute batches of
+ * indexed tasks. Every worker owns a queue of task indices; once its own
+ * queue runs dry it steals from the back of the other workers' queues, so
+ * uneven tasks (e.g. tiles covering glass versus sky) keep every core busy.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+public:
+    // Spawns threadCount workers (0 selects the hardware concurrency).
+    explicit ThreadPool(int threadCount = 0);
+
+    // Joins all worker threads.
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int threadCount() const { return static_cast<int>(m_threads.size()); }
+
+    // Runs task(index, workerIndex) for every index in [0, taskCount) and
+    // blocks until all of them have finished. Tasks are dealt to the workers
+    // in contiguous chunks, so neighbouring indices tend to run on the same
+    // thread.
+    void parallelFor(uint32_t taskCount,
+                     const std::function<void(uint32_t, int)>& task);
+
+private:
+    // Per-worker task queue, padded to its own cache line.
+    struct alignas(64) WorkQueue
+    {
+        std::mutex mutex;
+        std::deque<uint32_t> tasks;
+    };
+
+    // Main loop of every worker thread.
+    void workerLoop(int workerIndex);
+
+    // Pops a task from the worker's own queue, or steals one from another
+    // worker. Returns false once every queue is empty.
+    bool nextTask(int workerIndex, uint32_t& task);
+
+    std::vector<std::thread> m_threads;
+    std::vector<std::unique_ptr<WorkQueue>> m_queues;
+
+    // Batch currently being executed.
+    const std::function<void(uint32_t, int)>* m_task = nullptr;
+
+    // Incremented for every batch so sleeping workers know to wake up.
+    uint64_t m_generation = 0;
+
+    // Number of workers still running the current batch.
+    int m_activeWorkers = 0;
+
+    bool m_stopping = false;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wakeWorkers;
+    std::condition_variable m_batchDone;
+};
@@ -0,0 +1,78 @@
+#include "tiles.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+    // Converts a distance along a Hilbert curve covering an n x n grid (n a
+    // power of two) into grid coordinates.
+    void hilbertToGrid(int n, int distance, int& x, int& y)
+    {
+        x = 0;
+        y = 0;
+
+        for (int s = 1; s < n; s *= 2)
+        {
+            int rx = 1 & (distance / 2);
+            int ry = 1 & (distance ^ rx);
+
+            // Rotate the quadrant.
+            if (ry == 0)
+            {
+                if (rx == 1)
+                {
+                    x = s - 1 - x;
+                    y = s - 1 - y;
+                }
+
+                std::swap(x, y);
+            }
+
+            x += s * rx;
+            y += s * ry;
+            distance /= 4;
+        }
+    }
+}
+
+std::vector<Tile> makeTiles(int imageWidth, int imageHeight, int tileSize)
+{
+    tileSize = std::max(1, tileSize);
+
+    int tilesX = (imageWidth + tileSize - 1) / tileSize;
+    int tilesY = (imageHeight + tileSize - 1) / tileSize;
+
+    // Smallest power-of-two grid enclosing every tile.
+    int n = 1;
+
+    while (n < tilesX || n < tilesY)
+    {
+        n *= 2;
+    }
+
+    std::vector<Tile> tiles;
+    tiles.reserve(static_cast<size_t>(tilesX) * tilesY);
+
+    for (int d = 0; d < n * n; ++d)
+    {
+        int tx, ty;
+        hilbertToGrid(n, d, tx, ty);
+
+        // Skip curve cells that fall outside of the image.
+        if (tx >= tilesX || ty >= tilesY)
+        {
+            continue;
+        }
+
+        Tile tile;
+        tile.x0 = tx * tileSize;
+        tile.y0 = ty * tileSize;
+        tile.x1 = std::min(tile.x0 + tileSize, imageWidth);
+        tile.y1 = std::min(tile.y0 + tileSize, imageHeight);
+
+        tiles.push_back(tile);
+    }
+
+    return tiles;
+}
@@ -0,0 +1,24 @@
+/*
+ * This file splits an image into rectangular tiles and orders them along a
+ * Hilbert curve, so that consecutive tiles are spatial neighbours and touch
+ * overlapping parts of the scene (and of the acceleration structure).
+ */
+
+#pragma once
+
+#include <vector>
+
+struct Tile
+{
+    // Top-left pixel (inclusive).
+    int x0, y0;
+
+    // Bottom-right pixel (exclusive).
+    int x1, y1;
+
+    int width() const { return x1 - x0; }
+    int height() const { return y1 - y0; }
+};
+
+// Returns the tiles covering a width x height image in Hilbert curve order.
+std::vector<Tile> makeTiles(int imageWidth, int imageHeight, int tileSize);
@@ -0,0 +1,238 @@
+#include "wavefrontIntegrator.h"
+
+#include <cmath>
+
+#include "../Hittables/hittable.h"
+#include "../Math/color.h"
+#include "../Math/interval.h"
+#include "../Math/utilities.h"
+#include "../Render/stats.h"
+
+bool parseIntegratorType(const std::string& name, IntegratorType& type)
+{
+    if (name == "path")
+    {
+        type = IntegratorType::Path;
+    }
+    else if (name == "wavefront")
+    {
+        type = IntegratorType::Wavefront;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+WavefrontIntegrator::WavefrontIntegrator(int maxDepth, int rouletteDepth,
+                                         bool sampleLights) :
+                                         m_maxDepth(maxDepth),
+                                         m_rouletteDepth(rouletteDepth),
+                                         m_sampleLights(sampleLights) {}
+
+void WavefrontIntegrator::addPath(const Ray& r, uint32_t pixelIndex,
+                                  uint32_t sampleIndex)
+{
+    m_origin.push_back(r.origin());
+    m_direction.push_back(r.direction());
+    m_time.push_back(r.time());
+    m_throughput.push_back(Color(1.0f, 1.0f, 1.0f));
+    m_rayPdf.push_back(0.0f);
+    m_pixelIndex.push_back(pixelIndex);
+    m_sampleIndex.push_back(sampleIndex);
+    m_color.push_back(Color(0.0f, 0.0f, 0.0f));
+}
+
+void WavefrontIntegrator::clear()
+{
+    m_origin.clear();
+    m_direction.clear();
+    m_time.clear();
+    m_throughput.clear();
+    m_rayPdf.clear();
+    m_pixelIndex.clear();
+    m_sampleIndex.clear();
+    m_color.clear();
+}
+
+const std::vector<Color>& WavefrontIntegrator::trace(const Scene& world,
+                                                     Sampler& sampler)
+{
+    size_t pathCount = m_pixelIndex.size();
+
+    m_hitPoint.resize(pathCount);
+    m_hitNormal.resize(pathCount);
+    m_frontFace.resize(pathCount);
+    m_material.resize(pathCount);
+
+    m_active.resize(pathCount);
+    m_raysTraced = 0;
+    m_lightsSampled = m_sampleLights && !world.lights().empty();
+
+    for (size_t i = 0; i < pathCount; ++i)
+    {
+        m_active[i] = static_cast<uint32_t>(i);
+    }
+
+    // Paths still active after the last bounce gather no more light.
+    for (int bounce = 0; bounce < m_maxDepth && !m_active.empty(); ++bounce)
+    {
+        extend(world, bounce);
+
+        m_nextActive.clear();
+
+        for (int type = 0; type < MATERIAL_TYPE_COUNT; ++type)
+        {
+            shade(world, static_cast<MaterialType>(type), sampler, bounce);
+        }
+
+        m_active.swap(m_nextActive);
+    }
+
+    RT_STATS_ADD(primaryRays, pathCount);
+    RT_STATS_ADD(secondaryRays, m_raysTraced - pathCount);
+
+    // Paths still active ran to the maximum depth.
+    RT_STATS_ADD(pathLengths[pathLengthBucket(m_maxDepth)], m_active.size());
+
+    return m_color;
+}
+
+void WavefrontIntegrator::extend(const Scene& world, int bounce)
+{
+    for (auto& queue : m_shadeQueues)
+    {
+        queue.clear();
+    }
+
+    RT_STATS_TIMER(timer, StatsPhase::Extend);
+    RT_STATS_ADD(phaseRays[static_cast<int>(StatsPhase::Extend)],
+                 m_active.size());
+
+    m_raysTraced += m_active.size();
+
+    for (uint32_t path : m_active)
+    {
+        Ray r(m_origin[path], m_direction[path], m_time[path]);
+        HitRecord rec;
+
+        if (!world.hit(r, Interval(0.001f, INF), rec))
+        {
+            m_color[path] += emissionWeight(r, m_rayPdf[path], world) *
+                             (m_throughput[path] * world.background(r));
+            RT_STATS_ADD(escapedPaths, 1);
+            RT_STATS_ADD(pathLengths[pathLengthBucket(bounce + 1)], 1);
+
+            continue;
+        }
+
+        if (rec.material->type == MaterialType::Emissive)
+        {
+            m_color[path] += emissionWeight(r, m_rayPdf[path], world, rec) *
+                             (m_throughput[path] *
+                              emitted(*rec.material, rec));
+        }
+
+        m_hitPoint[path] = rec.p;
+        m_hitNormal[path] = rec.normal;
+        m_frontFace[path] = rec.frontFace ? 1 : 0;
+        m_material[path] = rec.material;
+
+        m_shadeQueues[static_cast<int>(rec.material->type)].push_back(path);
+    }
+}
+
+void WavefrontIntegrator::shade(const Scene& world, MaterialType type,
+                                Sampler& sampler, int bounce)
+{
+    // Select the sampling function once for the whole queue.
+    bool (*sampleFunction)(const MaterialData&, const Ray&,
+                           const HitRecord&, Sampler&, ScatterSample&);
+
+    switch (type)
+    {
+    case MaterialType::Metal:
+        sampleFunction = sampleMetal;
+        break;
+    case MaterialType::Glass:
+        sampleFunction = sampleGlass;
+        break;
+    case MaterialType::Emissive:
+        sampleFunction = sampleEmissive;
+        break;
+    case MaterialType::Diffuse:
+    default:
+        sampleFunction = sampleDiffuse;
+        break;
+    }
+
+    RT_STATS_TIMER(timer, StatsPhase::Shade);
+    RT_STATS_ADD(scatterCalls[static_cast<int>(type)],
+                 m_shadeQueues[static_cast<int>(type)].size());
+    RT_STATS_ADD(phaseRays[static_cast<int>(StatsPhase::Shade)],
+                 m_shadeQueues[static_cast<int>(type)].size());
+
+    for (uint32_t path : m_shadeQueues[static_cast<int>(type)])
+    {
+        // Restore the path's place in the sample sequence.
+        sampler.startPixelSample(m_pixelIndex[path], m_sampleIndex[path]);
+        sampler.startBounce(bounce);
+
+        Ray r(m_origin[path], m_direction[path], m_time[path]);
+
+        HitRecord rec;
+        rec.p = m_hitPoint[path];
+        rec.normal = m_hitNormal[path];
+        rec.frontFace = m_frontFace[path] != 0;
+        rec.material = m_material[path];
+
+        if (m_lightsSampled && hasScatterPdf(*rec.material))
+        {
+            m_color[path] += m_throughput[path] *
+                             sampleDirectLight(r, rec, world, sampler,
+                                               bounce);
+        }
+
+        ScatterSample sample;
+
+        if (!sampleFunction(*rec.material, r, rec, sampler, sample))
+        {
+            RT_STATS_ADD(absorbedPaths, 1);
+            RT_STATS_ADD(pathLengths[pathLengthBucket(bounce + 1)], 1);
+
+            continue;
+        }
+
+        Color throughput = m_throughput[path] * sample.weight;
+
+        // Russian roulette, exactly as in rayColor.
+        if (bounce + 1 >= m_rouletteDepth)
+        {
+            float survival = std::fmax(throughput.x(),
+                                       std::fmax(throughput.y(),
+                                                 throughput.z()));
+
+            if (survival < 1.0f)
+            {
+                if (sampler.getRoulette1D(bounce) >= survival)
+                {
+                    RT_STATS_ADD(rouletteTerminatedPaths, 1);
+                    RT_STATS_ADD(pathLengths[pathLengthBucket(bounce + 1)], 1);
+
+                    continue;
+                }
+
+                throughput = throughput / survival;
+            }
+        }
+
+        m_throughput[path] = throughput;
+        m_rayPdf[path] = m_lightsSampled ? sample.pdf : 0.0f;
+        m_origin[path] = rec.p;
+        m_direction[path] = sample.direction;
+
+        m_nextActive.push_back(path);
+    }
+}
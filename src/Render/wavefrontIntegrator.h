@@ -0,0 +1,101 @@
+/*
+ * This file provides a wavefront path tracer. Instead of following one path
+ * to its end before starting the next, it advances a whole batch of paths
+ * one bounce at a time in separate stages: extend (intersect every path with
+ * the scene), sort the hits into one queue per material type, then shade
+ * each queue in turn. Traversal and scattering thus run over long runs of
+ * similar work. Paths draw the same sample values as in rayColor, so both
+ * integrators produce the same image.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../Materials/materialData.h"
+#include "../Math/ray.h"
+#include "../Math/vector3.h"
+#include "../Sampling/sampler.h"
+#include "../Scene/scene.h"
+
+// Number of paths the camera hands to the wavefront integrator at once.
+const int WAVEFRONT_BATCH_SIZE = 1 << 14;
+
+enum class IntegratorType
+{
+    Path,
+    Wavefront
+};
+
+// Parses an integrator name ("path" or "wavefront").
+bool parseIntegratorType(const std::string& name, IntegratorType& type);
+
+class WavefrontIntegrator
+{
+public:
+    // Initialization constructor (see rayColor for the parameters).
+    WavefrontIntegrator(int maxDepth, int rouletteDepth,
+                        bool sampleLights = true);
+
+    // Appends a path starting with the given camera ray. The pixel and
+    // sample index select the path's sample values.
+    void addPath(const Ray& r, uint32_t pixelIndex, uint32_t sampleIndex);
+
+    // Number of paths added since the last clear().
+    size_t pathCount() const { return m_pixelIndex.size(); }
+
+    // Traces every path added and returns their colors in the order the
+    // paths were added.
+    const std::vector<Color>& trace(const Scene& world, Sampler& sampler);
+
+    // Number of rays traced by the last call to trace().
+    uint64_t raysTraced() const { return m_raysTraced; }
+
+    // Removes every path (the buffers keep their capacity).
+    void clear();
+
+private:
+    // Intersects every active path with the scene. Paths that miss are
+    // finished with the sky color, the others gather the light of emitters
+    // they hit and are queued by material.
+    void extend(const Scene& world, int bounce);
+
+    // Samples the lights from and scatters every path queued for the given
+    // material type and keeps the ones that survive for the next bounce.
+    void shade(const Scene& world, MaterialType type, Sampler& sampler,
+               int bounce);
+
+    int m_maxDepth;
+    int m_rouletteDepth;
+    bool m_sampleLights;
+
+    // Whether or not the scene of the current trace() has lights to sample.
+    bool m_lightsSampled = false;
+
+    uint64_t m_raysTraced = 0;
+
+    // Path state, one entry per path (structure of arrays).
+    std::vector<Point3> m_origin;
+    std::vector<Vector3> m_direction;
+    std::vector<float> m_time;
+    std::vector<Color> m_throughput;
+    std::vector<float> m_rayPdf;
+    std::vector<uint32_t> m_pixelIndex;
+    std::vector<uint32_t> m_sampleIndex;
+    std::vector<Color> m_color;
+
+    // Surface hit by each path in the last extend stage.
+    std::vector<Point3> m_hitPoint;
+    std::vector<Vector3> m_hitNormal;
+    std::vector<uint8_t> m_frontFace;
+    std::vector<const MaterialData*> m_material;
+
+    // Paths still bouncing, and the paths that survive the current bounce.
+    std::vector<uint32_t> m_active;
+    std::vector<uint32_t> m_nextActive;
+
+    // Paths waiting to be shaded, one queue per material type.
+    std::vector<uint32_t> m_shadeQueues[MATERIAL_TYPE_COUNT];
+};
@@ -0,0 +1,25 @@
+#include "independentSampler.h"
+
+#include "../Math/random.h"
+
+IndependentSampler::IndependentSampler(int samplesPerPixel) :
+                                       Sampler(samplesPerPixel) {}
+
+void IndependentSampler::startPixelSample(uint32_t pixelIndex,
+                                          uint32_t sampleIndex)
+{
+    Sampler::startPixelSample(pixelIndex, sampleIndex);
+
+    m_stream = RandomStream(pixelIndex, sampleIndex, 0);
+}
+
+float IndependentSampler::sample1D(int dimension) const
+{
+    return m_stream.floatAt(static_cast<uint32_t>(dimension));
+}
+
+Point2 IndependentSampler::sample2D(int dimension) const
+{
+    return Point2(m_stream.floatAt(static_cast<uint32_t>(dimension)),
+                  m_stream.floatAt(static_cast<uint32_t>(dimension + 1)));
+}
@@ -0,0 +1,28 @@
+/*
+ * This class hands out independent uniform random values for every
+ * dimension (plain Monte Carlo). It is the reference the other samplers are
+ * compared against.
+ */
+
+#pragma once
+
+#include "sampler.h"
+
+#include "../Math/random.h"
+
+class IndependentSampler : public Sampler
+{
+public:
+    // Default constructor.
+    IndependentSampler(int samplesPerPixel);
+
+    void startPixelSample(uint32_t pixelIndex, uint32_t sampleIndex) override;
+
+protected:
+    float sample1D(int dimension) const override;
+    Point2 sample2D(int dimension) const override;
+
+private:
+    // Stream keyed by the current pixel sample; dimensions index into it.
+    RandomStream m_stream;
+};
@@ -0,0 +1,124 @@
+/*
+ * This file provides the building blocks of the low-discrepancy samplers:
+ * the first two dimensions of the Sobol sequence, hash-based Owen scrambling
+ * (Burley, "Practical Hash-based Owen Scrambling", 2020) and random
+ * permutations of sample indices.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "../Math/random.h"
+
+// Reverses the order of the bits of a 32-bit integer.
+inline uint32_t reverseBits32(uint32_t n)
+{
+    n = (n << 16) | (n >> 16);
+    n = ((n & 0x00FF00FFu) << 8) | ((n & 0xFF00FF00u) >> 8);
+    n = ((n & 0x0F0F0F0Fu) << 4) | ((n & 0xF0F0F0F0u) >> 4);
+    n = ((n & 0x33333333u) << 2) | ((n & 0xCCCCCCCCu) >> 2);
+    n = ((n & 0x55555555u) << 1) | ((n & 0xAAAAAAAAu) >> 1);
+
+    return n;
+}
+
+// Returns the sample index-th point of the Sobol sequence in dimension 0
+// (van der Corput) or 1 as a 0.32 fixed point number.
+inline uint32_t sobolSample(uint32_t index, int dimension)
+{
+    if (dimension == 0)
+    {
+        return reverseBits32(index);
+    }
+
+    // The direction numbers of the second dimension follow Pascal's
+    // triangle modulo two: v(k + 1) = v(k) ^ (v(k) >> 1).
+    uint32_t result = 0;
+
+    for (uint32_t v = 1u << 31; index != 0; index >>= 1, v ^= v >> 1)
+    {
+        if (index & 1u)
+        {
+            result ^= v;
+        }
+    }
+
+    return result;
+}
+
+// Hash that only propagates bits from low to high, which after bit
+// reversal turns into a nested uniform (Owen) scramble.
+inline uint32_t laineKarrasPermutation(uint32_t x, uint32_t seed)
+{
+    x += seed;
+    x ^= x * 0x6C50B47Cu;
+    x ^= x * 0xB82F1E52u;
+    x ^= x * 0xC7AFE638u;
+    x ^= x * 0x8D22F6E6u;
+
+    return x;
+}
+
+// Owen-scrambles a 0.32 fixed point number.
+inline uint32_t nestedUniformScramble(uint32_t x, uint32_t seed)
+{
+    return reverseBits32(laineKarrasPermutation(reverseBits32(x), seed));
+}
+
+// Converts a 0.32 fixed point number to a float within [0, 1).
+inline float fixedPointToFloat(uint32_t x)
+{
+    return static_cast<float>(x >> 8) * (1.0f / 16777216.0f);
+}
+
+// Returns element i of a random permutation of [0, n) selected by seed
+// (Kensler, "Correlated Multi-Jittered Sampling", 2013).
+inline uint32_t permutationElement(uint32_t i, uint32_t n, uint32_t seed)
+{
+    if (n <= 1)
+    {
+        return 0;
+    }
+
+    uint32_t w = n - 1;
+    w |= w >> 1;
+    w |= w >> 2;
+    w |= w >> 4;
+    w |= w >> 8;
+    w |= w >> 16;
+
+    do
+    {
+        i ^= seed;
+        i *= 0xE170893Du;
+        i ^= seed >> 16;
+        i ^= (i & w) >> 4;
+        i ^= seed >> 8;
+        i *= 0x0929EB3Fu;
+        i ^= seed >> 23;
+        i ^= (i & w) >> 1;
+        i *= 1u | seed >> 27;
+        i *= 0x6935FA69u;
+        i ^= (i & w) >> 11;
+        i *= 0x74DCB303u;
+        i ^= (i & w) >> 2;
+        i *= 0x9E501CC3u;
+        i ^= (i & w) >> 2;
+        i *= 0xC860A3DFu;
+        i &= w;
+        i ^= i >> 5;
+    } while (i >= n);
+
+    return (i + seed) % n;
+}
+
+// Hashes a pixel and a sampling dimension into a 32-bit seed.
+inline uint32_t dimensionSeed(uint32_t pixelIndex, int dimension,
+                              uint32_t salt = 0)
+{
+    uint64_t key = (static_cast<uint64_t>(pixelIndex) << 32) |
+                   (static_cast<uint32_t>(dimension) ^ (salt << 24));
+
+    return static_cast<uint32_t>(RandomStream::mix(key) >> 32);
+}
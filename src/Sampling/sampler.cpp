@@ -0,0 +1,44 @@
+#include "sampler.h"
+
+#include <memory>
+#include <string>
+
+#include "independentSampler.h"
+#include "stratifiedSampler.h"
+#include "sobolSampler.h"
+
+std::unique_ptr<Sampler> makeSampler(SamplerType type, int samplesPerPixel)
+{
+    switch (type)
+    {
+    case SamplerType::Independent:
+        return std::make_unique<IndependentSampler>(samplesPerPixel);
+    case SamplerType::Stratified:
+        return std::make_unique<StratifiedSampler>(samplesPerPixel);
+    case SamplerType::Sobol:
+    default:
+        return std::make_unique<SobolSampler>(samplesPerPixel);
+    }
+}
+
+bool parseSamplerType(const std::string& name, SamplerType& type)
+{
+    if (name == "independent")
+    {
+        type = SamplerType::Independent;
+    }
+    else if (name == "stratified")
+    {
+        type = SamplerType::Stratified;
+    }
+    else if (name == "sobol")
+    {
+        type = SamplerType::Sobol;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,122 @@
+/*
+ * This is an abstract class that hands out the sample values used to trace a
+ * path. Every value belongs to a numbered dimension: the pixel jitter, the
+ * lens position and the shutter time come first, followed by a fixed block
+ * of dimensions per bounce. Implementations decide how the values of one
+ * dimension are distributed across the samples of a pixel.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "../Math/point2.h"
+
+enum class SamplerType
+{
+    Independent,
+    Stratified,
+    Sobol
+};
+
+class Sampler
+{
+public:
+    // Dimensions used by the camera: pixel jitter (2), lens (2), time (1).
+    static const int CAMERA_DIMENSIONS = 5;
+
+    // Dimensions reserved for every bounce along a path.
+    static const int BOUNCE_DIMENSIONS = 8;
+
+    // Initialization constructor.
+    explicit Sampler(int samplesPerPixel) :
+                     m_samplesPerPixel(samplesPerPixel) {}
+
+    virtual ~Sampler() = default;
+
+    int samplesPerPixel() const { return m_samplesPerPixel; }
+
+    // Starts sample sampleIndex of the given pixel. The next values handed
+    // out are the lens and time dimensions.
+    virtual void startPixelSample(uint32_t pixelIndex, uint32_t sampleIndex)
+    {
+        m_pixelIndex = pixelIndex;
+        m_sampleIndex = sampleIndex;
+        m_dimension = 2;
+    }
+
+    // Moves on to the dimensions reserved for the given bounce, so every
+    // bounce uses the same dimensions whatever the previous ones consumed.
+    void startBounce(int bounce)
+    {
+        m_dimension = CAMERA_DIMENSIONS + bounce * BOUNCE_DIMENSIONS;
+    }
+
+    // Returns the jitter of the pixel sample within [0, 1)^2.
+    Point2 getPixel2D() { return sample2D(0); }
+
+    // Returns the value of the next dimension within [0, 1).
+    float get1D() { return sample1D(m_dimension++); }
+
+    // Returns the values of the next two dimensions within [0, 1)^2.
+    Point2 get2D()
+    {
+        int dimension = m_dimension;
+        m_dimension += 2;
+
+        return sample2D(dimension);
+    }
+
+    // Returns the Russian roulette value of the given bounce. It comes from
+    // the last dimension reserved for the bounce, which materials never
+    // reach, so terminating paths does not change the values they draw.
+    float getRoulette1D(int bounce) const
+    {
+        return sample1D(CAMERA_DIMENSIONS + bounce * BOUNCE_DIMENSIONS +
+                        BOUNCE_DIMENSIONS - 1);
+    }
+
+    // Returns the value that picks the light sampled at the given bounce.
+    // Like the Russian roulette value, the light sampling values come from
+    // dimensions reserved for the bounce that materials never reach.
+    float getLight1D(int bounce) const
+    {
+        return sample1D(CAMERA_DIMENSIONS + bounce * BOUNCE_DIMENSIONS +
+                        LIGHT_DIMENSION);
+    }
+
+    // Returns the values that pick a point on the light sampled at the given
+    // bounce.
+    Point2 getLight2D(int bounce) const
+    {
+        return sample2D(CAMERA_DIMENSIONS + bounce * BOUNCE_DIMENSIONS +
+                        LIGHT_DIMENSION + 1);
+    }
+
+protected:
+    // First of the three dimensions of a bounce used by light sampling.
+    static const int LIGHT_DIMENSION = 4;
+
+    // Returns the value of the current pixel sample in one dimension.
+    virtual float sample1D(int dimension) const = 0;
+
+    // Returns the value of the current pixel sample in two consecutive
+    // dimensions.
+    virtual Point2 sample2D(int dimension) const = 0;
+
+    int m_samplesPerPixel;
+
+    uint32_t m_pixelIndex = 0;
+    uint32_t m_sampleIndex = 0;
+
+    // Next dimension to hand out.
+    int m_dimension = 0;
+};
+
+// Creates a sampler of the given type.
+std::unique_ptr<Sampler> makeSampler(SamplerType type, int samplesPerPixel);
+
+// Parses a sampler name ("independent", "stratified" or "sobol").
+bool parseSamplerType(const std::string& name, SamplerType& type);
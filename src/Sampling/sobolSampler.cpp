@@ -0,0 +1,33 @@
+#include "sobolSampler.h"
+
+#include "lowDiscrepancy.h"
+
+SobolSampler::SobolSampler(int samplesPerPixel) : Sampler(samplesPerPixel) {}
+
+float SobolSampler::sample1D(int dimension) const
+{
+    uint32_t seed = dimensionSeed(m_pixelIndex, dimension);
+
+    // Shuffle the sample order, then scramble the point itself.
+    uint32_t index = nestedUniformScramble(m_sampleIndex, seed);
+    uint32_t value = nestedUniformScramble(sobolSample(index, 0),
+                                           dimensionSeed(m_pixelIndex,
+                                                         dimension, 1));
+
+    return fixedPointToFloat(value);
+}
+
+Point2 SobolSampler::sample2D(int dimension) const
+{
+    uint32_t seed = dimensionSeed(m_pixelIndex, dimension);
+
+    uint32_t index = nestedUniformScramble(m_sampleIndex, seed);
+    uint32_t x = nestedUniformScramble(sobolSample(index, 0),
+                                       dimensionSeed(m_pixelIndex,
+                                                     dimension, 1));
+    uint32_t y = nestedUniformScramble(sobolSample(index, 1),
+                                       dimensionSeed(m_pixelIndex,
+                                                     dimension, 2));
+
+    return Point2(fixedPointToFloat(x), fixedPointToFloat(y));
+}
@@ -0,0 +1,23 @@
+/*
+ * This class hands out Owen-scrambled Sobol samples. Every pair of
+ * dimensions uses the first two (well stratified) Sobol dimensions with its
+ * own shuffled sample order and nested uniform scramble, seeded by the pixel
+ * and the dimension ("padded" Sobol). The sequence is progressive: any
+ * prefix of power-of-two length is well distributed, so it also suits
+ * adaptive and progressive rendering.
+ */
+
+#pragma once
+
+#include "sampler.h"
+
+class SobolSampler : public Sampler
+{
+public:
+    // Default constructor.
+    SobolSampler(int samplesPerPixel);
+
+protected:
+    float sample1D(int dimension) const override;
+    Point2 sample2D(int dimension) const override;
+};
@@ -0,0 +1,74 @@
+#include "stratifiedSampler.h"
+
+#include <cmath>
+
+#include "lowDiscrepancy.h"
+#include "../Math/random.h"
+
+StratifiedSampler::StratifiedSampler(int samplesPerPixel) :
+                                     Sampler(samplesPerPixel)
+{
+    // Use the most square factorization of the sample count.
+    m_xStrata = static_cast<int>(std::sqrt(static_cast<float>(
+                                           samplesPerPixel)));
+
+    while (m_xStrata > 1 && samplesPerPixel % m_xStrata != 0)
+    {
+        --m_xStrata;
+    }
+
+    m_xStrata = m_xStrata < 1 ? 1 : m_xStrata;
+    m_yStrata = samplesPerPixel / m_xStrata;
+    m_yStrata = m_yStrata < 1 ? 1 : m_yStrata;
+}
+
+void StratifiedSampler::startPixelSample(uint32_t pixelIndex,
+                                         uint32_t sampleIndex)
+{
+    Sampler::startPixelSample(pixelIndex, sampleIndex);
+
+    m_stream = RandomStream(pixelIndex, sampleIndex, 0);
+}
+
+float StratifiedSampler::sample1D(int dimension) const
+{
+    uint32_t strataCount = static_cast<uint32_t>(m_samplesPerPixel);
+
+    // Samples beyond the configured count no longer fit into the strata.
+    if (m_sampleIndex >= strataCount)
+    {
+        return m_stream.floatAt(static_cast<uint32_t>(dimension));
+    }
+
+    uint32_t stratum = permutationElement(m_sampleIndex, strataCount,
+                                          dimensionSeed(m_pixelIndex,
+                                                        dimension));
+    float jitter = m_stream.floatAt(static_cast<uint32_t>(dimension));
+    float value = (stratum + jitter) / strataCount;
+
+    return value < 1.0f ? value : 0.99999994f;
+}
+
+Point2 StratifiedSampler::sample2D(int dimension) const
+{
+    uint32_t strataCount = static_cast<uint32_t>(m_xStrata * m_yStrata);
+
+    float jitterX = m_stream.floatAt(static_cast<uint32_t>(dimension));
+    float jitterY = m_stream.floatAt(static_cast<uint32_t>(dimension + 1));
+
+    if (m_sampleIndex >= strataCount)
+    {
+        return Point2(jitterX, jitterY);
+    }
+
+    uint32_t stratum = permutationElement(m_sampleIndex, strataCount,
+                                          dimensionSeed(m_pixelIndex,
+                                                        dimension));
+    int x = static_cast<int>(stratum) % m_xStrata;
+    int y = static_cast<int>(stratum) / m_xStrata;
+
+    float u = (x + jitterX) / m_xStrata;
+    float v = (y + jitterY) / m_yStrata;
+
+    return Point2(u < 1.0f ? u : 0.99999994f, v < 1.0f ? v : 0.99999994f);
+}
@@ -0,0 +1,34 @@
+/*
+ * This class hands out jittered stratified samples: every dimension (or pair
+ * of dimensions) of a pixel is split into one stratum per sample, and each
+ * sample lands at a random position within its own stratum. The strata are
+ * visited in a different random order per dimension so that dimensions are
+ * not correlated with each other.
+ */
+
+#pragma once
+
+#include "sampler.h"
+
+#include "../Math/random.h"
+
+class StratifiedSampler : public Sampler
+{
+public:
+    // Default constructor. The 2D strata form an xStrata x yStrata grid with
+    // xStrata * yStrata == samplesPerPixel.
+    StratifiedSampler(int samplesPerPixel);
+
+    void startPixelSample(uint32_t pixelIndex, uint32_t sampleIndex) override;
+
+protected:
+    float sample1D(int dimension) const override;
+    Point2 sample2D(int dimension) const override;
+
+private:
+    int m_xStrata;
+    int m_yStrata;
+
+    // Jitter within the strata.
+    RandomStream m_stream;
+};
@@ -0,0 +1,125 @@
+/*
+ * This file maps uniform samples from the unit square (or cube) onto other
+ * domains in closed form. Unlike the rejection loops in vector3.h, every
+ * mapping consumes a fixed number of dimensions and preserves the
+ * stratification of low-discrepancy samples.
+ */
+
+#pragma once
+
+#include <cmath>
+
+#include "../Math/point2.h"
+#include "../Math/vector3.h"
+#include "../Math/utilities.h"
+
+// Maps the unit square onto the unit disk (z = 0) with Shirley's concentric
+// mapping, which keeps neighbouring samples close together.
+inline Vector3 sampleUniformDiskConcentric(const Point2& u)
+{
+    float ox = 2.0f * u.x - 1.0f;
+    float oy = 2.0f * u.y - 1.0f;
+
+    if (ox == 0.0f && oy == 0.0f)
+    {
+        return Vector3(0.0f, 0.0f, 0.0f);
+    }
+
+    float r, theta;
+
+    if (std::fabs(ox) > std::fabs(oy))
+    {
+        r = ox;
+        theta = (PI / 4.0f) * (oy / ox);
+    }
+    else
+    {
+        r = oy;
+        theta = (PI / 2.0f) - (PI / 4.0f) * (ox / oy);
+    }
+
+    return Vector3(r * std::cos(theta), r * std::sin(theta), 0.0f);
+}
+
+// Maps the unit square onto a uniformly distributed unit vector.
+inline Vector3 sampleUniformSphere(const Point2& u)
+{
+    float z = 1.0f - 2.0f * u.x;
+    float r = std::sqrt(std::fmax(0.0f, 1.0f - z * z));
+    float phi = 2.0f * PI * u.y;
+
+    return Vector3(r * std::cos(phi), r * std::sin(phi), z);
+}
+
+// Maps the unit square onto a unit vector in the hemisphere around +z
+// whose density is proportional to its cosine with +z (cos / pi per solid
+// angle). The polar mapping of the disk keeps it free of branches.
+inline Vector3 sampleCosineHemisphere(const Point2& u)
+{
+    float r = std::sqrt(u.x);
+    float phi = 2.0f * PI * u.y;
+
+    return Vector3(r * std::cos(phi), r * std::sin(phi),
+                   std::sqrt(std::fmax(0.0f, 1.0f - u.x)));
+}
+
+// Maps the unit cube onto a uniformly distributed point within the unit
+// ball.
+inline Vector3 sampleUniformBall(const Point2& u, float radiusSample)
+{
+    return std::cbrt(radiusSample) * sampleUniformSphere(u);
+}
+
+// Maps the unit square onto a uniformly distributed unit vector within the
+// cone of directions around +z whose angle with it has a cosine of at least
+// 1 - oneMinusCosThetaMax. Passing the difference keeps narrow cones (e.g.
+// distant lights) accurate. The density is 1 / (2 pi oneMinusCosThetaMax)
+// per solid angle.
+inline Vector3 sampleUniformCone(const Point2& u, float oneMinusCosThetaMax)
+{
+    float oneMinusCosTheta = u.x * oneMinusCosThetaMax;
+    float sinTheta = std::sqrt(std::fmax(0.0f, oneMinusCosTheta *
+                                               (2.0f - oneMinusCosTheta)));
+    float phi = 2.0f * PI * u.y;
+
+    return Vector3(sinTheta * std::cos(phi), sinTheta * std::sin(phi),
+                   1.0f - oneMinusCosTheta);
+}
+
+// Completes the unit vector n to an orthonormal basis (tangent, bitangent,
+// n) without branching on its direction (Duff et al. 2017).
+inline void orthonormalBasis(const Vector3& n, Vector3& tangent,
+                             Vector3& bitangent)
+{
+    float sign = std::copysign(1.0f, n.z());
+    float a = -1.0f / (sign + n.z());
+    float b = n.x() * n.y() * a;
+
+    tangent = Vector3(1.0f + sign * n.x() * n.x() * a, sign * b,
+                      -sign * n.x());
+    bitangent = Vector3(b, sign + n.y() * n.y() * a, -n.y());
+}
+
+// An orthonormal basis around a unit normal, in which shading happens with
+// the normal along +z.
+struct ShadingFrame
+{
+    Vector3 tangent;
+    Vector3 bitangent;
+    Vector3 normal;
+
+    explicit ShadingFrame(const Vector3& n) : normal(n)
+    {
+        orthonormalBasis(n, tangent, bitangent);
+    }
+
+    Vector3 toLocal(const Vector3& v) const
+    {
+        return Vector3(dot(v, tangent), dot(v, bitangent), dot(v, normal));
+    }
+
+    Vector3 toWorld(const Vector3& v) const
+    {
+        return v.x() * tangent + v.y() * bitangent + v.z() * normal;
+    }
+};
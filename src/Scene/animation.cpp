@@ -0,0 +1,218 @@
+#include "animation.h"
+
+#include <algorithm>
+
+namespace
+{
+    Vector3 lerp(const Vector3& a, const Vector3& b, float weight)
+    {
+        return (1.0f - weight) * a + weight * b;
+    }
+
+    Transform stepTransform(const TransformStep& step)
+    {
+        switch (step.type)
+        {
+        case TransformStepType::Translate:
+            return Transform::translation(step.values);
+        case TransformStepType::Rotate:
+            return Transform::rotation(step.axis, step.values.x());
+        case TransformStepType::Scale:
+            return Transform::scaling(step.values);
+        }
+
+        return Transform();
+    }
+
+    // Checks whether or not the parameters of two step lists can be
+    // interpolated.
+    bool sameSteps(const std::vector<TransformStep>& a,
+                   const std::vector<TransformStep>& b)
+    {
+        if (a.size() != b.size())
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+            if (a[i].type != b[i].type ||
+                (a[i].type == TransformStepType::Rotate &&
+                 a[i].axis != b[i].axis))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+}
+
+Transform composeSteps(const std::vector<TransformStep>& steps)
+{
+    Transform transform;
+
+    for (const TransformStep& step : steps)
+    {
+        transform = stepTransform(step) * transform;
+    }
+
+    return transform;
+}
+
+template <typename Value>
+Animation::Track<Value>& Animation::insertKey(
+    std::vector<Track<Value>>& tracks, uint32_t object, int frame,
+    const Value& value)
+{
+    auto track = std::find_if(tracks.begin(), tracks.end(),
+                              [object](const Track<Value>& candidate)
+                              {
+                                  return candidate.object == object;
+                              });
+
+    if (track == tracks.end())
+    {
+        tracks.push_back(Track<Value>{object, {}});
+        track = tracks.end() - 1;
+    }
+
+    std::vector<Key<Value>>& keys = track->keys;
+    auto position = std::lower_bound(keys.begin(), keys.end(), frame,
+                                     [](const Key<Value>& key, int f)
+                                     {
+                                         return key.frame < f;
+                                     });
+
+    if (position != keys.end() && position->frame == frame)
+    {
+        position->value = value;
+    }
+    else
+    {
+        keys.insert(position, Key<Value>{frame, value});
+    }
+
+    return *track;
+}
+
+template <typename Value>
+void Animation::bracket(const std::vector<Key<Value>>& keys, int frame,
+                        const Value*& before, const Value*& after,
+                        float& weight)
+{
+    auto next = std::upper_bound(keys.begin(), keys.end(), frame,
+                                 [](int f, const Key<Value>& key)
+                                 {
+                                     return f < key.frame;
+                                 });
+
+    if (next == keys.begin())
+    {
+        before = after = &next->value;
+        weight = 0.0f;
+    }
+    else if (next == keys.end())
+    {
+        before = after = &keys.back().value;
+        weight = 0.0f;
+    }
+    else
+    {
+        const Key<Value>& previous = *(next - 1);
+
+        before = &previous.value;
+        after = &next->value;
+        weight = static_cast<float>(frame - previous.frame) /
+                 static_cast<float>(next->frame - previous.frame);
+    }
+}
+
+void Animation::addCameraKey(int frame, const Point3& lookFrom,
+                             const Point3& lookAt)
+{
+    // The camera has a single track; reuse the track insertion for it.
+    std::vector<Track<CameraPose>> tracks(1);
+    tracks[0].object = 0;
+    tracks[0].keys.swap(m_cameraKeys);
+
+    insertKey(tracks, 0, frame, CameraPose{lookFrom, lookAt});
+
+    m_cameraKeys.swap(tracks[0].keys);
+}
+
+void Animation::addSphereKey(uint32_t sphere, int frame, const Point3& center)
+{
+    insertKey(m_sphereTracks, sphere, frame, center);
+}
+
+bool Animation::addInstanceKey(uint32_t instance, int frame,
+                               const std::vector<TransformStep>& steps)
+{
+    for (const auto& track : m_instanceTracks)
+    {
+        if (track.object == instance &&
+            !sameSteps(track.keys.front().value, steps))
+        {
+            return false;
+        }
+    }
+
+    insertKey(m_instanceTracks, instance, frame, steps);
+
+    return true;
+}
+
+bool Animation::cameraAt(int frame, Point3& lookFrom, Point3& lookAt) const
+{
+    if (m_cameraKeys.empty())
+    {
+        return false;
+    }
+
+    const CameraPose* before;
+    const CameraPose* after;
+    float weight;
+
+    bracket(m_cameraKeys, frame, before, after, weight);
+
+    lookFrom = lerp(before->lookFrom, after->lookFrom, weight);
+    lookAt = lerp(before->lookAt, after->lookAt, weight);
+
+    return true;
+}
+
+void Animation::poseScene(int frame, Scene& scene) const
+{
+    for (const Track<Point3>& track : m_sphereTracks)
+    {
+        const Point3* before;
+        const Point3* after;
+        float weight;
+
+        bracket(track.keys, frame, before, after, weight);
+        scene.spheres().setCenter(track.object,
+                                  lerp(*before, *after, weight));
+    }
+
+    std::vector<TransformStep> steps;
+
+    for (const Track<std::vector<TransformStep>>& track : m_instanceTracks)
+    {
+        const std::vector<TransformStep>* before;
+        const std::vector<TransformStep>* after;
+        float weight;
+
+        bracket(track.keys, frame, before, after, weight);
+
+        steps = *before;
+
+        for (size_t i = 0; i < steps.size(); ++i)
+        {
+            steps[i].values = lerp((*before)[i].values, (*after)[i].values,
+                                   weight);
+        }
+
+        scene.setInstanceTransform(track.object, composeSteps(steps));
+    }
+}
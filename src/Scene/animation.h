@@ -0,0 +1,121 @@
+/*
+ * This file describes animated scenes: a camera path plus keyframed sphere
+ * centers and instance transforms over a sequence of frames. Between two
+ * keyframes of a track values are interpolated linearly; before the first
+ * and after the last keyframe they are held.
+ *
+ * Instance keyframes store the steps of their transform (translations,
+ * rotations and scales) rather than a matrix, and the parameters of the
+ * steps are interpolated. A rotation keyed from 0 to 360 degrees therefore
+ * turns a full circle, where interpolated matrices would not turn at all.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "scene.h"
+#include "../Math/transform.h"
+#include "../Math/vector3.h"
+
+enum class TransformStepType : uint8_t
+{
+    Translate,
+    Rotate,
+    Scale
+};
+
+// One step of a transform as written in a scene file.
+struct TransformStep
+{
+    TransformStepType type;
+
+    // Rotation axis (0, 1 or 2 for x, y or z).
+    int axis;
+
+    // Translation offset, rotation angle in degrees (x) or scale factors.
+    Vector3 values;
+};
+
+// Returns the transform that applies the steps in the order given.
+Transform composeSteps(const std::vector<TransformStep>& steps);
+
+class Animation
+{
+public:
+    // Number of frames of the sequence (1 for a still image).
+    int frameCount() const { return m_frameCount; }
+
+    void setFrameCount(int frameCount) { m_frameCount = frameCount; }
+
+    // Checks whether or not anything is keyed.
+    bool animated() const
+    {
+        return !m_cameraKeys.empty() || !m_sphereTracks.empty() ||
+               !m_instanceTracks.empty();
+    }
+
+    // Keys the camera position and target at frame.
+    void addCameraKey(int frame, const Point3& lookFrom,
+                      const Point3& lookAt);
+
+    // Keys the center of a sphere (by insertion index) at frame.
+    void addSphereKey(uint32_t sphere, int frame, const Point3& center);
+
+    // Keys the transform of an instance (by the order instances were added
+    // in) at frame. Returns false if the steps do not have the same types
+    // and axes as those of the other keys of the instance, since they could
+    // not be interpolated.
+    bool addInstanceKey(uint32_t instance, int frame,
+                        const std::vector<TransformStep>& steps);
+
+    // Returns the camera position and target at frame, or false if the
+    // camera is not animated.
+    bool cameraAt(int frame, Point3& lookFrom, Point3& lookAt) const;
+
+    // Moves the animated spheres and instances of the scene to frame. The
+    // scene must be refitted or rebuilt afterwards.
+    void poseScene(int frame, Scene& scene) const;
+
+private:
+    template <typename Value>
+    struct Key
+    {
+        int frame;
+        Value value;
+    };
+
+    struct CameraPose
+    {
+        Point3 lookFrom;
+        Point3 lookAt;
+    };
+
+    // Keys of one object, sorted by frame.
+    template <typename Value>
+    struct Track
+    {
+        uint32_t object;
+        std::vector<Key<Value>> keys;
+    };
+
+    // Inserts a key into the track of object, keeping the keys sorted; a
+    // key at the same frame replaces the old one.
+    template <typename Value>
+    static Track<Value>& insertKey(std::vector<Track<Value>>& tracks,
+                                   uint32_t object, int frame,
+                                   const Value& value);
+
+    // Finds the keys around frame and the weight of the later one.
+    template <typename Value>
+    static void bracket(const std::vector<Key<Value>>& keys, int frame,
+                        const Value*& before, const Value*& after,
+                        float& weight);
+
+    int m_frameCount = 1;
+
+    std::vector<Key<CameraPose>> m_cameraKeys;
+    std::vector<Track<Point3>> m_sphereTracks;
+    std::vector<Track<std::vector<TransformStep>>> m_instanceTracks;
+};
@@ -0,0 +1,185 @@
+#include "environment.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "../Math/utilities.h"
+
+namespace
+{
+    // Rec. 709 luminance, as in color.h.
+    float texelLuminance(const Color& c)
+    {
+        return 0.2126f * c.x() + 0.7152f * c.y() + 0.0722f * c.z();
+    }
+
+    // Turns running sums into a distribution from 0 to 1, or a uniform one
+    // if they are all 0. Returns the total.
+    double normalize(const std::vector<double>& sums, float* cdf)
+    {
+        size_t count = sums.size() - 1;
+        double total = sums[count];
+
+        for (size_t i = 0; i <= count; ++i)
+        {
+            cdf[i] = total > 0.0 ? static_cast<float>(sums[i] / total) :
+                                   static_cast<float>(i) / count;
+        }
+
+        cdf[count] = 1.0f;
+
+        return total;
+    }
+
+    // Inverts a piecewise constant distribution of count pieces: returns
+    // the position of u in [0, count), continuous within its piece, and
+    // stores the piece in index.
+    float sampleCdf(const float* cdf, int count, float u, int& index)
+    {
+        index = static_cast<int>(std::upper_bound(cdf, cdf + count + 1, u) -
+                                 cdf) - 1;
+        index = std::max(0, std::min(index, count - 1));
+
+        float width = cdf[index + 1] - cdf[index];
+        float offset = width > 0.0f ? (u - cdf[index]) / width : 0.5f;
+
+        return index + std::min(offset, 1.0f);
+    }
+}
+
+Environment::Environment(const Framebuffer& image, float rotation)
+    : m_width(image.width()), m_height(image.height()),
+      m_tilesPerRow((image.width() + TILE_SIZE - 1) / TILE_SIZE),
+      m_rotation(rotation), m_phiOffset(degreesToRadians(rotation)),
+      m_integral(0.0f)
+{
+    int tileRows = (m_height + TILE_SIZE - 1) / TILE_SIZE;
+
+    m_texels.resize(static_cast<size_t>(m_tilesPerRow) * tileRows *
+                    TILE_SIZE * TILE_SIZE);
+    m_conditionalCdf.resize(static_cast<size_t>(m_width + 1) * m_height);
+    m_marginalCdf.resize(m_height + 1);
+
+    std::vector<float> function(static_cast<size_t>(m_width) * m_height);
+    std::vector<double> rowSums(m_width + 1);
+    std::vector<double> marginalSums(m_height + 1, 0.0);
+
+    for (int y = 0; y < m_height; ++y)
+    {
+        float sinTheta = std::sin(PI * (y + 0.5f) / m_height);
+        rowSums[0] = 0.0;
+
+        for (int x = 0; x < m_width; ++x)
+        {
+            Color radiance = image.pixel(x, y);
+            Texel& texel = m_texels[texelIndex(x, y)];
+
+            texel.red = radiance.x();
+            texel.green = radiance.y();
+            texel.blue = radiance.z();
+
+            float value = std::max(texelLuminance(radiance), 0.0f) *
+                          sinTheta;
+            function[static_cast<size_t>(y) * m_width + x] = value;
+            rowSums[x + 1] = rowSums[x] + value;
+        }
+
+        double rowTotal = normalize(rowSums, &m_conditionalCdf[
+                                    static_cast<size_t>(y) * (m_width + 1)]);
+        marginalSums[y + 1] = marginalSums[y] + rowTotal;
+    }
+
+    // Mean of the function over the unit square.
+    m_integral = static_cast<float>(normalize(marginalSums,
+                                              m_marginalCdf.data()) /
+                                    (static_cast<double>(m_width) *
+                                     m_height));
+
+    for (int y = 0; y < m_height; ++y)
+    {
+        for (int x = 0; x < m_width; ++x)
+        {
+            float value = function[static_cast<size_t>(y) * m_width + x];
+
+            m_texels[texelIndex(x, y)].density =
+                m_integral > 0.0f ? value / (m_integral * 2.0f * PI * PI) :
+                                    0.0f;
+        }
+    }
+}
+
+void Environment::toImage(const Vector3& direction, float& u, float& v,
+                          float& sinTheta) const
+{
+    float cosTheta = clamp(direction.y(), -1.0f, 1.0f);
+    float phi = std::atan2(direction.x(), -direction.z()) + m_phiOffset;
+
+    u = phi / (2.0f * PI) + 0.5f;
+    u -= std::floor(u);
+    v = std::acos(cosTheta) / PI;
+    sinTheta = std::sqrt(std::max(0.0f, 1.0f - cosTheta * cosTheta));
+}
+
+Color Environment::lookup(const Vector3& direction) const
+{
+    float u, v, sinTheta;
+    toImage(unitVector(direction), u, v, sinTheta);
+
+    int x = std::min(static_cast<int>(u * m_width), m_width - 1);
+    int y = std::min(static_cast<int>(v * m_height), m_height - 1);
+
+    return texel(x, y);
+}
+
+bool Environment::sample(const Point2& u, Vector3& direction,
+                         float& pdf) const
+{
+    if (!canSample())
+    {
+        return false;
+    }
+
+    int y, x;
+    float v = sampleCdf(m_marginalCdf.data(), m_height, u.y, y) / m_height;
+    float s = sampleCdf(&m_conditionalCdf[static_cast<size_t>(y) *
+                                          (m_width + 1)],
+                        m_width, u.x, x) / m_width;
+
+    float theta = v * PI;
+    float sinTheta = std::sin(theta);
+    float density = m_texels[texelIndex(x, y)].density;
+
+    if (!(sinTheta > 0.0f) || !(density > 0.0f))
+    {
+        return false;
+    }
+
+    float phi = (s - 0.5f) * 2.0f * PI - m_phiOffset;
+
+    direction = Vector3(sinTheta * std::sin(phi), std::cos(theta),
+                        -sinTheta * std::cos(phi));
+    pdf = density / sinTheta;
+
+    return true;
+}
+
+float Environment::pdf(const Vector3& direction) const
+{
+    if (!canSample())
+    {
+        return 0.0f;
+    }
+
+    float u, v, sinTheta;
+    toImage(direction, u, v, sinTheta);
+
+    if (!(sinTheta > 0.0f))
+    {
+        return 0.0f;
+    }
+
+    int x = std::min(static_cast<int>(u * m_width), m_width - 1);
+    int y = std::min(static_cast<int>(v * m_height), m_height - 1);
+
+    return m_texels[texelIndex(x, y)].density / sinTheta;
+}
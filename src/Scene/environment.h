@@ -0,0 +1,108 @@
+/*
+ * This class lights a scene with an equirectangular (latitude-longitude)
+ * image of the light arriving from every direction, such as an HDR photo of
+ * the sky. The top row of the image looks straight up (+y), the bottom row
+ * straight down, and the center column looks along -z before the image is
+ * rotated around the y axis.
+ *
+ * Directions can be sampled in proportion to the luminance of the image: a
+ * row is drawn from the marginal distribution of the rows, then a column
+ * from the conditional distribution of that row, both piecewise constant
+ * over the texels. Each texel is weighted by the sine of its latitude,
+ * since rows near the poles cover less of the sphere. A small sun that
+ * covers a few texels therefore receives most of the samples it deserves.
+ *
+ * Texels are stored in 4x4 tiles with their sampling density beside their
+ * radiance, so the lookups of rays that escape near each other, and the
+ * density their multiple importance sampling weight needs, share cache
+ * lines.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "../Math/point2.h"
+#include "../Math/vector3.h"
+#include "../Render/framebuffer.h"
+
+class Environment
+{
+public:
+    // Builds the environment from image, turned by rotation degrees around
+    // the y axis (counterclockwise seen from above).
+    Environment(const Framebuffer& image, float rotation);
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    float rotation() const { return m_rotation; }
+
+    // Radiance of the texel at (x, y), top row first.
+    Color texel(int x, int y) const
+    {
+        const Texel& t = m_texels[texelIndex(x, y)];
+
+        return Color(t.red, t.green, t.blue);
+    }
+
+    // Returns the radiance arriving from direction (of any length).
+    Color lookup(const Vector3& direction) const;
+
+    // False if the image is black, which leaves nothing to sample.
+    bool canSample() const { return m_integral > 0.0f; }
+
+    // Picks a unit direction with a density proportional to the luminance
+    // arriving from it. Returns false if none can be picked.
+    bool sample(const Point2& u, Vector3& direction, float& pdf) const;
+
+    // Returns the solid angle density with which sample picks direction.
+    float pdf(const Vector3& direction) const;
+
+private:
+    // Side of the square tiles texels are stored in.
+    static const int TILE_SIZE = 4;
+
+    // 16 bytes, so the four texels of a tile row fill one cache line.
+    struct Texel
+    {
+        float red, green, blue;
+
+        // Density of picking a direction within the texel over the unit
+        // square of the image, divided by 2 pi^2; dividing it by the sine
+        // of the latitude gives the solid angle density.
+        float density;
+    };
+
+    size_t texelIndex(int x, int y) const
+    {
+        size_t tile = static_cast<size_t>(y / TILE_SIZE) * m_tilesPerRow +
+                      x / TILE_SIZE;
+
+        return tile * TILE_SIZE * TILE_SIZE + (y % TILE_SIZE) * TILE_SIZE +
+               x % TILE_SIZE;
+    }
+
+    // Maps a unit direction to image coordinates in [0, 1) and the sine of
+    // its latitude.
+    void toImage(const Vector3& direction, float& u, float& v,
+                 float& sinTheta) const;
+
+    int m_width;
+    int m_height;
+    int m_tilesPerRow;
+    float m_rotation;
+
+    // Rotation in radians.
+    float m_phiOffset;
+
+    std::vector<Texel> m_texels;
+
+    // Cumulative distributions over the columns of every row (width + 1
+    // values per row, row after row) and over the rows (height + 1 values),
+    // each running from 0 to 1.
+    std::vector<float> m_conditionalCdf;
+    std::vector<float> m_marginalCdf;
+
+    // Mean of the sampling function over the image.
+    float m_integral;
+};
@@ -0,0 +1,174 @@
+#include "lightSet.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "../Math/utilities.h"
+#include "../Sampling/warp.h"
+
+void LightSet::build(const SphereSoA& spheres,
+                     const std::vector<MaterialData>& materials)
+{
+    m_center.clear();
+    m_motion.clear();
+    m_radius.clear();
+    m_sphereLight.assign(spheres.count, NO_LIGHT);
+    m_probability.clear();
+    m_cdf.clear();
+
+    float totalPower = 0.0f;
+
+    for (uint32_t i = 0; i < spheres.count; ++i)
+    {
+        const MaterialData& material = materials[spheres.materialIndex[i]];
+        const Color& emission = material.emission;
+
+        // Power is proportional to the surface area times the radiance.
+        float power = (emission.x() + emission.y() + emission.z()) *
+                      spheres.radius[i] * spheres.radius[i];
+
+        if (material.type != MaterialType::Emissive || !(power > 0.0f))
+        {
+            continue;
+        }
+
+        m_sphereLight[i] = size();
+        m_center.push_back(Point3(spheres.centerX[i], spheres.centerY[i],
+                                  spheres.centerZ[i]));
+        m_motion.push_back(Vector3(spheres.motionX[i], spheres.motionY[i],
+                                   spheres.motionZ[i]));
+        m_radius.push_back(spheres.radius[i]);
+        m_probability.push_back(power);
+
+        totalPower += power;
+    }
+
+    float sum = 0.0f;
+
+    for (float& probability : m_probability)
+    {
+        probability /= totalPower;
+        sum += probability;
+        m_cdf.push_back(sum);
+    }
+
+    updateEnvironmentProbability();
+}
+
+void LightSet::setEnvironment(const Environment* environment)
+{
+    m_environment = environment;
+    updateEnvironmentProbability();
+}
+
+void LightSet::updateEnvironmentProbability()
+{
+    if (!m_environment || !m_environment->canSample())
+    {
+        m_environmentProbability = 0.0f;
+    }
+    else
+    {
+        m_environmentProbability = m_radius.empty() ? 1.0f : 0.5f;
+    }
+}
+
+bool LightSet::cone(uint32_t light, const Point3& p, float time,
+                    Vector3& axis, float& distance,
+                    float& oneMinusCosThetaMax) const
+{
+    Vector3 toCenter = m_center[light] + time * m_motion[light] - p;
+    float distanceSquared = toCenter.magnitudeSquared();
+    float radiusSquared = m_radius[light] * m_radius[light];
+
+    if (distanceSquared <= radiusSquared)
+    {
+        return false;
+    }
+
+    distance = std::sqrt(distanceSquared);
+    axis = toCenter / distance;
+
+    // 1 - cos written without the cancellation of small angles.
+    float sinSquared = radiusSquared / distanceSquared;
+    oneMinusCosThetaMax = sinSquared /
+                          (1.0f + std::sqrt(1.0f - sinSquared));
+
+    return true;
+}
+
+float LightSet::conePdf(uint32_t light, float oneMinusCosThetaMax) const
+{
+    return (1.0f - m_environmentProbability) * m_probability[light] /
+           (2.0f * PI * oneMinusCosThetaMax);
+}
+
+bool LightSet::sample(const Point3& p, float time, float lightSample,
+                      const Point2& u, Vector3& direction, float& pdf,
+                      uint32_t& light) const
+{
+    if (lightSample < m_environmentProbability)
+    {
+        if (!m_environment->sample(u, direction, pdf))
+        {
+            return false;
+        }
+
+        light = NO_LIGHT;
+        pdf = environmentPdf(direction);
+
+        return pdf > 0.0f;
+    }
+
+    if (m_radius.empty())
+    {
+        return false;
+    }
+
+    // Reuse the rest of the light sample to pick a sphere.
+    lightSample = (lightSample - m_environmentProbability) /
+                  (1.0f - m_environmentProbability);
+
+    light = static_cast<uint32_t>(
+            std::upper_bound(m_cdf.begin(), m_cdf.end(), lightSample) -
+            m_cdf.begin());
+    light = std::min(light, size() - 1);
+
+    Vector3 axis;
+    float distance, oneMinusCosThetaMax;
+
+    if (!cone(light, p, time, axis, distance, oneMinusCosThetaMax))
+    {
+        return false;
+    }
+
+    Vector3 local = sampleUniformCone(u, oneMinusCosThetaMax);
+    Vector3 tangent, bitangent;
+    orthonormalBasis(axis, tangent, bitangent);
+
+    direction = local.x() * tangent + local.y() * bitangent +
+                local.z() * axis;
+    pdf = conePdf(light, oneMinusCosThetaMax);
+
+    return pdf > 0.0f;
+}
+
+float LightSet::pdf(const Point3& p, float time, uint32_t light) const
+{
+    Vector3 axis;
+    float distance, oneMinusCosThetaMax;
+
+    if (light == NO_LIGHT ||
+        !cone(light, p, time, axis, distance, oneMinusCosThetaMax))
+    {
+        return 0.0f;
+    }
+
+    return conePdf(light, oneMinusCosThetaMax);
+}
+
+float LightSet::environmentPdf(const Vector3& direction) const
+{
+    return m_environmentProbability > 0.0f ?
+           m_environmentProbability * m_environment->pdf(direction) : 0.0f;
+}
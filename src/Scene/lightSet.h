@@ -0,0 +1,104 @@
+/*
+ * This class samples directions towards the emissive spheres of a scene, so
+ * paths can connect to small lights with a shadow ray instead of having to
+ * hit them by chance. A light is picked with a probability proportional to
+ * its power, then a direction within the cone the sphere subtends is picked
+ * uniformly.
+ *
+ * A direction only counts towards the density of the light it was sampled
+ * from: a shadow ray takes the light of the light it aims at and of no
+ * other, and a path that hits a light by scattering weighs it against that
+ * light's density alone (see HitRecord::light). Either costs the same for
+ * any number of lights. Emitters that are not spheres (meshes) are never
+ * sampled; paths still find them by scattering.
+ *
+ * An environment map is one more light: it is picked with probability 1/2
+ * beside the spheres (or always without them) and samples directions by
+ * its luminance. Its shadow rays take its light if they leave the scene.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "../Geometry/sphereKernels.h"
+#include "../Hittables/hittable.h"
+#include "../Materials/materialData.h"
+#include "environment.h"
+#include "../Math/point2.h"
+#include "../Math/vector3.h"
+
+class LightSet
+{
+public:
+    // Collects the spheres whose material emits light, numbered in their
+    // order in spheres.
+    void build(const SphereSoA& spheres,
+               const std::vector<MaterialData>& materials);
+
+    // Samples the environment too, unless it is null or black. The
+    // environment must outlive the light set.
+    void setEnvironment(const Environment* environment);
+
+    bool empty() const
+    {
+        return m_radius.empty() && m_environmentProbability == 0.0f;
+    }
+
+    // Number of emissive spheres.
+    uint32_t size() const { return static_cast<uint32_t>(m_radius.size()); }
+
+    // Returns the light of the sphere at the given index of the spheres the
+    // set was built from, or NO_LIGHT if it does not emit.
+    uint32_t sphereLight(uint32_t sphere) const
+    {
+        return m_sphereLight[sphere];
+    }
+
+    // Picks a direction from p at the given shutter time towards a light,
+    // using lightSample to choose the light and u to choose the direction.
+    // The light picked is stored in light, NO_LIGHT for the environment.
+    // Returns false if no light can be seen from p (it lies within them).
+    bool sample(const Point3& p, float time, float lightSample,
+                const Point2& u, Vector3& direction, float& pdf,
+                uint32_t& light) const;
+
+    // Returns the solid angle density with which sample picks a direction
+    // from p that hits the given light (0 for NO_LIGHT).
+    float pdf(const Point3& p, float time, uint32_t light) const;
+
+    // Returns the solid angle density with which sample picks the unit
+    // vector direction from the environment.
+    float environmentPdf(const Vector3& direction) const;
+
+private:
+    // Finds the cone of directions from p towards a light: its axis (unit
+    // length), distance to the center and 1 - cos of its half angle.
+    // Returns false if p lies within the light.
+    bool cone(uint32_t light, const Point3& p, float time, Vector3& axis,
+              float& distance, float& oneMinusCosThetaMax) const;
+
+    // Returns the density of picking a light and a direction within its
+    // cone, given 1 - cos of the cone's half angle.
+    float conePdf(uint32_t light, float oneMinusCosThetaMax) const;
+
+    void updateEnvironmentProbability();
+
+    // Emissive spheres.
+    std::vector<Point3> m_center;
+    std::vector<Vector3> m_motion;
+    std::vector<float> m_radius;
+
+    // Light of every sphere of the set, or NO_LIGHT.
+    std::vector<uint32_t> m_sphereLight;
+
+    // Probability of picking each light and their running sum.
+    std::vector<float> m_probability;
+    std::vector<float> m_cdf;
+
+    const Environment* m_environment = nullptr;
+
+    // Probability of sampling the environment instead of the spheres.
+    float m_environmentProbability = 0.0f;
+};
@@ -0,0 +1,144 @@
+#include "mappedFile.h"
+
+#include <iostream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string& path)
+{
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                              nullptr, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        std::cerr << "Could not open " << path << ".\n";
+
+        return false;
+    }
+
+    LARGE_INTEGER size;
+
+    if (!GetFileSizeEx(file, &size))
+    {
+        std::cerr << "Could not read the size of " << path << ".\n";
+        CloseHandle(file);
+
+        return false;
+    }
+
+    m_file = file;
+    m_size = static_cast<size_t>(size.QuadPart);
+
+    // Empty files cannot be mapped, but are valid (empty) input.
+    if (m_size == 0)
+    {
+        return true;
+    }
+
+    m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0,
+                                   nullptr);
+    m_data = m_mapping ? static_cast<const char*>(
+                             MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0)) :
+                         nullptr;
+#else
+    int file = ::open(path.c_str(), O_RDONLY);
+
+    if (file < 0)
+    {
+        std::cerr << "Could not open " << path << ".\n";
+
+        return false;
+    }
+
+    struct stat status;
+
+    if (fstat(file, &status) != 0)
+    {
+        std::cerr << "Could not read the size of " << path << ".\n";
+        ::close(file);
+
+        return false;
+    }
+
+    m_size = static_cast<size_t>(status.st_size);
+
+    if (m_size == 0)
+    {
+        ::close(file);
+
+        return true;
+    }
+
+    void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0);
+
+    // The mapping keeps the file alive on its own.
+    ::close(file);
+
+    if (data != MAP_FAILED)
+    {
+        // Scene files are read front to back.
+        madvise(data, m_size, MADV_SEQUENTIAL);
+        m_data = static_cast<const char*>(data);
+    }
+#endif
+
+    if (!m_data)
+    {
+        std::cerr << "Could not map " << path << " into memory.\n";
+        close();
+
+        return false;
+    }
+
+    return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+    if (m_data)
+    {
+        UnmapViewOfFile(m_data);
+    }
+
+    if (m_mapping)
+    {
+        CloseHandle(m_mapping);
+    }
+
+    if (m_file)
+    {
+        CloseHandle(m_file);
+    }
+
+    m_file = nullptr;
+    m_mapping = nullptr;
+#else
+    if (m_data)
+    {
+        munmap(const_cast<char*>(m_data), m_size);
+    }
+#endif
+
+    m_data = nullptr;
+    m_size = 0;
+}
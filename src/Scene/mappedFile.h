@@ -0,0 +1,42 @@
+/*
+ * This class maps a file read-only into memory, so large scene files can be
+ * read without copying them through stream buffers. The mapping lives as
+ * long as the object.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+class MappedFile
+{
+public:
+    // Default constructor (no file mapped).
+    MappedFile() {}
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Maps the file at path, replacing any previous mapping. Returns false
+    // and reports the error if the file cannot be opened or mapped.
+    bool open(const std::string& path);
+
+    // Unmaps the file.
+    void close();
+
+    const char* data() const { return m_data; }
+
+    size_t size() const { return m_size; }
+
+private:
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+
+#ifdef _WIN32
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#endif
+};
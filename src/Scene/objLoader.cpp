@@ -0,0 +1,405 @@
+#include "objLoader.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "mappedFile.h"
+#include "textParsing.h"
+#include "../Render/threadPool.h"
+
+namespace
+{
+    // Bytes per chunk; large enough that the per-chunk overhead vanishes.
+    const size_t OBJ_CHUNK_SIZE = 1 << 20;
+
+    // A contiguous range of whole lines and what the passes found in it.
+    struct ObjChunk
+    {
+        const char* begin;
+        const char* end;
+
+        // Counts of the first pass.
+        uint32_t vertexCount = 0;
+        uint32_t triangleCount = 0;
+        uint32_t lineCount = 0;
+
+        // Exclusive prefix sums of the counts of the preceding chunks.
+        uint32_t firstVertex = 0;
+        uint32_t firstTriangle = 0;
+        uint32_t firstLine = 0;
+
+        // First error of the chunk; errorLine is relative to the chunk.
+        uint32_t errorLine = 0;
+        std::string error;
+    };
+
+    bool isSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    // Finds the next whitespace separated word in [cursor, end). Returns
+    // false if there is none.
+    bool nextToken(const char*& cursor, const char* end, const char*& begin,
+                   const char*& tokenEnd)
+    {
+        while (cursor != end && isSpace(*cursor))
+        {
+            ++cursor;
+        }
+
+        if (cursor == end)
+        {
+            return false;
+        }
+
+        begin = cursor;
+
+        while (cursor != end && !isSpace(*cursor))
+        {
+            ++cursor;
+        }
+
+        tokenEnd = cursor;
+
+        return true;
+    }
+
+    // Returns the end of the line starting at begin, without the comment.
+    // next is set to the start of the following line.
+    const char* lineEnd(const char* begin, const char* end,
+                        const char*& next)
+    {
+        const char* newline = static_cast<const char*>(
+                                  std::memchr(begin, '\n', end - begin));
+
+        next = newline ? newline + 1 : end;
+
+        const char* stop = newline ? newline : end;
+        const char* comment = static_cast<const char*>(
+                                  std::memchr(begin, '#', stop - begin));
+
+        return comment ? comment : stop;
+    }
+
+    // Classifies a line by its first word.
+    enum class ObjStatement
+    {
+        Vertex,
+        Face,
+        Other
+    };
+
+    ObjStatement statement(const char*& cursor, const char* end)
+    {
+        const char* begin;
+        const char* tokenEnd;
+
+        if (!nextToken(cursor, end, begin, tokenEnd) ||
+            tokenEnd - begin != 1)
+        {
+            return ObjStatement::Other;
+        }
+
+        switch (*begin)
+        {
+        case 'v':
+            return ObjStatement::Vertex;
+        case 'f':
+            return ObjStatement::Face;
+        default:
+            return ObjStatement::Other;
+        }
+    }
+
+    // First pass: counts the lines, vertices and triangles of a chunk.
+    void countChunk(ObjChunk& chunk)
+    {
+        const char* line = chunk.begin;
+
+        while (line != chunk.end)
+        {
+            const char* next;
+            const char* end = lineEnd(line, chunk.end, next);
+            const char* cursor = line;
+
+            ++chunk.lineCount;
+
+            switch (statement(cursor, end))
+            {
+            case ObjStatement::Vertex:
+                ++chunk.vertexCount;
+                break;
+            case ObjStatement::Face:
+            {
+                const char* begin;
+                const char* tokenEnd;
+                uint32_t corners = 0;
+
+                while (nextToken(cursor, end, begin, tokenEnd))
+                {
+                    ++corners;
+                }
+
+                if (corners < 3)
+                {
+                    if (chunk.error.empty())
+                    {
+                        chunk.errorLine = chunk.lineCount;
+                        chunk.error = "a face needs at least 3 vertices";
+                    }
+                }
+                else
+                {
+                    chunk.triangleCount += corners - 2;
+                }
+
+                break;
+            }
+            case ObjStatement::Other:
+                break;
+            }
+
+            line = next;
+        }
+    }
+
+    // Parses the position index of a face corner ("i", "i/t", "i//n" or
+    // "i/t/n") and resolves it against the vertices defined so far.
+    bool parseCorner(const char* begin, const char* end,
+                     uint32_t verticesSoFar, uint32_t vertexCount,
+                     uint32_t& index)
+    {
+        const char* slash = std::find(begin, end, '/');
+        int value;
+
+        if (!parseInt(begin, slash, value) || value == 0)
+        {
+            return false;
+        }
+
+        // Negative indices count back from the latest vertex.
+        int64_t resolved = value > 0 ?
+                           static_cast<int64_t>(value) - 1 :
+                           static_cast<int64_t>(verticesSoFar) + value;
+
+        if (resolved < 0 || resolved >= vertexCount)
+        {
+            return false;
+        }
+
+        index = static_cast<uint32_t>(resolved);
+
+        return true;
+    }
+
+    // Second pass: parses a chunk into its slices of vertices and indices.
+    void parseChunk(ObjChunk& chunk, uint32_t vertexCount,
+                    std::vector<Point3>& vertices,
+                    std::vector<uint32_t>& indices)
+    {
+        const char* line = chunk.begin;
+        uint32_t vertex = chunk.firstVertex;
+        uint32_t* index = indices.data() + 3 * size_t(chunk.firstTriangle);
+        uint32_t lineNumber = 0;
+
+        auto fail = [&](const char* message)
+        {
+            chunk.errorLine = lineNumber;
+            chunk.error = message;
+        };
+
+        while (line != chunk.end)
+        {
+            const char* next;
+            const char* end = lineEnd(line, chunk.end, next);
+            const char* cursor = line;
+            const char* begin;
+            const char* tokenEnd;
+
+            ++lineNumber;
+
+            switch (statement(cursor, end))
+            {
+            case ObjStatement::Vertex:
+            {
+                // Extra values (w or vertex colors) are ignored.
+                float xyz[3];
+
+                for (float& value : xyz)
+                {
+                    if (!nextToken(cursor, end, begin, tokenEnd) ||
+                        !parseFloat(begin, tokenEnd, value))
+                    {
+                        fail("a vertex needs 3 coordinates");
+                        return;
+                    }
+                }
+
+                vertices[vertex++] = Point3(xyz[0], xyz[1], xyz[2]);
+                break;
+            }
+            case ObjStatement::Face:
+            {
+                uint32_t first = 0;
+                uint32_t previous = 0;
+                uint32_t corner = 0;
+
+                while (nextToken(cursor, end, begin, tokenEnd))
+                {
+                    uint32_t current;
+
+                    if (!parseCorner(begin, tokenEnd, vertex, vertexCount,
+                                     current))
+                    {
+                        fail("invalid or out of range vertex index");
+                        return;
+                    }
+
+                    if (corner == 0)
+                    {
+                        first = current;
+                    }
+                    else if (corner >= 2)
+                    {
+                        *index++ = first;
+                        *index++ = previous;
+                        *index++ = current;
+                    }
+
+                    previous = current;
+                    ++corner;
+                }
+
+                break;
+            }
+            case ObjStatement::Other:
+                break;
+            }
+
+            line = next;
+        }
+    }
+
+    // Reports the first error of the file, if any. Chunks are in file
+    // order, so the first chunk with an error holds it.
+    bool reportError(const std::vector<ObjChunk>& chunks,
+                     const std::string& path)
+    {
+        for (const ObjChunk& chunk : chunks)
+        {
+            if (!chunk.error.empty())
+            {
+                std::cerr << path << ':'
+                          << chunk.firstLine + chunk.errorLine << ": "
+                          << chunk.error << '\n';
+
+                return true;
+            }
+        }
+
+        return false;
+    }
+}
+
+bool loadObj(const std::string& path, std::vector<Point3>& vertices,
+             std::vector<uint32_t>& indices, int threadCount)
+{
+    MappedFile file;
+
+    if (!file.open(path))
+    {
+        return false;
+    }
+
+    const char* data = file.data();
+    size_t size = file.size();
+
+    // Cut the file into chunks of whole lines.
+    size_t chunkCount = std::max<size_t>(1, size / OBJ_CHUNK_SIZE);
+    std::vector<ObjChunk> chunks(chunkCount);
+    const char* begin = data;
+
+    for (size_t i = 0; i < chunkCount; ++i)
+    {
+        const char* end = data + size;
+
+        if (i + 1 < chunkCount)
+        {
+            end = std::max(begin, data + (i + 1) * size / chunkCount);
+
+            const char* newline = static_cast<const char*>(
+                                      std::memchr(end, '\n',
+                                                  data + size - end));
+
+            end = newline ? newline + 1 : data + size;
+        }
+
+        chunks[i].begin = begin;
+        chunks[i].end = end;
+        begin = end;
+    }
+
+    ThreadPool pool(chunkCount > 1 ? threadCount : 1);
+
+    pool.parallelFor(static_cast<uint32_t>(chunkCount),
+                     [&](uint32_t chunk, int)
+                     {
+                         countChunk(chunks[chunk]);
+                     });
+
+    uint64_t vertexCount = 0;
+    uint64_t triangleCount = 0;
+    uint32_t lineCount = 0;
+
+    for (ObjChunk& chunk : chunks)
+    {
+        chunk.firstVertex = static_cast<uint32_t>(vertexCount);
+        chunk.firstTriangle = static_cast<uint32_t>(triangleCount);
+        chunk.firstLine = lineCount;
+
+        vertexCount += chunk.vertexCount;
+        triangleCount += chunk.triangleCount;
+        lineCount += chunk.lineCount;
+    }
+
+    if (reportError(chunks, path))
+    {
+        return false;
+    }
+
+    // Indices are 32-bit, and so is every triangle slot.
+    if (vertexCount > UINT32_MAX || 3 * triangleCount > UINT32_MAX)
+    {
+        std::cerr << path << " has too many vertices or triangles.\n";
+        return false;
+    }
+
+    vertices.resize(static_cast<size_t>(vertexCount));
+    indices.resize(static_cast<size_t>(3 * triangleCount));
+
+    pool.parallelFor(static_cast<uint32_t>(chunkCount),
+                     [&](uint32_t chunk, int)
+                     {
+                         parseChunk(chunks[chunk],
+                                    static_cast<uint32_t>(vertexCount),
+                                    vertices, indices);
+                     });
+
+    if (reportError(chunks, path))
+    {
+        return false;
+    }
+
+    if (triangleCount == 0)
+    {
+        std::cerr << path << " has no faces.\n";
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,27 @@
+/*
+ * This file reads triangle meshes from Wavefront OBJ files. The file is
+ * memory-mapped and cut into chunks at line boundaries that are parsed in
+ * parallel: a first pass counts the vertices and triangles of every chunk,
+ * so the second pass can write each chunk straight into its slice of the
+ * output arrays.
+ *
+ * Only positions ('v') and faces ('f') are read. Faces with more than three
+ * vertices are split into triangle fans; texture and normal references
+ * (f 1/2/3, f 1//3) and negative (relative) indices are accepted, but
+ * texture coordinates and normals are ignored, as are groups, smoothing
+ * groups and materials.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../Math/vector3.h"
+
+// Loads the mesh at path into vertices and three indices (0-based) per
+// triangle, using threadCount threads (0 selects the hardware concurrency).
+// Errors are reported with their line number.
+bool loadObj(const std::string& path, std::vector<Point3>& vertices,
+             std::vector<uint32_t>& indices, int threadCount = 0);
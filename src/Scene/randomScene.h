@@ -0,0 +1,13 @@
+/*
+ * This file builds the demo scene of the renderer: a large glass, diffuse and
+ * metal sphere surrounded by a grid of small random spheres. The scene is
+ * drawn from the calling thread's random stream, so it is the same every
+ * time for the same stream state.
+ */
+
+#pragma once
+
+#include "../Hittables/hittableList.h"
+
+// Returns the demo scene.
+HittableList randomScene();
@@ -0,0 +1,458 @@
+#include "scene.h"
+
+#include <iostream>
+#include <unordered_map>
+#include <utility>
+
+#include "../Geometry/sphere.h"
+#include "../Hittables/instance.h"
+#include "../Materials/material.h"
+#include "../Math/color.h"
+#include "../Math/hash.h"
+#include "../Render/stats.h"
+
+namespace
+{
+    // Instances are costly to test (a ray transform and a bottom-level
+    // traversal), so top-level leaves stay small.
+    const int INSTANCE_LEAF_SIZE = 2;
+
+    // A refitted hierarchy whose cost grew beyond this factor of its cost
+    // when built is rebuilt.
+    const float REFIT_COST_LIMIT = 1.5f;
+
+    template <typename T>
+    uint64_t hashValues(const std::vector<T>& values, size_t count,
+                        uint64_t hash)
+    {
+        return contentHash(values.data(), count * sizeof(T), hash);
+    }
+
+    void appendVector(std::vector<float>& values, const Vector3& v)
+    {
+        values.push_back(v.x());
+        values.push_back(v.y());
+        values.push_back(v.z());
+    }
+}
+
+Scene::Scene() {}
+
+Scene::Scene(const HittableList& list)
+{
+    // Materials shared by several objects get a single table entry.
+    std::unordered_map<const Material*, uint32_t> materialIds;
+    std::unordered_map<const TriangleMesh*, uint32_t> meshIds;
+    size_t skipped = 0;
+
+    auto materialId = [&](const Material* material)
+    {
+        auto inserted = materialIds.emplace(
+                            material,
+                            static_cast<uint32_t>(m_materials.size()));
+
+        if (inserted.second)
+        {
+            addMaterial(material->data());
+        }
+
+        return inserted.first->second;
+    };
+
+    // Instances of the same mesh share one entry of the bottom level.
+    auto instance = [&](const std::shared_ptr<TriangleMesh>& mesh,
+                        const Transform& transform)
+    {
+        auto inserted = meshIds.emplace(
+                            mesh.get(),
+                            static_cast<uint32_t>(m_meshes.size()));
+
+        if (inserted.second)
+        {
+            addMesh(mesh);
+        }
+
+        addInstance(inserted.first->second, transform,
+                    materialId(mesh->material().get()));
+    };
+
+    for (const auto& object : list.objects())
+    {
+        if (const Sphere* sphere = dynamic_cast<const Sphere*>(object.get()))
+        {
+            m_spheres.add(sphere->center(), sphere->motion(),
+                          sphere->radius(),
+                          materialId(sphere->material().get()));
+        }
+        else if (auto mesh = std::dynamic_pointer_cast<TriangleMesh>(object))
+        {
+            instance(mesh, Transform());
+        }
+        else if (const Instance* placed =
+                     dynamic_cast<const Instance*>(object.get()))
+        {
+            auto instanced = std::dynamic_pointer_cast<TriangleMesh>(
+                                 placed->object());
+
+            if (instanced)
+            {
+                instance(instanced, placed->transform());
+            }
+            else
+            {
+                ++skipped;
+            }
+        }
+        else
+        {
+            ++skipped;
+        }
+    }
+
+    if (skipped > 0)
+    {
+        std::cerr << "Skipped " << skipped
+                  << " objects that are neither spheres nor meshes.\n";
+    }
+
+    build();
+}
+
+uint32_t Scene::addMaterial(const MaterialData& material)
+{
+    m_materials.push_back(material);
+
+    return static_cast<uint32_t>(m_materials.size() - 1);
+}
+
+void Scene::addSphere(const Point3& center, float radius, uint32_t materialId)
+{
+    m_spheres.add(center, Vector3(0.0f, 0.0f, 0.0f), radius, materialId);
+}
+
+void Scene::addSphere(const Point3& centerBegin, const Point3& centerEnd,
+                      float radius, uint32_t materialId)
+{
+    m_spheres.add(centerBegin, centerEnd - centerBegin, radius, materialId);
+}
+
+uint32_t Scene::addMesh(std::shared_ptr<TriangleMesh> mesh)
+{
+    m_meshes.push_back(std::move(mesh));
+
+    return static_cast<uint32_t>(m_meshes.size() - 1);
+}
+
+void Scene::addInstance(uint32_t mesh, const Transform& transform,
+                        uint32_t materialId)
+{
+    m_instanceSlots.push_back(static_cast<uint32_t>(m_instances.size()));
+    m_instances.push_back({mesh, materialId, transform});
+}
+
+void Scene::assignSpheres(SphereSoA spheres, std::vector<BVHNode> nodes)
+{
+    m_spheres.assign(std::move(spheres), std::move(nodes));
+    m_lights.build(m_spheres.spheres(), m_materials);
+}
+
+void Scene::assignInstanceTree(std::vector<BVHNode> nodes)
+{
+    m_instanceTree.assign(std::move(nodes),
+                          static_cast<uint32_t>(m_instances.size()));
+}
+
+void Scene::build()
+{
+    RT_STATS_TIMER(timer, StatsPhase::SceneBuild);
+
+    m_spheres.build();
+
+    std::vector<AABB> bounds;
+    bounds.reserve(m_instances.size());
+
+    for (const MeshInstance& instance : m_instances)
+    {
+        bounds.push_back(instance.transform.bounds(
+                             m_meshes[instance.mesh]->boundingBox()));
+    }
+
+    m_instanceTree.build(bounds, INSTANCE_LEAF_SIZE);
+
+    // Store the instances in leaf order so leaves index them directly.
+    const std::vector<uint32_t>& order = m_instanceTree.primitiveIndices();
+    std::vector<MeshInstance> ordered;
+    std::vector<uint32_t> newSlots(order.size());
+    ordered.reserve(m_instances.size());
+
+    for (uint32_t slot = 0; slot < order.size(); ++slot)
+    {
+        ordered.push_back(m_instances[order[slot]]);
+        newSlots[order[slot]] = slot;
+    }
+
+    m_instances.swap(ordered);
+
+    for (uint32_t& slot : m_instanceSlots)
+    {
+        slot = newSlots[slot];
+    }
+
+    m_sphereTreeCost = m_spheres.tree().cost();
+    m_instanceTreeCost = m_instanceTree.cost();
+
+    m_lights.build(m_spheres.spheres(), m_materials);
+}
+
+void Scene::setInstanceTransform(uint32_t instance,
+                                 const Transform& transform)
+{
+    m_instances[m_instanceSlots[instance]].transform = transform;
+}
+
+bool Scene::refit()
+{
+    RT_STATS_TIMER(timer, StatsPhase::SceneRefit);
+
+    // Scenes loaded from a cache were never built here; measure their
+    // hierarchies before the first refit instead.
+    if (m_sphereTreeCost == 0.0f && m_instanceTreeCost == 0.0f)
+    {
+        m_sphereTreeCost = m_spheres.tree().cost();
+        m_instanceTreeCost = m_instanceTree.cost();
+    }
+
+    m_spheres.refit();
+    m_instanceTree.refit(instanceBounds());
+    m_lights.build(m_spheres.spheres(), m_materials);
+
+    return m_spheres.tree().cost() <= REFIT_COST_LIMIT * m_sphereTreeCost &&
+           m_instanceTree.cost() <= REFIT_COST_LIMIT * m_instanceTreeCost;
+}
+
+std::vector<AABB> Scene::instanceBounds() const
+{
+    const std::vector<uint32_t>& order = m_instanceTree.primitiveIndices();
+    std::vector<AABB> bounds(m_instances.size());
+
+    for (uint32_t slot = 0; slot < m_instances.size(); ++slot)
+    {
+        const MeshInstance& instance = m_instances[slot];
+
+        bounds[order[slot]] = instance.transform.bounds(
+                                  m_meshes[instance.mesh]->boundingBox());
+    }
+
+    return bounds;
+}
+
+void Scene::setSkyIntensity(float intensity)
+{
+    m_skyIntensity = intensity;
+
+    // A dark sky is not worth any shadow rays.
+    m_lights.setEnvironment(m_skyIntensity > 0.0f ? m_environment.get() :
+                                                    nullptr);
+}
+
+void Scene::setEnvironment(std::shared_ptr<const Environment> environment)
+{
+    m_environment = std::move(environment);
+    setSkyIntensity(m_skyIntensity);
+}
+
+Color Scene::background(const Ray& r) const
+{
+    if (m_environment)
+    {
+        return m_skyIntensity * m_environment->lookup(r.direction());
+    }
+
+    return m_skyIntensity * skyColor(r);
+}
+
+bool Scene::hit(const Ray& r, Interval ray_t, HitRecord& rec) const
+{
+    GeometryType nearestType = GeometryType::Sphere;
+    uint32_t nearest = 0;
+    float closestSoFar = ray_t.max;
+    bool wasHit = false;
+
+    // Each primitive type only narrows the interval; shading information is
+    // computed once, for the nearest hit.
+    uint32_t sphere;
+    float tHit;
+
+    if (m_spheres.intersect(r, Interval(ray_t.min, closestSoFar), sphere,
+                            tHit))
+    {
+        nearestType = GeometryType::Sphere;
+        nearest = sphere;
+        closestSoFar = tHit;
+        wasHit = true;
+    }
+
+    // Instances narrow the interval further through the top-level BVH.
+    uint32_t nearestInstance = 0;
+
+    m_instanceTree.traverse(
+        r, Interval(ray_t.min, closestSoFar),
+        [&](uint32_t first, uint32_t count, Interval range,
+            float& closest)
+        {
+            bool found = false;
+
+            for (uint32_t i = first; i < first + count; ++i)
+            {
+                const MeshInstance& instance = m_instances[i];
+                uint32_t triangle;
+
+                if (m_meshes[instance.mesh]->intersect(
+                        instance.transform.toObject(r),
+                        Interval(range.min, closest), triangle, tHit))
+                {
+                    nearestType = GeometryType::Triangle;
+                    nearestInstance = i;
+                    nearest = triangle;
+                    closest = tHit;
+                    closestSoFar = tHit;
+                    wasHit = true;
+                    found = true;
+                }
+            }
+
+            return found;
+        });
+
+    if (!wasHit)
+    {
+        return false;
+    }
+
+    uint32_t materialId = 0;
+
+    switch (nearestType)
+    {
+    case GeometryType::Sphere:
+        materialId = m_spheres.surface(r, nearest, closestSoFar, rec);
+        rec.light = m_lights.sphereLight(nearest);
+        break;
+    case GeometryType::Triangle:
+    {
+        const MeshInstance& instance = m_instances[nearestInstance];
+
+        // Shade in object space, then move the point and normal back; the
+        // normal keeps facing against the ray.
+        m_meshes[instance.mesh]->surface(instance.transform.toObject(r),
+                                         nearest, closestSoFar, rec);
+        rec.p = r.at(closestSoFar);
+        rec.normal = unitVector(instance.transform.normal(rec.normal));
+        materialId = instance.materialId;
+        rec.light = NO_LIGHT;
+        break;
+    }
+    }
+
+    rec.material = &m_materials[materialId];
+
+    return true;
+}
+
+bool Scene::setKernel(SphereKernel kernel)
+{
+    if (!m_spheres.setKernel(kernel))
+    {
+        return false;
+    }
+
+    for (const auto& mesh : m_meshes)
+    {
+        mesh->setKernel(kernel);
+    }
+
+    return true;
+}
+
+AABB Scene::boundingBox() const
+{
+    if (m_instances.empty())
+    {
+        return m_spheres.boundingBox();
+    }
+
+    return AABB(m_spheres.boundingBox(), m_instanceTree.bounds());
+}
+
+uint64_t Scene::contentHash() const
+{
+    std::vector<float> values;
+    values.push_back(m_skyIntensity);
+
+    for (const MaterialData& material : m_materials)
+    {
+        values.push_back(static_cast<float>(material.type));
+        appendVector(values, material.albedo);
+        values.push_back(material.fuzz);
+        values.push_back(material.refractionIndex);
+        appendVector(values, material.emission);
+    }
+
+    uint64_t hash = hashValues(values, values.size(), FNV_OFFSET);
+
+    // Sphere arrays are padded past the last sphere.
+    const SphereSoA& spheres = m_spheres.spheres();
+    uint32_t count = spheres.count;
+
+    for (const std::vector<float>* array :
+         {&spheres.centerX, &spheres.centerY, &spheres.centerZ,
+          &spheres.radius, &spheres.motionX, &spheres.motionY,
+          &spheres.motionZ})
+    {
+        hash = hashValues(*array, count, hash);
+    }
+
+    hash = hashValues(spheres.materialIndex, count, hash);
+
+    for (const std::shared_ptr<TriangleMesh>& mesh : m_meshes)
+    {
+        values.clear();
+
+        for (const Point3& vertex : mesh->vertices())
+        {
+            appendVector(values, vertex);
+        }
+
+        hash = hashValues(values, values.size(), hash);
+        hash = hashValues(mesh->indices(), mesh->indices().size(), hash);
+    }
+
+    for (const MeshInstance& instance : m_instances)
+    {
+        uint32_t ids[2] = {instance.mesh, instance.materialId};
+        float matrix[12];
+        instance.transform.rows(matrix);
+
+        hash = ::contentHash(ids, sizeof(ids), hash);
+        hash = ::contentHash(matrix, sizeof(matrix), hash);
+    }
+
+    if (m_environment)
+    {
+        values.clear();
+        values.push_back(static_cast<float>(m_environment->width()));
+        values.push_back(static_cast<float>(m_environment->height()));
+        values.push_back(m_environment->rotation());
+
+        for (int y = 0; y < m_environment->height(); ++y)
+        {
+            for (int x = 0; x < m_environment->width(); ++x)
+            {
+                appendVector(values, m_environment->texel(x, y));
+            }
+        }
+
+        hash = hashValues(values, values.size(), hash);
+    }
+
+    return hash;
+}
@@ -0,0 +1,195 @@
+/*
+ * This class holds a render-ready scene in a data-oriented layout: materials
+ * live in one flat table referenced by 32-bit indices and geometry is kept
+ * in typed arrays, one per primitive type. Intersection and shading dispatch
+ * over this closed set of types directly, without virtual calls or
+ * reference-counted pointers on the hot path.
+ *
+ * Triangle meshes are instanced in two levels: every unique mesh keeps its
+ * own BVH (the bottom level), and a top-level BVH over the transformed
+ * bounds of the instances decides which meshes a ray has to visit. Memory
+ * therefore grows with the unique geometry, not with the instance count.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "../Geometry/sphereKernels.h"
+#include "../Geometry/sphereSet.h"
+#include "../Geometry/triangleMesh.h"
+#include "../Hittables/bvh.h"
+#include "../Hittables/hittable.h"
+#include "../Hittables/hittableList.h"
+#include "../Materials/materialData.h"
+#include "../Math/aabb.h"
+#include "../Math/interval.h"
+#include "../Math/ray.h"
+#include "../Math/transform.h"
+#include "../Math/vector3.h"
+#include "environment.h"
+#include "lightSet.h"
+
+// Every kind of primitive a Scene stores.
+enum class GeometryType : uint8_t
+{
+    Sphere,
+    Triangle
+};
+
+// A placement of a shared mesh.
+struct MeshInstance
+{
+    // Index into Scene::meshes().
+    uint32_t mesh;
+
+    uint32_t materialId;
+
+    // Object to world transform.
+    Transform transform;
+};
+
+class Scene
+{
+public:
+    // Default constructor (an empty scene).
+    Scene();
+
+    // Converts a scene assembled from Hittable and Material objects. Only
+    // spheres, triangle meshes and instances of triangle meshes are
+    // supported; other objects are reported and skipped.
+    Scene(const HittableList& list);
+
+    // Appends a material to the table and returns its index.
+    uint32_t addMaterial(const MaterialData& material);
+
+    // Adds a stationary sphere.
+    void addSphere(const Point3& center, float radius, uint32_t materialId);
+
+    // Adds a sphere moving from centerBegin to centerEnd over the shutter
+    // interval.
+    void addSphere(const Point3& centerBegin, const Point3& centerEnd,
+                   float radius, uint32_t materialId);
+
+    // Adds a triangle mesh to the geometry that instances refer to and
+    // returns its index. The mesh is shared, not copied, and keeps its own
+    // BVH; it is not rendered until it is instanced.
+    uint32_t addMesh(std::shared_ptr<TriangleMesh> mesh);
+
+    // Places mesh (an index returned by addMesh()) with the given transform
+    // and material.
+    void addInstance(uint32_t mesh, const Transform& transform,
+                     uint32_t materialId);
+
+    // Adopts spheres and their BVH built earlier (see SphereSet::assign()).
+    void assignSpheres(SphereSoA spheres, std::vector<BVHNode> nodes);
+
+    // Adopts a top-level BVH built earlier (e.g. loaded from a scene cache)
+    // whose leaves reference the instances in the order they were added.
+    void assignInstanceTree(std::vector<BVHNode> nodes);
+
+    // Builds the acceleration structures. Must be called after the last
+    // primitive was added and before the scene is rendered.
+    void build();
+
+    // Replaces the transform of an instance, by the order instances were
+    // added in. The scene must be refitted or rebuilt before it is
+    // rendered again.
+    void setInstanceTransform(uint32_t instance, const Transform& transform);
+
+    // Updates the acceleration structures after spheres (see
+    // SphereSet::setCenter()) or instances moved, keeping their hierarchies.
+    // Returns false if a hierarchy got so much worse than when it was built
+    // that the scene should be rebuilt instead.
+    bool refit();
+
+    // Finds the nearest primitive hit by the ray within ray_t and fills the
+    // record with its surface and material.
+    bool hit(const Ray& r, Interval ray_t, HitRecord& rec) const;
+
+    const MaterialData& material(uint32_t materialId) const
+    {
+        return m_materials[materialId];
+    }
+
+    const std::vector<MaterialData>& materials() const { return m_materials; }
+
+    SphereSet& spheres() { return m_spheres; }
+    const SphereSet& spheres() const { return m_spheres; }
+
+    const std::vector<std::shared_ptr<TriangleMesh>>& meshes() const
+    {
+        return m_meshes;
+    }
+
+    // Instances in top-level BVH leaf order once the scene is built.
+    const std::vector<MeshInstance>& instances() const { return m_instances; }
+
+    const BVHTree& instanceTree() const { return m_instanceTree; }
+
+    // Scales the sky (or environment) that lights the scene (0 for a scene
+    // lit only by its emitters).
+    void setSkyIntensity(float intensity);
+
+    float skyIntensity() const { return m_skyIntensity; }
+
+    // Replaces the sky gradient with an environment map, which is sampled
+    // like the emitters (null restores the gradient).
+    void setEnvironment(std::shared_ptr<const Environment> environment);
+
+    const std::shared_ptr<const Environment>& environment() const
+    {
+        return m_environment;
+    }
+
+    // Returns the light arriving along a ray that leaves the scene.
+    Color background(const Ray& r) const;
+
+    // Emissive spheres and the environment, for light sampling. Updated by
+    // build(), refit() and assignSpheres().
+    const LightSet& lights() const { return m_lights; }
+
+    // Selects the intersection kernel of every primitive type. Returns false
+    // (and changes nothing) if the CPU does not support it.
+    bool setKernel(SphereKernel kernel);
+
+    // Returns a box enclosing every primitive of the scene.
+    AABB boundingBox() const;
+
+    // Hash of everything the image depends on: materials, spheres, meshes,
+    // instances, the sky and the environment. Vectors are hashed by their
+    // components, so it agrees across machines and vector backends.
+    uint64_t contentHash() const;
+
+private:
+    std::vector<MaterialData> m_materials;
+
+    SphereSet m_spheres;
+
+    // Unique meshes (the bottom level) and their placements.
+    std::vector<std::shared_ptr<TriangleMesh>> m_meshes;
+    std::vector<MeshInstance> m_instances;
+
+    // Top-level BVH over the world bounds of the instances.
+    BVHTree m_instanceTree;
+
+    LightSet m_lights;
+
+    float m_skyIntensity = 1.0f;
+
+    std::shared_ptr<const Environment> m_environment;
+
+    // Slot in m_instances of every instance, in the order they were added.
+    std::vector<uint32_t> m_instanceSlots;
+
+    // SAH costs of the hierarchies when they were built (0 until known),
+    // against which refitted hierarchies are measured.
+    float m_sphereTreeCost = 0.0f;
+    float m_instanceTreeCost = 0.0f;
+
+    // World bounds of the instances, indexed like the bounds passed to
+    // m_instanceTree.build().
+    std::vector<AABB> instanceBounds() const;
+};
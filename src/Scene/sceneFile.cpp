@@ -0,0 +1,1321 @@
+#include "sceneFile.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "animation.h"
+#include "environment.h"
+#include "mappedFile.h"
+#include "objLoader.h"
+#include "scene.h"
+#include "textParsing.h"
+#include "../Geometry/sphereKernels.h"
+#include "../Geometry/triangleMesh.h"
+#include "../Hittables/bvh.h"
+#include "../Materials/materialData.h"
+#include "../Math/aabb.h"
+#include "../Math/transform.h"
+#include "../Math/vector3.h"
+#include "../Render/framebuffer.h"
+#include "../Render/imageReader.h"
+
+namespace
+{
+    const char SCENE_CACHE_MAGIC[4] = {'R', 'T', 'S', 'C'};
+    const uint32_t SCENE_CACHE_VERSION = 5;
+
+    // Most values a statement may have (the camera has 12, and a mesh or
+    // mesh key as many as its transform steps need).
+    const int MAX_TOKENS = 32;
+
+    // A word of the input; points into the mapped file.
+    struct Token
+    {
+        const char* begin;
+        const char* end;
+
+        bool operator==(const char* text) const
+        {
+            size_t length = std::strlen(text);
+
+            return static_cast<size_t>(end - begin) == length &&
+                   std::memcmp(begin, text, length) == 0;
+        }
+
+        std::string str() const { return std::string(begin, end); }
+    };
+
+    // Resolves a path found in the scene file at scenePath; relative paths
+    // are relative to the directory of the scene file.
+    std::string resolvePath(const std::string& scenePath,
+                            const std::string& path)
+    {
+        bool absolute = (!path.empty() &&
+                         (path[0] == '/' || path[0] == '\\')) ||
+                        (path.size() > 1 && path[1] == ':');
+        size_t separator = scenePath.find_last_of("/\\");
+
+        if (absolute || separator == std::string::npos)
+        {
+            return path;
+        }
+
+        return scenePath.substr(0, separator + 1) + path;
+    }
+
+    // Reads a text scene in one pass over the mapped file. Tokens point into
+    // the mapping, so no line is ever copied.
+    class SceneParser
+    {
+    public:
+        SceneParser(const char* data, size_t size, const std::string& path,
+                    Scene& scene, SceneSettings& settings,
+                    Animation* animation) :
+                    m_cursor(data), m_end(data + size), m_path(path),
+                    m_scene(scene), m_settings(settings),
+                    m_animation(animation) {}
+
+        bool parse()
+        {
+            while (nextLine())
+            {
+                if (m_tokenCount > 0 && !parseStatement())
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+    private:
+        // Splits the next line into tokens, dropping comments. Returns
+        // false at the end of the input.
+        bool nextLine()
+        {
+            if (m_cursor == m_end)
+            {
+                return false;
+            }
+
+            ++m_line;
+            m_tokenCount = 0;
+            m_tooManyTokens = false;
+
+            while (m_cursor != m_end && *m_cursor != '\n')
+            {
+                char c = *m_cursor;
+
+                if (c == ' ' || c == '\t' || c == '\r')
+                {
+                    ++m_cursor;
+                }
+                else if (c == '#')
+                {
+                    while (m_cursor != m_end && *m_cursor != '\n')
+                    {
+                        ++m_cursor;
+                    }
+                }
+                else
+                {
+                    const char* begin = m_cursor;
+
+                    while (m_cursor != m_end && *m_cursor != ' ' &&
+                           *m_cursor != '\t' && *m_cursor != '\r' &&
+                           *m_cursor != '\n' && *m_cursor != '#')
+                    {
+                        ++m_cursor;
+                    }
+
+                    if (m_tokenCount == MAX_TOKENS)
+                    {
+                        m_tooManyTokens = true;
+                    }
+                    else
+                    {
+                        m_tokens[m_tokenCount++] = Token{begin, m_cursor};
+                    }
+                }
+            }
+
+            if (m_cursor != m_end)
+            {
+                ++m_cursor;
+            }
+
+            return true;
+        }
+
+        // Reports an error at the current line and returns false.
+        bool error(const std::string& message) const
+        {
+            std::cerr << m_path << ':' << m_line << ": " << message << '\n';
+
+            return false;
+        }
+
+        // Checks that the statement has exactly count tokens.
+        bool expectTokens(int count) const
+        {
+            if (m_tooManyTokens || m_tokenCount != count)
+            {
+                return error("'" + m_tokens[0].str() + "' expects " +
+                             std::to_string(count - 1) + " values");
+            }
+
+            return true;
+        }
+
+        bool readFloat(int index, float& value) const
+        {
+            if (!::parseFloat(m_tokens[index].begin, m_tokens[index].end,
+                              value))
+            {
+                return error("'" + m_tokens[index].str() +
+                             "' is not a number");
+            }
+
+            return true;
+        }
+
+        bool readInt(int index, int& value) const
+        {
+            if (!::parseInt(m_tokens[index].begin, m_tokens[index].end,
+                            value))
+            {
+                return error("'" + m_tokens[index].str() +
+                             "' is not an integer");
+            }
+
+            return true;
+        }
+
+        bool readVector(int index, Vector3& v) const
+        {
+            float x, y, z;
+
+            if (!readFloat(index, x) || !readFloat(index + 1, y) ||
+                !readFloat(index + 2, z))
+            {
+                return false;
+            }
+
+            v = Vector3(x, y, z);
+
+            return true;
+        }
+
+        bool parseStatement()
+        {
+            const Token& keyword = m_tokens[0];
+
+            // Spheres come first: large scenes consist of little else.
+            if (keyword == "sphere")
+            {
+                return parseSphere();
+            }
+            else if (keyword == "material")
+            {
+                return parseMaterial();
+            }
+            else if (keyword == "mesh")
+            {
+                return parseMesh();
+            }
+            else if (keyword == "camera")
+            {
+                return parseCamera();
+            }
+            else if (keyword == "key")
+            {
+                return parseKey();
+            }
+            else if (keyword == "frames")
+            {
+                return parseFrames();
+            }
+            else if (keyword == "sky")
+            {
+                float intensity;
+
+                if (!expectTokens(2) || !readFloat(1, intensity))
+                {
+                    return false;
+                }
+
+                if (intensity < 0.0f)
+                {
+                    return error("The sky intensity must not be negative");
+                }
+
+                m_scene.setSkyIntensity(intensity);
+
+                return true;
+            }
+            else if (keyword == "environment")
+            {
+                return parseEnvironment();
+            }
+            else if (keyword == "image")
+            {
+                return expectTokens(3) &&
+                       readInt(1, m_settings.imageWidth) &&
+                       readInt(2, m_settings.imageHeight) &&
+                       ((m_settings.imageWidth > 0 &&
+                         m_settings.imageHeight > 0) ||
+                        error("The image size must be positive"));
+            }
+            else if (keyword == "render")
+            {
+                return expectTokens(3) &&
+                       readInt(1, m_settings.samplesPerPixel) &&
+                       readInt(2, m_settings.maxDepth) &&
+                       ((m_settings.samplesPerPixel > 0 &&
+                         m_settings.maxDepth > 0) ||
+                        error("Samples and depth must be positive"));
+            }
+
+            return error("Unknown statement '" + keyword.str() + "'");
+        }
+
+        bool parseCamera()
+        {
+            return expectTokens(13) &&
+                   readVector(1, m_settings.lookFrom) &&
+                   readVector(4, m_settings.lookAt) &&
+                   readVector(7, m_settings.upVector) &&
+                   readFloat(10, m_settings.verticalFOV) &&
+                   readFloat(11, m_settings.defocusAngle) &&
+                   readFloat(12, m_settings.focusDistance);
+        }
+
+        bool parseMaterial()
+        {
+            if (m_tokenCount < 3)
+            {
+                return error("'material' expects a name and a type");
+            }
+
+            const Token& type = m_tokens[2];
+            MaterialData material;
+
+            if (type == "diffuse")
+            {
+                Color albedo;
+
+                if (!expectTokens(6) || !readVector(3, albedo))
+                {
+                    return false;
+                }
+
+                material = MaterialData::diffuse(albedo);
+            }
+            else if (type == "metal")
+            {
+                Color albedo;
+                float fuzz;
+
+                if (!expectTokens(7) || !readVector(3, albedo) ||
+                    !readFloat(6, fuzz))
+                {
+                    return false;
+                }
+
+                material = MaterialData::metal(albedo, fuzz);
+            }
+            else if (type == "glass")
+            {
+                float refractionIndex;
+
+                if (!expectTokens(4) || !readFloat(3, refractionIndex))
+                {
+                    return false;
+                }
+
+                material = MaterialData::glass(refractionIndex);
+            }
+            else if (type == "emissive")
+            {
+                Color emission;
+
+                if (!expectTokens(6) || !readVector(3, emission))
+                {
+                    return false;
+                }
+
+                material = MaterialData::emissive(emission);
+            }
+            else
+            {
+                return error("Unknown material type '" + type.str() + "'");
+            }
+
+            // Redeclaring a name rebinds it for the spheres that follow.
+            m_materials[m_tokens[1].str()] = m_scene.addMaterial(material);
+
+            return true;
+        }
+
+        bool parseSphere()
+        {
+            bool moving = m_tokenCount == 9;
+
+            if (!moving && !expectTokens(6))
+            {
+                return false;
+            }
+
+            Point3 center, centerEnd;
+            float radius;
+
+            if (!readVector(1, center) ||
+                (moving && !readVector(4, centerEnd)) ||
+                !readFloat(moving ? 7 : 4, radius))
+            {
+                return false;
+            }
+
+            const Token& name = m_tokens[moving ? 8 : 5];
+
+            // Reuse the key's buffer; consecutive spheres mostly differ in
+            // their material.
+            m_name.assign(name.begin, name.end);
+            auto material = m_materials.find(m_name);
+
+            if (material == m_materials.end())
+            {
+                return error("Unknown material '" + m_name + "'");
+            }
+
+            if (moving)
+            {
+                m_scene.addSphere(center, centerEnd, radius,
+                                  material->second);
+            }
+            else
+            {
+                m_scene.addSphere(center, radius, material->second);
+            }
+
+            return true;
+        }
+
+        // Reads the transform steps from token index to the end of the
+        // statement, each applied after the ones before it.
+        bool readSteps(int index, std::vector<TransformStep>& steps) const
+        {
+            steps.clear();
+
+            while (index < m_tokenCount)
+            {
+                const Token& token = m_tokens[index];
+                TransformStep step{TransformStepType::Translate, 0,
+                                   Vector3()};
+
+                if (token == "translate" && index + 3 < m_tokenCount)
+                {
+                    if (!readVector(index + 1, step.values))
+                    {
+                        return false;
+                    }
+
+                    index += 4;
+                }
+                else if (token == "rotate" && index + 2 < m_tokenCount)
+                {
+                    const Token& axis = m_tokens[index + 1];
+                    float degrees;
+
+                    if (!(axis == "x" || axis == "y" || axis == "z"))
+                    {
+                        return error("Unknown rotation axis '" + axis.str() +
+                                     "'");
+                    }
+
+                    if (!readFloat(index + 2, degrees))
+                    {
+                        return false;
+                    }
+
+                    step.type = TransformStepType::Rotate;
+                    step.axis = *axis.begin - 'x';
+                    step.values = Vector3(degrees, 0.0f, 0.0f);
+                    index += 3;
+                }
+                else if (token == "scale" && index + 1 < m_tokenCount)
+                {
+                    // One factor scales uniformly, three per axis.
+                    float value;
+                    bool uniform = index + 3 >= m_tokenCount ||
+                                   !::parseFloat(m_tokens[index + 2].begin,
+                                                 m_tokens[index + 2].end,
+                                                 value);
+                    Vector3& factor = step.values;
+
+                    if (uniform)
+                    {
+                        if (!readFloat(index + 1, value))
+                        {
+                            return false;
+                        }
+
+                        factor = Vector3(value, value, value);
+                        index += 2;
+                    }
+                    else
+                    {
+                        if (!readVector(index + 1, factor))
+                        {
+                            return false;
+                        }
+
+                        index += 4;
+                    }
+
+                    if (factor.x() == 0.0f || factor.y() == 0.0f ||
+                        factor.z() == 0.0f)
+                    {
+                        return error("Scale factors must not be zero");
+                    }
+
+                    step.type = TransformStepType::Scale;
+                }
+                else
+                {
+                    return error("Expected 'translate x y z', 'rotate "
+                                 "<axis> degrees' or 'scale s' instead of '" +
+                                 token.str() + "'");
+                }
+
+                steps.push_back(step);
+            }
+
+            return true;
+        }
+
+        bool parseFrames()
+        {
+            int frameCount;
+
+            if (!expectTokens(2) || !readInt(1, frameCount))
+            {
+                return false;
+            }
+
+            if (!m_animation)
+            {
+                return error("Animated scenes cannot be loaded here");
+            }
+
+            if (frameCount <= 0)
+            {
+                return error("The frame count must be positive");
+            }
+
+            if (m_keyCount > 0)
+            {
+                return error("'frames' must come before the keys");
+            }
+
+            m_animation->setFrameCount(frameCount);
+
+            return true;
+        }
+
+        // Reads the 0-based index of the sphere or mesh a key animates; the
+        // object must have been declared before the key.
+        bool readObject(int index, int count, const char* kind,
+                        uint32_t& object) const
+        {
+            int value;
+
+            if (!readInt(index, value))
+            {
+                return false;
+            }
+
+            if (value < 0 || value >= count)
+            {
+                return error("There is no " + std::string(kind) + " " +
+                             m_tokens[index].str() + " above this key");
+            }
+
+            object = static_cast<uint32_t>(value);
+
+            return true;
+        }
+
+        bool parseKey()
+        {
+            int frame;
+
+            if (m_tokenCount < 3 || !readInt(1, frame))
+            {
+                return error("'key' expects a frame and a target");
+            }
+
+            if (!m_animation)
+            {
+                return error("Animated scenes cannot be loaded here");
+            }
+
+            if (frame < 0 || frame >= m_animation->frameCount())
+            {
+                return error("Frame " + m_tokens[1].str() + " is outside "
+                             "the sequence (declare 'frames' first)");
+            }
+
+            const Token& target = m_tokens[2];
+            uint32_t object;
+
+            ++m_keyCount;
+
+            if (target == "camera")
+            {
+                Point3 lookFrom, lookAt;
+
+                if (!expectTokens(9) || !readVector(3, lookFrom) ||
+                    !readVector(6, lookAt))
+                {
+                    return false;
+                }
+
+                m_animation->addCameraKey(frame, lookFrom, lookAt);
+            }
+            else if (target == "sphere")
+            {
+                Point3 center;
+
+                if (!expectTokens(7) ||
+                    !readObject(3, static_cast<int>(m_scene.spheres().size()),
+                                "sphere", object) ||
+                    !readVector(4, center))
+                {
+                    return false;
+                }
+
+                m_animation->addSphereKey(object, frame, center);
+            }
+            else if (target == "mesh")
+            {
+                if (m_tooManyTokens || m_tokenCount < 4)
+                {
+                    return error("'key mesh' expects a mesh index and "
+                                 "optional transform steps");
+                }
+
+                if (!readObject(3, m_instanceCount, "mesh", object) ||
+                    !readSteps(4, m_steps))
+                {
+                    return false;
+                }
+
+                if (!m_animation->addInstanceKey(object, frame, m_steps))
+                {
+                    return error("The keys of a mesh must have the same "
+                                 "steps with the same rotation axes");
+                }
+            }
+            else
+            {
+                return error("Unknown key target '" + target.str() +
+                             "' (expected camera, sphere or mesh)");
+            }
+
+            return true;
+        }
+
+        bool parseMesh()
+        {
+            if (m_tooManyTokens || m_tokenCount < 3)
+            {
+                return error("'mesh' expects a path, a material and "
+                             "optional transform steps");
+            }
+
+            auto material = m_materials.find(m_tokens[2].str());
+
+            if (material == m_materials.end())
+            {
+                return error("Unknown material '" + m_tokens[2].str() + "'");
+            }
+
+            if (!readSteps(3, m_steps))
+            {
+                return false;
+            }
+
+            Transform transform = composeSteps(m_steps);
+
+            // A mesh placed several times is loaded and built only once;
+            // the placements are instances of it.
+            std::string path = resolvePath(m_path, m_tokens[1].str());
+            auto mesh = m_meshes.find(path);
+
+            if (mesh == m_meshes.end())
+            {
+                std::vector<Point3> vertices;
+                std::vector<uint32_t> indices;
+
+                if (!loadObj(path, vertices, indices))
+                {
+                    return error("Could not load mesh '" + path + "'");
+                }
+
+                uint32_t index = m_scene.addMesh(
+                                     std::make_shared<TriangleMesh>(
+                                         std::move(vertices),
+                                         std::move(indices)));
+
+                mesh = m_meshes.emplace(path, index).first;
+            }
+
+            m_scene.addInstance(mesh->second, transform, material->second);
+            ++m_instanceCount;
+
+            return true;
+        }
+
+        bool parseEnvironment()
+        {
+            float rotation = 0.0f;
+
+            if (m_tooManyTokens || m_tokenCount < 2 || m_tokenCount > 3)
+            {
+                return error("'environment' expects a path and an optional "
+                             "rotation");
+            }
+
+            if (m_tokenCount == 3 && !readFloat(2, rotation))
+            {
+                return false;
+            }
+
+            std::string path = resolvePath(m_path, m_tokens[1].str());
+            Framebuffer image;
+
+            if (!readImage(path, image))
+            {
+                return error("Could not load environment '" + path + "'");
+            }
+
+            m_scene.setEnvironment(std::make_shared<Environment>(image,
+                                                                 rotation));
+
+            return true;
+        }
+
+        const char* m_cursor;
+        const char* m_end;
+        const std::string& m_path;
+
+        Scene& m_scene;
+        SceneSettings& m_settings;
+
+        // Material indices by name.
+        std::unordered_map<std::string, uint32_t> m_materials;
+        std::string m_name;
+
+        // Indices of the loaded meshes by resolved path.
+        std::unordered_map<std::string, uint32_t> m_meshes;
+
+        // Keyframes of an animated scene; null if the caller takes none.
+        Animation* m_animation;
+        int m_keyCount = 0;
+        int m_instanceCount = 0;
+
+        // Buffer for the transform steps of the current line.
+        std::vector<TransformStep> m_steps;
+
+        // Tokens of the current line.
+        Token m_tokens[MAX_TOKENS];
+        int m_tokenCount = 0;
+        bool m_tooManyTokens = false;
+
+        int m_line = 0;
+    };
+
+    // Sequential reader over the mapped cache.
+    class CacheReader
+    {
+    public:
+        CacheReader(const char* data, size_t size) :
+                    m_cursor(data), m_end(data + size) {}
+
+        template <typename T>
+        bool read(T* values, size_t count)
+        {
+            size_t bytes = count * sizeof(T);
+
+            if (static_cast<size_t>(m_end - m_cursor) < bytes)
+            {
+                return false;
+            }
+
+            std::memcpy(values, m_cursor, bytes);
+            m_cursor += bytes;
+
+            return true;
+        }
+
+        template <typename T>
+        bool read(T& value)
+        {
+            return read(&value, 1);
+        }
+
+        bool atEnd() const { return m_cursor == m_end; }
+
+        size_t remaining() const { return m_end - m_cursor; }
+
+    private:
+        const char* m_cursor;
+        const char* m_end;
+    };
+
+    template <typename T>
+    void writeValues(std::ostream& out, const T* values, size_t count)
+    {
+        out.write(reinterpret_cast<const char*>(values),
+                  static_cast<std::streamsize>(count * sizeof(T)));
+    }
+
+    template <typename T>
+    void writeValue(std::ostream& out, const T& value)
+    {
+        writeValues(out, &value, 1);
+    }
+
+    void writeVector(std::ostream& out, const Vector3& v)
+    {
+        float values[3] = {v.x(), v.y(), v.z()};
+
+        writeValues(out, values, 3);
+    }
+
+    bool readCacheVector(CacheReader& reader, Vector3& v)
+    {
+        float values[3];
+
+        if (!reader.read(values, 3))
+        {
+            return false;
+        }
+
+        v = Vector3(values[0], values[1], values[2]);
+
+        return true;
+    }
+
+    void writeNodes(std::ostream& out, const std::vector<BVHNode>& nodes)
+    {
+        writeValue(out, static_cast<uint32_t>(nodes.size()));
+
+        for (const BVHNode& node : nodes)
+        {
+            float bounds[6] = {node.bounds.x.min, node.bounds.x.max,
+                               node.bounds.y.min, node.bounds.y.max,
+                               node.bounds.z.min, node.bounds.z.max};
+            uint8_t padding = 0;
+
+            writeValues(out, bounds, 6);
+            writeValue(out, node.offset);
+            writeValue(out, node.primitiveCount);
+            writeValue(out, node.axis);
+            writeValue(out, padding);
+        }
+    }
+
+    // Reads the nodes of a BVH over primitiveCount primitives. Returns false
+    // if the data is truncated or the tree is malformed.
+    bool readNodes(CacheReader& reader, uint32_t primitiveCount,
+                   std::vector<BVHNode>& nodes)
+    {
+        uint32_t nodeCount;
+
+        // Each node takes 32 bytes; bound the count before allocating.
+        if (!reader.read(nodeCount) || nodeCount > reader.remaining() / 32)
+        {
+            return false;
+        }
+
+        nodes.resize(nodeCount);
+
+        // Depth of every node below the root. Parents precede their
+        // children, so a node's depth is final once it is reached.
+        std::vector<uint8_t> depths(nodeCount, 0);
+
+        for (uint32_t i = 0; i < nodeCount; ++i)
+        {
+            float bounds[6] = {};
+            uint8_t padding;
+            BVHNode& node = nodes[i];
+
+            if (!reader.read(bounds, 6) || !reader.read(node.offset) ||
+                !reader.read(node.primitiveCount) ||
+                !reader.read(node.axis) || !reader.read(padding))
+            {
+                return false;
+            }
+
+            node.bounds = AABB(Interval(bounds[0], bounds[1]),
+                               Interval(bounds[2], bounds[3]),
+                               Interval(bounds[4], bounds[5]));
+
+            // Leaves must stay within the primitives and children must
+            // follow their parent, or traversal could run out of bounds.
+            bool valid = node.primitiveCount > 0 ?
+                         static_cast<uint64_t>(node.offset) +
+                         node.primitiveCount <= primitiveCount :
+                         node.offset > i && node.offset < nodeCount;
+
+            if (!valid)
+            {
+                return false;
+            }
+
+            // Traversal keeps a stack of BVHTree::MAX_DEPTH entries, so
+            // interior nodes may not reach that depth.
+            if (node.primitiveCount == 0)
+            {
+                if (depths[i] >= BVHTree::MAX_DEPTH)
+                {
+                    return false;
+                }
+
+                uint8_t childDepth = static_cast<uint8_t>(depths[i] + 1);
+                depths[i + 1] = std::max(depths[i + 1], childDepth);
+                depths[node.offset] = std::max(depths[node.offset],
+                                               childDepth);
+            }
+        }
+
+        return (nodeCount == 0) == (primitiveCount == 0);
+    }
+
+    // Writes the meshes of a scene, its instances and the top-level BVH.
+    void writeMeshes(std::ostream& out, const Scene& scene)
+    {
+        writeValue(out, static_cast<uint32_t>(scene.meshes().size()));
+
+        for (const auto& mesh : scene.meshes())
+        {
+            const std::vector<Point3>& vertices = mesh->vertices();
+            std::vector<float> coordinates;
+            coordinates.reserve(3 * vertices.size());
+
+            for (const Point3& vertex : vertices)
+            {
+                coordinates.push_back(vertex.x());
+                coordinates.push_back(vertex.y());
+                coordinates.push_back(vertex.z());
+            }
+
+            writeValue(out, static_cast<uint32_t>(vertices.size()));
+            writeValue(out, mesh->triangleCount());
+            writeValues(out, coordinates.data(), coordinates.size());
+            writeValues(out, mesh->indices().data(), mesh->indices().size());
+            writeNodes(out, mesh->tree().nodes());
+        }
+
+        writeValue(out, static_cast<uint32_t>(scene.instances().size()));
+
+        for (const MeshInstance& instance : scene.instances())
+        {
+            float matrix[12], inverse[12];
+            instance.transform.rows(matrix);
+            instance.transform.inverseRows(inverse);
+
+            writeValue(out, instance.mesh);
+            writeValue(out, instance.materialId);
+            writeValues(out, matrix, 12);
+            writeValues(out, inverse, 12);
+        }
+
+        writeNodes(out, scene.instanceTree().nodes());
+    }
+
+    bool readMeshes(CacheReader& reader, uint32_t materialCount,
+                    Scene& scene)
+    {
+        uint32_t meshCount;
+
+        // Every mesh takes at least 12 bytes.
+        if (!reader.read(meshCount) || meshCount > reader.remaining() / 12)
+        {
+            return false;
+        }
+
+        for (uint32_t i = 0; i < meshCount; ++i)
+        {
+            uint32_t vertexCount, triangleCount;
+
+            if (!reader.read(vertexCount) || !reader.read(triangleCount) ||
+                vertexCount > reader.remaining() / 12 ||
+                triangleCount > reader.remaining() / 12)
+            {
+                return false;
+            }
+
+            std::vector<float> coordinates(3 * size_t(vertexCount));
+            std::vector<uint32_t> indices(3 * size_t(triangleCount));
+            std::vector<BVHNode> nodes;
+
+            if (!reader.read(coordinates.data(), coordinates.size()) ||
+                !reader.read(indices.data(), indices.size()) ||
+                !readNodes(reader, triangleCount, nodes))
+            {
+                return false;
+            }
+
+            for (uint32_t index : indices)
+            {
+                if (index >= vertexCount)
+                {
+                    return false;
+                }
+            }
+
+            std::vector<Point3> vertices(vertexCount);
+
+            for (uint32_t v = 0; v < vertexCount; ++v)
+            {
+                vertices[v] = Point3(coordinates[3 * v],
+                                     coordinates[3 * v + 1],
+                                     coordinates[3 * v + 2]);
+            }
+
+            scene.addMesh(std::make_shared<TriangleMesh>(
+                              std::move(vertices), std::move(indices),
+                              std::move(nodes)));
+        }
+
+        uint32_t instanceCount;
+
+        // Every instance takes 104 bytes.
+        if (!reader.read(instanceCount) ||
+            instanceCount > reader.remaining() / 104)
+        {
+            return false;
+        }
+
+        for (uint32_t i = 0; i < instanceCount; ++i)
+        {
+            uint32_t mesh, materialId;
+            float matrix[12], inverse[12];
+
+            if (!reader.read(mesh) || !reader.read(materialId) ||
+                !reader.read(matrix, 12) || !reader.read(inverse, 12) ||
+                mesh >= meshCount || materialId >= materialCount)
+            {
+                return false;
+            }
+
+            // The stored inverse is used as is, so cached scenes trace the
+            // same rays as the text scene they came from.
+            Transform transform(matrix, inverse);
+
+            if (!transform.isInvertible())
+            {
+                return false;
+            }
+
+            scene.addInstance(mesh, transform, materialId);
+        }
+
+        std::vector<BVHNode> nodes;
+
+        if (!readNodes(reader, instanceCount, nodes))
+        {
+            return false;
+        }
+
+        scene.assignInstanceTree(std::move(nodes));
+
+        return true;
+    }
+
+    void writeEnvironment(std::ostream& out, const Scene& scene)
+    {
+        const Environment* environment = scene.environment().get();
+        int32_t size[2] = {environment ? environment->width() : 0,
+                           environment ? environment->height() : 0};
+
+        writeValues(out, size, 2);
+        writeValue(out, environment ? environment->rotation() : 0.0f);
+
+        std::vector<float> texels;
+        texels.reserve(3 * static_cast<size_t>(size[0]) * size[1]);
+
+        for (int y = 0; y < size[1]; ++y)
+        {
+            for (int x = 0; x < size[0]; ++x)
+            {
+                Color texel = environment->texel(x, y);
+
+                texels.push_back(texel.x());
+                texels.push_back(texel.y());
+                texels.push_back(texel.z());
+            }
+        }
+
+        writeValues(out, texels.data(), texels.size());
+    }
+
+    bool readEnvironment(CacheReader& reader, Scene& scene)
+    {
+        int32_t size[2];
+        float rotation;
+
+        if (!reader.read(size, 2) || !reader.read(rotation) ||
+            size[0] < 0 || size[1] < 0 ||
+            (size[0] == 0) != (size[1] == 0) ||
+            static_cast<uint64_t>(size[0]) * size[1] >
+            reader.remaining() / 12)
+        {
+            return false;
+        }
+
+        if (size[0] == 0)
+        {
+            return true;
+        }
+
+        std::vector<float> texels(3 * static_cast<size_t>(size[0]) *
+                                  size[1]);
+
+        if (!reader.read(texels.data(), texels.size()))
+        {
+            return false;
+        }
+
+        Framebuffer image(size[0], size[1]);
+
+        for (int y = 0; y < size[1]; ++y)
+        {
+            for (int x = 0; x < size[0]; ++x)
+            {
+                const float* texel = &texels[3 * (static_cast<size_t>(y) *
+                                                  size[0] + x)];
+
+                image.addSamples(x, y, Color(texel[0], texel[1], texel[2]),
+                                 1);
+            }
+        }
+
+        scene.setEnvironment(std::make_shared<Environment>(image, rotation));
+
+        return true;
+    }
+
+    bool loadSceneCache(const MappedFile& file, const std::string& path,
+                        Scene& scene, SceneSettings& settings)
+    {
+        CacheReader reader(file.data() + 4, file.size() - 4);
+        uint32_t version;
+        int32_t image[4];
+        SceneSettings loaded;
+        uint32_t materialCount, sphereCount;
+        float skyIntensity;
+
+        if (!reader.read(version) || version != SCENE_CACHE_VERSION ||
+            !reader.read(image, 4) ||
+            !readCacheVector(reader, loaded.lookFrom) ||
+            !readCacheVector(reader, loaded.lookAt) ||
+            !readCacheVector(reader, loaded.upVector) ||
+            !reader.read(loaded.verticalFOV) ||
+            !reader.read(loaded.defocusAngle) ||
+            !reader.read(loaded.focusDistance) ||
+            !reader.read(skyIntensity) ||
+            !reader.read(materialCount) || !reader.read(sphereCount))
+        {
+            std::cerr << path << " is not a valid scene cache.\n";
+
+            return false;
+        }
+
+        loaded.imageWidth = image[0];
+        loaded.imageHeight = image[1];
+        loaded.samplesPerPixel = image[2];
+        loaded.maxDepth = image[3];
+        scene.setSkyIntensity(skyIntensity);
+
+        for (uint32_t i = 0; i < materialCount; ++i)
+        {
+            uint32_t type;
+            MaterialData material;
+
+            if (!reader.read(type) || type >= MATERIAL_TYPE_COUNT ||
+                !readCacheVector(reader, material.albedo) ||
+                !reader.read(material.fuzz) ||
+                !reader.read(material.refractionIndex) ||
+                !readCacheVector(reader, material.emission))
+            {
+                std::cerr << path << " has invalid materials.\n";
+
+                return false;
+            }
+
+            material.type = static_cast<MaterialType>(type);
+            scene.addMaterial(material);
+        }
+
+        SphereSoA spheres;
+        spheres.resize(sphereCount);
+
+        bool complete =
+            reader.read(spheres.centerX.data(), sphereCount) &&
+            reader.read(spheres.centerY.data(), sphereCount) &&
+            reader.read(spheres.centerZ.data(), sphereCount) &&
+            reader.read(spheres.radius.data(), sphereCount) &&
+            reader.read(spheres.motionX.data(), sphereCount) &&
+            reader.read(spheres.motionY.data(), sphereCount) &&
+            reader.read(spheres.motionZ.data(), sphereCount) &&
+            reader.read(spheres.materialIndex.data(), sphereCount);
+
+        for (uint32_t i = 0; complete && i < sphereCount; ++i)
+        {
+            complete = spheres.materialIndex[i] < materialCount;
+        }
+
+        std::vector<BVHNode> nodes;
+
+        complete = complete && readNodes(reader, sphereCount, nodes) &&
+                   readMeshes(reader, materialCount, scene) &&
+                   readEnvironment(reader, scene);
+
+        if (!complete || !reader.atEnd())
+        {
+            std::cerr << path << " is truncated or corrupt.\n";
+
+            return false;
+        }
+
+        scene.assignSpheres(std::move(spheres), std::move(nodes));
+        settings = loaded;
+
+        return true;
+    }
+}
+
+void SceneSettings::resizeImage(int width, int height)
+{
+    if (width > 0 && height <= 0)
+    {
+        height = std::max(1, static_cast<int>(
+                             static_cast<int64_t>(width) * imageHeight /
+                             imageWidth));
+    }
+    else if (height > 0 && width <= 0)
+    {
+        width = std::max(1, static_cast<int>(
+                            static_cast<int64_t>(height) * imageWidth /
+                            imageHeight));
+    }
+
+    if (width > 0 && height > 0)
+    {
+        imageWidth = width;
+        imageHeight = height;
+    }
+}
+
+bool loadScene(const std::string& path, Scene& scene,
+               SceneSettings& settings, Animation* animation)
+{
+    MappedFile file;
+
+    if (!file.open(path))
+    {
+        return false;
+    }
+
+    if (file.size() >= 4 &&
+        std::memcmp(file.data(), SCENE_CACHE_MAGIC, 4) == 0)
+    {
+        return loadSceneCache(file, path, scene, settings);
+    }
+
+    SceneParser parser(file.data(), file.size(), path, scene, settings,
+                       animation);
+
+    if (!parser.parse())
+    {
+        return false;
+    }
+
+    scene.build();
+
+    return true;
+}
+
+bool saveSceneCache(const Scene& scene, const SceneSettings& settings,
+                    const std::string& path)
+{
+    std::ofstream out(path, std::ios::binary);
+
+    if (!out)
+    {
+        std::cerr << "Could not open " << path << " for writing.\n";
+
+        return false;
+    }
+
+    const SphereSoA& spheres = scene.spheres().spheres();
+    int32_t image[4] = {settings.imageWidth, settings.imageHeight,
+                        settings.samplesPerPixel, settings.maxDepth};
+
+    out.write(SCENE_CACHE_MAGIC, 4);
+    writeValue(out, SCENE_CACHE_VERSION);
+    writeValues(out, image, 4);
+    writeVector(out, settings.lookFrom);
+    writeVector(out, settings.lookAt);
+    writeVector(out, settings.upVector);
+    writeValue(out, settings.verticalFOV);
+    writeValue(out, settings.defocusAngle);
+    writeValue(out, settings.focusDistance);
+    writeValue(out, scene.skyIntensity());
+    writeValue(out, static_cast<uint32_t>(scene.materials().size()));
+    writeValue(out, spheres.count);
+
+    for (const MaterialData& material : scene.materials())
+    {
+        writeValue(out, static_cast<uint32_t>(material.type));
+        writeVector(out, material.albedo);
+        writeValue(out, material.fuzz);
+        writeValue(out, material.refractionIndex);
+        writeVector(out, material.emission);
+    }
+
+    writeValues(out, spheres.centerX.data(), spheres.count);
+    writeValues(out, spheres.centerY.data(), spheres.count);
+    writeValues(out, spheres.centerZ.data(), spheres.count);
+    writeValues(out, spheres.radius.data(), spheres.count);
+    writeValues(out, spheres.motionX.data(), spheres.count);
+    writeValues(out, spheres.motionY.data(), spheres.count);
+    writeValues(out, spheres.motionZ.data(), spheres.count);
+    writeValues(out, spheres.materialIndex.data(), spheres.count);
+
+    writeNodes(out, scene.spheres().tree().nodes());
+    writeMeshes(out, scene);
+    writeEnvironment(out, scene);
+
+    if (!out.flush())
+    {
+        std::cerr << "Could not write " << path << ".\n";
+
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,129 @@
+/*
+ * This file reads scenes from disk. A scene is either a text description or
+ * a binary cache compiled from one.
+ *
+ * The text format has one statement per line; '#' starts a comment:
+ *
+ *   image <width> <height>
+ *   render <samplesPerPixel> <maxDepth>
+ *   sky <intensity>
+ *   environment <path.hdr|path.pfm> [<rotation>]
+ *   camera <lookFrom x y z> <lookAt x y z> <up x y z> <verticalFOV>
+ *          <defocusAngle> <focusDistance>
+ *   material <name> diffuse <r g b>
+ *   material <name> metal <r g b> <fuzz>
+ *   material <name> glass <refractionIndex>
+ *   material <name> emissive <radiance r g b>
+ *   sphere <center x y z> <radius> <material>
+ *   sphere <center x y z> <centerEnd x y z> <radius> <material>
+ *   mesh <path.obj> <material> [<step> ...]
+ *   frames <count>
+ *   key <frame> camera <lookFrom x y z> <lookAt x y z>
+ *   key <frame> sphere <index> <center x y z>
+ *   key <frame> mesh <index> [<step> ...]
+ *
+ * 'sky' scales the sky gradient that lights the scene (by default 1; 0
+ * leaves only the emitters). 'environment' replaces the gradient with an
+ * equirectangular image, turned by rotation degrees around the y axis and
+ * scaled by 'sky' too (see environment.h). Materials must be declared
+ * before the objects using them. Emissive materials are light sources;
+ * spheres made of them and the environment are sampled directly (see
+ * lightSet.h). A sphere with two centers moves from the first to the second
+ * over the shutter interval. Image and mesh paths are relative to the scene
+ * file. The optional steps transform the mesh, applied in the order given:
+ *
+ *   translate <x y z>
+ *   rotate <x|y|z> <degrees>
+ *   scale <s>  or  scale <x y z>
+ *
+ * A mesh placed several times is loaded and built once; every placement is
+ * an instance that shares its triangles and BVH.
+ *
+ * 'frames' turns the scene into a sequence of that many frames (numbered
+ * from 0) and must precede the keys. A key sets the camera, the center of a
+ * sphere or the transform steps of a mesh placement at a frame; values are
+ * interpolated between keys (see animation.h). Spheres and meshes are
+ * numbered from 0 in the order of the file, separately, and must be declared
+ * before their keys. The keys of one mesh must use the same steps.
+ *
+ * The binary cache holds the flat material table, the spheres and triangles
+ * in BVH leaf order and the BVHs themselves, so loading it is a memory copy
+ * with no parsing and no BVH build. Layout (native byte order):
+ *   char      magic[4]   "RTSC"
+ *   uint32_t  version
+ *   int32_t   imageWidth, imageHeight, samplesPerPixel, maxDepth
+ *   float     lookFrom[3], lookAt[3], upVector[3]
+ *   float     verticalFOV, defocusAngle, focusDistance
+ *   float     skyIntensity
+ *   uint32_t  materialCount, sphereCount
+ *   materials: uint32_t type, float albedo[3], fuzz, refractionIndex,
+ *             emission[3]
+ *   float     centerX[n], centerY[n], centerZ[n], radius[n]
+ *   float     motionX[n], motionY[n], motionZ[n]
+ *   uint32_t  materialIndex[n]
+ *   BVH       (of the spheres)
+ *   uint32_t  meshCount
+ *   meshes:   uint32_t vertexCount, triangleCount, float vertices[3 v],
+ *             uint32_t indices[3 t] (in leaf order), BVH
+ *   uint32_t  instanceCount
+ *   instances: uint32_t mesh, material, float matrix[12], inverse[12]
+ *             (rows of the object to world transform and of its inverse),
+ *             in top-level leaf order
+ *   BVH       (the top level, over the instances)
+ *   int32_t   environmentWidth, environmentHeight (0 0 without one)
+ *   float     environmentRotation
+ *   float     texels[3 w h] (top row first)
+ *
+ * where a BVH is a uint32_t nodeCount followed by the nodes:
+ *   float bounds[6] (min and max of x, y, z), uint32_t offset,
+ *   uint16_t primitiveCount, uint8_t axis, uint8_t padding
+ */
+
+#pragma once
+
+#include <string>
+
+#include "animation.h"
+#include "scene.h"
+#include "../Math/vector3.h"
+
+// Image and camera parameters of a scene. The defaults frame the demo scene
+// returned by randomScene().
+struct SceneSettings
+{
+    int imageWidth = 1200;
+    int imageHeight = 675;
+
+    int samplesPerPixel = 500;
+
+    // Maximum number of bounces per path.
+    int maxDepth = 50;
+
+    Point3 lookFrom = Point3(13.0f, 2.0f, 3.0f);
+    Point3 lookAt = Point3(0.0f, 0.0f, 0.0f);
+    Vector3 upVector = Vector3(0.0f, 1.0f, 0.0f);
+
+    // Vertical field of view in degrees.
+    float verticalFOV = 20.0f;
+
+    float defocusAngle = 0.02f;
+    float focusDistance = 10.0f;
+
+    // Changes the image size. If only one of width and height is positive,
+    // the other follows from the aspect ratio of the current size; if
+    // neither is, the size is kept.
+    void resizeImage(int width, int height);
+};
+
+// Loads a text scene or a scene cache (detected by its header) from path
+// into an empty scene. The scene is ready to render afterwards. Errors are
+// reported with their line number. The keys of an animated text scene are
+// stored in animation; without one, animated scenes are rejected. Caches
+// hold a single frame and no keys.
+bool loadScene(const std::string& path, Scene& scene,
+               SceneSettings& settings, Animation* animation = nullptr);
+
+// Writes a built scene as a binary cache that loadScene() reads without
+// parsing or rebuilding.
+bool saveSceneCache(const Scene& scene, const SceneSettings& settings,
+                    const std::string& path);
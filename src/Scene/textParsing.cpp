@@ -0,0 +1,152 @@
+#include "textParsing.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+    // Powers of ten that are exact in double precision.
+    const double EXACT_POWERS_OF_TEN[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+}
+
+bool parseFloat(const char* begin, const char* end, float& value)
+{
+    const char* p = begin;
+    bool negative = false;
+
+    if (p != end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        ++p;
+    }
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool anyDigit = false;
+
+    for (; p != end && *p >= '0' && *p <= '9'; ++p)
+    {
+        anyDigit = true;
+
+        if (mantissa != 0 || *p != '0')
+        {
+            mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+            ++digits;
+        }
+    }
+
+    if (p != end && *p == '.')
+    {
+        for (++p; p != end && *p >= '0' && *p <= '9'; ++p)
+        {
+            anyDigit = true;
+
+            if (mantissa != 0 || *p != '0')
+            {
+                mantissa = mantissa * 10 +
+                           static_cast<uint64_t>(*p - '0');
+                ++digits;
+            }
+
+            --exponent;
+        }
+    }
+
+    if (p != end && (*p == 'e' || *p == 'E'))
+    {
+        ++p;
+        bool negativeExponent = false;
+
+        if (p != end && (*p == '-' || *p == '+'))
+        {
+            negativeExponent = *p == '-';
+            ++p;
+        }
+
+        int explicitExponent = 0;
+        bool anyExponentDigit = false;
+
+        for (; p != end && *p >= '0' && *p <= '9'; ++p)
+        {
+            anyExponentDigit = true;
+            explicitExponent = std::min(explicitExponent * 10 +
+                                        (*p - '0'), 10000);
+        }
+
+        if (!anyExponentDigit)
+        {
+            return false;
+        }
+
+        exponent += negativeExponent ? -explicitExponent :
+                                       explicitExponent;
+    }
+
+    if (!anyDigit || p != end)
+    {
+        return false;
+    }
+
+    if (digits <= 15 && exponent >= -22 && exponent <= 22)
+    {
+        double result = static_cast<double>(mantissa);
+
+        result = exponent < 0 ? result / EXACT_POWERS_OF_TEN[-exponent] :
+                                result * EXACT_POWERS_OF_TEN[exponent];
+        value = static_cast<float>(negative ? -result : result);
+
+        return true;
+    }
+
+    char buffer[64];
+    size_t length = static_cast<size_t>(end - begin);
+
+    if (length >= sizeof(buffer))
+    {
+        return false;
+    }
+
+    std::memcpy(buffer, begin, length);
+    buffer[length] = '\0';
+    value = static_cast<float>(std::strtod(buffer, nullptr));
+
+    return true;
+}
+
+bool parseInt(const char* begin, const char* end, int& value)
+{
+    const char* p = begin;
+    bool negative = p != end && *p == '-';
+
+    if (negative)
+    {
+        ++p;
+    }
+
+    if (p == end)
+    {
+        return false;
+    }
+
+    long long result = 0;
+
+    for (; p != end; ++p)
+    {
+        if (*p < '0' || *p > '9' || result > 0x7FFFFFFF)
+        {
+            return false;
+        }
+
+        result = result * 10 + (*p - '0');
+    }
+
+    value = static_cast<int>(negative ? -result : result);
+
+    return true;
+}
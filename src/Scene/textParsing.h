@@ -0,0 +1,15 @@
+/*
+ * This file provides number parsing for the scene and mesh readers. The
+ * parsers work on character ranges (e.g. inside a memory-mapped file), so
+ * the input never has to be copied into null-terminated strings.
+ */
+
+#pragma once
+
+// Parses the whole range [begin, end) as a decimal number. Numbers with up
+// to 15 significant digits and small exponents take one correctly rounded
+// double operation; all others fall back to strtod.
+bool parseFloat(const char* begin, const char* end, float& value);
+
+// Parses the whole range [begin, end) as a decimal integer.
+bool parseInt(const char* begin, const char* end, int& value);
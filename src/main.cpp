@@ -1,99 +1,894 @@
 #include <iostream>
 #include <memory>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <csignal>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+#include <string>
 #include "Math/vector3.h"
 #include "Math/ray.h"
 #include "Math/color.h"
 #include "Math/utilities.h"
 #include "Geometry/sphere.h"
 #include "Hittables/hittableList.h"
+#include "Scene/animation.h"
+#include "Scene/scene.h"
+#include "Scene/randomScene.h"
+#include "Scene/sceneFile.h"
 #include "Camera/camera.h"
+#include "Sampling/sampler.h"
+#include "Render/framebuffer.h"
+#include "Render/imageWriter.h"
+#include "Render/adaptiveSampling.h"
+#include "Render/denoiser.h"
+#include "Render/distributedRenderer.h"
+#include "Render/featureBuffer.h"
+#include "Render/progressiveRenderer.h"
+#include "Render/renderServer.h"
+#include "Render/stats.h"
 #include "Materials/material.h"
 #include "Materials/diffuse.h"
 #include "Materials/metal.h"
 #include "Materials/glass.h"
 
-HittableList randomScene()
+// Set by SIGINT and SIGTERM to shut a render server down cleanly.
+std::atomic<bool> serverStopRequested(false);
+
+extern "C" void requestServerStop(int)
+{
+	serverStopRequested = true;
+}
+
+// Prints the supported command line options.
+void printUsage(const char* program)
+{
+	std::cerr << "Usage: " << program << " [options]\n"
+			  << "  --scene PATH    Scene description or scene cache "
+				 "(default: random spheres)\n"
+			  << "  --frame N       Renders frame N of an animated scene "
+				 "(default: all\n"
+			  << "                  frames, numbered into the output "
+				 "path)\n"
+			  << "  --save-scene-cache PATH  Writes the loaded scene as a "
+				 "binary cache\n"
+			  << "  --output PATH   Image file (.ppm, .png, .pfm or .hdr); "
+				 "\"-\" writes\n"
+			  << "                  a binary PPM to stdout (default: -); "
+				 "a run of '#'\n"
+			  << "                  is replaced by the frame number\n"
+			  << "  --resolution WxH  Image size (a 0 keeps the aspect ratio "
+				 "of the scene)\n"
+			  << "  --threads N     Number of render threads "
+				 "(default: all cores)\n"
+			  << "  --tile-size N   Edge length of the render tiles in "
+				 "pixels (default: 32)\n"
+			  << "  --sampler NAME  independent, stratified or sobol "
+				 "(default: sobol)\n"
+			  << "  --spp N         Samples per pixel (default: from the "
+				 "scene, or 500)\n"
+			  << "  --integrator NAME  path or wavefront (default: path)\n"
+			  << "  --roulette-depth N  Bounces before Russian roulette "
+				 "may end a path (default: 3)\n"
+			  << "  --light-sampling on|off  Samples emissive spheres with "
+				 "shadow rays\n"
+			  << "                  (default: on)\n"
+			  << "  --sphere-kernel NAME  scalar, sse or avx2 (default: "
+				 "widest supported);\n"
+			  << "                  also selects the triangle kernel\n"
+			  << "  --adaptive E    Stop sampling pixels once their "
+				 "standard error (in\n"
+			  << "                  gamma corrected units) drops below E\n"
+			  << "  --min-spp N     Adaptive: samples before the first error "
+				 "estimate (default: 16)\n"
+			  << "  --max-spp N     Adaptive: sample budget per pixel "
+				 "(default: 1024)\n"
+			  << "  --spp-heatmap PATH  Adaptive: writes the samples taken "
+				 "per pixel as an image\n"
+			  << "  --progressive N Renders the whole frame in passes of N "
+				 "samples per pixel\n"
+			  << "  --preview PATH  Progressive: rewrites this image after "
+				 "every pass\n"
+			  << "  --checkpoint PATH   Progressive: saves the accumulation "
+				 "buffer to PATH\n"
+			  << "  --checkpoint-interval S  Seconds between checkpoints "
+				 "(default: 300)\n"
+			  << "  --resume PATH   Progressive: continues from a "
+				 "checkpoint\n"
+			  << "  --denoise N     Denoises the image with N filter "
+				 "iterations (1 to 16, 5 is\n"
+			  << "                  a good start), guided by first-hit "
+				 "albedo, normals and depth\n"
+			  << "  --aovs PATH     Writes the albedo, normal and depth "
+				 "images as PATH with\n"
+			  << "                  .albedo, .normal or .depth before the "
+				 "extension\n"
+			  << "  --stats PATH    Writes render statistics as JSON (builds "
+				 "with\n"
+			  << "                  RAYTRACER_STATS; default: next to the "
+				 "image)\n"
+			  << "  --coordinator ADDRESS  Hands the frame out to workers "
+				 "connecting at\n"
+			  << "                  ADDRESS (host:port or unix:path)\n"
+			  << "  --worker ADDRESS  Renders jobs of the coordinator at "
+				 "ADDRESS (needs the\n"
+			  << "                  same scene)\n"
+			  << "  --split NAME    Coordinator: tiles or samples "
+				 "(default: tiles)\n"
+			  << "  --job-size N    Coordinator: tile edge in pixels "
+				 "(default: 128) or samples\n"
+			  << "                  per job (default: 16)\n"
+			  << "  --worker-timeout S  Coordinator: seconds before a silent "
+				 "worker's job is\n"
+			  << "                  reassigned (default: wait while "
+				 "connected)\n"
+			  << "  --serve ADDRESS Runs a render server that keeps scenes "
+				 "loaded\n"
+			  << "  --scene-cache N Server: scenes kept in memory "
+				 "(default: 8)\n"
+			  << "  --scene-root DIR  Server: directory the scene paths of "
+				 "jobs are\n"
+			  << "                  relative to (default: the working "
+				 "directory)\n"
+			  << "  --max-pixels N  Server: largest image a job may ask for "
+				 "(default: 8192^2)\n"
+			  << "  --max-spp N     Server: most samples per pixel of a job "
+				 "(default: 4096)\n"
+			  << "  --max-clients N Server: clients connected at once "
+				 "(default: 64)\n"
+			  << "  --server ADDRESS  Renders the scene on the render "
+				 "server at ADDRESS\n"
+			  << "  --priority N    Server job priority; higher preempts "
+				 "lower (default: 0)\n";
+}
+
+// Returns the path of a frame's image: a run of '#' in path is replaced by
+// the zero-padded frame number. Without one, the frames of a sequence get
+// "_NNNN" before the extension. "-" (stdout) is kept.
+std::string framePath(const std::string& path, int frame, bool sequence)
+{
+	size_t hashes = path.find('#');
+
+	if (path == "-" || (hashes == std::string::npos && !sequence))
+	{
+		return path;
+	}
+
+	std::ostringstream number;
+
+	if (hashes == std::string::npos)
+	{
+		size_t extension = path.find_last_of('.');
+		size_t separator = path.find_last_of("/\\");
+
+		if (extension == std::string::npos ||
+			(separator != std::string::npos && extension < separator))
+		{
+			extension = path.size();
+		}
+
+		number << '_' << std::setw(4) << std::setfill('0') << frame;
+
+		return path.substr(0, extension) + number.str() +
+			   path.substr(extension);
+	}
+
+	size_t run = path.find_first_not_of('#', hashes);
+
+	if (run == std::string::npos)
+	{
+		run = path.size();
+	}
+
+	number << std::setw(static_cast<int>(run - hashes)) << std::setfill('0')
+		   << frame;
+
+	return path.substr(0, hashes) + number.str() + path.substr(run);
+}
+
+// Returns path with ".name" inserted before its extension.
+std::string featurePath(const std::string& path, const std::string& name)
 {
-	HittableList world;
+	size_t extension = path.find_last_of('.');
+	size_t separator = path.find_last_of("/\\");
 
-	auto groundMaterial = std::make_shared<Diffuse>(Color(0.5f, 0.5f, 0.5f));
-	world.add(std::make_shared<Sphere>(Point3(0.0f, -1000.0f, 0.0f), 1000.0f,
-									   groundMaterial));
+	if (extension == std::string::npos ||
+		(separator != std::string::npos && extension < separator))
+	{
+		extension = path.size();
+	}
+
+	return path.substr(0, extension) + "." + name + path.substr(extension);
+}
 
-	for (int a = -11; a < 11; ++a)
+// Returns the milliseconds elapsed since start.
+double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[])
+{
+	// Render settings that may be overridden on the command line.
+	int threadCount = 0;
+	int tileSize = 32;
+	SamplerType samplerType = SamplerType::Sobol;
+	std::string outputPath = "-";
+	int samplesPerPixel = 0;
+	std::string scenePath;
+	std::string sceneCachePath;
+	int rouletteDepth = ROULETTE_MIN_DEPTH;
+	bool lightSampling = true;
+	IntegratorType integrator = IntegratorType::Path;
+	AdaptiveSettings adaptive;
+	std::string heatmapPath;
+	bool progressive = false;
+	ProgressiveSettings progressiveSettings;
+	std::string previewPath;
+	std::string statsPath;
+	bool forceSphereKernel = false;
+	SphereKernel sphereKernel = SphereKernel::Scalar;
+	DistributedSettings distributed;
+	std::string workerAddress;
+	int frameIndex = -1;
+	int imageWidth = 0;
+	int imageHeight = 0;
+	std::string serveAddress;
+	std::string serverAddress;
+	int sceneCacheSize = 0;
+	std::string sceneRoot;
+	long long maxPixels = 0;
+	int maxClients = 0;
+	int maxSamples = 0;
+	int priority = 0;
+	int denoiseIterations = 0;
+	std::string aovPath;
+
+	for (int i = 1; i < argc; ++i)
 	{
-		for (int b = -11; b < 11; ++b)
+		std::string option = argv[i];
+
+		if (i + 1 >= argc)
 		{
-			float chooseMat = randomFloat();
-			Point3 center(a + (0.9f * randomFloat()), 0.2f,
-						  b + (0.9f * randomFloat()));
+			printUsage(argv[0]);
+			return 1;
+		}
+
+		if (option == "--output")
+		{
+			outputPath = argv[++i];
+		}
+		else if (option == "--resolution")
+		{
+			std::string size = argv[++i];
+			size_t separator = size.find('x');
 
-			if ((center - Point3(4.0f, 0.2f, 0.0f)).magnitude() > 0.9f)
+			if (separator == std::string::npos)
 			{
-				std::shared_ptr<Material> sphereMaterial;
+				printUsage(argv[0]);
+				return 1;
+			}
 
-				if (chooseMat < 0.8f)
-				{
-					// Diffuse
-					Vector3 albedo = Color::random() * Color::random();
-					sphereMaterial = std::make_shared<Diffuse>(albedo);
-					auto center2 = center + Vector3(0, randomFloat(0, .5), 0);
-					world.add(std::make_shared<Sphere>(center, center2, 0.2, sphereMaterial));
-				}
-				else if (chooseMat < 0.95f)
-				{
-					// Metal
-					Vector3 albedo = Color::random(0.5f, 1.0f);
-					float fuzz = randomFloat(0.0f, 0.5f);
-					sphereMaterial = std::make_shared<Metal>(albedo, fuzz);
-					world.add(std::make_shared<Sphere>
-							 (center, 0.2f, sphereMaterial));
-				}
-				else
+			imageWidth = std::atoi(size.substr(0, separator).c_str());
+			imageHeight = std::atoi(size.substr(separator + 1).c_str());
+		}
+		else if (option == "--threads")
+		{
+			threadCount = std::atoi(argv[++i]);
+		}
+		else if (option == "--tile-size")
+		{
+			tileSize = std::atoi(argv[++i]);
+		}
+		else if (option == "--spp")
+		{
+			samplesPerPixel = std::atoi(argv[++i]);
+		}
+		else if (option == "--integrator")
+		{
+			if (!parseIntegratorType(argv[++i], integrator))
+			{
+				printUsage(argv[0]);
+				return 1;
+			}
+		}
+		else if (option == "--roulette-depth")
+		{
+			rouletteDepth = std::atoi(argv[++i]);
+		}
+		else if (option == "--light-sampling")
+		{
+			std::string value = argv[++i];
+
+			if (value != "on" && value != "off")
+			{
+				printUsage(argv[0]);
+				return 1;
+			}
+
+			lightSampling = value == "on";
+		}
+		else if (option == "--adaptive")
+		{
+			adaptive.enabled = true;
+			adaptive.errorThreshold = static_cast<float>(
+				std::atof(argv[++i]));
+		}
+		else if (option == "--min-spp")
+		{
+			adaptive.minSamples = std::atoi(argv[++i]);
+		}
+		else if (option == "--max-spp")
+		{
+			adaptive.maxSamples = std::atoi(argv[++i]);
+		}
+		else if (option == "--spp-heatmap")
+		{
+			heatmapPath = argv[++i];
+		}
+		else if (option == "--progressive")
+		{
+			progressive = true;
+			progressiveSettings.samplesPerPass = std::atoi(argv[++i]);
+		}
+		else if (option == "--preview")
+		{
+			previewPath = argv[++i];
+		}
+		else if (option == "--checkpoint")
+		{
+			progressiveSettings.checkpointPath = argv[++i];
+		}
+		else if (option == "--checkpoint-interval")
+		{
+			progressiveSettings.checkpointInterval = std::atof(argv[++i]);
+		}
+		else if (option == "--resume")
+		{
+			progressive = true;
+			progressiveSettings.resumePath = argv[++i];
+		}
+		else if (option == "--scene")
+		{
+			scenePath = argv[++i];
+		}
+		else if (option == "--frame")
+		{
+			frameIndex = std::atoi(argv[++i]);
+		}
+		else if (option == "--save-scene-cache")
+		{
+			sceneCachePath = argv[++i];
+		}
+		else if (option == "--denoise")
+		{
+			denoiseIterations = std::atoi(argv[++i]);
+
+			if (denoiseIterations < 1 ||
+				denoiseIterations > MAX_DENOISE_ITERATIONS)
+			{
+				std::cerr << "--denoise takes 1 to "
+						  << MAX_DENOISE_ITERATIONS << " iterations.\n";
+				return 1;
+			}
+		}
+		else if (option == "--aovs")
+		{
+			aovPath = argv[++i];
+		}
+		else if (option == "--stats")
+		{
+			statsPath = argv[++i];
+		}
+		else if (option == "--sampler")
+		{
+			if (!parseSamplerType(argv[++i], samplerType))
+			{
+				printUsage(argv[0]);
+				return 1;
+			}
+		}
+		else if (option == "--coordinator")
+		{
+			distributed.address = argv[++i];
+		}
+		else if (option == "--worker")
+		{
+			workerAddress = argv[++i];
+		}
+		else if (option == "--split")
+		{
+			if (!parseWorkSplit(argv[++i], distributed.split))
+			{
+				printUsage(argv[0]);
+				return 1;
+			}
+		}
+		else if (option == "--job-size")
+		{
+			distributed.jobSize = std::atoi(argv[++i]);
+		}
+		else if (option == "--worker-timeout")
+		{
+			distributed.workerTimeout = std::atof(argv[++i]);
+		}
+		else if (option == "--serve")
+		{
+			serveAddress = argv[++i];
+		}
+		else if (option == "--scene-cache")
+		{
+			sceneCacheSize = std::atoi(argv[++i]);
+		}
+		else if (option == "--scene-root")
+		{
+			sceneRoot = argv[++i];
+		}
+		else if (option == "--max-pixels")
+		{
+			maxPixels = std::atoll(argv[++i]);
+		}
+		else if (option == "--max-spp")
+		{
+			maxSamples = std::atoi(argv[++i]);
+		}
+		else if (option == "--max-clients")
+		{
+			maxClients = std::atoi(argv[++i]);
+		}
+		else if (option == "--server")
+		{
+			serverAddress = argv[++i];
+		}
+		else if (option == "--priority")
+		{
+			priority = std::atoi(argv[++i]);
+		}
+		else if (option == "--sphere-kernel")
+		{
+			forceSphereKernel = true;
+
+			if (!parseSphereKernel(argv[++i], sphereKernel))
+			{
+				printUsage(argv[0]);
+				return 1;
+			}
+		}
+		else
+		{
+			printUsage(argv[0]);
+			return 1;
+		}
+	}
+
+#ifdef RAYTRACER_STATS
+	// Write the report next to the image unless told otherwise.
+	if (statsPath.empty() && outputPath != "-")
+	{
+		size_t extension = outputPath.find_last_of('.');
+		size_t separator = outputPath.find_last_of("/\\");
+
+		if (extension == std::string::npos ||
+			(separator != std::string::npos && extension < separator))
+		{
+			extension = outputPath.size();
+		}
+
+		statsPath = outputPath.substr(0, extension) + ".stats.json";
+	}
+#else
+	if (!statsPath.empty())
+	{
+		std::cerr << "Render statistics are not compiled in; rebuild with "
+					 "RAYTRACER_STATS to use --stats.\n";
+		statsPath.clear();
+	}
+#endif
+
+	bool useFeatures = denoiseIterations > 0 || !aovPath.empty();
+
+	if (useFeatures && (!serveAddress.empty() || !serverAddress.empty() ||
+						!distributed.address.empty() ||
+						!workerAddress.empty()))
+	{
+		std::cerr << "Denoising and feature images need a local render.\n";
+		return 1;
+	}
+
+	if (!serveAddress.empty())
+	{
+		// Scenes are loaded as jobs ask for them.
+		ServerSettings server;
+		server.address = serveAddress;
+		server.threadCount = threadCount;
+		server.tileSize = tileSize;
+
+		if (sceneCacheSize > 0)
+		{
+			server.sceneCacheSize = static_cast<size_t>(sceneCacheSize);
+		}
+
+		server.sceneRoot = sceneRoot;
+
+		if (maxPixels > 0)
+		{
+			server.maxPixels = static_cast<uint64_t>(maxPixels);
+		}
+
+		if (maxSamples > 0)
+		{
+			server.maxSamplesPerPixel = maxSamples;
+		}
+
+		if (maxClients > 0)
+		{
+			server.maxClients = maxClients;
+		}
+
+		server.stop = &serverStopRequested;
+		std::signal(SIGINT, requestServerStop);
+		std::signal(SIGTERM, requestServerStop);
+
+		return runRenderServer(server) ? 0 : 1;
+	}
+
+	if (!serverAddress.empty())
+	{
+		// The server loads the scene; nothing is loaded here.
+		RenderRequest request;
+		request.imageWidth = imageWidth;
+		request.imageHeight = imageHeight;
+		request.samplesPerPixel = samplesPerPixel;
+		request.samplesPerPass = progressive ?
+								 progressiveSettings.samplesPerPass : 0;
+		request.priority = priority;
+		request.frame = frameIndex >= 0 ? frameIndex : 0;
+		request.sampler = static_cast<int32_t>(samplerType);
+		request.integrator = static_cast<int32_t>(integrator);
+
+		Framebuffer framebuffer;
+		auto writePreview = [&](const Framebuffer& image, int)
+		{
+			if (!previewPath.empty())
+			{
+				writeImage(image, previewPath);
+			}
+		};
+
+		if (!requestRender(serverAddress, scenePath, request, framebuffer,
+						   writePreview) ||
+			!writeImage(framebuffer,
+						framePath(outputPath, request.frame, false)))
+		{
+			return 1;
+		}
+
+		return 0;
+	}
+
+	// Image and camera settings come with the scene.
+	Scene scene;
+	SceneSettings settings;
+	Animation animation;
+
+	if (scenePath.empty())
+	{
+		// Flatten the demo scene into material and geometry tables.
+		scene = Scene(randomScene());
+	}
+	else
+	{
+		auto start = std::chrono::steady_clock::now();
+
+		if (!loadScene(scenePath, scene, settings, &animation))
+		{
+			return 1;
+		}
+
+		size_t triangles = 0;
+
+		for (const auto& mesh : scene.meshes())
+		{
+			triangles += mesh->triangleCount();
+		}
+
+		std::clog << "Loaded " << scene.spheres().size() << " spheres and "
+				  << scene.instances().size() << " instances of "
+				  << triangles << " unique triangles from " << scenePath
+				  << " in "
+				  << std::chrono::duration<double>(
+						 std::chrono::steady_clock::now() - start).count()
+				  << " s.\n";
+	}
+
+	if (!sceneCachePath.empty())
+	{
+		if (animation.animated())
+		{
+			std::cerr << "Scene caches hold no animation; the cache gets the "
+						 "scene as declared.\n";
+		}
+
+		if (!saveSceneCache(scene, settings, sceneCachePath))
+		{
+			return 1;
+		}
+	}
+
+	// Render the whole sequence, or only the frame asked for.
+	int firstFrame = 0;
+	int endFrame = animation.frameCount();
+
+	if (frameIndex >= 0)
+	{
+		if (frameIndex >= animation.frameCount())
+		{
+			std::cerr << "The scene has " << animation.frameCount()
+					  << " frames; there is no frame " << frameIndex
+					  << ".\n";
+			return 1;
+		}
+
+		firstFrame = frameIndex;
+		endFrame = frameIndex + 1;
+	}
+
+	bool sequence = endFrame - firstFrame > 1;
+
+	if (sequence && (progressive || !distributed.address.empty() ||
+					 !workerAddress.empty()))
+	{
+		std::cerr << "Sequences render one pass per frame on one machine; "
+					 "use --frame to render a frame progressively or "
+					 "distributed.\n";
+		return 1;
+	}
+
+	if (samplesPerPixel > 0)
+	{
+		settings.samplesPerPixel = samplesPerPixel;
+	}
+
+	settings.resizeImage(imageWidth, imageHeight);
+
+	if (forceSphereKernel && !scene.setKernel(sphereKernel))
+	{
+		std::cerr << "The " << sphereKernelName(sphereKernel)
+				  << " kernel is not supported by this CPU.\n";
+		return 1;
+	}
+
+	std::clog << "Intersecting primitives with the "
+			  << sphereKernelName(scene.spheres().kernel()) << " kernel.\n";
+
+	Camera camera(settings.imageWidth, settings.imageHeight,
+				  settings.samplesPerPixel, settings.maxDepth,
+				  static_cast<float>(settings.imageWidth) /
+				  settings.imageHeight,
+				  settings.verticalFOV, settings.defocusAngle,
+				  settings.focusDistance, settings.lookFrom, settings.lookAt,
+				  settings.upVector);
+
+	camera.setThreadCount(threadCount);
+	camera.setTileSize(tileSize);
+	camera.setSampler(samplerType);
+	camera.setIntegrator(integrator);
+	camera.setRouletteDepth(rouletteDepth);
+	camera.setLightSampling(lightSampling);
+	camera.setAdaptiveSampling(adaptive);
+
+	// Time spent on the acceleration structures of the last frame posed.
+	double buildMilliseconds = 0.0;
+	double refitMilliseconds = 0.0;
+
+	// Moves the camera and the scene to a frame. The hierarchies are
+	// refitted, or rebuilt if refitting degraded them too much.
+	auto poseFrame = [&](int frame)
+	{
+		Point3 lookFrom, lookAt;
+
+		if (animation.cameraAt(frame, lookFrom, lookAt))
+		{
+			camera.setView(lookFrom, lookAt);
+		}
+
+		animation.poseScene(frame, scene);
+
+		auto start = std::chrono::steady_clock::now();
+		bool refitted = scene.refit();
+
+		refitMilliseconds = millisecondsSince(start);
+		buildMilliseconds = 0.0;
+
+		if (!refitted)
+		{
+			start = std::chrono::steady_clock::now();
+			scene.build();
+			buildMilliseconds = millisecondsSince(start);
+		}
+	};
+
+	if (!workerAddress.empty())
+	{
+		if (animation.animated())
+		{
+			poseFrame(firstFrame);
+		}
+
+		// Workers return their results to the coordinator, which writes
+		// the image.
+		return runWorker(workerAddress, camera, scene) ? 0 : 1;
+	}
+
+	if (!distributed.address.empty() && progressive)
+	{
+		std::cerr << "Distributed renders are not progressive; use "
+					 "--split samples to spread the samples instead.\n";
+		return 1;
+	}
+
+	// One framebuffer serves every frame of a sequence.
+	Framebuffer framebuffer(settings.imageWidth, settings.imageHeight);
+
+	// First-hit features, recorded only when they are used. The denoiser
+	// shares its threads with the camera.
+	FeatureBuffer features;
+	std::unique_ptr<ThreadPool> pool;
+
+	if (useFeatures)
+	{
+		camera.setFeatureBuffer(&features);
+	}
+
+	if (denoiseIterations > 0)
+	{
+		pool.reset(new ThreadPool(threadCount));
+		camera.setThreadPool(pool.get());
+	}
+
+	double totalBuild = 0.0;
+	double totalRefit = 0.0;
+	double totalRender = 0.0;
+
+	for (int frame = firstFrame; frame < endFrame; ++frame)
+	{
+		if (animation.animated())
+		{
+			poseFrame(frame);
+		}
+
+		framebuffer.clear();
+		features.clear();
+
+		auto renderStart = std::chrono::steady_clock::now();
+
+		if (!distributed.address.empty())
+		{
+			RenderJob job;
+			job.imageWidth = settings.imageWidth;
+			job.imageHeight = settings.imageHeight;
+			job.sceneHash = scene.contentHash();
+			job.cameraHash = camera.settingsHash();
+			job.samplesPerPixel = settings.samplesPerPixel;
+			job.sampler = static_cast<int32_t>(samplerType);
+			job.integrator = static_cast<int32_t>(integrator);
+			job.rouletteDepth = rouletteDepth;
+			job.lightSampling = lightSampling ? 1 : 0;
+			job.adaptive = adaptive.enabled ? 1 : 0;
+			job.errorThreshold = adaptive.errorThreshold;
+			job.minSamples = adaptive.minSamples;
+			job.maxSamples = adaptive.maxSamples;
+
+			if (!coordinateRender(job, distributed, framebuffer))
+			{
+				return 1;
+			}
+		}
+		else if (progressive)
+		{
+			// Expose every finished pass as a preview image.
+			auto writePreview = [&](const Framebuffer& image, int)
+			{
+				if (!previewPath.empty())
 				{
-					// Glass
-					sphereMaterial = std::make_shared<Glass>(1.5f);
-					world.add(std::make_shared<Sphere>
-							 (center, 0.2f, sphereMaterial));
+					writeImage(image, previewPath);
 				}
+			};
+
+			if (!renderProgressive(camera, scene, framebuffer,
+								   progressiveSettings, writePreview))
+			{
+				return 1;
 			}
 		}
-	}
+		else
+		{
+			camera.render(scene, framebuffer);
+		}
 
-	auto material1 = std::make_shared<Glass>(1.5f);
-	world.add(std::make_shared<Sphere>
-			 (Point3(0.0f, 1.0f, 0.0f), 1.0f, material1));
+		double renderSeconds = millisecondsSince(renderStart) / 1000.0;
+		Framebuffer denoised;
 
-	auto material2 = std::make_shared<Diffuse>(Color(0.4f, 0.2f, 0.1f));
-	world.add(std::make_shared<Sphere>
-			 (Point3(-4.0f, 1.0f, 0.0f), 1.0f, material2));
+		if (denoiseIterations > 0)
+		{
+			DenoiseSettings denoiseSettings;
+			denoiseSettings.iterations = denoiseIterations;
 
-	auto material3 = std::make_shared<Metal>(Color(0.7f, 0.6f, 0.5f), 0.0f);
-	world.add(std::make_shared<Sphere>
-			 (Point3(4.0f, 1.0f, 0.0f), 1.0f, material3));
+			auto start = std::chrono::steady_clock::now();
+			denoised = denoise(framebuffer, features, denoiseSettings, *pool);
 
-	return world;
-}
+			std::clog << "Denoised in " << millisecondsSince(start)
+					  << " ms.\n";
+		}
 
-int main()
-{
-	// Image
-	const float ASPECT_RATIO = 16.0f / 9.0f;
-	const int IMAGE_WIDTH = 1200;
-	const int IMAGE_HEIGHT = static_cast<int>(IMAGE_WIDTH / ASPECT_RATIO);
-	const int SAMPLES_PER_PIXEL = 500;
-	const int MAX_DEPTH = 50;
-	bool msaa = true;
-
-	// Create hittable list and add primitives to world.
-	HittableList world = randomScene();
-
-	Camera camera(IMAGE_WIDTH, IMAGE_HEIGHT, SAMPLES_PER_PIXEL, MAX_DEPTH, ASPECT_RATIO, 20.0f, .02f, 10.0f,
-				  Point3(13.0f, 2.0f, 3.0f), Point3(0.0f, 0.0f, 0.0f),
-				  Vector3(0.0f, 1.0f, 0.0f));
-
-	camera.render(world);
+		if (!writeImage(denoiseIterations > 0 ? denoised : framebuffer,
+						framePath(outputPath, frame, sequence)))
+		{
+			return 1;
+		}
+
+		if (!aovPath.empty())
+		{
+			std::string path = framePath(aovPath, frame, sequence);
+
+			if (!writeImage(features.albedoImage(),
+							featurePath(path, "albedo")) ||
+				!writeImage(features.normalImage(),
+							featurePath(path, "normal")) ||
+				!writeImage(features.depthImage(),
+							featurePath(path, "depth")))
+			{
+				return 1;
+			}
+		}
+
+		if (!heatmapPath.empty() &&
+			!writeImage(makeSampleCountHeatmap(framebuffer,
+											   adaptive.enabled ?
+											   adaptive.maxSamples :
+											   settings.samplesPerPixel),
+						framePath(heatmapPath, frame, sequence)))
+		{
+			return 1;
+		}
+
+		if (animation.animated())
+		{
+			std::clog << "Frame " << frame << ": build " << buildMilliseconds
+					  << " ms, refit " << refitMilliseconds << " ms, render "
+					  << renderSeconds << " s.\n";
+		}
+
+		totalBuild += buildMilliseconds;
+		totalRefit += refitMilliseconds;
+		totalRender += renderSeconds;
+	}
+
+	if (sequence)
+	{
+		std::clog << "Rendered " << endFrame - firstFrame << " frames: build "
+				  << totalBuild << " ms, refit " << totalRefit
+				  << " ms, render " << totalRender << " s.\n";
+	}
+
+	if (!statsPath.empty())
+	{
+		RenderStats stats = collectStats();
+		int render = static_cast<int>(StatsPhase::Render);
+
+		std::clog << "Traced " << stats.rays() << " rays ("
+				  << stats.phaseRays[render] /
+					 std::fmax(stats.phaseSeconds[render], 1e-9) / 1e6
+				  << " Mrays/s).\n";
+
+		if (!writeStatsReport(stats, statsPath))
+		{
+			return 1;
+		}
+	}
 
 	return 0;
 }